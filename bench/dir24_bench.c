@@ -0,0 +1,293 @@
+/*
+ * File     : dir24_bench.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-16 15:40:18
+*/
+
+/*
+ * 国内 IP 库查询引擎对比: LPM trie vs DIR-24-8
+ * LPM trie 按内核 kernel/bpf/lpm_trie.c 的插入与查找算法在用户态实现，
+ * 内存按内核节点大小 (kmalloc-64) 估算；DIR-24-8 直接使用 user/dir24.c 的构造结果。
+ * 用法: dir24_bench [-n 查询次数] [-s 合成规则数] [规则文件]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "direct_path_user.h"
+#include "direct_path_dir24.h"
+
+/* 默认查询次数 */
+#define BENCH_LOOKUP_NUM                10000000
+/* 默认合成规则数，与 china_ip_list 规模相当 */
+#define BENCH_SYNTH_RULE_NUM            8192
+/* 内核 lpm_trie_node: rcu_head + child[2] + prefixlen + flags + 4 字节 key + 4 字节 value，落在 kmalloc-64 */
+#define BENCH_LPM_NODE_BYTES            64
+
+#define LPM_NODE_INTERMEDIATE           1
+
+typedef struct lpm_node {
+    struct lpm_node *child[2];
+    __u32 prefixlen;
+    __u32 flags;
+    /* 主机字节序 */
+    __u32 data;
+    __u32 value;
+} lpm_node_t;
+
+typedef struct {
+    lpm_node_t *root;
+    size_t nodes;
+} lpm_trie_t;
+
+static __always_inline __u32 lpm_extract_bit(__u32 data, __u32 index) {
+    return (data >> (31 - index)) & 1;
+}
+
+static __always_inline __u32 lpm_longest_prefix_match(const lpm_node_t *node, __u32 data, __u32 prefixlen) {
+    __u32 limit = node->prefixlen < prefixlen ? node->prefixlen : prefixlen;
+    __u32 diff = node->data ^ data;
+    __u32 matched = diff ? (__u32)__builtin_clz(diff) : 32;
+
+    return matched < limit ? matched : limit;
+}
+
+static bool lpm_insert(lpm_trie_t *trie, __u32 data, __u32 prefixlen, __u32 value) {
+    lpm_node_t *new_node = calloc(1, sizeof(lpm_node_t));
+    if (NULL == new_node) return false;
+
+    new_node->prefixlen = prefixlen;
+    new_node->data = data;
+    new_node->value = value;
+
+    __u32 matchlen = 0;
+    lpm_node_t *node = NULL;
+    lpm_node_t **slot = &trie->root;
+    while ((node = *slot) != NULL) {
+        matchlen = lpm_longest_prefix_match(node, data, prefixlen);
+        if (node->prefixlen != matchlen || node->prefixlen == prefixlen || node->prefixlen == 32) break;
+
+        slot = &node->child[lpm_extract_bit(data, node->prefixlen)];
+    }
+
+    trie->nodes++;
+    if (NULL == node) {
+        *slot = new_node;
+        return true;
+    }
+
+    /* 相同前缀，替换原节点 */
+    if (node->prefixlen == matchlen) {
+        new_node->child[0] = node->child[0];
+        new_node->child[1] = node->child[1];
+        *slot = new_node;
+        free(node);
+        trie->nodes--;
+        return true;
+    }
+
+    /* 新节点是原节点的前缀 */
+    if (matchlen == prefixlen) {
+        new_node->child[lpm_extract_bit(node->data, matchlen)] = node;
+        *slot = new_node;
+        return true;
+    }
+
+    /* 分叉，插入中间节点 */
+    lpm_node_t *im = calloc(1, sizeof(lpm_node_t));
+    if (NULL == im) return false;
+
+    im->prefixlen = matchlen;
+    im->flags = LPM_NODE_INTERMEDIATE;
+    im->data = node->data;
+    if (lpm_extract_bit(data, matchlen)) {
+        im->child[0] = node;
+        im->child[1] = new_node;
+    } else {
+        im->child[0] = new_node;
+        im->child[1] = node;
+    }
+
+    *slot = im;
+    trie->nodes++;
+
+    return true;
+}
+
+static __u32 lpm_lookup(const lpm_trie_t *trie, __u32 addr) {
+    const lpm_node_t *found = NULL;
+
+    for (const lpm_node_t *node = trie->root; node; ) {
+        __u32 matchlen = lpm_longest_prefix_match(node, addr, 32);
+        if (matchlen == 32) {
+            if (!(node->flags & LPM_NODE_INTERMEDIATE)) found = node;
+            break;
+        }
+
+        if (matchlen < node->prefixlen) break;
+        if (!(node->flags & LPM_NODE_INTERMEDIATE)) found = node;
+
+        node = node->child[lpm_extract_bit(addr, node->prefixlen)];
+    }
+
+    return found ? found->value : ACTION_NONE;
+}
+
+static void lpm_free(lpm_node_t *node) {
+    if (NULL == node) return ;
+
+    lpm_free(node->child[0]);
+    lpm_free(node->child[1]);
+    free(node);
+}
+
+/* xorshift，固定种子保证多次运行可比 */
+static __u32 bench_rand_state = 0x9E3779B9;
+static __always_inline __u32 bench_rand(void) {
+    __u32 x = bench_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return bench_rand_state = x;
+}
+
+/* 读取规则文件，支持 "IP-CIDR,1.0.1.0/24" 与 "1.0.1.0/24" 两种格式 */
+static bool bench_rules_load(const char *path, ip_rule_set_t *rules) {
+    FILE *fp = fopen(path, "r");
+    if (NULL == fp) {
+        perror("[ERROR] 无法打开规则文件");
+        return false;
+    }
+
+    char line[FILE_LINE_MAXLEN] = {0};
+    while (fgets(line, sizeof(line), fp)) {
+        char *cidr = strstr(line, RULE_IP);
+        cidr = cidr ? cidr + strlen(RULE_IP) : line;
+
+        char addr[INET_ADDRSTRLEN] = {0};
+        unsigned int prefixlen = 0;
+        if (2 != sscanf(cidr, " %15[0-9.]/%u", addr, &prefixlen) || prefixlen > 32) continue;
+
+        ip_lpm_key_t key = {.prefixlen = prefixlen};
+        if (1 != inet_pton(AF_INET, addr, &key.ipv4)) continue;
+        if (prefixlen < 32) key.ipv4 &= htonl(prefixlen ? ~0U << (32 - prefixlen) : 0);
+
+        if (!ip_rule_set_add(rules, &key, ACTION_DIRECT)) break;
+    }
+
+    fclose(fp);
+    return true;
+}
+
+/* 合成规则，前缀长度分布参考 china_ip_list: 以 /12 - /24 为主，少量长于 /24 */
+static bool bench_rules_synth(size_t num, ip_rule_set_t *rules) {
+    for (size_t i = 0; i < num; i++) {
+        __u32 r = bench_rand() % 100;
+        __u32 prefixlen = (r < 2) ? 25 + bench_rand() % 8 : 12 + bench_rand() % 13;
+        __u32 addr = bench_rand() & (~0U << (32 - prefixlen));
+
+        ip_lpm_key_t key = {.prefixlen = prefixlen, .ipv4 = htonl(addr)};
+        __u32 action = (bench_rand() % 8) ? ACTION_DIRECT : 2 + bench_rand() % (ACTION_MAX_NUM - 2);
+        if (!ip_rule_set_add(rules, &key, action)) return false;
+    }
+
+    return true;
+}
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    size_t lookup_num = BENCH_LOOKUP_NUM;
+    size_t synth_num = BENCH_SYNTH_RULE_NUM;
+
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': lookup_num = strtoul(optarg, NULL, 10); break;
+            case 's': synth_num = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n lookups] [-s synthetic rules] [rule file]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    ip_rule_set_t rules = {0};
+    bool ok = (optind < argc) ? bench_rules_load(argv[optind], &rules) : bench_rules_synth(synth_num, &rules);
+    if (!ok || 0 == rules.num || 0 == lookup_num) {
+        fprintf(stderr, "[ERROR] 没有可用规则\n");
+        return 1;
+    }
+
+    /* 与写入 LPM 的覆盖语义一致 */
+    ip_rule_set_dedup(&rules);
+
+    lpm_trie_t trie = {0};
+    for (size_t i = 0; i < rules.num; i++) {
+        if (!lpm_insert(&trie, ntohl(rules.rules[i].key.ipv4), rules.rules[i].key.prefixlen, rules.rules[i].action)) {
+            fprintf(stderr, "[ERROR] LPM 构造失败\n");
+            return 1;
+        }
+    }
+
+    double t0 = bench_now_ns();
+    dir24_table_t table = {0};
+    if (!dir24_build(&table, &rules)) {
+        fprintf(stderr, "[ERROR] DIR-24-8 构造失败\n");
+        return 1;
+    }
+    double build_ns = bench_now_ns() - t0;
+
+    /* 一半地址取自规则内，一半均匀随机 */
+    __u32 *addrs = malloc(lookup_num * sizeof(__u32));
+    if (NULL == addrs) return 1;
+    for (size_t i = 0; i < lookup_num; i++) {
+        if (i & 1) {
+            addrs[i] = bench_rand();
+            continue;
+        }
+
+        const ip_rule_t *rule = &rules.rules[bench_rand() % rules.num];
+        __u32 host_mask = (rule->key.prefixlen >= 32) ? 0 : (~0U >> rule->key.prefixlen);
+        addrs[i] = ntohl(rule->key.ipv4) | (bench_rand() & host_mask);
+    }
+
+    /* 结果校验 */
+    size_t mismatch = 0;
+    for (size_t i = 0; i < lookup_num; i++) {
+        if (lpm_lookup(&trie, addrs[i]) != dir24_lookup(&table, addrs[i])) mismatch++;
+    }
+
+    __u64 sum = 0;
+    t0 = bench_now_ns();
+    for (size_t i = 0; i < lookup_num; i++) sum += lpm_lookup(&trie, addrs[i]);
+    double lpm_ns = (bench_now_ns() - t0) / lookup_num;
+
+    t0 = bench_now_ns();
+    for (size_t i = 0; i < lookup_num; i++) sum += dir24_lookup(&table, addrs[i]);
+    double dir24_ns = (bench_now_ns() - t0) / lookup_num;
+
+    printf("规则数          : %zu\n", rules.num);
+    printf("查询次数        : %zu (校验不一致 %zu)\n", lookup_num, mismatch);
+    printf("LPM trie        : %8.2f ns/次, 节点 %zu 个, 内存约 %zu KB\n", 
+        lpm_ns, trie.nodes, trie.nodes * BENCH_LPM_NODE_BYTES / 1024);
+    printf("DIR-24-8        : %8.2f ns/次, 溢出 /24 %zu 个, 内存 %zu KB, 构造 %.1f ms\n", 
+        dir24_ns, table.ovf_num, dir24_mem_size(&table) / 1024, build_ns / 1e6);
+    printf("校验和          : %llu\n", (unsigned long long)sum);
+
+    free(addrs);
+    dir24_free(&table);
+    lpm_free(trie.root);
+    ip_rule_set_free(&rules);
+
+    return mismatch ? 1 : 0;
+}
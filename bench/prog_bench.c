@@ -0,0 +1,524 @@
+/*
+ * File     : prog_bench.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-11 16:27:09
+*/
+
+/*
+ * XDP / TC 程序微基准
+ * 加载 bpf 目录编译出的两个对象 (不复用、不固定任何 map，不影响正在运行的实例)，
+ * 按常见规模填充规则与缓存，再用 BPF_PROG_TEST_RUN 驱动合成报文，输出各场景每包耗时。
+ * 缓存命中等无状态场景一次 test run 内重复 repeat 次；
+ * 会改变 map 状态的场景 (如 LPM 命中后写入缓存) 每次运行前恢复状态，逐次运行后取平均，包含内核计时开销。
+ * 用法: prog_bench [-n repeat] [xdp_direct_path.o] [tc_direct_path.o]
+ * 需要 root 权限，仅支持 lpm 查询引擎。
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include <linux/tcp.h>
+#include <linux/pkt_cls.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+
+/* 默认重复次数 */
+#define BENCH_REPEAT_NUM                1000000
+/* 有状态场景逐次运行的次数 */
+#define BENCH_COLD_NUM                  20000
+
+/* 填充规模，与 ChinaMax + china_ip_list 相当 */
+#define BENCH_DOMAIN_RULE_NUM           100000
+#define BENCH_IP_RULE_NUM               8192
+#define BENCH_BLKLIST_RULE_NUM          256
+#define BENCH_DOMAIN_CACHE_FILL         4096
+#define BENCH_HOTPATH_FILL              32768
+#define BENCH_PRE_CACHE_FILL            32768
+
+#define BENCH_PKT_MAX_LEN               512
+#define BENCH_DNS_PORT                  53
+#define BENCH_CLIENT_PORT               40000
+/* DNS 头部中的 RD 标志，标准查询 */
+#define BENCH_DNS_FLAGS_RD              0x0100
+#define BENCH_TCP_FLAG_PSH_ACK          0x18
+
+#define BENCH_NSEC_PER_SEC              1000000000ULL
+
+/* 场景中使用的地址与域名 */
+#define BENCH_CLIENT_ADDR               "192.168.1.100"
+#define BENCH_DOMAIN_CACHE_HIT          "www.bench-cache.com"
+#define BENCH_DOMAIN_LPM_HIT            "www.bench-rule.com"
+#define BENCH_DOMAIN_LPM_RULE           "bench-rule.com"
+#define BENCH_DOMAIN_MISS               "www.bench-miss.org"
+/* 接近 DOMAIN_MAX_LEN 的长域名，后缀命中规则 */
+#define BENCH_DOMAIN_LONG               "a1234567890.b1234567890.c1234567890.d12345678.bench-rule.com"
+#define BENCH_ADDR_HOTPATH              "1.1.1.1"
+#define BENCH_ADDR_PRE_CACHE            "1.1.1.2"
+#define BENCH_ADDR_LPM_HIT              "1.1.1.3"
+#define BENCH_ADDR_MISS                 "8.8.8.8"
+#define BENCH_ADDR_BLKLIST              "1.1.1.4"
+#define BENCH_PREFIX_DIRECT             "1.1.1.0/24"
+
+typedef struct {
+    __u8 data[BENCH_PKT_MAX_LEN];
+    __u32 len;
+} bench_pkt_t;
+
+typedef struct {
+    struct bpf_object *obj;
+    int prog_fd;
+} bench_prog_t;
+
+typedef struct bench_scene bench_scene_t;
+
+struct bench_scene {
+    const char *name;
+    bench_prog_t *prog;
+    bench_pkt_t pkt;
+    /* 有状态场景每次运行前恢复 map 状态，无状态场景为 NULL */
+    bool (*prepare)(const bench_scene_t *scene);
+    /* prepare 使用的 map 与 key */
+    int map_fd;
+    __u8 key[sizeof(domain_lpm_key_t)];
+};
+
+static bench_prog_t xdp_prog;
+static bench_prog_t tc_prog;
+
+static __u64 ktime_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (__u64)ts.tv_sec * BENCH_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static __u32 bench_addr(const char *str) {
+    struct in_addr addr;
+    inet_pton(AF_INET, str, &addr);
+    return addr.s_addr;
+}
+
+static int bench_map_fd(const bench_prog_t *prog, const char *name) {
+    struct bpf_map *map = bpf_object__find_map_by_name(prog->obj, name);
+    if (NULL == map) {
+        fprintf(stderr, "[ERROR] 对象中没有 map %s\n", name);
+        return -1;
+    }
+
+    return bpf_map__fd(map);
+}
+
+/* 打开并加载对象，map 由 libbpf 按对象中的定义新建 */
+static bool bench_prog_load(bench_prog_t *prog, const char *file) {
+    prog->obj = bpf_object__open_file(file, NULL);
+    if (libbpf_get_error(prog->obj)) {
+        fprintf(stderr, "[ERROR] 无法打开 %s\n", file);
+        prog->obj = NULL;
+        return false;
+    }
+
+    if (bpf_object__load(prog->obj)) {
+        fprintf(stderr, "[ERROR] 无法加载 %s: %s\n", file, strerror(errno));
+        return false;
+    }
+
+    struct bpf_program *p = bpf_object__next_program(prog->obj, NULL);
+    prog->prog_fd = p ? bpf_program__fd(p) : -1;
+    return prog->prog_fd >= 0;
+}
+
+static __u32 bench_pkt_ip(bench_pkt_t *pkt, __u8 protocol, __u32 saddr, __u32 daddr) {
+    memset(pkt, 0, sizeof(*pkt));
+
+    struct ethhdr *eth = (struct ethhdr *)pkt->data;
+    eth->h_proto = htons(ETH_P_IP);
+
+    struct iphdr *ip = (struct iphdr *)(eth + 1);
+    ip->version = 4;
+    ip->ihl = sizeof(struct iphdr) / 4;
+    ip->ttl = 64;
+    ip->protocol = protocol;
+    ip->saddr = saddr;
+    ip->daddr = daddr;
+
+    return sizeof(struct ethhdr) + sizeof(struct iphdr);
+}
+
+static void bench_pkt_ip_finish(bench_pkt_t *pkt, __u32 len) {
+    struct iphdr *ip = (struct iphdr *)(pkt->data + sizeof(struct ethhdr));
+    ip->tot_len = htons(len - sizeof(struct ethhdr));
+    pkt->len = len;
+}
+
+/* 写入 DNS 查询报文，返回长度 */
+static __u32 bench_dns_query(__u8 *buf, const char *domain) {
+    __u16 *hdr = (__u16 *)buf;
+    hdr[0] = htons(0x1234);
+    hdr[1] = htons(BENCH_DNS_FLAGS_RD);
+    hdr[2] = htons(1);
+
+    __u32 off = 12;
+    const char *label = domain;
+    while (*label) {
+        const char *dot = strchr(label, '.');
+        __u32 len = dot ? (__u32)(dot - label) : strlen(label);
+        buf[off++] = len;
+        memcpy(buf + off, label, len);
+        off += len;
+        label += len + (dot ? 1 : 0);
+    }
+
+    buf[off++] = 0;
+    /* QTYPE A，QCLASS IN */
+    *(__u16 *)(buf + off) = htons(1);
+    *(__u16 *)(buf + off + 2) = htons(1);
+
+    return off + 4;
+}
+
+static void bench_pkt_dns_udp(bench_pkt_t *pkt, const char *domain, __u32 saddr, __u32 daddr) {
+    __u32 off = bench_pkt_ip(pkt, IPPROTO_UDP, saddr, daddr);
+
+    struct udphdr *udp = (struct udphdr *)(pkt->data + off);
+    udp->source = htons(BENCH_CLIENT_PORT);
+    udp->dest = htons(BENCH_DNS_PORT);
+
+    __u32 dns_len = bench_dns_query((__u8 *)(udp + 1), domain);
+    udp->len = htons(sizeof(*udp) + dns_len);
+
+    bench_pkt_ip_finish(pkt, off + sizeof(*udp) + dns_len);
+}
+
+static void bench_pkt_dns_tcp(bench_pkt_t *pkt, const char *domain, __u32 saddr, __u32 daddr) {
+    __u32 off = bench_pkt_ip(pkt, IPPROTO_TCP, saddr, daddr);
+
+    struct tcphdr *tcp = (struct tcphdr *)(pkt->data + off);
+    tcp->source = htons(BENCH_CLIENT_PORT);
+    tcp->dest = htons(BENCH_DNS_PORT);
+    tcp->doff = sizeof(*tcp) / 4;
+    ((__u8 *)tcp)[13] = BENCH_TCP_FLAG_PSH_ACK;
+
+    /* TCP DNS 报文前有两个字节的长度 */
+    __u8 *payload = (__u8 *)(tcp + 1);
+    __u32 dns_len = bench_dns_query(payload + 2, domain);
+    *(__u16 *)payload = htons(dns_len);
+
+    bench_pkt_ip_finish(pkt, off + sizeof(*tcp) + 2 + dns_len);
+}
+
+/* 外网回程的普通 UDP 报文 */
+static void bench_pkt_udp(bench_pkt_t *pkt, __u32 saddr, __u32 daddr) {
+    __u32 off = bench_pkt_ip(pkt, IPPROTO_UDP, saddr, daddr);
+
+    struct udphdr *udp = (struct udphdr *)(pkt->data + off);
+    udp->source = htons(443);
+    udp->dest = htons(BENCH_CLIENT_PORT);
+    udp->len = htons(sizeof(*udp) + 64);
+
+    bench_pkt_ip_finish(pkt, off + sizeof(*udp) + 64);
+}
+
+static bool bench_fill_domain(void) {
+    int map_fd = bench_map_fd(&xdp_prog, DOMAIN_MAPNAME);
+    int bloom_fd = bench_map_fd(&xdp_prog, DOMAINBLOOM_MAPNAME);
+    int cache_fd = bench_map_fd(&xdp_prog, DOMAINCACHE_MAPNAME);
+    if (map_fd < 0 || bloom_fd < 0 || cache_fd < 0) return false;
+
+    domain_rule_set_t rules = {0};
+    domain_lpm_key_t key;
+    char domain[FILE_LINE_MAXLEN];
+
+    for (__u32 i = 0; i < BENCH_DOMAIN_RULE_NUM; i++) {
+        snprintf(domain, sizeof(domain), "site%u.example%u.com", i, i % 97);
+        memset(&key, 0, sizeof(key));
+        if (domain_encode_and_reverse(domain, &key)) domain_rule_set_add(&rules, &key, ACTION_DIRECT);
+    }
+
+    memset(&key, 0, sizeof(key));
+    if (domain_encode_and_reverse(BENCH_DOMAIN_LPM_RULE, &key)) domain_rule_set_add(&rules, &key, ACTION_DIRECT);
+
+    size_t dup = 0, shadowed = 0;
+    domain_rule_set_prune(&rules, &dup, &shadowed);
+
+    int ret = domain_rule_set_write(map_fd, bloom_fd, &rules);
+    domain_rule_set_free(&rules);
+    if (ret) return false;
+
+    /* 域名缓存中放入其他常见域名，以及缓存命中场景的域名 */
+    domain_cache_val_t val = {.hits = 1, .action = ACTION_DIRECT};
+    for (__u32 i = 0; i < BENCH_DOMAIN_CACHE_FILL; i++) {
+        snprintf(domain, sizeof(domain), "www.cached%u.com", i);
+        memset(&key, 0, sizeof(key));
+        if (domain_encode_and_reverse(domain, &key)) bpf_map_update_elem(cache_fd, &key, &val, BPF_ANY);
+    }
+
+    memset(&key, 0, sizeof(key));
+    if (!domain_encode_and_reverse(BENCH_DOMAIN_CACHE_HIT, &key)) return false;
+    return 0 == bpf_map_update_elem(cache_fd, &key, &val, BPF_ANY);
+}
+
+/* xorshift，固定种子保证多次运行可比，rand() 在 glibc 上只有 31 位，无法覆盖整个地址段 */
+static __u32 bench_rand_state = 0x9E3779B9;
+static __always_inline __u32 bench_rand(void) {
+    __u32 x = bench_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return bench_rand_state = x;
+}
+
+static bool bench_fill_ip(void) {
+    int direct_fd = bench_map_fd(&tc_prog, DIRECT_MAPNAME);
+    int blk_fd = bench_map_fd(&tc_prog, BLKLIST_MAPNAME);
+    int bloom_fd = bench_map_fd(&tc_prog, BLKLISTBLOOM_MAPNAME);
+    int config_fd = bench_map_fd(&tc_prog, TCCONFIG_MAPNAME);
+    int hot_fd = bench_map_fd(&tc_prog, HOTPATH_MAPNAME);
+    int pre_fd = bench_map_fd(&tc_prog, PRE_MAPNAME);
+    if (direct_fd < 0 || blk_fd < 0 || bloom_fd < 0 || config_fd < 0 || hot_fd < 0 || pre_fd < 0) return false;
+
+    /* 国内 IP 库: 分散在 36.0.0.0 - 223.0.0.0 的 /16 - /24 前缀 */
+    __u32 action = ACTION_DIRECT;
+    for (__u32 i = 0; i < BENCH_IP_RULE_NUM; i++) {
+        ip_lpm_key_t key = {.prefixlen = 16 + bench_rand() % 9};
+        __u32 addr = (36U << 24) + bench_rand() % (187U << 24);
+        key.ipv4 = htonl(addr & (~0U << (32 - key.prefixlen)));
+        bpf_map_update_elem(direct_fd, &key, &action, BPF_ANY);
+    }
+
+    ip_lpm_key_t key = {.prefixlen = 24, .ipv4 = bench_addr(BENCH_PREFIX_DIRECT)};
+    if (bpf_map_update_elem(direct_fd, &key, &action, BPF_ANY)) return false;
+
+    /* 黑名单: /32 主机，先写 Bloom 与前缀长度掩码 */
+    tc_config_t cfg = {.blk_prefix_mask = 1ULL << 32};
+    __u32 zero = 0;
+    if (bpf_map_update_elem(config_fd, &zero, &cfg, BPF_ANY)) return false;
+
+    for (__u32 i = 0; i <= BENCH_BLKLIST_RULE_NUM; i++) {
+        ip_lpm_key_t blk = {.prefixlen = 32, .ipv4 = htonl((100U << 24) + i)};
+        if (BENCH_BLKLIST_RULE_NUM == i) blk.ipv4 = bench_addr(BENCH_ADDR_BLKLIST);
+
+        bpf_map_update_elem(bloom_fd, NULL, &blk, BPF_ANY);
+        bpf_map_update_elem(blk_fd, &blk, &action, BPF_ANY);
+    }
+
+    /* 缓存: 其他地址 + 场景地址 */
+    __u64 now = ktime_now();
+    hotpath_val_t hot = {.update_time = now, .action = ACTION_DIRECT};
+    pre_val_t pre = {.first_seen = now, .count = 1, .action = ACTION_DIRECT};
+    for (__u32 i = 0; i < BENCH_HOTPATH_FILL; i++) {
+        __u32 addr = htonl((110U << 24) + i);
+        bpf_map_update_elem(hot_fd, &addr, &hot, BPF_ANY);
+    }
+    for (__u32 i = 0; i < BENCH_PRE_CACHE_FILL; i++) {
+        __u32 addr = htonl((111U << 24) + i);
+        bpf_map_update_elem(pre_fd, &addr, &pre, BPF_ANY);
+    }
+
+    __u32 addr = bench_addr(BENCH_ADDR_HOTPATH);
+    if (bpf_map_update_elem(hot_fd, &addr, &hot, BPF_ANY)) return false;
+
+    addr = bench_addr(BENCH_ADDR_PRE_CACHE);
+    return 0 == bpf_map_update_elem(pre_fd, &addr, &pre, BPF_ANY);
+}
+
+/* 删除缓存项，使下一次运行重新经过 LPM */
+static bool bench_prepare_delete(const bench_scene_t *scene) {
+    bpf_map_delete_elem(scene->map_fd, scene->key);
+    return true;
+}
+
+/* 预缓存项已满足晋升条件，晋升前复核黑名单 */
+static bool bench_prepare_blklist(const bench_scene_t *scene) {
+    pre_val_t pre = {.first_seen = 0, .count = HOTPKG_NUM, .action = ACTION_DIRECT};
+    return 0 == bpf_map_update_elem(scene->map_fd, scene->key, &pre, BPF_ANY);
+}
+
+/* 运行一次 test run，返回平均每包耗时 (ns) */
+static bool bench_test_run(const bench_scene_t *scene, __u32 repeat, __u32 *duration, char *verdict, size_t size) {
+    bench_pkt_t out;
+    struct __sk_buff skb;
+    memset(&skb, 0, sizeof(skb));
+
+    LIBBPF_OPTS(bpf_test_run_opts, opts,
+        .data_in = scene->pkt.data,
+        .data_size_in = scene->pkt.len,
+        .data_out = out.data,
+        .data_size_out = sizeof(out.data),
+        .repeat = repeat,
+    );
+
+    if (scene->prog == &tc_prog) {
+        opts.ctx_in = &skb;
+        opts.ctx_size_in = sizeof(skb);
+        opts.ctx_out = &skb;
+        opts.ctx_size_out = sizeof(skb);
+    }
+
+    if (bpf_prog_test_run_opts(scene->prog->prog_fd, &opts)) {
+        fprintf(stderr, "[ERROR] %s test run 失败: %s\n", scene->name, strerror(errno));
+        return false;
+    }
+
+    *duration = opts.duration;
+
+    /* XDP 输出改写后的目的端口，TC 输出 skb->mark */
+    if (scene->prog == &xdp_prog) {
+        const struct iphdr *ip = (const struct iphdr *)(out.data + sizeof(struct ethhdr));
+        const __u16 *ports = (const __u16 *)((const __u8 *)ip + ip->ihl * 4);
+        snprintf(verdict, size, "ret=%u dport=%u", opts.retval, ntohs(ports[1]));
+    } else {
+        snprintf(verdict, size, "ret=%u mark=0x%x", opts.retval, skb.mark);
+    }
+
+    return true;
+}
+
+static bool bench_scene_run(const bench_scene_t *scene, __u32 repeat) {
+    char verdict[64] = {0};
+    double ns = 0;
+
+    if (NULL == scene->prepare) {
+        __u32 duration = 0;
+        if (!bench_test_run(scene, repeat, &duration, verdict, sizeof(verdict))) return false;
+        ns = duration;
+    } else {
+        __u64 total = 0;
+        for (__u32 i = 0; i < BENCH_COLD_NUM; i++) {
+            __u32 duration = 0;
+            if (!scene->prepare(scene) || !bench_test_run(scene, 1, &duration, verdict, sizeof(verdict))) return false;
+            total += duration;
+        }
+        ns = (double)total / BENCH_COLD_NUM;
+    }
+
+    printf("%-24s %12.1f  %s\n", scene->name, ns, verdict);
+    return true;
+}
+
+static int bench_run(__u32 repeat) {
+    __u32 client = bench_addr(BENCH_CLIENT_ADDR);
+    __u32 resolver = bench_addr("192.168.1.1");
+    bench_scene_t scenes[10];
+    __u32 num = 0;
+    memset(scenes, 0, sizeof(scenes));
+
+    /* XDP: DNS 查询 */
+    bench_scene_t *s = &scenes[num++];
+    s->name = "xdp cache hit";
+    s->prog = &xdp_prog;
+    bench_pkt_dns_udp(&s->pkt, BENCH_DOMAIN_CACHE_HIT, client, resolver);
+
+    s = &scenes[num++];
+    s->name = "xdp lpm hit";
+    s->prog = &xdp_prog;
+    s->prepare = bench_prepare_delete;
+    s->map_fd = bench_map_fd(&xdp_prog, DOMAINCACHE_MAPNAME);
+    domain_encode_and_reverse(BENCH_DOMAIN_LPM_HIT, (domain_lpm_key_t *)s->key);
+    bench_pkt_dns_udp(&s->pkt, BENCH_DOMAIN_LPM_HIT, client, resolver);
+
+    s = &scenes[num++];
+    s->name = "xdp miss";
+    s->prog = &xdp_prog;
+    bench_pkt_dns_udp(&s->pkt, BENCH_DOMAIN_MISS, client, resolver);
+
+    s = &scenes[num++];
+    s->name = "xdp long name lpm hit";
+    s->prog = &xdp_prog;
+    s->prepare = bench_prepare_delete;
+    s->map_fd = bench_map_fd(&xdp_prog, DOMAINCACHE_MAPNAME);
+    domain_encode_and_reverse(BENCH_DOMAIN_LONG, (domain_lpm_key_t *)s->key);
+    bench_pkt_dns_udp(&s->pkt, BENCH_DOMAIN_LONG, client, resolver);
+
+    s = &scenes[num++];
+    s->name = "xdp tcp cache hit";
+    s->prog = &xdp_prog;
+    bench_pkt_dns_tcp(&s->pkt, BENCH_DOMAIN_CACHE_HIT, client, resolver);
+
+    /* TC: 外网回程报文，按源地址分流 */
+    s = &scenes[num++];
+    s->name = "tc hotpath hit";
+    s->prog = &tc_prog;
+    bench_pkt_udp(&s->pkt, bench_addr(BENCH_ADDR_HOTPATH), client);
+
+    s = &scenes[num++];
+    s->name = "tc pre_cache hit";
+    s->prog = &tc_prog;
+    bench_pkt_udp(&s->pkt, bench_addr(BENCH_ADDR_PRE_CACHE), client);
+
+    __u32 addr = bench_addr(BENCH_ADDR_LPM_HIT);
+    s = &scenes[num++];
+    s->name = "tc lpm hit";
+    s->prog = &tc_prog;
+    s->prepare = bench_prepare_delete;
+    s->map_fd = bench_map_fd(&tc_prog, PRE_MAPNAME);
+    memcpy(s->key, &addr, sizeof(addr));
+    bench_pkt_udp(&s->pkt, addr, client);
+
+    s = &scenes[num++];
+    s->name = "tc miss";
+    s->prog = &tc_prog;
+    bench_pkt_udp(&s->pkt, bench_addr(BENCH_ADDR_MISS), client);
+
+    addr = bench_addr(BENCH_ADDR_BLKLIST);
+    s = &scenes[num++];
+    s->name = "tc blacklisted";
+    s->prog = &tc_prog;
+    s->prepare = bench_prepare_blklist;
+    s->map_fd = bench_map_fd(&tc_prog, PRE_MAPNAME);
+    memcpy(s->key, &addr, sizeof(addr));
+    bench_pkt_udp(&s->pkt, addr, client);
+
+    printf("%-24s %12s  %s\n", "scene", "ns/packet", "result");
+    for (__u32 i = 0; i < num; i++) {
+        if (!bench_scene_run(&scenes[i], repeat)) return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    __u32 repeat = BENCH_REPEAT_NUM;
+    const char *xdp_file = XDP_BPF_OBJ;
+    const char *tc_file = TC_BPF_OBJ;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if ('n' == opt) repeat = strtoul(optarg, NULL, 10);
+        else {
+            fprintf(stderr, "Usage: %s [-n repeat] [xdp_direct_path.o] [tc_direct_path.o]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind < argc) xdp_file = argv[optind++];
+    if (optind < argc) tc_file = argv[optind++];
+
+#if DIRECT_IP_ENGINE != DIRECT_IP_ENGINE_LPM || DOMAIN_ENGINE != DOMAIN_ENGINE_LPM
+    fprintf(stderr, "[ERROR] 仅支持 lpm 查询引擎\n");
+    return 1;
+#endif
+
+    if (!bench_prog_load(&xdp_prog, xdp_file) || !bench_prog_load(&tc_prog, tc_file)) return 1;
+
+    printf("[INFO] 填充规则: 域名 %u 条，IP %u 条，黑名单 %u 条\n",
+        BENCH_DOMAIN_RULE_NUM, BENCH_IP_RULE_NUM, BENCH_BLKLIST_RULE_NUM);
+    if (!bench_fill_domain() || !bench_fill_ip()) {
+        fprintf(stderr, "[ERROR] 填充 map 失败: %s\n", strerror(errno));
+        return 1;
+    }
+
+    int ret = bench_run(repeat);
+
+    bpf_object__close(xdp_prog.obj);
+    bpf_object__close(tc_prog.obj);
+    return ret;
+}
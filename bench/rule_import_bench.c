@@ -0,0 +1,106 @@
+/*
+ * File     : rule_import_bench.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-30 14:02:51
+*/
+
+/*
+ * 规则文件导入对比: 文本 vs gzip vs zstd
+ * 每个文件在独立子进程中解析 (与 rule 导入相同的收集路径，不写 map)，
+ * 统计解析耗时与子进程峰值 RSS；文件大小即部署时在 /tmp (tmpfs) 中占用的内存。
+ * 用法: rule_import_bench [domain/ip] [file1] [file2] ...
+ * 例如: rule_import_bench domain ChinaMax.yml ChinaMax.yml.gz ChinaMax.yml.zst
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+
+#define BENCH_ARGS_MIN_NUM              3
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* 子进程: 解析一个规则文件，通过管道返回规则数与耗时 */
+static void bench_child(const char *import_type, char *file, int fd) {
+    import_rules_t rules;
+    memset(&rules, 0, sizeof(rules));
+
+    /* 屏蔽导入过程的逐文件输出 */
+    if (NULL == freopen("/dev/null", "w", stdout)) _exit(1);
+
+    double start = now_ms();
+    int ret = import_rules_collect(import_type, &file, 1, ACTION_DIRECT, &rules);
+    double cost = now_ms() - start;
+
+    size_t num = rules.ip.num + rules.domain.num + rules.keyword.num;
+    import_rules_free(&rules);
+
+    if (sizeof(num) != write(fd, &num, sizeof(num)) || sizeof(cost) != write(fd, &cost, sizeof(cost))) _exit(1);
+    _exit(ret ? 1 : 0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < BENCH_ARGS_MIN_NUM) {
+        fprintf(stderr, "Usage: %s [domain/ip] [file1] [file2] ...\n", argv[0]);
+        return 1;
+    }
+
+    const char *import_type = argv[1];
+    printf("%-40s %12s %10s %10s %14s\n", "file", "file KB", "rules", "ms", "peak RSS KB");
+
+    for (int i = 2; i < argc; i++) {
+        struct stat st;
+        if (stat(argv[i], &st)) {
+            fprintf(stderr, "[ERROR] 无法访问 %s\n", argv[i]);
+            continue;
+        }
+
+        int pipefd[2];
+        if (pipe(pipefd)) return 1;
+
+        /* 子进程会重定向 stdout，先刷新避免缓冲区内容重复输出 */
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) return 1;
+        if (0 == pid) {
+            close(pipefd[0]);
+            bench_child(import_type, argv[i], pipefd[1]);
+        }
+
+        close(pipefd[1]);
+
+        size_t num = 0;
+        double cost = 0;
+        bool ok = (sizeof(num) == read(pipefd[0], &num, sizeof(num))) &&
+            (sizeof(cost) == read(pipefd[0], &cost, sizeof(cost)));
+        close(pipefd[0]);
+
+        int status = 0;
+        struct rusage usage;
+        memset(&usage, 0, sizeof(usage));
+        wait4(pid, &status, 0, &usage);
+
+        if (!ok || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            fprintf(stderr, "[ERROR] %s 解析失败\n", argv[i]);
+            continue;
+        }
+
+        printf("%-40s %12lld %10zu %10.1f %14ld\n", argv[i], (long long)st.st_size / 1024, num, cost, usage.ru_maxrss);
+    }
+
+    return 0;
+}
@@ -0,0 +1,412 @@
+/*
+ * File     : verifier_stats.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-19 15:06:33
+*/
+
+/*
+ * 校验器复杂度报告
+ * 以 BPF_LOG_STATS 日志级别加载 bpf 目录编译出的对象 (map 由 libbpf 新建，不影响正在运行的实例)，
+ * 输出每个程序的校验指令数、状态数、xlated/JIT 大小与栈深度。
+ * 指定基线文件时与基线比较，任一指标增长超过阈值，或指令数、栈深度超过校验器上限的给定比例时返回失败，
+ * 用于在修改解析逻辑 (如 DOMAIN_MAX_LEN) 时度量校验器预算。
+ * 用法: verifier_stats [-b baseline] [-u] [-g growth%] [-l limit%] [-D rodata=value] obj...
+ * 需要 root 权限，结果与内核版本相关，基线应在同一台机器上生成。
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <bpf/btf.h>
+
+/* 只输出统计信息的日志级别 */
+#define VSTATS_LOG_LEVEL                4
+/* 日志缓冲区，加载失败时保存完整的校验日志 */
+#define VSTATS_LOG_SIZE                 (16U << 20)
+/* 加载失败时输出日志末尾的字节数 */
+#define VSTATS_LOG_TAIL                 4096
+
+/* 校验器上限: 单个程序处理的指令数与栈深度 */
+#define VSTATS_INSN_LIMIT               1000000
+#define VSTATS_STACK_LIMIT              512
+
+/* 默认阈值: 相对基线的增长比例，占校验器上限的比例 */
+#define VSTATS_DEFAULT_GROWTH_PCT       10
+#define VSTATS_DEFAULT_LIMIT_PCT        80
+
+#define VSTATS_PROG_MAX                 16
+#define VSTATS_RODATA_MAX               8
+#define VSTATS_NAME_MAXLEN              64
+#define VSTATS_LINE_MAXLEN              256
+
+/* 指标，下标与 vstats_metric_names 一致 */
+#define VSTATS_INSNS                    0
+#define VSTATS_STATES                   1
+#define VSTATS_PEAK_STATES              2
+#define VSTATS_XLATED                   3
+#define VSTATS_JITED                    4
+#define VSTATS_STACK                    5
+#define VSTATS_METRIC_NUM               6
+
+static const char *vstats_metric_names[VSTATS_METRIC_NUM] = {
+    [VSTATS_INSNS]       = "insns",
+    [VSTATS_STATES]      = "states",
+    [VSTATS_PEAK_STATES] = "peak",
+    [VSTATS_XLATED]      = "xlated",
+    [VSTATS_JITED]       = "jited",
+    [VSTATS_STACK]       = "stack",
+};
+
+typedef struct {
+    char name[VSTATS_NAME_MAXLEN];
+    __u64 metric[VSTATS_METRIC_NUM];
+    /* 校验耗时 (us)，受机器负载影响，只输出不比较 */
+    __u64 verify_us;
+} vstats_prog_t;
+
+typedef struct {
+    vstats_prog_t progs[VSTATS_PROG_MAX];
+    __u32 num;
+} vstats_set_t;
+
+typedef struct {
+    const char *name;
+    __u64 value;
+} vstats_rodata_t;
+
+static vstats_rodata_t rodata_list[VSTATS_RODATA_MAX];
+static __u32 rodata_num;
+
+/* 按 BTF 中 .rodata 段的变量信息修改初值，按小端序截取变量大小 */
+static bool vstats_rodata_apply(struct bpf_object *obj) {
+    struct bpf_map *map = bpf_object__find_map_by_name(obj, ".rodata");
+    struct btf *btf = bpf_object__btf(obj);
+    if (0 == rodata_num) return true;
+    if (NULL == map || NULL == btf) return false;
+
+    int sec_id = btf__find_by_name_kind(btf, ".rodata", BTF_KIND_DATASEC);
+    if (sec_id < 0) return false;
+
+    size_t data_size = 0;
+    char *data = bpf_map__initial_value(map, &data_size);
+    if (NULL == data) return false;
+
+    const struct btf_type *sec = btf__type_by_id(btf, sec_id);
+    const struct btf_var_secinfo *vars = btf_var_secinfos(sec);
+    for (__u32 r = 0; r < rodata_num; r++) {
+        for (__u32 i = 0; i < btf_vlen(sec); i++) {
+            const struct btf_type *var = btf__type_by_id(btf, vars[i].type);
+            if (strcmp(btf__name_by_offset(btf, var->name_off), rodata_list[r].name)) continue;
+            if (vars[i].size > sizeof(__u64) || vars[i].offset + vars[i].size > data_size) return false;
+
+            memcpy(data + vars[i].offset, &rodata_list[r].value, vars[i].size);
+        }
+    }
+
+    return true;
+}
+
+/* 从统计日志中取出 "key N"，栈深度为各子程序之和 "stack depth 64+32" */
+static __u64 vstats_log_value(const char *log, const char *key) {
+    const char *pos = strstr(log, key);
+    if (NULL == pos) return 0;
+
+    pos += strlen(key);
+    __u64 sum = 0;
+    char *end = NULL;
+    do {
+        sum += strtoull(pos, &end, 10);
+        pos = end + 1;
+    } while ('+' == *end);
+
+    return sum;
+}
+
+static bool vstats_prog_collect(struct bpf_program *prog, const char *log, vstats_prog_t *out) {
+    snprintf(out->name, sizeof(out->name), "%s", bpf_program__name(prog));
+
+    struct bpf_prog_info info;
+    __u32 info_len = sizeof(info);
+    memset(&info, 0, sizeof(info));
+    if (bpf_prog_get_info_by_fd(bpf_program__fd(prog), &info, &info_len)) return false;
+
+    out->metric[VSTATS_INSNS] = vstats_log_value(log, "processed ");
+    out->metric[VSTATS_STATES] = vstats_log_value(log, "total_states ");
+    out->metric[VSTATS_PEAK_STATES] = vstats_log_value(log, "peak_states ");
+    out->metric[VSTATS_XLATED] = info.xlated_prog_len;
+    out->metric[VSTATS_JITED] = info.jited_prog_len;
+    out->metric[VSTATS_STACK] = vstats_log_value(log, "stack depth ");
+    out->verify_us = vstats_log_value(log, "verification time ");
+
+    /* 旧内核不输出统计日志时使用 prog_info 中的校验指令数 */
+    if (0 == out->metric[VSTATS_INSNS]) out->metric[VSTATS_INSNS] = info.verified_insns;
+    return true;
+}
+
+/* 加载对象，每个程序使用独立的日志缓冲区 */
+static bool vstats_obj_load(const char *file, vstats_set_t *set) {
+    struct bpf_object *obj = bpf_object__open_file(file, NULL);
+    if (libbpf_get_error(obj)) {
+        fprintf(stderr, "[ERROR] 无法打开 %s\n", file);
+        return false;
+    }
+
+    if (!vstats_rodata_apply(obj)) {
+        fprintf(stderr, "[ERROR] %s 的 .rodata 变量设置失败\n", file);
+        bpf_object__close(obj);
+        return false;
+    }
+
+    char *logs[VSTATS_PROG_MAX] = {0};
+    struct bpf_program *prog;
+    __u32 num = 0;
+    bool ret = false;
+
+    bpf_object__for_each_program(prog, obj) {
+        if (num >= VSTATS_PROG_MAX || set->num + num >= VSTATS_PROG_MAX) goto out;
+        logs[num] = calloc(1, VSTATS_LOG_SIZE);
+        if (NULL == logs[num]) goto out;
+
+        bpf_program__set_log_level(prog, VSTATS_LOG_LEVEL);
+        bpf_program__set_log_buf(prog, logs[num], VSTATS_LOG_SIZE);
+        num++;
+    }
+
+    if (bpf_object__load(obj)) {
+        fprintf(stderr, "[ERROR] 无法加载 %s: %s\n", file, strerror(errno));
+        for (__u32 i = 0; i < num; i++) {
+            size_t len = strlen(logs[i]);
+            if (len) fprintf(stderr, "%s\n", logs[i] + (len > VSTATS_LOG_TAIL ? len - VSTATS_LOG_TAIL : 0));
+        }
+        goto out;
+    }
+
+    __u32 i = 0;
+    bpf_object__for_each_program(prog, obj) {
+        if (!vstats_prog_collect(prog, logs[i++], &set->progs[set->num])) {
+            fprintf(stderr, "[ERROR] 无法读取程序 %s 的信息: %s\n", bpf_program__name(prog), strerror(errno));
+            goto out;
+        }
+        set->num++;
+    }
+
+    ret = true;
+
+out:
+    for (__u32 j = 0; j < num; j++) free(logs[j]);
+    bpf_object__close(obj);
+    return ret;
+}
+
+static vstats_prog_t *vstats_find(vstats_set_t *set, const char *name) {
+    for (__u32 i = 0; i < set->num; i++) {
+        if (!strcmp(set->progs[i].name, name)) return &set->progs[i];
+    }
+
+    return NULL;
+}
+
+/* 基线文件每行: 程序名 insns states peak xlated jited stack，# 开头为注释 */
+static bool vstats_baseline_read(const char *file, vstats_set_t *set) {
+    FILE *fp = fopen(file, "r");
+    if (NULL == fp) return false;
+
+    char line[VSTATS_LINE_MAXLEN];
+    while (fgets(line, sizeof(line), fp) && set->num < VSTATS_PROG_MAX) {
+        if ('#' == line[0] || '\n' == line[0]) continue;
+
+        vstats_prog_t *prog = &set->progs[set->num];
+        unsigned long long m[VSTATS_METRIC_NUM];
+        if (1 + VSTATS_METRIC_NUM != sscanf(line, "%63s %llu %llu %llu %llu %llu %llu", prog->name,
+            &m[0], &m[1], &m[2], &m[3], &m[4], &m[5])) {
+            fprintf(stderr, "[ERROR] 基线文件 %s 格式错误: %s", file, line);
+            fclose(fp);
+            return false;
+        }
+
+        for (__u32 i = 0; i < VSTATS_METRIC_NUM; i++) prog->metric[i] = m[i];
+        set->num++;
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static bool vstats_baseline_write(const char *file, const vstats_set_t *set) {
+    FILE *fp = fopen(file, "w");
+    if (NULL == fp) {
+        fprintf(stderr, "[ERROR] 无法写入 %s: %s\n", file, strerror(errno));
+        return false;
+    }
+
+    fprintf(fp, "# prog");
+    for (__u32 i = 0; i < VSTATS_METRIC_NUM; i++) fprintf(fp, " %s", vstats_metric_names[i]);
+    fprintf(fp, "\n");
+
+    for (__u32 p = 0; p < set->num; p++) {
+        fprintf(fp, "%s", set->progs[p].name);
+        for (__u32 i = 0; i < VSTATS_METRIC_NUM; i++) fprintf(fp, " %llu", (unsigned long long)set->progs[p].metric[i]);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp);
+    printf("[INFO] 基线已写入 %s\n", file);
+    return true;
+}
+
+static void vstats_show(const vstats_set_t *set, vstats_set_t *base) {
+    printf("%-20s", "prog");
+    for (__u32 i = 0; i < VSTATS_METRIC_NUM; i++) printf(" | %-16s", vstats_metric_names[i]);
+    printf(" | %s\n", "time(us)");
+
+    for (__u32 p = 0; p < set->num; p++) {
+        const vstats_prog_t *prog = &set->progs[p];
+        const vstats_prog_t *old = base ? vstats_find(base, prog->name) : NULL;
+
+        printf("%-20s", prog->name);
+        for (__u32 i = 0; i < VSTATS_METRIC_NUM; i++) {
+            char cell[32];
+            if (old && old->metric[i] != prog->metric[i]) {
+                snprintf(cell, sizeof(cell), "%llu (%+lld)", (unsigned long long)prog->metric[i],
+                    (long long)(prog->metric[i] - old->metric[i]));
+            } else {
+                snprintf(cell, sizeof(cell), "%llu", (unsigned long long)prog->metric[i]);
+            }
+            printf(" | %-16s", cell);
+        }
+        printf(" | %llu\n", (unsigned long long)prog->verify_us);
+    }
+}
+
+/* 返回超出阈值的项数 */
+static __u32 vstats_check(const vstats_set_t *set, vstats_set_t *base, __u32 growth_pct, __u32 limit_pct) {
+    __u32 fail = 0;
+
+    for (__u32 p = 0; p < set->num; p++) {
+        const vstats_prog_t *prog = &set->progs[p];
+
+        if (prog->metric[VSTATS_INSNS] * 100 > (__u64)VSTATS_INSN_LIMIT * limit_pct) {
+            fprintf(stderr, "[ERROR] %s 校验指令数 %llu 超过上限 %u 的 %u%%\n", prog->name,
+                (unsigned long long)prog->metric[VSTATS_INSNS], VSTATS_INSN_LIMIT, limit_pct);
+            fail++;
+        }
+
+        if (prog->metric[VSTATS_STACK] * 100 > (__u64)VSTATS_STACK_LIMIT * limit_pct) {
+            fprintf(stderr, "[ERROR] %s 栈深度 %llu 超过上限 %u 的 %u%%\n", prog->name,
+                (unsigned long long)prog->metric[VSTATS_STACK], VSTATS_STACK_LIMIT, limit_pct);
+            fail++;
+        }
+
+        const vstats_prog_t *old = base ? vstats_find(base, prog->name) : NULL;
+        if (NULL == old) continue;
+
+        for (__u32 i = 0; i < VSTATS_METRIC_NUM; i++) {
+            /* 基线为 0 表示该项此前未采集 (如未启用 JIT)，不作比较 */
+            if (0 == old->metric[i]) continue;
+            if (prog->metric[i] * 100 <= old->metric[i] * (100 + growth_pct)) continue;
+
+            fprintf(stderr, "[ERROR] %s %s 由 %llu 增长到 %llu，超过 %u%%\n", prog->name, vstats_metric_names[i],
+                (unsigned long long)old->metric[i], (unsigned long long)prog->metric[i], growth_pct);
+            fail++;
+        }
+    }
+
+    return fail;
+}
+
+static bool vstats_rodata_parse(char *arg) {
+    char *sep = strchr(arg, '=');
+    if (NULL == sep || rodata_num >= VSTATS_RODATA_MAX) return false;
+
+    *sep = '\0';
+    char *end = NULL;
+    rodata_list[rodata_num].name = arg;
+    rodata_list[rodata_num].value = strtoull(sep + 1, &end, 0);
+    if (end == sep + 1 || *end) return false;
+
+    rodata_num++;
+    return true;
+}
+
+/* 解析百分比参数，拒绝空串、符号、多余字符与溢出 */
+static bool vstats_pct_parse(const char *arg, __u32 *pct) {
+    if (NULL == arg || *arg < '0' || *arg > '9') return false;
+
+    char *end = NULL;
+    errno = 0;
+    unsigned long val = strtoul(arg, &end, 10);
+    if (end == arg || *end || ERANGE == errno || val != (__u32)val) return false;
+
+    *pct = (__u32)val;
+    return true;
+}
+
+static void vstats_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-b baseline] [-u] [-g growth%%] [-l limit%%] [-D rodata=value] obj...\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *baseline = NULL;
+    bool update = false;
+    __u32 growth_pct = VSTATS_DEFAULT_GROWTH_PCT;
+    __u32 limit_pct = VSTATS_DEFAULT_LIMIT_PCT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:ug:l:D:")) != -1) {
+        switch (opt) {
+            case 'b': baseline = optarg; break;
+            case 'u': update = true; break;
+            case 'g':
+                if (vstats_pct_parse(optarg, &growth_pct)) break;
+                vstats_usage(argv[0]);
+                return 1;
+            case 'l':
+                if (vstats_pct_parse(optarg, &limit_pct)) break;
+                vstats_usage(argv[0]);
+                return 1;
+            case 'D':
+                if (vstats_rodata_parse(optarg)) break;
+                /* fall through */
+            default:
+                vstats_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind >= argc || (update && NULL == baseline)) {
+        vstats_usage(argv[0]);
+        return 1;
+    }
+
+    static vstats_set_t set, base;
+    for (int i = optind; i < argc; i++) {
+        if (!vstats_obj_load(argv[i], &set)) return 1;
+    }
+
+    if (update) {
+        vstats_show(&set, NULL);
+        return vstats_baseline_write(baseline, &set) ? 0 : 1;
+    }
+
+    bool has_base = baseline && vstats_baseline_read(baseline, &base);
+    if (baseline && !has_base && ENOENT == errno)
+        printf("[INFO] 基线 %s 不存在，只检查校验器上限，可用 -u 生成\n", baseline);
+    else if (baseline && !has_base) return 1;
+
+    vstats_show(&set, has_base ? &base : NULL);
+
+    __u32 fail = vstats_check(&set, has_base ? &base : NULL, growth_pct, limit_pct);
+    if (fail) {
+        fprintf(stderr, "[ERROR] %u 项超出阈值\n", fail);
+        return 1;
+    }
+
+    printf("[INFO] 校验器预算检查通过\n");
+    return 0;
+}
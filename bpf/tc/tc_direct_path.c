@@ -21,6 +21,44 @@ blklist_ip_map_t blklist_ip_map SEC(".maps");
 /* 国内 IP 白名单 (LPM) */
 direct_ip_map_t direct_ip_map SEC(".maps");
 
+#if DIRECT_IP_ENGINE == DIRECT_IP_ENGINE_DIR24
+/* 国内 IP 白名单 DIR-24-8 数组 */
+direct_ip_dir24_t direct_ip_dir24 SEC(".maps");
+
+/* 国内 IP 白名单 DIR-24-8 溢出表 */
+direct_ip_overflow_t direct_ip_ovf SEC(".maps");
+#endif
+
+/* 黑名单 Bloom 过滤器 */
+blklist_bloom_t blklist_bloom SEC(".maps");
+
+/* TC 运行时配置 */
+tc_config_map_t tc_config SEC(".maps");
+
+/* TC 统计计数 */
+tc_stats_t tc_stats SEC(".maps");
+
+/* 事件流 */
+trace_ringbuf_t trace_ringbuf SEC(".maps");
+trace_config_map_t trace_config SEC(".maps");
+
+/* 分阶段耗时分布 */
+profile_hist_t profile_hist SEC(".maps");
+
+/* 加载时由用户态按配置文件写入，校验器视为常量 */
+const volatile __u16 cfg_direct_dns_port = DIRECT_DNS_SERVER_PORT;
+const volatile __u16 cfg_proxy_dns_port = PROXY_DNS_SERVER_PORT;
+const volatile __u32 cfg_direct_mark = DIRECT_MARK;
+const volatile __u32 cfg_hotpkg_num = HOTPKG_NUM;
+const volatile __u64 cfg_hotpkg_inv_time = HOTPKG_INV_TIME;
+const volatile __u32 cfg_profile = 0;
+
+/* DNS 解析器池 */
+dns_pool_map_t dns_pool_map SEC(".maps");
+
+/* 策略动作表 */
+action_map_t action_map SEC(".maps");
+
 
 /* 私网检查函数 */
 static __always_inline int is_private_ip(__u32 ip) {
@@ -31,66 +69,192 @@ static __always_inline int is_private_ip(__u32 ip) {
     return 0;
 }
 
-/* 查找Map */
-static __always_inline int do_lookup_map(__u32 *addr) {
-    if (unlikely(NULL == addr)) return 0;
+/* 统计计数递增 */
+static __always_inline void tc_stat_inc(__u32 idx) {
+    __u64 *count = bpf_map_lookup_elem(&tc_stats, &idx);
+    if (count) (*count)++;
+}
 
-    ip_lpm_key_t key = {.prefixlen = 32, .ipv4 = *addr};
+/* 阶段计时开始，未开启 profile 时整段被校验器裁剪 */
+static __always_inline __u64 tc_profile_start(void) {
+    return cfg_profile ? bpf_ktime_get_ns() : 0;
+}
+
+/* 阶段计时结束，耗时计入该阶段的分布 */
+static __always_inline void tc_profile_end(__u32 stage, __u64 start) {
+    if (!cfg_profile) return ;
+
+    __u32 idx = stage * PROFILE_HIST_SLOTS + profile_slot(bpf_ktime_get_ns() - start);
+    __u64 *count = bpf_map_lookup_elem(&profile_hist, &idx);
+    if (count) (*count)++;
+}
+
+/* 按黑名单中出现过的前缀长度逐个探测 Bloom，可能命中返回 1，一定不在黑名单返回 0 */
+static __always_inline __u8 blklist_bloom_maybe(__u32 addr) {
+    __u32 zero = 0;
+    tc_config_t *cfg = bpf_map_lookup_elem(&tc_config, &zero);
+    if (unlikely(NULL == cfg)) return 1;
+
+    __u64 mask = cfg->blk_prefix_mask;
+    ip_lpm_key_t val = {0};
+
+    #pragma unroll
+    for (__u32 len = 0; len <= 32; len++) {
+        if (!(mask & (1ULL << len))) continue;
+
+        val.prefixlen = len;
+        val.ipv4 = addr & bpf_htonl(len ? (~0U << (32 - len)) : 0);
+        if (0 == bpf_map_peek_elem(&blklist_bloom, &val)) {
+            tc_stat_inc(TC_STAT_BLK_BLOOM_PASS);
+            return 1;
+        }
+    }
+
+    tc_stat_inc(TC_STAT_BLK_BLOOM_SKIP);
+    return 0;
+}
+
+/* 查国内 IP 白名单，返回命中规则的动作编号 */
+static __always_inline __u32 direct_ip_lookup(ip_lpm_key_t *key) {
+#if DIRECT_IP_ENGINE == DIRECT_IP_ENGINE_DIR24
+    __u32 addr = bpf_ntohl(key->ipv4);
+
+    /* 一次数组访问取出 16 个 /24 的 nibble */
+    __u32 idx = addr >> DIR24_WORD_SHIFT;
+    __u64 *word = bpf_map_lookup_elem(&direct_ip_dir24, &idx);
+    if (unlikely(NULL == word)) return ACTION_NONE;
+
+    __u32 slot = (addr >> 8) & (DIR24_SLOTS_PER_WORD - 1);
+    __u32 nibble = (*word >> (slot * DIR24_NIBBLE_BITS)) & DIR24_NIBBLE_MASK;
+    if (!(nibble & DIR24_NIBBLE_OVERFLOW)) return nibble;
+
+    /* 该 /24 内存在更长前缀，再查一次溢出表 */
+    __u32 key24 = addr >> 8;
+    dir24_overflow_t *ovf = bpf_map_lookup_elem(&direct_ip_ovf, &key24);
+    if (unlikely(NULL == ovf)) return ACTION_NONE;
+
+    return ovf->action[addr & (DIR24_OVERFLOW_SLOTS - 1)];
+#else
+    __u32 *action = bpf_map_lookup_elem(&direct_ip_map, key);
+    return action ? *action : ACTION_NONE;
+#endif
+}
+
+/* 查找Map，返回命中规则的动作编号，未命中返回 ACTION_NONE，tier 返回得出结果的层级 */
+static __always_inline __u32 do_lookup_map(__u32 *addr, __u8 *tier) {
+    if (unlikely(NULL == addr)) return ACTION_NONE;
 
-    /* 检查黑名单 (源或目的在黑名单则不加速) */
-    if (bpf_map_lookup_elem(&blklist_ip_map, &key)) return 0;
+    ip_lpm_key_t key = {.prefixlen = 32, .ipv4 = *addr};
 
     /* 查缓存一级白名单表之前检查地址是否是私网地址是为了防止缓存或国内IP白名单中混入私网地址 
      * 这样设计的目的是，除了黑名单以外，其他任何的缓存名单混入了私网的地址，都不予处理
      * */
-    if (is_private_ip(*addr)) return 0;
-
-    /* 检查缓存 */
-    if (bpf_map_lookup_elem(&hotpath_cache, addr)) {
-        return 1;
+    if (is_private_ip(*addr)) return ACTION_NONE;
+
+    /* 检查缓存，缓存只会由已排除黑名单的白名单结果晋升而来，无需再查黑名单 */
+    __u64 start = tc_profile_start();
+    hotpath_val_t *hv = bpf_map_lookup_elem(&hotpath_cache, addr);
+    tc_profile_end(PROFILE_STAGE_TC_CACHE, start);
+    if (hv) {
+        *tier = TRACE_TIER_CACHE;
+        return hv->action;
     }
 
     __u64 now = bpf_ktime_get_ns();
 
     /* 检查预缓存 */
     pre_val_t *pv = NULL;
+    start = tc_profile_start();
    if ((pv = bpf_map_lookup_elem(&pre_cache, addr)) != NULL) {
         /* 原子操作，包计数递增 */
         /* __sync_fetch_and_add 返回的是自增前的值，因此需要加1进行判断 */
-        /* 加入缓存，判定标准：见过超过 HOTPKG_NUM 个包，且距离第一次见面已经过了 HOTPKG_INV_TIME 秒 */
-        if (((__sync_fetch_and_add(&pv->count, 1) + 1) >= HOTPKG_NUM) && ((now - pv->first_seen) > HOTPKG_INV_TIME)) {
-            bpf_map_update_elem(&hotpath_cache, addr, &now, BPF_ANY);
+        /* 加入缓存，判定标准：见过超过 cfg_hotpkg_num 个包，且距离第一次见面已经过了 cfg_hotpkg_inv_time 纳秒 */
+        if (((__sync_fetch_and_add(&pv->count, 1) + 1) >= cfg_hotpkg_num) && ((now - pv->first_seen) > cfg_hotpkg_inv_time)) {
+            /* 晋升前复核黑名单，防止预缓存期间黑名单发生变化 */
+            if (blklist_bloom_maybe(*addr) && bpf_map_lookup_elem(&blklist_ip_map, &key)) {
+                bpf_map_delete_elem(&pre_cache, addr);
+                tc_profile_end(PROFILE_STAGE_TC_PRE, start);
+                *tier = TRACE_TIER_BLKLIST;
+                return ACTION_NONE;
+            }
+
+            hotpath_val_t hot = {.update_time = now, .action = pv->action};
+            bpf_map_update_elem(&hotpath_cache, addr, &hot, BPF_ANY);
         }
 
         /* 只要命中白名单，无论命中白名单还是哪个缓存，当前包都要加速 */
-        return 1; 
+        tc_profile_end(PROFILE_STAGE_TC_PRE, start);
+        *tier = TRACE_TIER_PRE;
+        return pv->action; 
     }
 
-    /* 查白名单并更新缓存 */
-    if (bpf_map_lookup_elem(&direct_ip_map, &key)) {
+    tc_profile_end(PROFILE_STAGE_TC_PRE, start);
+
+    /* 查白名单并更新缓存，用户态导入时已从白名单中扣除黑名单，一次 LPM 即可得出结果 */
+    start = tc_profile_start();
+    __u32 action = direct_ip_lookup(&key);
+    tc_profile_end(PROFILE_STAGE_TC_RULE, start);
+    if (ACTION_NONE != action) {
         /* 加入到预缓存 */
-        pre_val_t first = {.first_seen = now, .count = 1};
+        pre_val_t first = {.first_seen = now, .count = 1, .action = action};
         bpf_map_update_elem(&pre_cache, addr, &first, BPF_ANY);
-        return 1;
+        *tier = TRACE_TIER_RULE;
+        return first.action;
     } 
 
-    return 0;
+    *tier = TRACE_TIER_MISS;
+    return ACTION_NONE;
 }
 
-/* 判断是否应当加速 */
-static __always_inline int do_lookup(struct iphdr *ip) {
-    if (unlikely(NULL == ip)) return 0;
+/* 判断是否应当加速，返回命中规则的动作编号 */
+static __always_inline __u32 do_lookup(struct iphdr *ip, __u8 *tier) {
+    if (unlikely(NULL == ip)) return ACTION_NONE;
 
     /* 过滤纯内网互访 */
-    if (is_private_ip(ip->saddr) && is_private_ip(ip->daddr)) return 0;
+    if (is_private_ip(ip->saddr) && is_private_ip(ip->daddr)) return ACTION_NONE;
 
     /* 查询目的IP */
-    if (do_lookup_map(&(ip->daddr))) return 1;
+    __u32 action = do_lookup_map(&(ip->daddr), tier);
+    if (ACTION_NONE != action) return action;
 
     /* 查询源IP */
-    if (do_lookup_map(&(ip->saddr))) return 1;
+    return do_lookup_map(&(ip->saddr), tier);
+}
 
-    return 0;
+/* 经动作表将动作编号翻译为流量标记 */
+static __always_inline __u32 action_mark(__u32 action) {
+    if (ACTION_NONE == action) return 0;
+
+    action_t *act = bpf_map_lookup_elem(&action_map, &action);
+    if (unlikely(NULL == act)) return bpf_htonl(cfg_direct_mark);
+
+    return act->mark;
+}
+
+/* 按事件流配置采样输出一条地址事件 */
+static __always_inline void tc_trace(__u32 client, __u32 remote, __u32 action, __u8 tier) {
+    if (TRACE_TIER_NONE == tier) return ;
+
+    __u32 zero = 0;
+    trace_config_t *cfg = bpf_map_lookup_elem(&trace_config, &zero);
+    if (!trace_wanted(cfg, TRACE_F_TC, client, action)) return ;
+
+    /* 消费端跟不上时丢弃，不阻塞数据面 */
+    trace_event_t *event = bpf_ringbuf_reserve(&trace_ringbuf, sizeof(*event), 0);
+    if (NULL == event) {
+        tc_stat_inc(TC_STAT_TRACE_DROP);
+        return ;
+    }
+
+    event->ts = bpf_ktime_get_ns();
+    event->client = client;
+    event->remote = remote;
+    event->action = action;
+    event->source = TRACE_SRC_TC;
+    event->tier = tier;
+    event->reserved = 0;
+
+    bpf_ringbuf_submit(event, 0);
 }
 
 static __always_inline void udp_dns_pkt_dport_modify(struct __sk_buff *skb, struct udphdr *udp) {
@@ -133,6 +297,26 @@ static __always_inline void tcp_dns_pkt_dport_modify(struct __sk_buff *skb, stru
     return ;
 }
 
+/* 判断源端口是否属于任意一个 DNS 解析器池 */
+static __always_inline __u8 is_dns_pool_port(__be16 port) {
+    if (port == bpf_htons(cfg_direct_dns_port) || port == bpf_htons(cfg_proxy_dns_port)) return 1;
+
+    #pragma unroll
+    for (__u32 pool_id = 0; pool_id < DNS_POOL_NUM; pool_id++) {
+        dns_pool_t *pool = bpf_map_lookup_elem(&dns_pool_map, &pool_id);
+        if (unlikely(NULL == pool)) continue;
+
+        __u32 num = pool->num;
+        #pragma unroll
+        for (__u32 i = 0; i < DNS_POOL_MAX_MEMBERS; i++) {
+            if (i >= num) break;
+            if (port == bpf_htons(pool->port[i])) return 1;
+        }
+    }
+
+    return 0;
+}
+
 static __always_inline int do_lookup_dns(struct __sk_buff *skb, void *l4_hdr, struct iphdr *ip, void *data_end) {
     if (unlikely(NULL == skb || NULL == ip || NULL == data_end)) return TC_ACT_OK;
     if (unlikely((l4_hdr + 4) > data_end)) return TC_ACT_OK;
@@ -141,16 +325,14 @@ static __always_inline int do_lookup_dns(struct __sk_buff *skb, void *l4_hdr, st
         case IPPROTO_UDP: {
             struct udphdr *udp = (struct udphdr *)l4_hdr;
             if ((void *)udp + sizeof(struct udphdr) > data_end) return TC_ACT_OK;
-            if (udp->source != bpf_htons(DIRECT_DNS_SERVER_PORT) &&
-                udp->source != bpf_htons(PROXY_DNS_SERVER_PORT)) return TC_ACT_OK;
+            if (!is_dns_pool_port(udp->source)) return TC_ACT_OK;
 
             udp_dns_pkt_dport_modify(skb, udp);
         } break;
         case IPPROTO_TCP: {
             struct tcphdr *tcp = (struct tcphdr *)l4_hdr;
             if ((void *)tcp + sizeof(struct tcphdr) > data_end) return TC_ACT_OK;
-            if (tcp->source != bpf_htons(DIRECT_DNS_SERVER_PORT) &&
-                tcp->source != bpf_htons(PROXY_DNS_SERVER_PORT)) return TC_ACT_OK;
+            if (!is_dns_pool_port(tcp->source)) return TC_ACT_OK;
 
             tcp_dns_pkt_dport_modify(skb, tcp);
         } break;
@@ -177,7 +359,14 @@ int tc_direct_path(struct __sk_buff *skb) {
     /* 如果目的地址不是私网地址，则不予处理 */
     if (!is_private_ip(ip->daddr)) return TC_ACT_OK;
 
-    if (do_lookup(ip)) skb->mark = bpf_htonl(DIRECT_MARK);
+    __u8 tier = TRACE_TIER_NONE;
+    __u64 start = tc_profile_start();
+    __u32 action = do_lookup(ip, &tier);
+    tc_profile_end(PROFILE_STAGE_TC_LOOKUP, start);
+    __u32 mark = action_mark(action);
+    if (mark) skb->mark = mark;
+
+    tc_trace(ip->daddr, ip->saddr, action, tier);
 
     do_lookup_dns(skb, (void *)ip + (ip->ihl * 4), ip, data_end);
 
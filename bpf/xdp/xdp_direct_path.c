@@ -14,12 +14,59 @@
 /* 定义 LRU Hash Map 作为预缓存 */
 domain_cache_t domain_cache SEC(".maps");
 
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+/* 国内域名双数组 trie */
+domain_arena_t domain_arena SEC(".maps");
+#else
 /* 定义国内域名白名单 */
 domain_map_t domain_map SEC(".maps");
 
+/* 国内域名 Bloom 过滤器 */
+domain_bloom_t domain_bloom SEC(".maps");
+#endif
+
+/* DOMAIN-KEYWORD 自动机转移表 */
+keyword_ac_map_t keyword_ac SEC(".maps");
+
 /* 定义数组，作为域名白名单key */
 domain_map_key_t domain_map_key SEC(".maps");
 
+#if DOMAIN_KEY_PACKED
+/* 定义数组，作为打包编码的符号暂存区 */
+domain_sym_map_t domain_sym_map SEC(".maps");
+#endif
+
+/* DNS 解析器池 */
+dns_pool_map_t dns_pool_map SEC(".maps");
+
+/* 策略动作表 */
+action_map_t action_map SEC(".maps");
+
+/* 客户端 DNS 限速令牌桶 */
+ratelimit_map_t ratelimit_map SEC(".maps");
+
+/* XDP 运行时配置 */
+xdp_config_map_t xdp_config SEC(".maps");
+
+/* XDP 统计计数 */
+xdp_stats_t xdp_stats SEC(".maps");
+
+/* DNS 解析器池成员计数 */
+dns_pool_stats_t dns_pool_stats SEC(".maps");
+
+/* 事件流 */
+trace_ringbuf_t trace_ringbuf SEC(".maps");
+trace_config_map_t trace_config SEC(".maps");
+
+/* 分阶段耗时分布 */
+profile_hist_t profile_hist SEC(".maps");
+
+/* 加载时由用户态按配置文件写入，校验器视为常量，关闭的分支直接裁剪 */
+const volatile __u16 cfg_direct_dns_port = DIRECT_DNS_SERVER_PORT;
+const volatile __u16 cfg_proxy_dns_port = PROXY_DNS_SERVER_PORT;
+const volatile __u32 cfg_debug = 0;
+const volatile __u32 cfg_profile = 0;
+
 
 static __always_inline void error_debug_info(void *cursor, domain_lpm_key_t *key, struct iphdr *ip) {
     if (unlikely(NULL == cursor || NULL == key || NULL == ip)) return ;
@@ -50,6 +97,31 @@ static __always_inline void udp_update_csum(__u16 old_val, __u16 new_val, __u16
     *csum = (__u16)(res + (res >> 16));
 }
 
+/* 统计计数累加 */
+static __always_inline void xdp_stat_add(__u32 idx, __u64 val) {
+    __u64 *count = bpf_map_lookup_elem(&xdp_stats, &idx);
+    if (count) (*count) += val;
+}
+
+/* 统计计数递增 */
+static __always_inline void xdp_stat_inc(__u32 idx) {
+    xdp_stat_add(idx, 1);
+}
+
+/* 阶段计时开始，未开启 profile 时整段被校验器裁剪 */
+static __always_inline __u64 xdp_profile_start(void) {
+    return cfg_profile ? bpf_ktime_get_ns() : 0;
+}
+
+/* 阶段计时结束，耗时计入该阶段的分布 */
+static __always_inline void xdp_profile_end(__u32 stage, __u64 start) {
+    if (!cfg_profile) return ;
+
+    __u32 idx = stage * PROFILE_HIST_SLOTS + profile_slot(bpf_ktime_get_ns() - start);
+    __u64 *count = bpf_map_lookup_elem(&profile_hist, &idx);
+    if (count) (*count)++;
+}
+
 /* 私网检查函数 */
 static __always_inline __u8 is_private_ip(__u32 ip) {
     if ((bpf_ntohl(ip) & 0xFF000000) == 0x7F000000) return 1; // 127.0.0.0/8
@@ -133,54 +205,333 @@ static __always_inline void domain_reverse(domain_lpm_key_t *key, __u32 len) {
     return ;
 }
 
-static __always_inline __u8 do_lookup_map(domain_lpm_key_t *key) {
-    if (unlikely(NULL == key)) return 0;
+/* 域名字符转 6 bit 符号，字母折叠为小写，非法字符返回 DOMAIN_SYM_PAD */
+static __always_inline __u8 dns_char_to_sym(unsigned char c) {
+    if (c >= '0' && c <= '9') return DOMAIN_SYM_DIGIT + (c - '0');
+    if (c >= 'a' && c <= 'z') return DOMAIN_SYM_ALPHA + (c - 'a');
+    if (c >= 'A' && c <= 'Z') return DOMAIN_SYM_ALPHA + (c - 'A');
+    if ('-' == c) return DOMAIN_SYM_HYPHEN;
+    if ('_' == c) return DOMAIN_SYM_UNDERSCORE;
+    return DOMAIN_SYM_PAD;
+}
+
+#if DOMAIN_KEY_PACKED
+/* 与 domain_copy 规则一致，但输出符号，标签长度字节输出为分隔符 */
+static __always_inline __u32 domain_copy_sym(unsigned char *ptr, domain_sym_buf_t *buf, void *data_end) {
+    if (unlikely(NULL == ptr || NULL == buf || NULL == data_end)) return 0;
+
+    __u32 len = 0;
+    __u8 remaining_label_len = 0;
+    #pragma unroll
+    for (int i = 0; i < DOMAIN_KEY_MAX_SYMS; i++, ptr++) {
+        if (unlikely(((void *)ptr + 1 > data_end) || (0 == *ptr))) break;
+
+        __u8 sym = DOMAIN_SYM_SEP;
+        if (0 == remaining_label_len) {
+            if (*ptr >= DNS_LABEL_MAX_LEN) continue;
+            remaining_label_len = *ptr;
+        } else {
+            sym = dns_char_to_sym(*ptr);
+            if (DOMAIN_SYM_PAD == sym) {
+                remaining_label_len = 0;
+                continue;
+            }
+
+            remaining_label_len--;
+        }
+
+        buf->sym[len++ & (DOMAIN_SYM_BUF_LEN - 1)] = sym;
+    }
+
+    return len;
+}
+
+/* 反转后的第 i 个符号 */
+static __always_inline __u8 domain_sym_rev(domain_sym_buf_t *buf, __u32 len, __u32 i) {
+    return (i < len) ? buf->sym[(len - 1 - i) & (DOMAIN_SYM_BUF_LEN - 1)] : DOMAIN_SYM_PAD;
+}
+
+/* 反转符号序列并按高位在前每 4 个符号打包为 3 字节，位序与 LPM 前缀比较一致 */
+static __always_inline void domain_pack_reverse(domain_sym_buf_t *buf, __u32 len, domain_lpm_key_t *key) {
+    if (unlikely(NULL == buf || NULL == key)) return ;
+
+    #pragma unroll
+    for (__u32 g = 0; g < DOMAIN_KEY_MAX_SYMS / 4; g++) {
+        if (g * 4 >= len) break;
+
+        __u8 s0 = domain_sym_rev(buf, len, g * 4);
+        __u8 s1 = domain_sym_rev(buf, len, g * 4 + 1);
+        __u8 s2 = domain_sym_rev(buf, len, g * 4 + 2);
+        __u8 s3 = domain_sym_rev(buf, len, g * 4 + 3);
+
+        key->domain[g * 3]     = (s0 << 2) | (s1 >> 4);
+        key->domain[g * 3 + 1] = ((s1 & 0x0F) << 4) | (s2 >> 2);
+        key->domain[g * 3 + 2] = ((s2 & 0x03) << 6) | s3;
+    }
+}
+#endif
+
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+/* 双数组遍历上下文 */
+typedef struct {
+    domain_sym_buf_t *buf;
+    __u32 len;
+    /* 当前生效的一份双数组在 arena 中的偏移及槽位数 */
+    __u32 node_off;
+    __u32 node_num;
+    __u32 state;
+    __u32 action;
+} domain_arena_walk_ctx_t;
+
+/* bpf_loop 回调，每次按反转后的顺序消费一个符号，转移失败即结束 */
+static long domain_arena_walk_step(__u32 i, void *data) {
+    domain_arena_walk_ctx_t *ctx = data;
+    if (i >= ctx->len) return 1;
+
+    /* arena 访问由 JIT 处理缺页，下标无需经过校验器证明 */
+    domain_dat_node_t __arena *nodes = (domain_dat_node_t __arena *)(void *)(DOMAIN_ARENA_ADDR + ctx->node_off);
+    __u32 next = nodes[ctx->state].base + domain_sym_rev(ctx->buf, ctx->len, i);
+    /* 先校验下标再读取，越界的 next 可能落在另一份双数组或 arena 之外 */
+    if (next >= ctx->node_num) return 1;
+    __u32 check = nodes[next].check;
+    if ((check & DOMAIN_DAT_PARENT_MASK) != ctx->state) return 1;
+
+    ctx->state = next;
+    if (ACTION_NONE != (check >> DOMAIN_DAT_ACTION_SHIFT)) ctx->action = check >> DOMAIN_DAT_ACTION_SHIFT;
+
+    return 0;
+}
+
+/* 在双数组中查找最长后缀规则，返回动作编号，未命中返回 ACTION_NONE */
+static __always_inline __u32 domain_arena_lookup(domain_sym_buf_t *buf, __u32 len) {
+    if (unlikely(NULL == buf)) return ACTION_NONE;
+
+    /* 引用 arena map，校验器据此允许本程序使用 arena 地址空间 */
+    asm volatile("" :: "r"(&domain_arena));
+
+    domain_arena_hdr_t __arena *hdr = (domain_arena_hdr_t __arena *)(void *)DOMAIN_ARENA_ADDR;
+    if (DOMAIN_ARENA_MAGIC != hdr->magic) return ACTION_NONE;
+
+    __u32 active = hdr->active & 1;
+    domain_arena_walk_ctx_t ctx = {
+        .buf = buf,
+        .len = len,
+        .node_off = DOMAIN_ARENA_NODE_OFF + active * DOMAIN_ARENA_NODE_MAX * sizeof(domain_dat_node_t),
+        .node_num = hdr->node_num[active],
+    };
+    if (0 == ctx.node_num) return ACTION_NONE;
+
+    bpf_loop(DOMAIN_KEY_MAX_SYMS, domain_arena_walk_step, &ctx, 0);
+
+    return ctx.action;
+}
+#else
+/* 逐个探测反转后域名在标签边界处的前缀，任一前缀可能命中返回 1，一定不在域名库返回 0
+ * 规则反转后以首个标签的长度字节 (打包编码为分隔符) 结尾，只在可能是规则结尾的位置探测 */
+#if DOMAIN_KEY_PACKED
+static __always_inline __u8 domain_bloom_maybe(domain_sym_buf_t *buf, __u32 len) {
+    if (unlikely(NULL == buf)) return 1;
+#else
+static __always_inline __u8 domain_bloom_maybe(domain_lpm_key_t *key, __u32 len) {
+    if (unlikely(NULL == key)) return 1;
+#endif
+
+    __u32 hash = DOMAIN_BLOOM_FNV_OFFSET;
+    domain_bloom_val_t val = {0};
+
+    #pragma unroll
+    for (__u32 i = 0; i < DOMAIN_KEY_MAX_SYMS; i++) {
+        if (i >= len) break;
+
+#if DOMAIN_KEY_PACKED
+        __u8 c = domain_sym_rev(buf, len, i);
+        hash = (hash ^ c) * DOMAIN_BLOOM_FNV_PRIME;
+        if (DOMAIN_SYM_SEP != c) continue;
+#else
+        __u8 c = key->domain[i];
+        hash = (hash ^ c) * DOMAIN_BLOOM_FNV_PRIME;
+        if (0 == c || c > DNS_LABEL_MAX_LEN) continue;
+#endif
+
+        val.len = i + 1;
+        val.hash = hash;
+        if (0 == bpf_map_peek_elem(&domain_bloom, &val)) {
+            xdp_stat_inc(XDP_STAT_DOMAIN_BLOOM_PASS);
+            return 1;
+        }
+    }
+
+    xdp_stat_inc(XDP_STAT_DOMAIN_BLOOM_SKIP);
+    return 0;
+}
+#endif
+
+/* 查域名库，返回命中规则的动作编号 */
+static __always_inline __u32 domain_rule_lookup(domain_lpm_key_t *key, void *bloom, __u32 len, __u8 *tier) {
+    *tier = TRACE_TIER_MISS;
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    /* 双数组未命中时在前几个符号就会转移失败，比 Bloom 探测更省，不再经过 Bloom */
+    return domain_arena_lookup(bloom, len);
+#else
+    /* Bloom 判定一定不存在，无需查询域名库 */
+    if (!domain_bloom_maybe(bloom, len)) {
+        *tier = TRACE_TIER_BLOOM;
+        return ACTION_NONE;
+    }
+
+    __u32 *action = bpf_map_lookup_elem(&domain_map, key);
+    return action ? *action : ACTION_NONE;
+#endif
+}
+
+/* 返回命中规则的动作编号，未命中返回 ACTION_NONE，tier 返回得出结果的层级
+ * bloom 为 Bloom 探测的输入: 打包编码时为符号暂存区，否则为 key 本身，arena 引擎下为双数组遍历的输入 */
+static __always_inline __u32 do_lookup_map(domain_lpm_key_t *key, void *bloom, __u32 len, __u8 *tier) {
+    if (unlikely(NULL == key)) return ACTION_NONE;
 
     /* 命中缓存 */
-    __u32 *cache_val = bpf_map_lookup_elem(&domain_cache, key);
+    __u64 start = xdp_profile_start();
+    domain_cache_val_t *cache_val = bpf_map_lookup_elem(&domain_cache, key);
+    xdp_profile_end(PROFILE_STAGE_XDP_CACHE, start);
     if (cache_val) {
-        __sync_fetch_and_add(cache_val, 1);
-        return 1;
+        __sync_fetch_and_add(&cache_val->hits, 1);
+        *tier = TRACE_TIER_CACHE;
+        return cache_val->action;
     }
 
-    /* 域名库中查不到 */
-    if (!bpf_map_lookup_elem(&domain_map, key)) return 0;
+    start = xdp_profile_start();
+    __u32 action = domain_rule_lookup(key, bloom, len, tier);
+    xdp_profile_end(PROFILE_STAGE_XDP_RULE, start);
+    if (ACTION_NONE == action) return ACTION_NONE;
 
     /* 命中域名库，写入缓存 */
-    __u32 val = 1;
+    *tier = TRACE_TIER_RULE;
+    domain_cache_val_t val = {.hits = 1, .action = action};
     bpf_map_update_elem(&domain_cache, key, &val, BPF_ANY);
 
-    return 1;
+    return val.action;
+}
+
+/* DOMAIN-KEYWORD 自动机遍历上下文 */
+typedef struct {
+    /* 打包编码时为符号暂存区 (正序)，否则为反转后的 key */
+    void *text;
+    __u32 len;
+    __u32 state;
+    __u32 action;
+    __u32 steps;
+    /* 本次遍历使用的转移表起始下标，遍历期间不随切换变化 */
+    __u32 base;
+    /* 字节编码下当前标签剩余字符数，用于区分长度字节与字符 */
+    __u32 remaining;
+} keyword_walk_ctx_t;
+
+/* bpf_loop 回调，每次按正序消费一个符号，命中关键字后结束 */
+static long keyword_walk_step(__u32 i, void *data) {
+    keyword_walk_ctx_t *ctx = data;
+    if (i >= ctx->len) return 1;
+
+#if DOMAIN_KEY_PACKED
+    domain_sym_buf_t *buf = ctx->text;
+    __u8 sym = buf->sym[i & (DOMAIN_SYM_BUF_LEN - 1)];
+#else
+    domain_lpm_key_t *key = ctx->text;
+    __u8 c = key->domain[(ctx->len - 1 - i) & (DOMAIN_MAX_LEN - 1)];
+    __u8 sym = DOMAIN_SYM_SEP;
+    if (0 == ctx->remaining) {
+        ctx->remaining = c;
+    } else {
+        sym = dns_char_to_sym(c);
+        ctx->remaining--;
+    }
+#endif
+
+    __u32 idx = ctx->base + ((ctx->state << KEYWORD_AC_ALPHABET_SHIFT) | (sym & (KEYWORD_AC_ALPHABET - 1)));
+    __u32 *next = bpf_map_lookup_elem(&keyword_ac, &idx);
+    ctx->steps++;
+    if (unlikely(NULL == next)) return 1;
+
+    ctx->state = *next & KEYWORD_AC_STATE_MASK;
+    ctx->action = *next >> KEYWORD_AC_ACTION_SHIFT;
+
+    return (ACTION_NONE != ctx->action);
+}
+
+/* 后缀规则未命中时，用 DOMAIN-KEYWORD 自动机扫描整个域名，命中写入缓存 */
+static __always_inline __u32 keyword_lookup(domain_lpm_key_t *key, void *text, __u32 len, __u8 *tier) {
+    if (unlikely(NULL == key || NULL == text)) return ACTION_NONE;
+
+    __u32 zero = 0;
+    xdp_config_t *cfg = bpf_map_lookup_elem(&xdp_config, &zero);
+    if (NULL == cfg || 0 == cfg->keyword_states) return ACTION_NONE;
+
+    keyword_walk_ctx_t ctx = {.text = text, .len = len, .base = (cfg->keyword_active & 1) * KEYWORD_AC_TABLE_SIZE};
+    __u64 start = xdp_profile_start();
+    bpf_loop(DOMAIN_KEY_MAX_SYMS, keyword_walk_step, &ctx, 0);
+    xdp_profile_end(PROFILE_STAGE_XDP_KEYWORD, start);
+
+    xdp_stat_inc(XDP_STAT_KEYWORD_WALK);
+    xdp_stat_add(XDP_STAT_KEYWORD_STEP, ctx.steps);
+    if (ACTION_NONE == ctx.action) return ACTION_NONE;
+
+    xdp_stat_inc(XDP_STAT_KEYWORD_HIT);
+    *tier = TRACE_TIER_KEYWORD;
+    domain_cache_val_t val = {.hits = 1, .action = ctx.action};
+    bpf_map_update_elem(&domain_cache, key, &val, BPF_ANY);
+
+    return ctx.action;
 }
 
-static __always_inline __u8 is_domain_match(unsigned char *dns_hdr, void *data_end) {
-    if (unlikely((NULL == dns_hdr) || (NULL == data_end))) return 0;
-    if (unlikely(!dns_standard_query_pkt_check(dns_hdr, data_end))) return 0;
+static __always_inline __u32 is_domain_match(unsigned char *dns_hdr, void *data_end, __u8 *tier) {
+    if (unlikely((NULL == dns_hdr) || (NULL == data_end))) return ACTION_NONE;
+    if (unlikely(!dns_standard_query_pkt_check(dns_hdr, data_end))) return ACTION_NONE;
 
     unsigned char *cursor = dns_hdr + DNS_HEADER_LEN;
 
     /* 获取一个key结构用于查询 */
+    __u64 start = xdp_profile_start();
     __u32 kkey = 0;
     domain_lpm_key_t *key = bpf_map_lookup_elem(&domain_map_key, &kkey);
-    if (unlikely(!key)) return 0;
+    if (unlikely(!key)) return ACTION_NONE;
     __builtin_memset(key, 0, sizeof(domain_lpm_key_t));
 
+#if DOMAIN_KEY_PACKED
+    /* 解析为符号序列，再反转打包到 key 中 */
+    domain_sym_buf_t *buf = bpf_map_lookup_elem(&domain_sym_map, &kkey);
+    if (unlikely(!buf)) return ACTION_NONE;
+
+    __u32 len = domain_copy_sym(cursor, buf, data_end);
+    if (unlikely(len == 0 || len > DOMAIN_KEY_MAX_SYMS)) return ACTION_NONE;
+    key->prefixlen = len * DOMAIN_SYM_BITS;
+
+    domain_pack_reverse(buf, len, key);
+    xdp_profile_end(PROFILE_STAGE_XDP_PARSE, start);
+
+    /* 匹配 */
+    __u32 action = do_lookup_map(key, buf, len, tier);
+    if (ACTION_NONE != action) return action;
+
+    return keyword_lookup(key, buf, len, tier);
+#else
     /* 根据 RFC1035 标准 [长度][内容][长度][内容] 拷贝有效报文到key中用于查询 */
     __u32 len = domain_copy(cursor, key, data_end);
-    if (unlikely(len == 0 || len > DOMAIN_MAX_LEN)) return 0;
+    if (unlikely(len == 0 || len > DOMAIN_MAX_LEN)) return ACTION_NONE;
     key->prefixlen = Byte_to_bit(LIMIT_BY_MASK(len, (DOMAIN_MAX_LEN - 1)));
 
     /* 翻转key拷贝好的报文，因为用于保存国内域名名单的共享内存数据结构是LPM，前缀树 */
     domain_reverse(key, len);
+    xdp_profile_end(PROFILE_STAGE_XDP_PARSE, start);
 
     /* 匹配 */
-    if (!do_lookup_map(key)) return 0;
+    __u32 action = do_lookup_map(key, key, len, tier);
+    if (ACTION_NONE != action) return action;
 
-    return 1;
+    return keyword_lookup(key, key, len, tier);
+#endif
 }
 
-static __always_inline __u8 is_domain_match_tcp(struct iphdr *ip, struct tcphdr *tcp, void *data_end) {
-    if (unlikely(NULL == ip || NULL == tcp || NULL == data_end)) return 0;
+static __always_inline __u32 is_domain_match_tcp(struct iphdr *ip, struct tcphdr *tcp, void *data_end, __u8 *tier) {
+    if (unlikely(NULL == ip || NULL == tcp || NULL == data_end)) return ACTION_NONE;
 
     /* 计算 TCP 数据负载偏移 
      * TCP 头部长度是动态的，由 doff 字段决定 (单位是 4 字节)
@@ -191,19 +542,20 @@ static __always_inline __u8 is_domain_match_tcp(struct iphdr *ip, struct tcphdr
     /* 处理 TCP DNS 的特殊性：2字节长度字段
      * RFC 1035: TCP DNS 会话中，报文前有两个字节表示长度
      * */
+    /* 握手等不携带 DNS 报文的包，按国内直连处理 */
     __u16 *dns_len_field = payload;
-    if ((void *)(dns_len_field + 1) > data_end) return XDP_PASS;
+    if ((void *)(dns_len_field + 1) > data_end) return ACTION_DIRECT;
 
     /* DNS 实际内容起始点 */
     unsigned char *dns_hdr = (void *)(dns_len_field + 1);
-    if ((void *)(dns_hdr + 1) > data_end) return XDP_PASS;
+    if ((void *)(dns_hdr + 1) > data_end) return ACTION_DIRECT;
 
-    return is_domain_match(dns_hdr, data_end);
+    return is_domain_match(dns_hdr, data_end, tier);
 }
 
-static __always_inline __u8 is_domain_match_udp(struct iphdr *ip, struct udphdr *udp, void *data_end) {
-    if (unlikely(NULL == ip || NULL == udp || NULL == data_end)) return 0;
-    return is_domain_match((void *)(udp + 1), data_end);
+static __always_inline __u32 is_domain_match_udp(struct iphdr *ip, struct udphdr *udp, void *data_end, __u8 *tier) {
+    if (unlikely(NULL == ip || NULL == udp || NULL == data_end)) return ACTION_NONE;
+    return is_domain_match((void *)(udp + 1), data_end, tier);
 }
 
 /* 修改端口 */
@@ -226,6 +578,190 @@ static __always_inline void udp_dns_pkt_dport_modify(struct udphdr *udp, __be16
     return ;
 }
 
+/* 32位哈希混合 (murmur3 fmix32) */
+static __always_inline __u32 hash_mix32(__u32 h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+/* 经动作表将动作编号翻译为解析器池编号 */
+static __always_inline __u32 action_dns_pool(__u32 action) {
+    action_t *act = bpf_map_lookup_elem(&action_map, &action);
+    if (unlikely(NULL == act)) return (ACTION_NONE == action) ? DNS_POOL_PROXY : DNS_POOL_DIRECT;
+
+    return act->dns_pool;
+}
+
+/* 解析器池为空时使用的默认端口 */
+static __always_inline __u16 dns_pool_default_port(__u32 pool_id) {
+    return (DNS_POOL_DIRECT == pool_id) ? cfg_direct_dns_port : cfg_proxy_dns_port;
+}
+
+/* 在解析器池中选择成员端口
+ * 采用最高随机权重 (rendezvous) 哈希：每个成员以 hash(flow_key, port) 打分，取最高分，
+ * 增删成员只会迁移落在该成员上的请求，其他成员上的请求不受影响
+ * */
+static __always_inline __be16 dns_pool_select(__u32 pool_id, __u32 flow_key) {
+    dns_pool_t *pool = bpf_map_lookup_elem(&dns_pool_map, &pool_id);
+    if (unlikely(NULL == pool || 0 == pool->num)) return bpf_htons(dns_pool_default_port(pool_id));
+
+    __u32 num = pool->num;
+    __u32 best = 0;
+    __u32 best_score = 0;
+    __u32 key_hash = hash_mix32(flow_key);
+
+    #pragma unroll
+    for (__u32 i = 0; i < DNS_POOL_MAX_MEMBERS; i++) {
+        if (i >= num) break;
+
+        __u32 score = hash_mix32(key_hash ^ ((__u32)pool->port[i] * 0x9E3779B9));
+        if (0 == i || score > best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    /* 成员计数 */
+    __u32 stats_key = pool_id * DNS_POOL_MAX_MEMBERS + best;
+    __u64 *count = bpf_map_lookup_elem(&dns_pool_stats, &stats_key);
+    if (count) (*count)++;
+
+    return bpf_htons(pool->port[best & (DNS_POOL_MAX_MEMBERS - 1)]);
+}
+
+/* UDP 请求以 客户端地址 + DNS 事务ID 作为选择依据，同一请求的重传落在同一成员 */
+static __always_inline __u32 dns_flow_key_udp(struct iphdr *ip, struct udphdr *udp, void *data_end) {
+    unsigned char *dns_hdr = (void *)(udp + 1);
+    if ((void *)(dns_hdr + 2) > data_end) return ip->saddr;
+
+    return ip->saddr ^ ((__u32)*(__u16 *)dns_hdr << 16);
+}
+
+/* TCP 连接的所有报文必须落在同一成员，以 客户端地址 + 源端口 作为选择依据 */
+static __always_inline __u32 dns_flow_key_tcp(struct iphdr *ip, struct tcphdr *tcp) {
+    return ip->saddr ^ ((__u32)tcp->source << 16);
+}
+
+/* 按事件流配置采样输出一条域名事件，域名 key 取自本次查询使用的暂存区 */
+static __always_inline void xdp_trace(__u32 client, __u32 action, __u8 tier) {
+    if (TRACE_TIER_NONE == tier) return ;
+
+    __u32 zero = 0;
+    trace_config_t *cfg = bpf_map_lookup_elem(&trace_config, &zero);
+    if (!trace_wanted(cfg, TRACE_F_XDP, client, action)) return ;
+
+    domain_lpm_key_t *key = bpf_map_lookup_elem(&domain_map_key, &zero);
+    if (unlikely(NULL == key)) return ;
+
+    /* 消费端跟不上时丢弃，不阻塞数据面 */
+    trace_domain_event_t *event = bpf_ringbuf_reserve(&trace_ringbuf, sizeof(*event), 0);
+    if (NULL == event) {
+        xdp_stat_inc(XDP_STAT_TRACE_DROP);
+        return ;
+    }
+
+    event->hdr.ts = bpf_ktime_get_ns();
+    event->hdr.client = client;
+    event->hdr.remote = 0;
+    event->hdr.action = action;
+    event->hdr.source = TRACE_SRC_XDP;
+    event->hdr.tier = tier;
+    event->hdr.reserved = 0;
+    __builtin_memcpy(&event->key, key, sizeof(event->key));
+
+    bpf_ringbuf_submit(event, 0);
+}
+
+/* 令牌桶限速检查，允许通过返回 1 */
+static __always_inline __u8 ratelimit_allow(__u32 saddr, xdp_config_t *cfg) {
+    if (unlikely(NULL == cfg || 0 == cfg->rl_rate)) return 1;
+
+    __u64 now = bpf_ktime_get_ns();
+    ratelimit_val_t *bucket = bpf_map_lookup_elem(&ratelimit_map, &saddr);
+    if (NULL == bucket) {
+        ratelimit_val_t init = {.last_refill = now, .tokens = (__s64)cfg->rl_burst - 1};
+        bpf_map_update_elem(&ratelimit_map, &saddr, &init, BPF_NOEXIST);
+        return 1;
+    }
+
+    /* 按经过时间补充令牌，只推进已折算为整数令牌的那部分时间，避免查询频繁时余数被丢弃 */
+    __u64 elapsed = now - bucket->last_refill;
+    if (elapsed > RATELIMIT_MAX_ELAPSED) {
+        elapsed = RATELIMIT_MAX_ELAPSED;
+        bucket->last_refill = now - elapsed;
+    }
+
+    __u64 refill = elapsed * cfg->rl_rate / NSEC_PER_SEC;
+    if (refill > 0) {
+        /* 多个 CPU 并发补充时可能重复补充，但总量始终受 burst 约束 */
+        bucket->last_refill += refill * NSEC_PER_SEC / cfg->rl_rate;
+        __s64 tokens = bucket->tokens + (__s64)refill;
+        bucket->tokens = (tokens > (__s64)cfg->rl_burst) ? (__s64)cfg->rl_burst : tokens;
+    }
+
+    /* 原子扣减令牌，令牌不足时归还 */
+    if (__sync_fetch_and_add(&bucket->tokens, -1) > 0) return 1;
+
+    __sync_fetch_and_add(&bucket->tokens, 1);
+    return 0;
+}
+
+/* 将查询原地改写为 TC 置位的截断响应，从收包网口发回 */
+static __always_inline int dns_truncate_reply(struct xdp_md *ctx, struct iphdr *ip, struct udphdr *udp, void *data_end) {
+    if (unlikely(NULL == ctx || NULL == ip || NULL == udp || NULL == data_end)) return XDP_DROP;
+
+    struct ethhdr *eth = (void *)(long)ctx->data;
+    if ((void *)(eth + 1) > data_end) return XDP_DROP;
+
+    unsigned char *dns_hdr = (void *)(udp + 1);
+    if ((void *)dns_hdr + DNS_HEADER_LEN > data_end) return XDP_DROP;
+
+    /* 交换 MAC */
+    unsigned char mac[ETH_ALEN];
+    __builtin_memcpy(mac, eth->h_source, ETH_ALEN);
+    __builtin_memcpy(eth->h_source, eth->h_dest, ETH_ALEN);
+    __builtin_memcpy(eth->h_dest, mac, ETH_ALEN);
+
+    /* 交换地址与端口，反码求和与字段顺序无关，IP 与 UDP 校验和无需更新 */
+    __be32 addr = ip->saddr;
+    ip->saddr = ip->daddr;
+    ip->daddr = addr;
+
+    __be16 port = udp->source;
+    udp->source = udp->dest;
+    udp->dest = port;
+
+    /* 置 QR 与 TC 位，清除 RA 与 RCODE */
+    __u16 old_flags = *(__u16 *)(dns_hdr + 2);
+    dns_hdr[2] |= DNS_FLAG_QR | DNS_FLAG_TC;
+    dns_hdr[3] = 0;
+    udp_update_csum(old_flags, *(__u16 *)(dns_hdr + 2), &udp->check);
+
+    return XDP_TX;
+}
+
+/* 客户端 DNS 限速，在域名匹配之前丢弃洪泛查询，放行返回 XDP_PASS */
+static __always_inline int dns_ratelimit(struct xdp_md *ctx, struct iphdr *ip, struct udphdr *udp, void *data_end) {
+    __u32 kcfg = 0;
+    xdp_config_t *cfg = bpf_map_lookup_elem(&xdp_config, &kcfg);
+    if (unlikely(NULL == cfg) || 0 == cfg->rl_rate) return XDP_PASS;
+
+    xdp_stat_inc(XDP_STAT_RL_CHECKED);
+    if (ratelimit_allow(ip->saddr, cfg)) return XDP_PASS;
+
+    if (RATELIMIT_ACTION_TRUNCATE == cfg->rl_action) {
+        xdp_stat_inc(XDP_STAT_RL_TRUNCATE);
+        return dns_truncate_reply(ctx, ip, udp, data_end);
+    }
+
+    xdp_stat_inc(XDP_STAT_RL_DROP);
+    return XDP_DROP;
+}
+
 static __always_inline int do_lookup(struct xdp_md *ctx, void *l4_hdr, struct iphdr *ip, void *data_end) {
     if (unlikely(NULL == l4_hdr || NULL == ip || NULL == data_end)) return XDP_PASS;
     if (unlikely((l4_hdr + 4) > data_end)) return XDP_PASS;
@@ -237,16 +773,33 @@ static __always_inline int do_lookup(struct xdp_md *ctx, void *l4_hdr, struct ip
             if ((void *)udp + sizeof(struct udphdr) > data_end) return XDP_PASS;
             if (bpf_htons(NORMAOL_DNS_PORT) != udp->dest) return XDP_PASS;
 
-            if (is_domain_match_udp(ip, udp, data_end)) udp_dns_pkt_dport_modify(udp, bpf_htons(DIRECT_DNS_SERVER_PORT));
-            else udp_dns_pkt_dport_modify(udp, bpf_htons(PROXY_DNS_SERVER_PORT));
+            int verdict = dns_ratelimit(ctx, ip, udp, data_end);
+            if (XDP_PASS != verdict) return verdict;
+
+            __u8 tier = TRACE_TIER_NONE;
+            __u64 start = xdp_profile_start();
+            __u32 action = is_domain_match_udp(ip, udp, data_end, &tier);
+            xdp_profile_end(PROFILE_STAGE_XDP_MATCH, start);
+            if (cfg_debug) bpf_printk("DNS udp %pI4 action [%u]", &ip->saddr, action);
+            xdp_trace(ip->saddr, action, tier);
+
+            __u32 pool_id = action_dns_pool(action);
+            udp_dns_pkt_dport_modify(udp, dns_pool_select(pool_id, dns_flow_key_udp(ip, udp, data_end)));
         } break;
         case IPPROTO_TCP: {
             struct tcphdr *tcp = (struct tcphdr *)l4_hdr;
             if ((void *)tcp + sizeof(struct tcphdr) > data_end) return XDP_PASS;
             if (bpf_htons(NORMAOL_DNS_PORT) != tcp->dest) return XDP_PASS;
 
-            if (is_domain_match_tcp(ip, tcp, data_end)) tcp_dns_pkt_dport_modify(tcp, bpf_htons(DIRECT_DNS_SERVER_PORT));
-            else tcp_dns_pkt_dport_modify(tcp, bpf_htons(PROXY_DNS_SERVER_PORT));
+            __u8 tier = TRACE_TIER_NONE;
+            __u64 start = xdp_profile_start();
+            __u32 action = is_domain_match_tcp(ip, tcp, data_end, &tier);
+            xdp_profile_end(PROFILE_STAGE_XDP_MATCH, start);
+            if (cfg_debug) bpf_printk("DNS tcp %pI4 action [%u]", &ip->saddr, action);
+            xdp_trace(ip->saddr, action, tier);
+
+            __u32 pool_id = action_dns_pool(action);
+            tcp_dns_pkt_dport_modify(tcp, dns_pool_select(pool_id, dns_flow_key_tcp(ip, tcp)));
         } break;
         default: return XDP_PASS;
     }
@@ -9,6 +9,7 @@ function(add_bpf_program NAME SRC)
         COMMAND ${BPF_CLANG}
             -target bpf
             -O2 -g
+            ${BPF_EXTRA_CFLAGS}
             -I${CMAKE_SOURCE_DIR}/include
             -I${OPENWRT_TARGET_DIR}/usr/include
             -I${OPENWRT_TOOLCHAIN_DIR}/usr/include
@@ -12,7 +12,84 @@
 
 /* RFC3635 标准域名最大长度是255，
  * 然而eBPF 处理循环压力太大，几乎无法加载，减少为86 */
+#ifndef DOMAIN_MAX_LEN
 #define DOMAIN_MAX_LEN                  64
+#endif
+
+/* 域名 key 编码，编译期选择 */
+/* 0: 每个字符 1 字节，反转后的 DNS 报文格式
+ * 1: 每个字符 6 bit，标签长度字节替换为分隔符，同样大小的 key 可容纳约 4/3 倍字符 */
+#ifndef DOMAIN_KEY_PACKED
+#define DOMAIN_KEY_PACKED               0
+#endif
+
+#if DOMAIN_KEY_PACKED
+/* 每个符号占用的位数 */
+#define DOMAIN_SYM_BITS                 6
+/* 每 3 字节打包 4 个符号 */
+#define DOMAIN_KEY_MAX_SYMS             ((DOMAIN_MAX_LEN / 3) * 4)
+#else
+#define DOMAIN_SYM_BITS                 8
+#define DOMAIN_KEY_MAX_SYMS             DOMAIN_MAX_LEN
+#endif
+
+/* 6 bit 符号表，字母统一折叠为小写 */
+/* 填充，也表示非法字符 */
+#define DOMAIN_SYM_PAD                  0
+/* 标签分隔符，替代标签长度字节 */
+#define DOMAIN_SYM_SEP                  1
+/* '0' - '9' 起始符号 */
+#define DOMAIN_SYM_DIGIT                2
+/* 'a' - 'z' 起始符号 */
+#define DOMAIN_SYM_ALPHA                12
+/* '-' */
+#define DOMAIN_SYM_HYPHEN               38
+/* '_' */
+#define DOMAIN_SYM_UNDERSCORE           39
+
+/* DOMAIN-KEYWORD 自动机，按 6 bit 符号表匹配，与域名 key 编码方式无关 */
+/* 转移表每个状态占用的符号槽位，取 2 的幂便于移位计算下标 */
+#define KEYWORD_AC_ALPHABET             64
+#define KEYWORD_AC_ALPHABET_SHIFT       6
+/* 自动机最大状态数 */
+#define KEYWORD_AC_MAX_STATES           4096
+/* 转移表元素: 低 24 位为下一状态，高 8 位为下一状态命中的动作编号 */
+#define KEYWORD_AC_STATE_MASK           0x00FFFFFF
+#define KEYWORD_AC_ACTION_SHIFT         24
+
+/* 国内域名库查询引擎，编译期选择 */
+/* LPM trie，每条规则一个内核节点，逐条系统调用写入 */
+#define DOMAIN_ENGINE_LPM               0
+/* BPF arena 中的双数组 trie，用户态直接在共享内存中构建，需要内核 >= 6.9 */
+#define DOMAIN_ENGINE_ARENA             1
+#ifndef DOMAIN_ENGINE
+#define DOMAIN_ENGINE                   DOMAIN_ENGINE_LPM
+#endif
+
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA && !DOMAIN_KEY_PACKED
+#error "arena 域名引擎按 6 bit 符号逐个转移，需要同时开启 DOMAIN_KEY_PACKED"
+#endif
+
+/* arena 布局: [头部 1 页][规则区][双数组 A][双数组 B]
+ * 双数组整体重建到非活动的一份后切换，数据面始终读到完整的一份 */
+/* 用户态与内核约定的 arena 映射地址，低 32 位为 0 */
+#define DOMAIN_ARENA_ADDR               (1ULL << 44)
+#define DOMAIN_ARENA_PAGE_SIZE          4096
+/* 规则区保存全部后缀规则的符号序列，重建双数组时作为输入 */
+#define DOMAIN_ARENA_RULE_OFF           DOMAIN_ARENA_PAGE_SIZE
+#define DOMAIN_ARENA_RULE_BYTES         (16U << 20)
+/* 每份双数组的节点数上限 */
+#define DOMAIN_ARENA_NODE_MAX           (4U << 20)
+#define DOMAIN_ARENA_NODE_OFF           (DOMAIN_ARENA_RULE_OFF + DOMAIN_ARENA_RULE_BYTES)
+/* arena 页数，只有写入过的页才占用物理内存 */
+#define DOMAIN_ARENA_PAGES              24576
+/* 头部魔数，"DAT1" */
+#define DOMAIN_ARENA_MAGIC              0x44415431U
+/* 双数组节点 check 字段: 低 24 位为父节点，高 8 位为本节点作为规则结尾时的动作编号 */
+#define DOMAIN_DAT_PARENT_MASK          0x00FFFFFFU
+#define DOMAIN_DAT_ACTION_SHIFT         24
+/* 双数组中未使用的槽位 */
+#define DOMAIN_ARENA_NO_PARENT          DOMAIN_DAT_PARENT_MASK
 
 /* 字节转比特 */
 #define Byte_to_bit(Byte)               (Byte * 8)
@@ -20,6 +97,28 @@
 #define USE_LIMIT_MAX(x, max)           (((x) <= (max)) ? (x) : (max))
 
 
+/* 国内IP库查询引擎，编译期选择 */
+/* LPM trie，逐位查找 */
+#define DIRECT_IP_ENGINE_LPM            0
+/* DIR-24-8，一次数组访问，少数更长前缀再查一次溢出表 */
+#define DIRECT_IP_ENGINE_DIR24          1
+#ifndef DIRECT_IP_ENGINE
+#define DIRECT_IP_ENGINE                DIRECT_IP_ENGINE_LPM
+#endif
+
+/* DIR-24-8 每个 /24 占 4 bit，低 3 位为动作编号，最高位表示需要查溢出表 */
+#define DIR24_NIBBLE_BITS               4
+#define DIR24_NIBBLE_MASK               0xF
+#define DIR24_NIBBLE_OVERFLOW           0x8
+#define DIR24_NIBBLE_ACTION_MASK        0x7
+/* 每个数组元素 (64 bit) 保存 16 个 /24 */
+#define DIR24_SLOTS_PER_WORD            16
+/* 主机字节序地址右移 12 位得到数组下标 */
+#define DIR24_WORD_SHIFT                12
+/* 溢出表中每个 /24 保存 256 个地址的动作编号 */
+#define DIR24_OVERFLOW_SLOTS            256
+
+
 /* 各共享内存大小 */
 
 /* 国内IP缓存共享内存大小 */
@@ -34,6 +133,180 @@
 #define DOMAINPRE_MAP_SIZE              8192
 /* 国内域名库共享内存大小 */
 #define DOMAIN_MAP_SIZE                 10485760
+/* 国内IP库 DIR-24-8 数组共享内存大小，2^24 个 /24 每个 4 bit，共 8MB */
+#define DIRECT_IP_DIR24_MAP_SIZE        (1 << (32 - DIR24_WORD_SHIFT))
+/* 国内IP库 DIR-24-8 溢出表共享内存大小，即包含长于 /24 前缀的 /24 数量上限 */
+#define DIRECT_IP_OVERFLOW_MAP_SIZE     4096
+/* 国内IP黑名单 Bloom 过滤器容量 */
+#define BLKLIST_BLOOM_MAP_SIZE          BLKLIST_IP_MAP_SIZE
+/* 国内域名 Bloom 过滤器容量，超出后误判率上升，但不会漏判 */
+#define DOMAIN_BLOOM_MAP_SIZE           262144
+/* TC 运行时配置共享内存大小 */
+#define TC_CONFIG_MAP_SIZE              1
+/* TC 统计计数共享内存大小 */
+#define TC_STATS_MAP_SIZE               TC_STAT_NUM
+/* DOMAIN-KEYWORD 规则共享内存大小 */
+#define KEYWORD_MAP_SIZE                4096
+/* DOMAIN-KEYWORD 自动机单份转移表的元素数 */
+#define KEYWORD_AC_TABLE_SIZE           (KEYWORD_AC_MAX_STATES * KEYWORD_AC_ALPHABET)
+/* DOMAIN-KEYWORD 自动机转移表共享内存大小，双缓冲各占一份 */
+#define KEYWORD_AC_MAP_SIZE             (2 * KEYWORD_AC_TABLE_SIZE)
+/* DNS 解析器池共享内存大小 */
+#define DNS_POOL_MAP_SIZE               DNS_POOL_NUM
+/* DNS 解析器池成员计数共享内存大小 */
+#define DNS_POOL_STATS_MAP_SIZE         (DNS_POOL_NUM * DNS_POOL_MAX_MEMBERS)
+/* 策略动作表共享内存大小 */
+#define ACTION_MAP_SIZE                 ACTION_MAX_NUM
+/* 客户端 DNS 限速令牌桶共享内存大小 */
+#define RATELIMIT_MAP_SIZE              4096
+/* XDP 运行时配置共享内存大小 */
+#define XDP_CONFIG_MAP_SIZE             1
+/* XDP 统计计数共享内存大小 */
+#define XDP_STATS_MAP_SIZE              XDP_STAT_NUM
+/* 事件流 ring buffer 大小 (字节)，须为页大小的 2 的幂倍 */
+#define TRACE_RINGBUF_SIZE              (256 * 1024)
+/* 事件流配置共享内存大小 */
+#define TRACE_CONFIG_MAP_SIZE           1
+/* 分阶段耗时分布共享内存大小 */
+#define PROFILE_HIST_MAP_SIZE           (PROFILE_STAGE_NUM * PROFILE_HIST_SLOTS)
+/* plan 规划 map 容量时默认的内核内存预算 (KB) */
+#define MAP_MEM_BUDGET_KB               65536
+
+
+/* 内网国内专用DNS服务器服务端口 */
+#define DIRECT_DNS_SERVER_PORT          15301
+/* 内网代理专用DNS服务器服务端口 */
+#define PROXY_DNS_SERVER_PORT           15302
+
+/* 总计收发20个包，且距离最开始的数据包的时间超过了 10秒，才被准入到缓存中
+ * 以上端口、准入参数与 DIRECT_MARK 均为默认值，可在 /etc/direct_path.conf 中修改 */
+#define HOTPKG_NUM                      20
+#define HOTPKG_INV_TIME                 10000000000ULL
+
+/* DNS 解析器池，XDP 按判定结果选择池，再在池内按一致性哈希选择成员 */
+/* 未命中国内域名库的查询使用的解析器池 */
+#define DNS_POOL_PROXY                  0
+/* 命中国内域名库的查询使用的解析器池 */
+#define DNS_POOL_DIRECT                 1
+/* 解析器池数量 */
+#define DNS_POOL_NUM                    4
+/* 单个解析器池最多成员数量 */
+#define DNS_POOL_MAX_MEMBERS            8
+
+/* 策略动作，规则 map 的 value 保存动作编号，
+ * XDP 经动作表翻译为解析器池，TC 经动作表翻译为流量标记 */
+/* 未命中任何规则 */
+#define ACTION_NONE                     0
+/* 国内直连，规则未指定动作时使用，与旧版规则 value 为 1 保持兼容 */
+#define ACTION_DIRECT                   1
+/* 动作表大小 */
+#define ACTION_MAX_NUM                  8
+
+#if ACTION_MAX_NUM > (DIR24_NIBBLE_ACTION_MASK + 1)
+#error "ACTION_MAX_NUM 超出 DIR-24-8 动作编号位宽"
+#endif
+
+/* 客户端 DNS 限速，超出令牌桶后的处理方式 */
+/* 直接丢弃 */
+#define RATELIMIT_ACTION_DROP           0
+/* 回复 TC 置位的截断响应，客户端会退避或改用 TCP 重试 */
+#define RATELIMIT_ACTION_TRUNCATE       1
+
+/* XDP 统计项，对应 xdp_stats 的下标 */
+/* 经过限速检查的 DNS 查询 */
+#define XDP_STAT_RL_CHECKED             0
+/* 因限速被丢弃 */
+#define XDP_STAT_RL_DROP                1
+/* 因限速回复截断响应 */
+#define XDP_STAT_RL_TRUNCATE            2
+/* 域名 Bloom 判定一定不存在，跳过域名库查询 */
+#define XDP_STAT_DOMAIN_BLOOM_SKIP      3
+/* 域名 Bloom 判定可能存在，继续查询域名库 */
+#define XDP_STAT_DOMAIN_BLOOM_PASS      4
+/* 经过 DOMAIN-KEYWORD 自动机匹配的查询 */
+#define XDP_STAT_KEYWORD_WALK           5
+/* 自动机累计转移步数，除以匹配次数即每个报文的平均步数 */
+#define XDP_STAT_KEYWORD_STEP           6
+/* 命中 DOMAIN-KEYWORD 规则 */
+#define XDP_STAT_KEYWORD_HIT            7
+/* 事件流 ring buffer 已满，丢弃的事件 */
+#define XDP_STAT_TRACE_DROP             8
+/* 统计项数量 */
+#define XDP_STAT_NUM                    9
+
+/* TC 统计项，对应 tc_stats 的下标 */
+/* 黑名单 Bloom 判定一定不存在，跳过黑名单查询 */
+#define TC_STAT_BLK_BLOOM_SKIP          0
+/* 黑名单 Bloom 判定可能存在，继续查询黑名单 */
+#define TC_STAT_BLK_BLOOM_PASS          1
+/* 事件流 ring buffer 已满，丢弃的事件 */
+#define TC_STAT_TRACE_DROP              2
+/* 统计项数量 */
+#define TC_STAT_NUM                     3
+
+/* 分阶段耗时分布，配置文件 profile = 1 时记录，对应 profile_hist 中的分组 */
+/* XDP 一次 DNS 查询的完整匹配 */
+#define PROFILE_STAGE_XDP_MATCH         0
+/* 域名拷贝与反转 (或编码打包) */
+#define PROFILE_STAGE_XDP_PARSE         1
+/* domain_cache 查询 */
+#define PROFILE_STAGE_XDP_CACHE         2
+/* Bloom 与域名库查询 (或双数组遍历) */
+#define PROFILE_STAGE_XDP_RULE          3
+/* DOMAIN-KEYWORD 自动机遍历 */
+#define PROFILE_STAGE_XDP_KEYWORD       4
+/* TC 一个报文的完整查询 */
+#define PROFILE_STAGE_TC_LOOKUP         5
+/* hotpath_cache 查询 */
+#define PROFILE_STAGE_TC_CACHE          6
+/* pre_cache 查询与晋升 */
+#define PROFILE_STAGE_TC_PRE            7
+/* 国内 IP 库查询 */
+#define PROFILE_STAGE_TC_RULE           8
+/* 阶段数量 */
+#define PROFILE_STAGE_NUM               9
+/* 每个阶段按 2 的幂分桶 (ns)，第 i 个桶为 [2^i, 2^(i+1)) */
+#define PROFILE_HIST_SLOTS              32
+
+/* 事件流，两个程序按采样率将分类结果写入共享的 ring buffer，由 trace 命令消费 */
+/* 事件来源 */
+#define TRACE_SRC_XDP                   1
+#define TRACE_SRC_TC                    2
+/* 得出结果的层级 */
+/* 未解析出域名或地址，不输出事件 */
+#define TRACE_TIER_NONE                 0
+/* 命中 domain_cache 或 hotpath_cache */
+#define TRACE_TIER_CACHE                1
+/* 命中 pre_cache */
+#define TRACE_TIER_PRE                  2
+/* 命中规则库 (LPM、DIR-24-8 或双数组) */
+#define TRACE_TIER_RULE                 3
+/* 命中 DOMAIN-KEYWORD 规则 */
+#define TRACE_TIER_KEYWORD              4
+/* Bloom 判定一定不存在 */
+#define TRACE_TIER_BLOOM                5
+/* 规则库未命中 */
+#define TRACE_TIER_MISS                 6
+/* 晋升前复核命中黑名单 */
+#define TRACE_TIER_BLKLIST              7
+/* 事件过滤标志 */
+#define TRACE_F_XDP                     0x1
+#define TRACE_F_TC                      0x2
+/* 只记录命中规则的事件 */
+#define TRACE_F_HIT                     0x4
+/* 只记录未命中规则的事件 */
+#define TRACE_F_MISS                    0x8
+
+/* Bloom 过滤器哈希函数个数 (1 - 15)，决定误判率，
+ * 内核按 容量 * 哈希个数 * 7 / 5 位分配位图，误判率约为 0.51 ^ 哈希个数，
+ * 默认 7 个约 1%，编译时可通过 -DBLOOM_NR_HASHES 调整 */
+#ifndef BLOOM_NR_HASHES
+#define BLOOM_NR_HASHES                 7
+#endif
+
+/* 域名 Bloom 使用 FNV-1a 对反转后的域名前缀计算哈希，用户态与内核一致 */
+#define DOMAIN_BLOOM_FNV_OFFSET         2166136261U
+#define DOMAIN_BLOOM_FNV_PRIME          16777619U
 
 
 /* TC PROG 预缓存LRU HASH key 结构 */
@@ -42,8 +315,74 @@ typedef struct {
     unsigned long long int first_seen; 
     /* 累计包量 */
     unsigned int count;      
+    /* 命中规则的动作编号 */
+    unsigned int action;
 } pre_val_t;
 
+/* TC PROG 缓存LRU HASH value 结构 */
+typedef struct {
+    /* 加入缓存的纳秒时间戳 */
+    unsigned long long int update_time;
+    /* 命中规则的动作编号 */
+    unsigned int action;
+    unsigned int reserved;
+} hotpath_val_t;
+
+/* XDP PROG 域名缓存LRU HASH value 结构 */
+typedef struct {
+    /* 命中次数 */
+    unsigned int hits;
+    /* 命中规则的动作编号 */
+    unsigned int action;
+} domain_cache_val_t;
+
+/* TC 运行时配置，由用户态程序写入 */
+typedef struct {
+    /* 黑名单中出现过的前缀长度，第 n 位表示存在 /n 前缀 */
+    unsigned long long int blk_prefix_mask;
+} tc_config_t;
+
+/* 域名 Bloom 过滤器元素，反转后域名前 len 字节的哈希 */
+typedef struct {
+    unsigned int len;
+    unsigned int hash;
+} domain_bloom_val_t;
+
+/* 策略动作 */
+typedef struct {
+    /* DNS 查询使用的解析器池编号 */
+    unsigned int dns_pool;
+    /* 流量标记，直接写入 skb->mark，0 表示不标记 */
+    unsigned int mark;
+} action_t;
+
+/* 客户端 DNS 限速令牌桶 */
+typedef struct {
+    /* 上次补充令牌的纳秒时间戳 */
+    unsigned long long int last_refill;
+    /* 剩余令牌 */
+    long long int tokens;
+} ratelimit_val_t;
+
+/* XDP 运行时配置，由用户态程序写入 */
+typedef struct {
+    /* 每个客户端每秒允许的查询数，0 表示不限速 */
+    unsigned int rl_rate;
+    /* 令牌桶容量，允许的突发查询数 */
+    unsigned int rl_burst;
+    /* 超出限速后的处理方式 RATELIMIT_ACTION_* */
+    unsigned int rl_action;
+    /* DOMAIN-KEYWORD 自动机状态数，0 表示没有关键字规则 */
+    unsigned int keyword_states;
+    /* 数据面正在使用的转移表 (0/1)，用户态写入另一份后切换 */
+    unsigned int keyword_active;
+} xdp_config_t;
+
+/* DOMAIN-KEYWORD 规则 key，小写关键字 */
+typedef struct {
+    char keyword[DOMAIN_MAX_LEN];
+} keyword_key_t;
+
 /* 国内域名白名单 LPM Key 结构体
  * 用户程序与内核定义一致  */
 typedef struct {
@@ -51,6 +390,37 @@ typedef struct {
     unsigned char domain[DOMAIN_MAX_LEN];
 } domain_lpm_key_t;
 
+/* arena 域名引擎头部，位于 arena 起始处 */
+typedef struct {
+    unsigned int magic;
+    /* 当前生效的双数组，0 或 1 */
+    unsigned int active;
+    /* 两份双数组各自的槽位数 */
+    unsigned int node_num[2];
+    /* 规则区中的规则数与已用字节数 */
+    unsigned int rule_num;
+    unsigned int rule_bytes;
+} domain_arena_hdr_t;
+
+/* 双数组节点，状态 s 经符号 c 转移到 t = base[s] + c，要求 check[t] 的父节点为 s */
+typedef struct {
+    unsigned int base;
+    unsigned int check;
+} domain_dat_node_t;
+
+/* DNS 解析器池，端口为主机字节序 */
+typedef struct {
+    /* 有效成员数量 */
+    unsigned int num;
+    /* 成员端口 */
+    unsigned short port[DNS_POOL_MAX_MEMBERS];
+} dns_pool_t;
+
+/* DIR-24-8 溢出表 value，以地址最后一个字节为下标 */
+typedef struct {
+    unsigned char action[DIR24_OVERFLOW_SLOTS];
+} dir24_overflow_t;
+
 /* 国内IP白名单 LPM Key 结构体
  * 用户程序与内核定义一致  */
 typedef struct {
@@ -58,6 +428,39 @@ typedef struct {
     unsigned int ipv4;
 } ip_lpm_key_t;
 
+/* 事件流配置，由 trace 命令写入 */
+typedef struct {
+    /* 每 sample 个事件随机记录 1 个，0 表示关闭 */
+    unsigned int sample;
+    /* 只记录该内网客户端，网络字节序，0 表示不过滤 */
+    unsigned int client;
+    /* TRACE_F_* */
+    unsigned int flags;
+} trace_config_t;
+
+/* 事件头，TC 事件只有事件头 */
+typedef struct {
+    /* bpf_ktime_get_ns */
+    unsigned long long int ts;
+    /* 内网客户端地址 */
+    unsigned int client;
+    /* TC 查询的外部地址，XDP 为 0 */
+    unsigned int remote;
+    /* 动作编号 */
+    unsigned int action;
+    /* TRACE_SRC_* */
+    unsigned char source;
+    /* TRACE_TIER_* */
+    unsigned char tier;
+    unsigned short reserved;
+} trace_event_t;
+
+/* XDP 事件，附带查询使用的域名 key */
+typedef struct {
+    trace_event_t hdr;
+    domain_lpm_key_t key;
+} trace_domain_event_t;
+
 
 /* 各共享内存 key 值大小 */
 
@@ -73,12 +476,40 @@ typedef struct {
 #define DOMAINPRE_MAP_KEY_SIZE          (sizeof(domain_lpm_key_t))
 /* 国内域名库共享内存 key 值大小 */
 #define DOMAIN_MAP_KEY_SIZE             (sizeof(domain_lpm_key_t))
+/* 国内IP库 DIR-24-8 数组共享内存 key 值大小 */
+#define DIRECT_IP_DIR24_MAP_KEY_SIZE    (sizeof(unsigned int))
+/* 国内IP库 DIR-24-8 溢出表共享内存 key 值大小，key 为主机字节序地址右移 8 位 */
+#define DIRECT_IP_OVERFLOW_MAP_KEY_SIZE (sizeof(unsigned int))
+/* DOMAIN-KEYWORD 规则共享内存 key 值大小 */
+#define KEYWORD_MAP_KEY_SIZE            (sizeof(keyword_key_t))
+/* DOMAIN-KEYWORD 自动机转移表共享内存 key 值大小 */
+#define KEYWORD_AC_MAP_KEY_SIZE         (sizeof(unsigned int))
+/* TC 运行时配置共享内存 key 值大小 */
+#define TC_CONFIG_MAP_KEY_SIZE          (sizeof(unsigned int))
+/* TC 统计计数共享内存 key 值大小 */
+#define TC_STATS_MAP_KEY_SIZE           (sizeof(unsigned int))
+/* DNS 解析器池共享内存 key 值大小 */
+#define DNS_POOL_MAP_KEY_SIZE           (sizeof(unsigned int))
+/* DNS 解析器池成员计数共享内存 key 值大小 */
+#define DNS_POOL_STATS_MAP_KEY_SIZE     (sizeof(unsigned int))
+/* 策略动作表共享内存 key 值大小 */
+#define ACTION_MAP_KEY_SIZE             (sizeof(unsigned int))
+/* 客户端 DNS 限速令牌桶共享内存 key 值大小 */
+#define RATELIMIT_MAP_KEY_SIZE          (sizeof(unsigned int))
+/* XDP 运行时配置共享内存 key 值大小 */
+#define XDP_CONFIG_MAP_KEY_SIZE         (sizeof(unsigned int))
+/* XDP 统计计数共享内存 key 值大小 */
+#define XDP_STATS_MAP_KEY_SIZE          (sizeof(unsigned int))
+/* 事件流配置共享内存 key 值大小 */
+#define TRACE_CONFIG_MAP_KEY_SIZE       (sizeof(unsigned int))
+/* 分阶段耗时分布共享内存 key 值大小 */
+#define PROFILE_HIST_MAP_KEY_SIZE       (sizeof(unsigned int))
 
 
 /* 各共享内存 value 值大小 */
 
 /* 国内IP缓存共享内存 key 值大小 */
-#define CACHE_IP_MAP_VAL_SIZE           (sizeof(unsigned long long int))
+#define CACHE_IP_MAP_VAL_SIZE           (sizeof(hotpath_val_t))
 /* 国内IP预缓存共享内存 key 值大小 */
 #define PRE_CACHE_IP_MAP_VAL_SIZE       (sizeof(pre_val_t))
 /* 国内IP黑名单共享内存 key 值大小 */
@@ -86,9 +517,41 @@ typedef struct {
 /* 国内IP库共享内存 key 值大小 */
 #define DIRECT_IP_MAP_VAL_SIZE          (sizeof(unsigned int))
 /* 国内域名HASH缓存库共享内存 key 值大小 */
-#define DOMAINPRE_MAP_VAL_SIZE          (sizeof(unsigned int))
+#define DOMAINPRE_MAP_VAL_SIZE          (sizeof(domain_cache_val_t))
 /* 国内域名库共享内存 key 值大小 */
 #define DOMAIN_MAP_VAL_SIZE             (sizeof(unsigned int))
+/* 国内IP库 DIR-24-8 数组共享内存 value 值大小 */
+#define DIRECT_IP_DIR24_MAP_VAL_SIZE    (sizeof(unsigned long long int))
+/* 国内IP库 DIR-24-8 溢出表共享内存 value 值大小 */
+#define DIRECT_IP_OVERFLOW_MAP_VAL_SIZE (sizeof(dir24_overflow_t))
+/* 国内IP黑名单 Bloom 过滤器 value 值大小，元素为掩掉主机位的前缀 */
+#define BLKLIST_BLOOM_MAP_VAL_SIZE      (sizeof(ip_lpm_key_t))
+/* 国内域名 Bloom 过滤器 value 值大小 */
+#define DOMAIN_BLOOM_MAP_VAL_SIZE       (sizeof(domain_bloom_val_t))
+/* DOMAIN-KEYWORD 规则共享内存 value 值大小，为动作编号 */
+#define KEYWORD_MAP_VAL_SIZE            (sizeof(unsigned int))
+/* DOMAIN-KEYWORD 自动机转移表共享内存 value 值大小 */
+#define KEYWORD_AC_MAP_VAL_SIZE         (sizeof(unsigned int))
+/* TC 运行时配置共享内存 value 值大小 */
+#define TC_CONFIG_MAP_VAL_SIZE          (sizeof(tc_config_t))
+/* TC 统计计数共享内存 value 值大小 (每CPU) */
+#define TC_STATS_MAP_VAL_SIZE           (sizeof(unsigned long long int))
+/* DNS 解析器池共享内存 value 值大小 */
+#define DNS_POOL_MAP_VAL_SIZE           (sizeof(dns_pool_t))
+/* DNS 解析器池成员计数共享内存 value 值大小 (每CPU) */
+#define DNS_POOL_STATS_MAP_VAL_SIZE     (sizeof(unsigned long long int))
+/* 策略动作表共享内存 value 值大小 */
+#define ACTION_MAP_VAL_SIZE             (sizeof(action_t))
+/* 客户端 DNS 限速令牌桶共享内存 value 值大小 */
+#define RATELIMIT_MAP_VAL_SIZE          (sizeof(ratelimit_val_t))
+/* XDP 运行时配置共享内存 value 值大小 */
+#define XDP_CONFIG_MAP_VAL_SIZE         (sizeof(xdp_config_t))
+/* XDP 统计计数共享内存 value 值大小 (每CPU) */
+#define XDP_STATS_MAP_VAL_SIZE          (sizeof(unsigned long long int))
+/* 事件流配置共享内存 value 值大小 */
+#define TRACE_CONFIG_MAP_VAL_SIZE       (sizeof(trace_config_t))
+/* 分阶段耗时分布共享内存 value 值大小 (每CPU) */
+#define PROFILE_HIST_MAP_VAL_SIZE       (sizeof(unsigned long long int))
 
 /* 直连流量标记 */
 #define DIRECT_MARK                     0x88
@@ -0,0 +1,28 @@
+/*
+ * File     : direct_path_action.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-10 21:03:18
+*/
+
+#ifndef DIRECT_PATH_ACTION_H_H
+#define DIRECT_PATH_ACTION_H_H
+
+/* 查看动作表 */
+#define ACTION_ARGS_SHOW            "show"
+
+/* 设置动作 */
+#define ACTION_ARGS_SET             "set"
+
+/* action 参数最少数量 */
+#define ACTION_ARGS_MIN_NUM         3
+
+/* action set 参数数量: action set [action id] [dns pool id] [mark] */
+#define ACTION_SET_ARGS_NUM         6
+
+#define ACTION_PROG_USAGE           "Usage: action show | action set [action id] [dns pool id] [mark, 0x88000000]"
+
+int action_main(int argc, char **argv);
+
+#endif
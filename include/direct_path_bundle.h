@@ -0,0 +1,66 @@
+/*
+ * File     : direct_path_bundle.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-28 15:32:09
+*/
+
+#ifndef DIRECT_PATH_BUNDLE_H_H
+#define DIRECT_PATH_BUNDLE_H_H
+
+#include <linux/types.h>
+
+#include "direct_path.h"
+
+#define RULE_ARGS_COMPILE               "compile"
+#define RULE_ARGS_LOAD_BUNDLE           "load-bundle"
+
+#define BUNDLE_COMPILE_USAGE            "Usage: rule compile [bundle file] [map path] [domain/ip][@action] [rule file num] [file1] ..."
+#define BUNDLE_LOAD_USAGE               "Usage: rule load-bundle [bundle file]"
+
+/* 规则包魔数 "DPRB"，按小端读出不一致说明字节序不同 */
+#define RULE_BUNDLE_MAGIC               0x42525044U
+#define RULE_BUNDLE_VERSION             1
+/* 段中保存的 map 固定路径最大长度 */
+#define RULE_BUNDLE_PATH_LEN            128
+/* 各段数据按 8 字节对齐 */
+#define RULE_BUNDLE_ALIGN               8
+
+/* 段类型 */
+#define RULE_BUNDLE_SEC_IP              0
+#define RULE_BUNDLE_SEC_DOMAIN          1
+#define RULE_BUNDLE_SEC_KEYWORD         2
+
+/* 规则包头部，位于文件起始处 */
+typedef struct {
+    __u32 magic;
+    __u32 version;
+    /* 域名 key 编码参数，与加载程序不一致时拒绝加载 */
+    __u32 domain_sym_bits;
+    __u32 domain_key_size;
+    __u32 section_num;
+    /* 头部之后全部内容的 CRC32 */
+    __u32 crc32;
+    /* 文件总字节数 */
+    __u64 size;
+} rule_bundle_hdr_t;
+
+/* 段描述，紧随头部，每段为同一 map 的一类规则
+ * 数据区先存放 count 个 key，再存放 count 个 value，可直接批量写入 */
+typedef struct {
+    char map_path[RULE_BUNDLE_PATH_LEN];
+    /* 同一组规则文件产生的段编号相同，加载时合并后整组写入 */
+    __u32 group;
+    __u32 type;
+    __u32 key_size;
+    __u32 value_size;
+    __u64 count;
+    /* 数据区相对文件起始的偏移 */
+    __u64 offset;
+} rule_bundle_section_t;
+
+int bundle_compile_args_parse(int argc, char **argv);
+int bundle_load_args_parse(int argc, char **argv);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * File     : direct_path_cache.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-01 21:10:37
+*/
+
+#ifndef DIRECT_PATH_CACHE_H_H
+#define DIRECT_PATH_CACHE_H_H
+
+#include <linux/types.h>
+
+/* 保存缓存快照 */
+#define CACHE_ARGS_SAVE             "save"
+
+/* 恢复缓存快照 */
+#define CACHE_ARGS_RESTORE          "restore"
+
+/* 以文本输出缓存内容 */
+#define CACHE_ARGS_DUMP             "dump"
+
+/* cache 参数最少数量 */
+#define CACHE_ARGS_MIN_NUM          3
+
+/* 默认快照文件，位于 overlay，重启后仍然保留 */
+#define CACHE_DEFAULT_FILE          "/etc/direct_path.cache"
+
+#define CACHE_PROG_USAGE            "Usage: cache save [file] | cache restore [file] | cache dump [hotpath_cache/pre_cache/domain_cache]"
+
+/* 输出的地址或域名最大长度 */
+#define CACHE_DUMP_NAME_MAXLEN      256
+
+/* 快照魔数 "DPCS" */
+#define CACHE_SNAPSHOT_MAGIC        0x53435044U
+#define CACHE_SNAPSHOT_VERSION      1
+
+/* 快照中 map 名称最大长度，与 BPF_OBJ_NAME_LEN 一致 */
+#define CACHE_SNAPSHOT_NAME_LEN     16
+
+/* 快照头部 */
+typedef struct {
+    __u32 magic;
+    __u32 version;
+    __u32 section_num;
+    /* 头部之后全部内容的 CRC32 */
+    __u32 crc32;
+    /* 保存时的实时时钟 (秒)，仅用于显示 */
+    __u64 save_time;
+} cache_snapshot_hdr_t;
+
+/* 每个缓存 map 一段，随后是 count 个 key 与 count 个 value
+ * value 中的 ktime 时间戳保存为距保存时刻的时长，恢复时按当前 ktime 换算 */
+typedef struct {
+    char name[CACHE_SNAPSHOT_NAME_LEN];
+    __u32 key_size;
+    __u32 value_size;
+    __u64 count;
+} cache_snapshot_section_t;
+
+/* 保存缓存快照，先写临时文件再改名 */
+int cache_save(const char *path);
+
+/* 输出一个缓存 map 的全部条目，name 为 map 名称 */
+int cache_dump(const char *name);
+
+/* 删除与当前规则不一致的缓存条目，name 为 map 名称 */
+int cache_revalidate(const char *name);
+
+int cache_main(int argc, char **argv);
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * File     : direct_path_config.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-05 11:02:18
+*/
+
+#ifndef DIRECT_PATH_CONFIG_H_H
+#define DIRECT_PATH_CONFIG_H_H
+
+#include <net/if.h>
+#include <linux/types.h>
+
+/* 配置文件，每行 key = value，# 开头为注释，未配置的项使用编译默认值 */
+#define DIRECT_PATH_CONF_FILE           "/etc/direct_path.conf"
+
+/* plan 按规则数与内存预算生成的 map 容量，格式相同，在配置文件之后读取，覆盖其中的容量项 */
+#define DIRECT_PATH_PLAN_FILE           "/etc/direct_path.plan"
+
+/* 配置文件中的 key */
+#define CONF_KEY_LAN_IF                 "lan_if"
+#define CONF_KEY_WAN_IF                 "wan_if"
+#define CONF_KEY_DIRECT_DNS_PORT        "direct_dns_port"
+#define CONF_KEY_PROXY_DNS_PORT         "proxy_dns_port"
+#define CONF_KEY_DIRECT_MARK            "direct_mark"
+#define CONF_KEY_HOTPKG_NUM             "hotpkg_num"
+#define CONF_KEY_HOTPKG_INV_MS          "hotpkg_inv_ms"
+#define CONF_KEY_DEBUG                  "debug"
+#define CONF_KEY_PROFILE                "profile"
+#define CONF_KEY_HOTPATH_CACHE_SIZE     "hotpath_cache_size"
+#define CONF_KEY_PRE_CACHE_SIZE         "pre_cache_size"
+#define CONF_KEY_BLKLIST_SIZE           "blklist_size"
+#define CONF_KEY_DIRECT_IP_SIZE         "direct_ip_size"
+#define CONF_KEY_DOMAIN_CACHE_SIZE      "domain_cache_size"
+#define CONF_KEY_DOMAIN_MAP_SIZE        "domain_map_size"
+#define CONF_KEY_DOMAIN_BLOOM_SIZE      "domain_bloom_size"
+#define CONF_KEY_RATELIMIT_SIZE         "ratelimit_size"
+#define CONF_KEY_MEM_BUDGET_KB          "mem_budget_kb"
+
+/* 加载时写入 BPF 程序 .rodata 的变量名，与 bpf 目录下的定义一致 */
+#define RODATA_DIRECT_DNS_PORT          "cfg_direct_dns_port"
+#define RODATA_PROXY_DNS_PORT           "cfg_proxy_dns_port"
+#define RODATA_DIRECT_MARK              "cfg_direct_mark"
+#define RODATA_HOTPKG_NUM               "cfg_hotpkg_num"
+#define RODATA_HOTPKG_INV_TIME          "cfg_hotpkg_inv_time"
+#define RODATA_DEBUG                    "cfg_debug"
+#define RODATA_PROFILE                  "cfg_profile"
+
+typedef struct {
+    /* 网卡 */
+    char lan_if[IF_NAMESIZE];
+    char wan_if[IF_NAMESIZE];
+
+    /* 数据面参数，写入 .rodata，加载后不可修改 */
+    __u32 direct_dns_port;
+    __u32 proxy_dns_port;
+    /* 与 DIRECT_MARK 含义一致，经 htonl 后写入 skb->mark */
+    __u32 direct_mark;
+    __u32 hotpkg_num;
+    /* 纳秒 */
+    __u64 hotpkg_inv_time;
+    __u32 debug;
+    /* 记录分阶段耗时分布 */
+    __u32 profile;
+
+    /* map 容量 */
+    __u32 hotpath_cache_size;
+    __u32 pre_cache_size;
+    __u32 blklist_size;
+    __u32 direct_ip_size;
+    __u32 domain_cache_size;
+    __u32 domain_map_size;
+    __u32 domain_bloom_size;
+    __u32 ratelimit_size;
+
+    /* plan 使用的 map 内存预算 (KB) */
+    __u32 mem_budget_kb;
+} direct_path_conf_t;
+
+/* 首次调用时读取配置文件，之后返回同一份配置 */
+const direct_path_conf_t *conf_get(void);
+
+/* 默认值与配置文件，不含 plan 生成的容量，plan 以此为容量下限 */
+const direct_path_conf_t *conf_get_base(void);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * File     : direct_path_daemon.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-20 21:03:18
+*/
+
+#ifndef DIRECT_PATH_DAEMON_H_H
+#define DIRECT_PATH_DAEMON_H_H
+
+#include <linux/types.h>
+
+#define DAEMON_PROG_USAGE               "Usage: daemon [sock=PATH] [cache=FILE] [save=SEC] [map path] [domain/ip][@action] [rule file num] [file1] [file2] ..."
+#define CTL_PROG_USAGE                  "Usage: ctl [sock=PATH] stats | status | dump [hotpath_cache/pre_cache/domain_cache] | reload | save"
+
+/* 参数名 */
+#define DAEMON_ARGS_SOCK                "sock="
+#define DAEMON_ARGS_CACHE               "cache="
+#define DAEMON_ARGS_SAVE                "save="
+
+/* ctl 参数最少数量 */
+#define CTL_ARGS_MIN_NUM                3
+
+/* 控制命令 */
+#define DAEMON_CMD_STATS                "stats"
+#define DAEMON_CMD_STATUS               "status"
+#define DAEMON_CMD_DUMP                 "dump"
+#define DAEMON_CMD_RELOAD               "reload"
+#define DAEMON_CMD_SAVE                 "save"
+
+/* 默认控制 socket */
+#define DAEMON_DEFAULT_SOCK             "/var/run/direct_path.sock"
+
+/* 默认缓存快照间隔 (秒)，快照位于 overlay，间隔过短会增加闪存写入 */
+#define DAEMON_DEFAULT_SAVE_SEC         3600
+
+/* 规则文件最后一次变化后等待的时间 (毫秒)，下载脚本依次写入多个文件时合并为一次导入 */
+#define DAEMON_SETTLE_MS                2000
+
+/* 规则组数量上限 */
+#define DAEMON_GROUP_MAX                16
+
+/* 单条控制命令最大长度与参数个数 */
+#define DAEMON_CMD_MAXLEN               256
+#define DAEMON_CMD_ARGS_MAX             8
+
+/* 读取控制命令与发送结果的超时 (秒)，避免客户端不发送命令或不读取结果时阻塞 daemon */
+#define DAEMON_CMD_TIMEOUT_SEC          1
+
+/* 命令输出之后发送分隔符与十进制返回码，输出均为文本，不含 '\0' */
+#define DAEMON_RET_SEP                  '\0'
+/* 返回码部分最大长度 */
+#define DAEMON_RET_MAXLEN               16
+
+/* 发送命令输出的缓冲区 */
+#define DAEMON_REPLY_BUF_SIZE           4096
+
+/* epoll 等待的事件数 */
+#define DAEMON_EPOLL_EVENTS             8
+
+/* inotify 读取缓冲区 */
+#define DAEMON_INOTIFY_BUF_SIZE         4096
+
+/* ctl 读取返回内容的缓冲区 */
+#define CTL_RECV_BUF_SIZE               4096
+
+int daemon_main(int argc, char **argv);
+
+int ctl_main(int argc, char **argv);
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * File     : direct_path_dir24.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-16 10:12:31
+*/
+
+#ifndef DIRECT_PATH_DIR24_H_H
+#define DIRECT_PATH_DIR24_H_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <linux/types.h>
+
+#include "direct_path.h"
+#include "direct_path_ip_set.h"
+
+/* 用户态构造的 DIR-24-8 表 */
+typedef struct {
+    __u32 key24;
+    dir24_overflow_t val;
+} dir24_overflow_entry_t;
+
+typedef struct {
+    /* DIRECT_IP_DIR24_MAP_SIZE 个 64 bit 元素 */
+    __u64 *words;
+    /* 溢出表，按 key24 升序 */
+    dir24_overflow_entry_t *ovf;
+    size_t ovf_num;
+} dir24_table_t;
+
+/* 由 LPM 规则集合构造 DIR-24-8 表，查找结果与最长前缀匹配一致 */
+bool dir24_build(dir24_table_t *table, const ip_rule_set_t *rules);
+void dir24_free(dir24_table_t *table);
+
+/* 查表，addr 为主机字节序 */
+__u32 dir24_lookup(const dir24_table_t *table, __u32 addr);
+
+/* 表占用字节数 */
+size_t dir24_mem_size(const dir24_table_t *table);
+
+/* 将表同步到内核 map，仅写入变化的数组元素 */
+int dir24_sync(const dir24_table_t *table, int array_fd, int ovf_fd);
+
+/* 从 direct_ip_map 重新生成 DIR-24-8，未启用该引擎时直接返回 0 */
+int dir24_rebuild(void);
+
+#endif
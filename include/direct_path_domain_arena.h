@@ -0,0 +1,49 @@
+/*
+ * File     : direct_path_domain_arena.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-24 20:17:52
+*/
+
+#ifndef DIRECT_PATH_DOMAIN_ARENA_H_H
+#define DIRECT_PATH_DOMAIN_ARENA_H_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <linux/types.h>
+
+#include "direct_path.h"
+
+/* 一条后缀规则，syms 为反转后的符号序列，即数据面的遍历顺序 */
+typedef struct {
+    __u8 num;
+    __u8 action;
+    __u8 syms[DOMAIN_KEY_MAX_SYMS];
+    /* 导入顺序，同一域名重复导入时后导入的生效 */
+    __u32 seq;
+} domain_arena_rule_t;
+
+/* 用户态构建的双数组，nodes 与 arena 中的布局一致 */
+typedef struct {
+    domain_dat_node_t *nodes;
+    __u32 num;
+} domain_dat_t;
+
+/* 规则排序去重后构建双数组，rules 会被原地排序，*num 返回去重后的规则数 */
+bool domain_dat_build(domain_dat_t *dat, domain_arena_rule_t *rules, size_t *num);
+void domain_dat_free(domain_dat_t *dat);
+
+/* 按数据面相同的方式查询，返回最长后缀规则的动作编号，未命中返回 ACTION_NONE */
+__u32 domain_dat_lookup(const domain_dat_t *dat, const __u8 *syms, __u32 num);
+
+/* 暂存一条规则，整组导入完成后由 domain_arena_commit 统一写入 arena */
+bool domain_arena_add(const __u8 *syms, __u32 num, __u32 action);
+
+/* 合并 arena 中已有的规则与暂存规则，重建双数组并切换 */
+int domain_arena_commit(void);
+
+/* 复制 arena 中当前生效的双数组，供用户态按数据面方式查询，用完以 domain_dat_free 释放 */
+bool domain_arena_snapshot(domain_dat_t *dat);
+
+#endif
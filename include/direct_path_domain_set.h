@@ -0,0 +1,46 @@
+/*
+ * File     : direct_path_domain_set.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-26 21:05:13
+*/
+
+#ifndef DIRECT_PATH_DOMAIN_SET_H_H
+#define DIRECT_PATH_DOMAIN_SET_H_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <linux/types.h>
+
+#include "direct_path.h"
+
+/* 规则集合初始容量 */
+#define DOMAIN_RULE_SET_INIT_CAP    4096
+
+/* 一条域名后缀规则 */
+typedef struct {
+    /* 反转编码后的 LPM key */
+    domain_lpm_key_t key;
+    /* 动作编号 */
+    __u32 action;
+    /* 加入顺序，key 相同时后加入的生效，与逐条写入 LPM 的覆盖语义一致 */
+    __u32 seq;
+} domain_rule_t;
+
+/* 域名规则集合 */
+typedef struct {
+    domain_rule_t *rules;
+    size_t num;
+    size_t cap;
+} domain_rule_set_t;
+
+bool domain_rule_set_add(domain_rule_set_t *set, const domain_lpm_key_t *key, __u32 action);
+void domain_rule_set_free(domain_rule_set_t *set);
+
+/* 去重并剪除冗余规则，结果按反转后的 key 排序
+ * 最近的更短后缀规则动作相同时，该规则不改变任何查询的结果，予以剪除
+ * dup 输出重复的规则数，shadowed 输出被更短后缀覆盖的规则数 */
+void domain_rule_set_prune(domain_rule_set_t *set, size_t *dup, size_t *shadowed);
+
+#endif
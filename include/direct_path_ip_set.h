@@ -0,0 +1,70 @@
+/*
+ * File     : direct_path_ip_set.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-14 16:20:47
+*/
+
+#ifndef DIRECT_PATH_IP_SET_H_H
+#define DIRECT_PATH_IP_SET_H_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <linux/types.h>
+
+#include "direct_path.h"
+
+/* 规则集合初始容量 */
+#define IP_RULE_SET_INIT_CAP        1024
+
+/* 一条 IP 规则 */
+typedef struct {
+    /* LPM key，ipv4 为网络字节序 */
+    ip_lpm_key_t key;
+    /* 动作编号 */
+    __u32 action;
+    /* 加入顺序，key 相同时后加入的生效，与逐条写入 LPM 的覆盖语义一致 */
+    __u32 seq;
+} ip_rule_t;
+
+/* IP 规则集合 */
+typedef struct {
+    ip_rule_t *rules;
+    size_t num;
+    size_t cap;
+} ip_rule_set_t;
+
+/* 主机字节序闭区间，用于黑名单覆盖判断 */
+typedef struct {
+    __u32 start;
+    __u32 end;
+} ip_range_t;
+
+/* 合并后互不重叠、按起始地址排序的区间集合 */
+typedef struct {
+    ip_range_t *ranges;
+    size_t num;
+} ip_range_set_t;
+
+bool ip_rule_set_add(ip_rule_set_t *set, const ip_lpm_key_t *key, __u32 action);
+void ip_rule_set_free(ip_rule_set_t *set);
+
+/* 读取 LPM map 全部内容 */
+bool ip_rule_set_from_map(ip_rule_set_t *set, int map_fd);
+
+/* 去重，key 相同时保留后加入的规则，结果按 (地址, 前缀长度) 排序 */
+void ip_rule_set_dedup(ip_rule_set_t *set);
+
+/* 由规则集合构造合并后的区间集合 */
+bool ip_range_set_build(ip_range_set_t *ranges, const ip_rule_set_t *set);
+void ip_range_set_free(ip_range_set_t *ranges);
+
+/* 主机字节序地址是否落在区间集合中 */
+bool ip_range_set_contains(const ip_range_set_t *ranges, __u32 addr);
+
+/* 计算 set - blk，被黑名单部分覆盖的前缀拆分为不与黑名单重叠的更长前缀，
+ * 结果已去重，写入 LPM 后的最长前缀匹配结果与 "先查黑名单再查 set" 一致 */
+bool ip_rule_set_subtract(const ip_rule_set_t *set, const ip_range_set_t *blk, ip_rule_set_t *out);
+
+#endif
@@ -42,13 +42,15 @@
 
 /* 标准DNS端口 */
 #define NORMAOL_DNS_PORT                53
-/* 内网国内专用DNS服务器服务端口 */
-#define DIRECT_DNS_SERVER_PORT          15301
-/* 内网代理专用DNS服务器服务端口 */
-#define PROXY_DNS_SERVER_PORT           15302
-/* 总计收发20个包，且距离最开始的数据包的时间超过了 10秒，才被准入到缓存中 */
-#define HOTPKG_NUM                      20
-#define HOTPKG_INV_TIME                 10000000000ULL
+
+/* DNS 头部第 3 字节: QR 位 */
+#define DNS_FLAG_QR                     0x80
+/* DNS 头部第 3 字节: TC (截断) 位 */
+#define DNS_FLAG_TC                     0x02
+/* 每秒纳秒数 */
+#define NSEC_PER_SEC                    1000000000ULL
+/* 令牌补充时最多折算的时间，避免长时间空闲后乘法溢出 */
+#define RATELIMIT_MAX_ELAPSED           (60 * NSEC_PER_SEC)
 
 /* 限制 x 防止 x 超过最大值，截断高位 */
 #define LIMIT_BY_MASK(x, mask)          ((x) & (mask))
@@ -87,6 +89,48 @@ typedef struct {
     __uint(map_flags, BPF_F_NO_PREALLOC);
 } direct_ip_map_t;
 
+/* 国内 IP 白名单 DIR-24-8 数组，由用户态从 direct_ip_map 生成 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, DIRECT_IP_DIR24_MAP_SIZE);
+    __uint(key_size, DIRECT_IP_DIR24_MAP_KEY_SIZE);
+    __uint(value_size, DIRECT_IP_DIR24_MAP_VAL_SIZE);
+    __uint(map_flags, BPF_F_MMAPABLE);
+} direct_ip_dir24_t;
+
+/* 国内 IP 白名单 DIR-24-8 溢出表，保存包含长于 /24 前缀的 /24 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(max_entries, DIRECT_IP_OVERFLOW_MAP_SIZE);
+    __uint(key_size, DIRECT_IP_OVERFLOW_MAP_KEY_SIZE);
+    __uint(value_size, DIRECT_IP_OVERFLOW_MAP_VAL_SIZE);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
+} direct_ip_overflow_t;
+
+/* 黑名单 Bloom 过滤器，判定一定不存在时跳过黑名单 LPM */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_BLOOM_FILTER);
+    __uint(max_entries, BLKLIST_BLOOM_MAP_SIZE);
+    __uint(value_size, BLKLIST_BLOOM_MAP_VAL_SIZE);
+    __uint(map_extra, BLOOM_NR_HASHES);
+} blklist_bloom_t;
+
+/* TC 运行时配置 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, TC_CONFIG_MAP_SIZE);
+    __uint(key_size, TC_CONFIG_MAP_KEY_SIZE);
+    __uint(value_size, TC_CONFIG_MAP_VAL_SIZE);
+} tc_config_map_t;
+
+/* TC 统计计数 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, TC_STATS_MAP_SIZE);
+    __uint(key_size, TC_STATS_MAP_KEY_SIZE);
+    __uint(value_size, TC_STATS_MAP_VAL_SIZE);
+} tc_stats_t;
+
 /* 定义 LRU Hash Map 作为国内域名白名单预缓存 */
 typedef struct {
     __uint(type, BPF_MAP_TYPE_LRU_HASH);
@@ -104,6 +148,103 @@ typedef struct {
     __uint(map_flags, BPF_F_NO_PREALLOC);
 } domain_map_t;
 
+/* 国内域名 Bloom 过滤器，判定一定不存在时跳过域名库 LPM */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_BLOOM_FILTER);
+    __uint(max_entries, DOMAIN_BLOOM_MAP_SIZE);
+    __uint(value_size, DOMAIN_BLOOM_MAP_VAL_SIZE);
+    __uint(map_extra, BLOOM_NR_HASHES);
+} domain_bloom_t;
+
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+#ifndef __BPF_FEATURE_ADDR_SPACE_CAST
+#error "arena 域名引擎需要支持 address_space 转换的 clang (LLVM >= 18)"
+#endif
+
+/* arena 地址空间，普通指针转换为该地址空间时编译器生成 addr_space_cast 指令 */
+#define __arena                         __attribute__((address_space(1)))
+
+/* 国内域名双数组 trie，用户态 mmap 到同一地址直接构建 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARENA);
+    __uint(map_flags, BPF_F_MMAPABLE);
+    __uint(max_entries, DOMAIN_ARENA_PAGES);
+    __ulong(map_extra, DOMAIN_ARENA_ADDR);
+} domain_arena_t;
+#endif
+
+/* DOMAIN-KEYWORD 自动机转移表，下标为 状态 << 6 | 符号 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, KEYWORD_AC_MAP_SIZE);
+    __uint(key_size, KEYWORD_AC_MAP_KEY_SIZE);
+    __uint(value_size, KEYWORD_AC_MAP_VAL_SIZE);
+    __uint(map_flags, BPF_F_MMAPABLE);
+} keyword_ac_map_t;
+
+/* DNS 解析器池，XDP 与 TC 共享 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, DNS_POOL_MAP_SIZE);
+    __uint(key_size, DNS_POOL_MAP_KEY_SIZE);
+    __uint(value_size, DNS_POOL_MAP_VAL_SIZE);
+} dns_pool_map_t;
+
+/* 策略动作表，XDP 与 TC 共享 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, ACTION_MAP_SIZE);
+    __uint(key_size, ACTION_MAP_KEY_SIZE);
+    __uint(value_size, ACTION_MAP_VAL_SIZE);
+} action_map_t;
+
+/* DNS 解析器池成员计数，key 为 池编号 * DNS_POOL_MAX_MEMBERS + 成员下标 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, DNS_POOL_STATS_MAP_SIZE);
+    __uint(key_size, DNS_POOL_STATS_MAP_KEY_SIZE);
+    __uint(value_size, DNS_POOL_STATS_MAP_VAL_SIZE);
+} dns_pool_stats_t;
+
+/* 客户端 DNS 限速令牌桶，key 为客户端地址 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_LRU_HASH);
+    __uint(max_entries, RATELIMIT_MAP_SIZE);
+    __uint(key_size, RATELIMIT_MAP_KEY_SIZE);
+    __uint(value_size, RATELIMIT_MAP_VAL_SIZE);
+} ratelimit_map_t;
+
+/* XDP 运行时配置 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, XDP_CONFIG_MAP_SIZE);
+    __uint(key_size, XDP_CONFIG_MAP_KEY_SIZE);
+    __uint(value_size, XDP_CONFIG_MAP_VAL_SIZE);
+} xdp_config_map_t;
+
+/* XDP 统计计数 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, XDP_STATS_MAP_SIZE);
+    __uint(key_size, XDP_STATS_MAP_KEY_SIZE);
+    __uint(value_size, XDP_STATS_MAP_VAL_SIZE);
+} xdp_stats_t;
+
+/* 打包编码前暂存报文中解析出的符号，长度取 2 的幂便于掩码限定下标 */
+#define DOMAIN_SYM_BUF_LEN              128
+
+typedef struct {
+    unsigned char sym[DOMAIN_SYM_BUF_LEN];
+} domain_sym_buf_t;
+
+/* 定义数组，作为打包编码的符号暂存区 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, 1);
+    __type(key, __u32);
+    __type(value, domain_sym_buf_t);
+} domain_sym_map_t;
+
 /* 定义数组，作为域名白名单key */
 typedef struct {
     __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
@@ -112,5 +253,51 @@ typedef struct {
     __type(value, domain_lpm_key_t);
 } domain_map_key_t;
 
+/* 事件流 ring buffer，XDP 与 TC 共享 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_RINGBUF);
+    __uint(max_entries, TRACE_RINGBUF_SIZE);
+} trace_ringbuf_t;
+
+/* 事件流配置，XDP 与 TC 共享 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, TRACE_CONFIG_MAP_SIZE);
+    __uint(key_size, TRACE_CONFIG_MAP_KEY_SIZE);
+    __uint(value_size, TRACE_CONFIG_MAP_VAL_SIZE);
+} trace_config_map_t;
+
+/* 分阶段耗时分布，XDP 与 TC 共享 */
+typedef struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, PROFILE_HIST_MAP_SIZE);
+    __uint(key_size, PROFILE_HIST_MAP_KEY_SIZE);
+    __uint(value_size, PROFILE_HIST_MAP_VAL_SIZE);
+} profile_hist_t;
+
+/* 耗时 (ns) 所在的桶，即 log2 向下取整，无循环便于校验器处理 */
+static __always_inline __u32 profile_slot(__u64 ns) {
+    __u32 slot = 0, shift = 0;
+
+    shift = (ns > 0xFFFFFFFF) << 5; ns >>= shift; slot |= shift;
+    shift = (ns > 0xFFFF) << 4; ns >>= shift; slot |= shift;
+    shift = (ns > 0xFF) << 3; ns >>= shift; slot |= shift;
+    shift = (ns > 0xF) << 2; ns >>= shift; slot |= shift;
+    shift = (ns > 0x3) << 1; ns >>= shift; slot |= shift;
+    slot |= (ns >> 1);
+
+    return slot < PROFILE_HIST_SLOTS ? slot : PROFILE_HIST_SLOTS - 1;
+}
+
+/* 按来源、客户端、命中与否过滤后按采样率决定是否记录事件 */
+static __always_inline __u8 trace_wanted(const trace_config_t *cfg, __u32 source_flag, __u32 client, __u32 action) {
+    if (NULL == cfg || 0 == cfg->sample || !(cfg->flags & source_flag)) return 0;
+    if (cfg->client && cfg->client != client) return 0;
+    if ((cfg->flags & TRACE_F_HIT) && ACTION_NONE == action) return 0;
+    if ((cfg->flags & TRACE_F_MISS) && ACTION_NONE != action) return 0;
+
+    return 1 == cfg->sample || 0 == bpf_get_prandom_u32() % cfg->sample;
+}
+
 #endif
 
@@ -0,0 +1,56 @@
+/*
+ * File     : direct_path_keyword.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-20 09:41:26
+*/
+
+#ifndef DIRECT_PATH_KEYWORD_H_H
+#define DIRECT_PATH_KEYWORD_H_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <linux/types.h>
+
+#include "direct_path.h"
+
+/* 一条关键字规则 */
+typedef struct {
+    __u8 syms[DOMAIN_MAX_LEN];
+    __u32 num;
+    __u32 action;
+} keyword_rule_t;
+
+/* 编译后的自动机，table 与内核转移表布局一致 */
+typedef struct {
+    __u32 *table;
+    __u32 states;
+} keyword_ac_t;
+
+/* 域名字符转 6 bit 符号，字母折叠为小写，非法字符返回 DOMAIN_SYM_PAD */
+__u8 domain_char_to_sym(unsigned char c);
+
+/* 关键字转符号序列，'.' 转为标签分隔符 */
+bool keyword_encode(const char *keyword, keyword_rule_t *rule);
+
+/* 关键字规则集合，key 与动作分开存放，可直接批量写入关键字表 */
+typedef struct {
+    keyword_key_t *keys;
+    __u32 *actions;
+    size_t num;
+    size_t cap;
+} keyword_set_t;
+
+/* 校验并加入一条关键字规则 */
+bool keyword_set_add(keyword_set_t *set, const char *keyword, __u32 action);
+void keyword_set_free(keyword_set_t *set);
+
+/* 将关键字编译为 Aho-Corasick DFA，先命中的关键字生效 */
+bool keyword_ac_build(keyword_ac_t *ac, const keyword_rule_t *rules, size_t num);
+void keyword_ac_free(keyword_ac_t *ac);
+
+/* 从关键字规则表重新编译自动机并写入内核 */
+int keyword_rebuild(void);
+
+#endif
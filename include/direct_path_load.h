@@ -15,6 +15,12 @@
 /* 卸载所有 */
 #define LOAD_ARGS_UNINSTALL        "uninstall"
 
+/* 保留 map 与缓存，原位升级程序 */
+#define LOAD_ARGS_UPGRADE          "upgrade"
+
+/* 查看挂载状态 */
+#define LOAD_ARGS_STATUS           "status"
+
 /* load 参数最少数量 */
 #define LOAD_ARGS_MIN_NUM           2
 
@@ -0,0 +1,33 @@
+/*
+ * File     : direct_path_mem.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-09 21:47:12
+*/
+
+#ifndef DIRECT_PATH_MEM_H_H
+#define DIRECT_PATH_MEM_H_H
+
+#include <linux/types.h>
+
+#define MEM_PROG_USAGE                  "Usage: mem"
+
+/* mem 参数数量 */
+#define MEM_ARGS_NUM                    2
+
+/* 固定目录下最多统计的 map 数量 */
+#define MEM_MAP_MAX_NUM                 64
+
+/* 增长预测的倍数: 预分配类 map 按容量，按需分配类 map 按条目数 */
+#define MEM_GROW_FACTOR                 2
+
+/* fdinfo 中内核统计的 map 内存占用 (6.4 之后为实际占用，之前为 memlock 估算) */
+#define MEM_FDINFO_MEMLOCK              "memlock:"
+
+/* map fd 在 /proc/self/fd 中的链接目标，程序与 link 分别为 bpf-prog、bpf_link */
+#define MEM_FD_MAP_TARGET               "anon_inode:bpf-map"
+
+int mem_main(int argc, char **argv);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * File     : direct_path_pcap.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-15 19:36:08
+*/
+
+#ifndef DIRECT_PATH_PCAP_H_H
+#define DIRECT_PATH_PCAP_H_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <linux/types.h>
+#include <linux/ip.h>
+
+/* pcap 文件头魔数 (微秒、纳秒时间戳)，字节序相反时为大小端不同的抓包机器生成 */
+#define PCAP_MAGIC_USEC                 0xa1b2c3d4U
+#define PCAP_MAGIC_NSEC                 0xa1b23c4dU
+
+/* 支持的链路层类型: 以太网与 Linux cooked (tcpdump -i any) */
+#define PCAP_LINKTYPE_ETHERNET          1
+#define PCAP_LINKTYPE_LINUX_SLL         113
+/* Linux cooked 头长度与其中协议字段的偏移 */
+#define PCAP_SLL_HDR_LEN                16
+#define PCAP_SLL_PROTO_OFF              14
+/* 单个报文记录的最大长度，与 tcpdump 的最大 snaplen 一致 */
+#define PCAP_REC_MAXLEN                 262144
+
+/* DNS 报头长度与查询域名最大长度 */
+#define PCAP_DNS_HDR_LEN                12
+#define PCAP_DNS_NAME_MAXLEN            256
+
+/* pcap 文件头 */
+typedef struct {
+    __u32 magic;
+    __u16 version_major;
+    __u16 version_minor;
+    __s32 thiszone;
+    __u32 sigfigs;
+    __u32 snaplen;
+    __u32 linktype;
+} pcap_file_hdr_t;
+
+/* pcap 报文头 */
+typedef struct {
+    __u32 ts_sec;
+    __u32 ts_frac;
+    __u32 caplen;
+    __u32 len;
+} pcap_rec_hdr_t;
+
+typedef struct {
+    FILE *fp;
+    /* 抓包机器与本机字节序不同 */
+    bool swapped;
+    /* 时间戳小数部分为纳秒 */
+    bool nsec;
+    __u32 linktype;
+    __u64 rec_num;
+    __u8 rec[PCAP_REC_MAXLEN];
+} pcap_reader_t;
+
+/* 报文中 IPv4 与四层端口的位置，非 IPv4 报文 ip 为 NULL */
+typedef struct {
+    const struct iphdr *ip;
+    const __u16 *ports;
+    __u32 l4_len;
+} pcap_pkt_info_t;
+
+/* 文件是否以 pcap 魔数开头 */
+bool pcap_probe(const char *file);
+
+/* 打开文件并校验文件头，失败时输出原因 */
+bool pcap_open(pcap_reader_t *reader, const char *file);
+void pcap_close(pcap_reader_t *reader);
+
+/* 读取下一个报文，Linux cooked 头转换为以太网头，ts 为纳秒时间戳
+ * 超过 size 的报文 *len 为 0
+ * 返回 1 读到报文，0 文件结束，-1 文件损坏 */
+int pcap_next(pcap_reader_t *reader, __u8 *pkt, __u32 size, __u32 *len, __u64 *ts);
+
+/* 解析以太网 IPv4 报文的三四层位置 */
+void pcap_pkt_parse(const __u8 *pkt, __u32 len, pcap_pkt_info_t *info);
+
+/* 取 UDP DNS 查询的第一个域名，失败时为空串 */
+void pcap_dns_qname(const pcap_pkt_info_t *info, char *name);
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * File     : direct_path_plan.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-07 20:16:05
+*/
+
+#ifndef DIRECT_PATH_PLAN_H_H
+#define DIRECT_PATH_PLAN_H_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <linux/types.h>
+
+#include "direct_path.h"
+
+#define PLAN_PROG_USAGE                 "Usage: plan [map path] [domain/ip][@action] [rule file num] [file1] ... [map path] ..."
+
+/* plan 参数最少数量 */
+#define PLAN_ARGS_MIN_NUM               6
+
+/* 规则类 map 在规则数之上预留的余量 (1/4)，供后续增量更新 */
+#define PLAN_RULE_HEADROOM_SHIFT        2
+/* 规则类 map 的最小容量 */
+#define PLAN_RULE_MIN_ENTRIES           1024
+
+/* 缓存类 map 的容量范围，以默认容量为基准按 2 的幂缩放 */
+#define PLAN_CACHE_MIN_ENTRIES          1024
+#define PLAN_CACHE_MAX_ENTRIES          (1U << 24)
+#define PLAN_CACHE_MAX_SHIFT            8
+
+/* 内核对象大小估算 (64 位内核)
+ * htab_elem 头部、哈希桶、lpm_trie_node 头部 */
+#define PLAN_HTAB_ELEM_SIZE             48
+#define PLAN_HTAB_BUCKET_SIZE           16
+#define PLAN_LPM_NODE_SIZE              40
+#define PLAN_PAGE_SIZE                  4096
+/* Bloom 过滤器未指定哈希函数个数时内核的默认值 */
+#define PLAN_BLOOM_DEFAULT_HASHES       5
+
+/* 各类规则去重后的条数 */
+typedef struct {
+    size_t direct_ip;
+    size_t blklist;
+    size_t domain;
+    size_t keyword;
+    /* 参数中是否有对应的规则组，没有时不规划该 map 的容量 */
+    bool has_direct_ip;
+    bool has_blklist;
+    bool has_domain;
+} plan_counts_t;
+
+/* 估算一个 map 的内核内存占用 (字节)
+ * 预分配类 map 按容量计算，LPM 与 BPF_F_NO_PREALLOC 的 HASH 按 used 条实际条目计算，
+ * LPM 中间节点按最坏情况 (used - 1 个) 计算 */
+__u64 plan_map_cost(__u32 map_type, __u32 key_size, __u32 value_size,
+    __u32 max_entries, __u32 map_flags, __u64 map_extra, __u64 used);
+
+/* 按规则条数规划的规则类或固定容量 map 的容量，map 不在规划中时返回 0 */
+__u32 plan_rule_map_entries(const plan_counts_t *counts, const char *map_name);
+
+int plan_main(int argc, char **argv);
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * File     : direct_path_pool.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-09 20:12:37
+*/
+
+#ifndef DIRECT_PATH_POOL_H_H
+#define DIRECT_PATH_POOL_H_H
+
+/* 查看解析器池成员及计数 */
+#define POOL_ARGS_SHOW              "show"
+
+/* 设置解析器池成员 */
+#define POOL_ARGS_SET               "set"
+
+/* 国内解析器池 */
+#define POOL_NAME_DIRECT            "direct"
+
+/* 代理解析器池 */
+#define POOL_NAME_PROXY             "proxy"
+
+/* 池名称最大长度 */
+#define POOL_NAME_MAX_LEN           16
+
+/* pool 参数最少数量 */
+#define POOL_ARGS_MIN_NUM           3
+
+/* pool set 参数最少数量: pool set [direct/proxy/池编号] [port1] */
+#define POOL_SET_ARGS_MIN_NUM       5
+
+#define POOL_PROG_USAGE             "Usage: pool show | pool set [direct/proxy/pool id] [port1] [port2] ..."
+
+int pool_main(int argc, char **argv);
+
+#endif
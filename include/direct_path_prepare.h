@@ -11,10 +11,11 @@
 
 #include <stdbool.h>
 
-#define SYSTEM_CMD_MAX_LEN          64
-
 bool umount_map_all();
 bool create_map_all();
+/* 只创建尚未固定的 map，已有 map 及其内容保持不变 */
+bool create_map_missing();
+bool init_map_all();
 
 #endif
 
@@ -0,0 +1,28 @@
+/*
+ * File     : direct_path_profile.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-18 10:24:51
+*/
+
+#ifndef DIRECT_PATH_PROFILE_H_H
+#define DIRECT_PATH_PROFILE_H_H
+
+#include <linux/types.h>
+
+#define PROFILE_PROG_USAGE              "Usage: profile | profile [seconds] | profile reset"
+
+/* profile 参数数量 */
+#define PROFILE_ARGS_MIN_NUM            2
+#define PROFILE_ARGS_MAX_NUM            3
+
+/* 清空耗时分布 */
+#define PROFILE_ARGS_RESET              "reset"
+
+/* 统计时长上限 (秒) */
+#define PROFILE_WINDOW_MAX_SEC          3600
+
+int profile_main(int argc, char **argv);
+
+#endif
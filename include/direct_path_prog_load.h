@@ -11,9 +11,25 @@
 
 #include <stdbool.h>
 
+#include <bpf/libbpf.h>
+
 #define MAP_PIN_PATH_MAXLEN         256
 
+/* XDP 挂载模式名称 */
+#define XDP_MODE_NAME_NATIVE        "native"
+#define XDP_MODE_NAME_GENERIC       "generic"
+#define XDP_MODE_NAME_OFFLOAD       "offload"
+
 bool load_and_pin_bpf_all();
 
+/* 加载对象但不固定，规则类 map 复用线上 map，LRU 缓存与统计使用副本，供离线回放 */
+bool load_bpf_prog_snapshot(const char *prog_file, const char *bpf_dir, struct bpf_object **obj, int *prog_fd);
+
+/* 保留已固定的 map，原位替换正在运行的 TC 与 XDP 程序 */
+bool upgrade_bpf_all();
+
+/* 输出程序挂载方式与 XDP 模式 */
+bool show_attach_status();
+
 #endif
 
@@ -0,0 +1,37 @@
+/*
+ * File     : direct_path_ratelimit.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-12 22:05:51
+*/
+
+#ifndef DIRECT_PATH_RATELIMIT_H_H
+#define DIRECT_PATH_RATELIMIT_H_H
+
+/* 查看限速配置 */
+#define RATELIMIT_ARGS_SHOW         "show"
+
+/* 设置限速 */
+#define RATELIMIT_ARGS_SET          "set"
+
+/* 关闭限速 */
+#define RATELIMIT_ARGS_OFF          "off"
+
+/* 超出限速后丢弃 */
+#define RATELIMIT_NAME_DROP         "drop"
+
+/* 超出限速后回复截断响应 */
+#define RATELIMIT_NAME_TRUNCATE     "truncate"
+
+/* ratelimit 参数最少数量 */
+#define RATELIMIT_ARGS_MIN_NUM      3
+
+/* ratelimit set 参数最少数量: ratelimit set [rate] [burst] */
+#define RATELIMIT_SET_ARGS_MIN_NUM  5
+
+#define RATELIMIT_PROG_USAGE        "Usage: ratelimit show | ratelimit off | ratelimit set [rate/s] [burst] [drop/truncate]"
+
+int ratelimit_main(int argc, char **argv);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * File     : direct_path_replay.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-13 20:41:26
+*/
+
+#ifndef DIRECT_PATH_REPLAY_H_H
+#define DIRECT_PATH_REPLAY_H_H
+
+#include <linux/types.h>
+
+#define REPLAY_PROG_USAGE               "Usage: replay [pcap file] [quiet]"
+
+/* replay 参数数量 */
+#define REPLAY_ARGS_MIN_NUM             3
+#define REPLAY_ARGS_MAX_NUM             4
+
+/* 只输出汇总与耗时分布，不逐包输出 */
+#define REPLAY_ARGS_QUIET               "quiet"
+
+/* test run 单个报文的最大长度，XDP 需要在一页内预留头尾空间 */
+#define REPLAY_PKT_MAXLEN               3072
+
+/* 耗时分布按 2 的幂分桶 (ns) */
+#define REPLAY_HIST_SLOTS               32
+/* 分布图的最大宽度 */
+#define REPLAY_HIST_BAR_WIDTH           40
+
+int replay_main(int argc, char **argv);
+
+#endif
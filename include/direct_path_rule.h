@@ -9,6 +9,68 @@
 #ifndef DIRECT_PATH_RULE_H_H
 #define DIRECT_PATH_RULE_H_H
 
+#include <stdbool.h>
+#include <linux/types.h>
+
+#include "direct_path_ip_set.h"
+#include "direct_path_domain_set.h"
+#include "direct_path_keyword.h"
+
+/* 内核内部错误码，不支持批量操作的 map 类型返回该值，用户态头文件中没有定义 */
+#ifndef ENOTSUPP
+#define ENOTSUPP                        524
+#endif
+
+/* 批量写入 map 时每批的元素数 */
+#define RULE_BATCH_SIZE                 4096
+
+/* 一组规则文件解析后的结果，整组去重后再写入 */
+typedef struct {
+    ip_rule_set_t ip;
+    domain_rule_set_t domain;
+    keyword_set_t keyword;
+} import_rules_t;
+
+void import_rules_free(import_rules_t *rules);
+
+/* 解析一组规则文件，只收集，不访问任何 map */
+int import_rules_collect(const char *import_type, char **rule_files, 
+    __u32 rule_file_num, __u32 default_action, import_rules_t *rules);
+
+/* 将收集到的规则写入 map_path 指向的 map，写入国内 IP 库成功后 rules->ip 为扣除黑名单后实际写入的前缀 */
+int import_rules_apply(const char *import_type, const char *map_path, import_rules_t *rules);
+
+/* 删除 IP 缓存中落在区间集合内的地址，what 用于日志 */
+void cache_purge_range(const char *map_path, const ip_range_set_t *ranges, const char *what);
+
+/* 读取 map 名称，用于区分导入目标是国内 IP 库还是黑名单 */
+bool map_name_get(int map_fd, char *name, size_t size);
+
+/* 批量写入，内核不支持批量操作的 map 类型 (如 LPM trie) 逐条写入剩余元素 */
+int map_update_all(int map_fd, const void *keys, __u32 key_size, 
+    const void *values, __u32 value_size, size_t num);
+
+/* 将域名编码并反转为域名库的 LPM key */
+bool domain_encode_and_reverse(const char *domain, domain_lpm_key_t *key);
+
+/* 将域名库的 LPM key 还原为域名，用于输出数据面事件 */
+bool domain_decode(const domain_lpm_key_t *key, char *name, size_t size);
+
+/* 按 key 中的顺序 (即反转后的遍历顺序) 取出符号，返回符号数 */
+__u32 domain_key_syms_get(const domain_lpm_key_t *key, __u8 *syms);
+
+/* 写入域名库，bloom_fd 小于 0 时不写 Bloom 过滤器 */
+int domain_rule_set_write(int map_fd, int bloom_fd, const domain_rule_set_t *rules);
+
+bool import_type_parse(const char *arg, char *import_type, size_t size, __u32 *default_action);
+
+/* 每组规则文件的处理函数 */
+typedef int (*rule_group_fn)(const char *import_type, const char *map_path, 
+    char **rule_files, __u32 rule_file_num, __u32 default_action, void *ctx);
+
+/* 从 argv[start] 开始按 [map path] [domain/ip][@action] [rule file num] [files...] 逐组解析 */
+int rule_groups_foreach(int argc, char **argv, int start, rule_group_fn fn, void *ctx);
+
 int rule_main(int argc, char **argv);
 
 #endif
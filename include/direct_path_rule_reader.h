@@ -0,0 +1,60 @@
+/*
+ * File     : direct_path_rule_reader.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-30 10:12:36
+*/
+
+#ifndef DIRECT_PATH_RULE_READER_H_H
+#define DIRECT_PATH_RULE_READER_H_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <zlib.h>
+#include <linux/types.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/* 解压缓冲区大小，规则文件只保留该大小的窗口在内存中 */
+#define RULE_READER_BUF_SIZE            (64 * 1024)
+
+/* zstd 帧魔数，小端存储 */
+#define RULE_READER_ZSTD_MAGIC          0xFD2FB528U
+
+/* 规则文件格式 */
+#define RULE_FORMAT_TEXT                0
+#define RULE_FORMAT_GZIP                1
+#define RULE_FORMAT_ZSTD                2
+
+/* 按行流式读取规则文件，文本与 gzip 由 zlib 处理 (未压缩内容原样透传)，zstd 需编译时开启 */
+typedef struct {
+    __u32 format;
+    /* 解压出错，读取提前结束 */
+    bool error;
+    gzFile gz;
+#ifdef HAVE_ZSTD
+    FILE *fp;
+    ZSTD_DStream *zds;
+    ZSTD_inBuffer in;
+    unsigned char *in_buf;
+    size_t in_cap;
+    unsigned char *out_buf;
+    size_t out_cap;
+    size_t out_pos;
+    size_t out_len;
+    bool in_eof;
+#endif
+} rule_reader_t;
+
+/* 按文件内容的魔数识别格式后打开 */
+bool rule_reader_open(rule_reader_t *reader, const char *path);
+
+/* 与 fgets 语义一致，读取一行 (包含换行符)，文件结束返回 NULL */
+char *rule_reader_gets(rule_reader_t *reader, char *buf, int len);
+
+void rule_reader_close(rule_reader_t *reader);
+
+#endif
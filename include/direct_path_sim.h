@@ -0,0 +1,37 @@
+/*
+ * File     : direct_path_sim.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-15 21:08:37
+*/
+
+#ifndef DIRECT_PATH_SIM_H_H
+#define DIRECT_PATH_SIM_H_H
+
+#include <linux/types.h>
+
+#define SIM_PROG_USAGE                  "Usage: sim [pcap/log file] [key=value1,value2,...] ..."
+
+/* sim 参数最少数量 */
+#define SIM_ARGS_MIN_NUM                3
+
+/* 每个参数最多扫描的取值个数 */
+#define SIM_SWEEP_MAX_NUM               8
+/* 取值列表分隔符 */
+#define SIM_SWEEP_SEPARATOR             ","
+
+/* 日志文件每行一个事件: 时间戳(秒，可带小数) IPv4 地址或域名，# 开头为注释
+ * IPv4 地址为 TC 查询的外部地址，域名为 XDP 收到的 DNS 查询 */
+#define SIM_LOG_COMMENT                 '#'
+
+/* 事件与 key 表的初始容量 */
+#define SIM_INIT_CAP                    4096
+
+/* 事件类型 */
+#define SIM_EVENT_IP                    0
+#define SIM_EVENT_DOMAIN                1
+
+int sim_main(int argc, char **argv);
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * File     : direct_path_stats.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-12 22:31:09
+*/
+
+#ifndef DIRECT_PATH_STATS_H_H
+#define DIRECT_PATH_STATS_H_H
+
+#include <stdbool.h>
+#include <linux/types.h>
+
+/* 汇总每CPU计数 */
+bool map_percpu_u64_sum(int map_fd, __u32 key, __u64 *sum);
+
+int stats_main(int argc, char **argv);
+
+#endif
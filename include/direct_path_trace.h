@@ -0,0 +1,48 @@
+/*
+ * File     : direct_path_trace.h
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-16 20:12:45
+*/
+
+#ifndef DIRECT_PATH_TRACE_H_H
+#define DIRECT_PATH_TRACE_H_H
+
+#include <linux/types.h>
+
+#define TRACE_PROG_USAGE                "Usage: trace [sample=N] [client=IP] [src=xdp/tc/all] [verdict=hit/miss/all] [count=N] [format=text/sim]"
+
+/* trace 参数最少数量 */
+#define TRACE_ARGS_MIN_NUM              2
+
+/* 参数名 */
+#define TRACE_ARGS_SAMPLE               "sample="
+#define TRACE_ARGS_CLIENT               "client="
+#define TRACE_ARGS_SRC                  "src="
+#define TRACE_ARGS_VERDICT              "verdict="
+#define TRACE_ARGS_COUNT                "count="
+#define TRACE_ARGS_FORMAT               "format="
+
+/* 参数取值 */
+#define TRACE_NAME_XDP                  "xdp"
+#define TRACE_NAME_TC                   "tc"
+#define TRACE_NAME_ALL                  "all"
+#define TRACE_NAME_HIT                  "hit"
+#define TRACE_NAME_MISS                 "miss"
+#define TRACE_NAME_TEXT                 "text"
+/* 输出为 sim 命令可读取的日志格式 */
+#define TRACE_NAME_SIM                  "sim"
+
+/* 默认记录全部事件，消费端跟不上时数据面丢弃并计入 trace dropped */
+#define TRACE_DEFAULT_SAMPLE            1
+
+/* 输出的域名最大长度 */
+#define TRACE_NAME_MAXLEN               256
+
+/* epoll 等待的事件数 */
+#define TRACE_EPOLL_EVENTS              2
+
+int trace_main(int argc, char **argv);
+
+#endif
@@ -33,7 +33,12 @@
 #define RULE_DOMAIN_KEYWORD             "DOMAIN-KEYWORD,"
 #define RULE_DOMAIN_SUFFIX              "DOMAIN-SUFFIX,"
 
-#define EXPORT_PROG_USAGE               "Usage: import [map path] [domain/ip] [rule file num] [file1] [file2] ..."
+#define EXPORT_PROG_USAGE               "Usage: import [map path] [domain/ip][@action] [rule file num] [file1] [file2] ..."
+
+/* 规则行尾可选的动作字段，例如 DOMAIN-SUFFIX,netflix.com,action=2 */
+#define RULE_ACTION_TAG                 ",action="
+/* 导入类型后缀，为整组规则文件指定默认动作，例如 domain@2 */
+#define IMPORT_TYPE_ACTION_SEPARATOR    '@'
 
 /* 规则文件注释符 */
 #define RULE_FILE_COMMIT_SEPARATOR      '#'
@@ -43,6 +48,8 @@
 #define IMPORT_TYPE_DOMAIN              "domain"
 /* 导入类型 IP */
 #define IMPORT_TYPE_IP                  "ip"
+/* 导入类型参数最大长度 */
+#define IMPORT_TYPE_MAX_LEN             16
 /* 用户态主程序，当前设计最小有效参数个数 */
 #define DIRECT_PATH_USER_VALID_ARGS_NUM 1
 /* 规则导入程序当前设计的，有效的最小参数个数 */
@@ -77,25 +84,87 @@
 /* 程序固定点路径 */
 #define TC_PROG_BASE                    TC_BPF_DIR"/tc_accel_prog"
 #define XDP_PROG_BASE                   XDP_BPF_DIR"/xdp_accel_prog"
+/* 程序按入口函数名固定在上述目录下 */
+#define TC_PROG_PIN                     TC_PROG_BASE"/tc_direct_path"
+#define XDP_PROG_PIN                    XDP_PROG_BASE"/xdp_direct_path"
+
+/* bpf_link 固定点路径，存在时表示程序以 link 方式挂载 */
+#define TC_LINK_INGRESS_PIN             TC_BPF_DIR"/tcx_ingress_link"
+#define TC_LINK_EGRESS_PIN              TC_BPF_DIR"/tcx_egress_link"
+#define XDP_LINK_PIN                    XDP_BPF_DIR"/xdp_link"
 
 // Map 名称
 #define HOTPATH_MAPNAME                 "hotpath_cache"
 #define PRE_MAPNAME                     "pre_cache"
 #define BLKLIST_MAPNAME                 "blklist_ip_map"
 #define DIRECT_MAPNAME                  "direct_ip_map"
+#define DIRECTDIR24_MAPNAME             "direct_ip_dir24"
+#define DIRECTOVERFLOW_MAPNAME          "direct_ip_ovf"
+#define BLKLISTBLOOM_MAPNAME            "blklist_bloom"
+#define TCCONFIG_MAPNAME                "tc_config"
+#define TCSTATS_MAPNAME                 "tc_stats"
+#define DOMAINBLOOM_MAPNAME             "domain_bloom"
+#define KEYWORD_MAPNAME                 "keyword_map"
+#define KEYWORDAC_MAPNAME               "keyword_ac"
 #define DOMAINCACHE_MAPNAME             "domain_cache"
 #define DOMAIN_MAPNAME                  "domain_map"
+#define DOMAINARENA_MAPNAME             "domain_arena"
+#define DNSPOOL_MAPNAME                 "dns_pool_map"
+#define DNSPOOLSTATS_MAPNAME            "dns_pool_stats"
+#define ACTION_MAPNAME                  "action_map"
+#define RATELIMIT_MAPNAME               "ratelimit_map"
+#define XDPCONFIG_MAPNAME               "xdp_config"
+#define XDPSTATS_MAPNAME                "xdp_stats"
+#define TRACERINGBUF_MAPNAME            "trace_ringbuf"
+#define TRACECONFIG_MAPNAME             "trace_config"
+#define PROFILEHIST_MAPNAME             "profile_hist"
 
 /* Map 固定路径 */
 #define HOTPATHMAP_PIN                  TC_BPF_DIR"/"HOTPATH_MAPNAME
 #define PREMAP_PIN                      TC_BPF_DIR"/"PRE_MAPNAME
 #define BLACKMAP_PIN                    TC_BPF_DIR"/"BLKLIST_MAPNAME
 #define DIRECTMAP_PIN                   TC_BPF_DIR"/"DIRECT_MAPNAME
+#define DIRECTDIR24_PIN                 TC_BPF_DIR"/"DIRECTDIR24_MAPNAME
+#define DIRECTOVERFLOW_PIN              TC_BPF_DIR"/"DIRECTOVERFLOW_MAPNAME
+#define BLKLISTBLOOM_PIN                TC_BPF_DIR"/"BLKLISTBLOOM_MAPNAME
+#define TCCONFIG_PIN                    TC_BPF_DIR"/"TCCONFIG_MAPNAME
+#define TCSTATS_PIN                     TC_BPF_DIR"/"TCSTATS_MAPNAME
+#define DOMAINBLOOM_PIN                 XDP_BPF_DIR"/"DOMAINBLOOM_MAPNAME
+#define KEYWORDMAP_PIN                  XDP_BPF_DIR"/"KEYWORD_MAPNAME
+#define KEYWORDAC_PIN                   XDP_BPF_DIR"/"KEYWORDAC_MAPNAME
 #define DOMAINCACHE_PIN                 XDP_BPF_DIR"/"DOMAINCACHE_MAPNAME
 #define DOMAINMAP_PIN                   XDP_BPF_DIR"/"DOMAIN_MAPNAME
+#define DOMAINARENA_PIN                 XDP_BPF_DIR"/"DOMAINARENA_MAPNAME
+#define DNSPOOL_XDP_PIN                 XDP_BPF_DIR"/"DNSPOOL_MAPNAME
+#define DNSPOOL_TC_PIN                  TC_BPF_DIR"/"DNSPOOL_MAPNAME
+#define DNSPOOLSTATS_PIN                XDP_BPF_DIR"/"DNSPOOLSTATS_MAPNAME
+#define ACTION_XDP_PIN                  XDP_BPF_DIR"/"ACTION_MAPNAME
+#define ACTION_TC_PIN                   TC_BPF_DIR"/"ACTION_MAPNAME
+#define RATELIMIT_PIN                   XDP_BPF_DIR"/"RATELIMIT_MAPNAME
+#define XDPCONFIG_PIN                   XDP_BPF_DIR"/"XDPCONFIG_MAPNAME
+#define XDPSTATS_PIN                    XDP_BPF_DIR"/"XDPSTATS_MAPNAME
+#define TRACERINGBUF_XDP_PIN            XDP_BPF_DIR"/"TRACERINGBUF_MAPNAME
+#define TRACERINGBUF_TC_PIN             TC_BPF_DIR"/"TRACERINGBUF_MAPNAME
+#define TRACECONFIG_XDP_PIN             XDP_BPF_DIR"/"TRACECONFIG_MAPNAME
+#define TRACECONFIG_TC_PIN              TC_BPF_DIR"/"TRACECONFIG_MAPNAME
+#define PROFILEHIST_XDP_PIN             XDP_BPF_DIR"/"PROFILEHIST_MAPNAME
+#define PROFILEHIST_TC_PIN              TC_BPF_DIR"/"PROFILEHIST_MAPNAME
 
 #define DIRECT_PATH_LOAD_ARGS           "load"
 #define DIRECT_PATH_RULE_ARGS           "rule"
+#define DIRECT_PATH_POOL_ARGS           "pool"
+#define DIRECT_PATH_ACTION_ARGS         "action"
+#define DIRECT_PATH_RATELIMIT_ARGS      "ratelimit"
+#define DIRECT_PATH_STATS_ARGS          "stats"
+#define DIRECT_PATH_CACHE_ARGS          "cache"
+#define DIRECT_PATH_PLAN_ARGS           "plan"
+#define DIRECT_PATH_MEM_ARGS            "mem"
+#define DIRECT_PATH_REPLAY_ARGS         "replay"
+#define DIRECT_PATH_SIM_ARGS            "sim"
+#define DIRECT_PATH_TRACE_ARGS          "trace"
+#define DIRECT_PATH_PROFILE_ARGS        "profile"
+#define DIRECT_PATH_DAEMON_ARGS         "daemon"
+#define DIRECT_PATH_CTL_ARGS            "ctl"
 
 #endif
 
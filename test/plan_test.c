@@ -0,0 +1,61 @@
+/*
+ * File     : plan_test.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-10-19 11:02:36
+*/
+
+/*
+ * plan 容量规划检查: 规则较少时各规则类 map 保持配置文件或默认的容量，
+ * 域名 Bloom 过滤器以自身的默认容量为下限，不随域名库容量放大。
+ * 用法: plan_test，失败时返回非 0
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "direct_path_user.h"
+#include "direct_path_config.h"
+#include "direct_path_plan.h"
+
+/* 少量规则，规划结果应停留在下限 */
+#define TEST_SMALL_RULE_NUM             100
+/* 大量规则，规划结果应为规则数加 1/4 余量 */
+#define TEST_LARGE_RULE_NUM             (1U << 22)
+
+static __u32 test_fail = 0;
+
+static void test_expect(const char *what, __u32 got, __u32 want) {
+    if (got == want) {
+        printf("[INFO] %-36s %u\n", what, got);
+        return ;
+    }
+
+    fprintf(stderr, "[ERROR] %-36s %u，应为 %u\n", what, got, want);
+    test_fail++;
+}
+
+int main(void) {
+    const direct_path_conf_t *base = conf_get_base();
+
+    plan_counts_t counts;
+    memset(&counts, 0, sizeof(counts));
+    counts.domain = TEST_SMALL_RULE_NUM;
+    counts.has_domain = true;
+
+    test_expect("少量规则 " DOMAIN_MAPNAME, plan_rule_map_entries(&counts, DOMAIN_MAPNAME), base->domain_map_size);
+#if DOMAIN_ENGINE != DOMAIN_ENGINE_ARENA
+    test_expect("少量规则 " DOMAINBLOOM_MAPNAME,
+        plan_rule_map_entries(&counts, DOMAINBLOOM_MAPNAME), base->domain_bloom_size);
+
+    /* 超过默认容量后按规则数规划，与域名库一致 */
+    __u32 large = TEST_LARGE_RULE_NUM + (TEST_LARGE_RULE_NUM >> PLAN_RULE_HEADROOM_SHIFT);
+    counts.domain = TEST_LARGE_RULE_NUM;
+    test_expect("大量规则 " DOMAINBLOOM_MAPNAME, plan_rule_map_entries(&counts, DOMAINBLOOM_MAPNAME),
+        (large > base->domain_bloom_size) ? large : base->domain_bloom_size);
+#endif
+
+    if (test_fail) fprintf(stderr, "[ERROR] plan_test: %u 项不符合预期\n", test_fail);
+    return test_fail ? 1 : 0;
+}
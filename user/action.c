@@ -0,0 +1,91 @@
+/*
+ * File     : action.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-10 21:05:44
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_action.h"
+
+int action_show(int argc, char **argv) {
+    int map_fd = bpf_obj_get(ACTION_XDP_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", ACTION_XDP_PIN, strerror(errno));
+        return -1;
+    }
+
+    printf("%-8s | %-10s | %-12s\n", "ACTION", "DNS POOL", "MARK");
+    for (__u32 i = 0; i < ACTION_MAX_NUM; i++) {
+        action_t act = {0};
+        if (bpf_map_lookup_elem(map_fd, &i, &act)) continue;
+        printf("%-8u | %-10u | 0x%08x\n", i, act.dns_pool, act.mark);
+    }
+
+    close(map_fd);
+    return 0;
+}
+
+int action_set(int argc, char **argv) {
+    if (argc < ACTION_SET_ARGS_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" ACTION_PROG_USAGE "\n");
+        return -1;
+    }
+
+    char *end = NULL;
+    unsigned long id = strtoul(argv[3], &end, 0);
+    if (end == argv[3] || *end != '\0' || ACTION_NONE == id || id >= ACTION_MAX_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误 action id [%s]，有效范围 1 - %d\n", argv[3], ACTION_MAX_NUM - 1);
+        return -1;
+    }
+
+    unsigned long pool = strtoul(argv[4], &end, 0);
+    if (end == argv[4] || *end != '\0' || pool >= DNS_POOL_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误 dns pool id [%s]，有效范围 0 - %d\n", argv[4], DNS_POOL_NUM - 1);
+        return -1;
+    }
+
+    unsigned long mark = strtoul(argv[5], &end, 0);
+    if (end == argv[5] || *end != '\0') {
+        fprintf(stderr, "[ERROR] 参数错误 mark [%s]\n", argv[5]);
+        return -1;
+    }
+
+    int map_fd = bpf_obj_get(ACTION_XDP_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", ACTION_XDP_PIN, strerror(errno));
+        return -1;
+    }
+
+    __u32 key = (__u32)id;
+    action_t act = {.dns_pool = (unsigned int)pool, .mark = (unsigned int)mark};
+    int ret = bpf_map_update_elem(map_fd, &key, &act, BPF_ANY);
+    if (ret) fprintf(stderr, "[ERROR] 动作 %u 更新失败: %s\n", key, strerror(errno));
+    else printf("[INFO] 动作 %u 已更新: dns pool %u, mark 0x%08x\n", key, act.dns_pool, act.mark);
+
+    close(map_fd);
+    return ret;
+}
+
+int action_args_parse(int argc, char **argv) {
+    if (argc < ACTION_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" ACTION_PROG_USAGE "\n");
+        return -1;
+    }
+
+    if (!strcmp(argv[2], ACTION_ARGS_SHOW)) return action_show(argc, argv);
+    else if (!strcmp(argv[2], ACTION_ARGS_SET)) return action_set(argc, argv);
+
+    return 0;
+}
+
+int action_main(int argc, char **argv) {
+    return action_args_parse(argc, argv);
+}
@@ -0,0 +1,344 @@
+/*
+ * File     : bundle.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-28 15:35:44
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+#include "direct_path_bundle.h"
+
+/* 规则包编译参数最少个数: direct_path rule compile [bundle] [map] [type] [num] [file] */
+#define BUNDLE_COMPILE_ARGS_MIN_NUM     8
+#define BUNDLE_LOAD_ARGS_MIN_NUM        4
+
+#define BUNDLE_ALIGN_UP(x)              (((x) + RULE_BUNDLE_ALIGN - 1) & ~((__u64)RULE_BUNDLE_ALIGN - 1))
+
+/* 编译过程中的一个段，data 为 count 个 key 后接 count 个 value */
+typedef struct {
+    rule_bundle_section_t sec;
+    void *data;
+} bundle_section_buf_t;
+
+typedef struct {
+    bundle_section_buf_t *secs;
+    __u32 num;
+    __u32 cap;
+    /* 当前规则组编号 */
+    __u32 group;
+} bundle_builder_t;
+
+/* 新增一个段，返回数据区，由调用者填充 key 与 value */
+static void *bundle_section_add(bundle_builder_t *b, const char *map_path, __u32 type,
+    __u32 key_size, __u32 value_size, size_t count) {
+    if (b->num == b->cap) {
+        __u32 cap = b->cap ? b->cap * 2 : 8;
+        bundle_section_buf_t *secs = realloc(b->secs, cap * sizeof(bundle_section_buf_t));
+        if (NULL == secs) return NULL;
+
+        b->secs = secs;
+        b->cap = cap;
+    }
+
+    void *data = malloc(count * (key_size + value_size) + 1);
+    if (NULL == data) return NULL;
+
+    bundle_section_buf_t *buf = &b->secs[b->num++];
+    memset(buf, 0, sizeof(*buf));
+    strncpy(buf->sec.map_path, map_path, RULE_BUNDLE_PATH_LEN - 1);
+    buf->sec.group = b->group;
+    buf->sec.type = type;
+    buf->sec.key_size = key_size;
+    buf->sec.value_size = value_size;
+    buf->sec.count = count;
+    buf->data = data;
+
+    return data;
+}
+
+static void bundle_builder_free(bundle_builder_t *b) {
+    for (__u32 i = 0; i < b->num; i++) free(b->secs[i].data);
+    free(b->secs);
+    memset(b, 0, sizeof(*b));
+}
+
+/* 一组规则文件解析、去重后转为段 */
+static int bundle_compile_group(const char *import_type, const char *map_path,
+    char **rule_files, __u32 rule_file_num, __u32 default_action, void *ctx) {
+    bundle_builder_t *b = ctx;
+    if (strlen(map_path) >= RULE_BUNDLE_PATH_LEN) {
+        fprintf(stderr, "[ERROR] map 路径过长: %s\n", map_path);
+        return -1;
+    }
+
+    import_rules_t rules;
+    memset(&rules, 0, sizeof(rules));
+
+    int ret = import_rules_collect(import_type, rule_files, rule_file_num, default_action, &rules);
+    if (ret) goto out;
+
+    ret = -1;
+    if (!strcmp(import_type, IMPORT_TYPE_IP)) {
+        ip_rule_set_dedup(&rules.ip);
+
+        ip_lpm_key_t *keys = bundle_section_add(b, map_path, RULE_BUNDLE_SEC_IP,
+            sizeof(ip_lpm_key_t), sizeof(__u32), rules.ip.num);
+        if (NULL == keys) goto out;
+
+        __u32 *values = (__u32 *)(keys + rules.ip.num);
+        for (size_t i = 0; i < rules.ip.num; i++) {
+            keys[i] = rules.ip.rules[i].key;
+            values[i] = rules.ip.rules[i].action;
+        }
+
+        printf("[INFO] %s: IP 规则 %zu 条\n", map_path, rules.ip.num);
+    } else {
+        size_t dup = 0, shadowed = 0;
+        domain_rule_set_prune(&rules.domain, &dup, &shadowed);
+
+        domain_lpm_key_t *keys = bundle_section_add(b, map_path, RULE_BUNDLE_SEC_DOMAIN,
+            sizeof(domain_lpm_key_t), sizeof(__u32), rules.domain.num);
+        if (NULL == keys) goto out;
+
+        __u32 *values = (__u32 *)(keys + rules.domain.num);
+        for (size_t i = 0; i < rules.domain.num; i++) {
+            keys[i] = rules.domain.rules[i].key;
+            values[i] = rules.domain.rules[i].action;
+        }
+
+        keyword_key_t *kw_keys = bundle_section_add(b, map_path, RULE_BUNDLE_SEC_KEYWORD,
+            sizeof(keyword_key_t), sizeof(__u32), rules.keyword.num);
+        if (NULL == kw_keys) goto out;
+
+        memcpy(kw_keys, rules.keyword.keys, rules.keyword.num * sizeof(keyword_key_t));
+        memcpy(kw_keys + rules.keyword.num, rules.keyword.actions, rules.keyword.num * sizeof(__u32));
+
+        printf("[INFO] %s: 域名规则 %zu 条 (重复 %zu 条，被更短后缀覆盖 %zu 条)，关键字 %zu 条\n",
+            map_path, rules.domain.num, dup, shadowed, rules.keyword.num);
+    }
+
+    b->group++;
+    ret = 0;
+
+out:
+    import_rules_free(&rules);
+    return ret;
+}
+
+/* 按 头部 + 段表 + 各段数据 的布局写出，先写临时文件再改名，避免留下不完整的规则包 */
+static int bundle_write(const bundle_builder_t *b, const char *path) {
+    __u64 size = sizeof(rule_bundle_hdr_t) + (__u64)b->num * sizeof(rule_bundle_section_t);
+    for (__u32 i = 0; i < b->num; i++) {
+        const rule_bundle_section_t *sec = &b->secs[i].sec;
+        size = BUNDLE_ALIGN_UP(size) + sec->count * (sec->key_size + sec->value_size);
+    }
+
+    unsigned char *buf = calloc(1, size);
+    if (NULL == buf) return -1;
+
+    rule_bundle_hdr_t *hdr = (rule_bundle_hdr_t *)buf;
+    rule_bundle_section_t *secs = (rule_bundle_section_t *)(hdr + 1);
+    __u64 offset = sizeof(rule_bundle_hdr_t) + (__u64)b->num * sizeof(rule_bundle_section_t);
+    for (__u32 i = 0; i < b->num; i++) {
+        offset = BUNDLE_ALIGN_UP(offset);
+        secs[i] = b->secs[i].sec;
+        secs[i].offset = offset;
+
+        __u64 bytes = secs[i].count * (secs[i].key_size + secs[i].value_size);
+        memcpy(buf + offset, b->secs[i].data, bytes);
+        offset += bytes;
+    }
+
+    hdr->magic = RULE_BUNDLE_MAGIC;
+    hdr->version = RULE_BUNDLE_VERSION;
+    hdr->domain_sym_bits = DOMAIN_SYM_BITS;
+    hdr->domain_key_size = sizeof(domain_lpm_key_t);
+    hdr->section_num = b->num;
+    hdr->size = size;
+    hdr->crc32 = crc32(0L, buf + sizeof(rule_bundle_hdr_t), size - sizeof(rule_bundle_hdr_t));
+
+    char tmp[FILE_LINE_MAXLEN];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    int ret = -1;
+    FILE *fp = fopen(tmp, "wb");
+    if (NULL == fp) {
+        fprintf(stderr, "[ERROR] 无法创建规则包 %s: %s\n", tmp, strerror(errno));
+        goto out;
+    }
+
+    bool ok = (1 == fwrite(buf, size, 1, fp));
+    ok = (0 == fclose(fp)) && ok;
+    if (!ok || rename(tmp, path)) {
+        fprintf(stderr, "[ERROR] 写入规则包 %s 失败: %s\n", path, strerror(errno));
+        unlink(tmp);
+        goto out;
+    }
+
+    printf("[INFO] 规则包 %s 已生成: %u 段，%llu 字节，crc32 %08x\n",
+        path, b->num, (unsigned long long)size, hdr->crc32);
+    ret = 0;
+
+out:
+    free(buf);
+    return ret;
+}
+
+int bundle_compile_args_parse(int argc, char **argv) {
+    if (argc < BUNDLE_COMPILE_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" BUNDLE_COMPILE_USAGE "\n");
+        return -1;
+    }
+
+    bundle_builder_t b;
+    memset(&b, 0, sizeof(b));
+
+    /* 只解析规则文件，不访问 BPF，可在编译主机上运行 */
+    int ret = rule_groups_foreach(argc, argv, 4, bundle_compile_group, &b);
+    if (!ret) ret = bundle_write(&b, argv[3]);
+
+    bundle_builder_free(&b);
+    return ret;
+}
+
+/* 校验段描述与数据区范围 */
+static bool bundle_section_check(const rule_bundle_hdr_t *hdr, const rule_bundle_section_t *sec) {
+    __u32 key_size = 0;
+    switch (sec->type) {
+        case RULE_BUNDLE_SEC_IP: key_size = sizeof(ip_lpm_key_t); break;
+        case RULE_BUNDLE_SEC_DOMAIN: key_size = sizeof(domain_lpm_key_t); break;
+        case RULE_BUNDLE_SEC_KEYWORD: key_size = sizeof(keyword_key_t); break;
+        default: return false;
+    }
+
+    if (sec->key_size != key_size || sec->value_size != sizeof(__u32)) return false;
+    if (NULL == memchr(sec->map_path, '\0', RULE_BUNDLE_PATH_LEN)) return false;
+    if (sec->offset > hdr->size || sec->count > (hdr->size - sec->offset) / (key_size + sizeof(__u32))) return false;
+
+    return true;
+}
+
+/* 将一个段的记录加入规则集合 */
+static bool bundle_section_collect(const unsigned char *base, const rule_bundle_section_t *sec, import_rules_t *rules) {
+    const unsigned char *keys = base + sec->offset;
+    const __u32 *values = (const __u32 *)(keys + sec->count * sec->key_size);
+
+    for (__u64 i = 0; i < sec->count; i++) {
+        const void *key = keys + i * sec->key_size;
+        bool ok = true;
+        switch (sec->type) {
+            case RULE_BUNDLE_SEC_IP: ok = ip_rule_set_add(&rules->ip, key, values[i]); break;
+            case RULE_BUNDLE_SEC_DOMAIN: ok = domain_rule_set_add(&rules->domain, key, values[i]); break;
+            case RULE_BUNDLE_SEC_KEYWORD: {
+                char keyword[DOMAIN_MAX_LEN + 1] = {0};
+                memcpy(keyword, ((const keyword_key_t *)key)->keyword, DOMAIN_MAX_LEN);
+                ok = keyword_set_add(&rules->keyword, keyword, values[i]);
+            } break;
+        }
+
+        if (!ok) return false;
+    }
+
+    return true;
+}
+
+static int bundle_load(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[ERROR] 无法打开规则包 %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int ret = -1;
+    struct stat st;
+    unsigned char *base = MAP_FAILED;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(rule_bundle_hdr_t)) {
+        fprintf(stderr, "[ERROR] 规则包 %s 不完整\n", path);
+        goto out;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == base) {
+        fprintf(stderr, "[ERROR] 规则包 mmap 失败: %s\n", strerror(errno));
+        goto out;
+    }
+
+    const rule_bundle_hdr_t *hdr = (const rule_bundle_hdr_t *)base;
+    if (RULE_BUNDLE_MAGIC != hdr->magic || RULE_BUNDLE_VERSION != hdr->version) {
+        fprintf(stderr, "[ERROR] 规则包 %s 格式或版本不支持 (字节序需与编译主机一致)\n", path);
+        goto out;
+    }
+
+    if (DOMAIN_SYM_BITS != hdr->domain_sym_bits || sizeof(domain_lpm_key_t) != hdr->domain_key_size) {
+        fprintf(stderr, "[ERROR] 规则包域名 key 编码与当前程序不一致，请使用相同的编译选项重新生成\n");
+        goto out;
+    }
+
+    if (hdr->size != (__u64)st.st_size ||
+        hdr->section_num > (hdr->size - sizeof(rule_bundle_hdr_t)) / sizeof(rule_bundle_section_t) ||
+        hdr->crc32 != crc32(0L, base + sizeof(rule_bundle_hdr_t), hdr->size - sizeof(rule_bundle_hdr_t))) {
+        fprintf(stderr, "[ERROR] 规则包 %s 校验失败\n", path);
+        goto out;
+    }
+
+    const rule_bundle_section_t *secs = (const rule_bundle_section_t *)(hdr + 1);
+    for (__u32 i = 0; i < hdr->section_num; i++) {
+        if (!bundle_section_check(hdr, &secs[i])) {
+            fprintf(stderr, "[ERROR] 规则包 %s 第 %u 段无效\n", path, i);
+            goto out;
+        }
+    }
+
+    /* 同一组的段合并后整组写入，与文本导入的写入路径一致 */
+    __u64 records = 0;
+    for (__u32 i = 0; i < hdr->section_num;) {
+        const rule_bundle_section_t *first = &secs[i];
+        const char *import_type = (RULE_BUNDLE_SEC_IP == first->type) ? IMPORT_TYPE_IP : IMPORT_TYPE_DOMAIN;
+
+        import_rules_t rules;
+        memset(&rules, 0, sizeof(rules));
+
+        bool ok = true;
+        for (; i < hdr->section_num && secs[i].group == first->group; i++) {
+            ok = ok && bundle_section_collect(base, &secs[i], &rules);
+            records += secs[i].count;
+        }
+
+        int err = ok ? import_rules_apply(import_type, first->map_path, &rules) : -1;
+        import_rules_free(&rules);
+        if (err) {
+            fprintf(stderr, "[ERROR] 规则包写入 %s 失败\n", first->map_path);
+            goto out;
+        }
+    }
+
+    printf("[INFO] 规则包 %s 加载完成: %u 段，%llu 条记录\n", path, hdr->section_num, (unsigned long long)records);
+    ret = 0;
+
+out:
+    if (MAP_FAILED != base) munmap(base, st.st_size);
+    close(fd);
+
+    return ret;
+}
+
+int bundle_load_args_parse(int argc, char **argv) {
+    if (argc < BUNDLE_LOAD_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" BUNDLE_LOAD_USAGE "\n");
+        return -1;
+    }
+
+    return bundle_load(argv[3]);
+}
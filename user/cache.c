@@ -0,0 +1,506 @@
+/*
+ * File     : cache.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-01 21:16:02
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <time.h>
+#include <zlib.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+#include "direct_path_cache.h"
+#include "direct_path_config.h"
+
+#define CACHE_NSEC_PER_SEC          1000000000ULL
+
+/* value 中没有 ktime 时间戳 */
+#define CACHE_NO_KTIME              (-1)
+
+/* 需要快照的缓存 map */
+typedef struct {
+    const char *name;
+    const char *pin;
+    __u32 key_size;
+    __u32 value_size;
+    /* 容量在配置中的偏移，与 create_map 使用同一配置 */
+    size_t size_off;
+    /* value 中 bpf_ktime_get_ns 时间戳的偏移 */
+    int ktime_off;
+    /* value 中动作编号的偏移 */
+    size_t action_off;
+} cache_map_desc_t;
+
+static const cache_map_desc_t cache_maps[] = {
+    { HOTPATH_MAPNAME, HOTPATHMAP_PIN, CACHE_IP_MAP_KEY_SIZE, CACHE_IP_MAP_VAL_SIZE,
+        offsetof(direct_path_conf_t, hotpath_cache_size), offsetof(hotpath_val_t, update_time),
+        offsetof(hotpath_val_t, action) },
+    { PRE_MAPNAME, PREMAP_PIN, PRE_CACHE_IP_MAP_KEY_SIZE, PRE_CACHE_IP_MAP_VAL_SIZE,
+        offsetof(direct_path_conf_t, pre_cache_size), offsetof(pre_val_t, first_seen),
+        offsetof(pre_val_t, action) },
+    { DOMAINCACHE_MAPNAME, DOMAINCACHE_PIN, DOMAINPRE_MAP_KEY_SIZE, DOMAINPRE_MAP_VAL_SIZE,
+        offsetof(direct_path_conf_t, domain_cache_size), CACHE_NO_KTIME,
+        offsetof(domain_cache_val_t, action) },
+};
+
+#define CACHE_MAP_NUM               (sizeof(cache_maps) / sizeof(cache_maps[0]))
+
+static __u32 cache_map_max_entries(const cache_map_desc_t *desc) {
+    return *(const __u32 *)((const char *)conf_get() + desc->size_off);
+}
+
+/* 与 bpf_ktime_get_ns 同一时钟 */
+static __u64 ktime_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (__u64)ts.tv_sec * CACHE_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* ktime 时间戳与距当前的时长互相换算 (两个方向都是 now - t)，values 未必 8 字节对齐 */
+static void cache_ktime_rebase(const cache_map_desc_t *desc, unsigned char *values, size_t num) {
+    if (CACHE_NO_KTIME == desc->ktime_off) return ;
+
+    __u64 now = ktime_now();
+    for (size_t i = 0; i < num; i++) {
+        unsigned char *p = values + i * desc->value_size + desc->ktime_off;
+
+        __u64 t = 0;
+        memcpy(&t, p, sizeof(t));
+        /* 保存: 时间戳 -> 时长；恢复: 时长 -> 时间戳，重启后 ktime 小于时长时取 0 */
+        t = (now > t) ? now - t : 0;
+        memcpy(p, &t, sizeof(t));
+    }
+}
+
+/* 逐个遍历导出，用于不支持批量操作的内核 */
+static size_t cache_map_dump_iter(int map_fd, const cache_map_desc_t *desc, unsigned char *keys, unsigned char *values) {
+    size_t num = 0;
+    void *prev = NULL;
+    while (num < cache_map_max_entries(desc) && !bpf_map_get_next_key(map_fd, prev, keys + num * desc->key_size)) {
+        unsigned char *key = keys + num * desc->key_size;
+        prev = key;
+        /* 遍历过程中条目可能被淘汰，查不到时跳过 */
+        if (bpf_map_lookup_elem(map_fd, key, values + num * desc->value_size)) continue;
+
+        num++;
+    }
+
+    return num;
+}
+
+/* 导出 map 全部条目，返回条目数，失败返回 -1 */
+static long cache_map_dump(int map_fd, const cache_map_desc_t *desc, unsigned char *keys, unsigned char *values) {
+    struct bpf_map_batch_opts opts = {
+        .sz = sizeof(opts),
+    };
+
+    /* 批量遍历位置，hash 类 map 的游标为 4 字节桶编号 */
+    __u64 in_batch = 0, out_batch = 0;
+    size_t num = 0;
+    bool first = true;
+    __u32 max_entries = cache_map_max_entries(desc);
+    while (num < max_entries) {
+        __u32 count = max_entries - num;
+        if (count > RULE_BATCH_SIZE) count = RULE_BATCH_SIZE;
+
+        int ret = bpf_map_lookup_batch(map_fd, first ? NULL : &in_batch, &out_batch,
+            keys + num * desc->key_size, values + num * desc->value_size, &count, &opts);
+        if (ret && ENOENT != errno) {
+            if (!first || (EINVAL != errno && EOPNOTSUPP != errno && ENOTSUPP != errno)) {
+                fprintf(stderr, "[ERROR] %s 导出失败: %s\n", desc->name, strerror(errno));
+                return -1;
+            }
+
+            return cache_map_dump_iter(map_fd, desc, keys, values);
+        }
+
+        num += count;
+        if (ret) break;
+
+        in_batch = out_batch;
+        first = false;
+    }
+
+    return num;
+}
+
+int cache_save(const char *path) {
+    char tmp[FILE_LINE_MAXLEN];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp, "wb");
+    if (NULL == fp) {
+        fprintf(stderr, "[ERROR] 无法创建缓存快照 %s: %s\n", tmp, strerror(errno));
+        return -1;
+    }
+
+    /* 先写占位头部，各段写完后回填 CRC */
+    cache_snapshot_hdr_t hdr = {
+        .magic = CACHE_SNAPSHOT_MAGIC,
+        .version = CACHE_SNAPSHOT_VERSION,
+        .save_time = time(NULL),
+    };
+    bool ok = (1 == fwrite(&hdr, sizeof(hdr), 1, fp));
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (size_t i = 0; ok && i < CACHE_MAP_NUM; i++) {
+        const cache_map_desc_t *desc = &cache_maps[i];
+        int map_fd = bpf_obj_get(desc->pin);
+        if (map_fd < 0) {
+            fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", desc->pin, strerror(errno));
+            ok = false;
+            break;
+        }
+
+        unsigned char *keys = malloc((size_t)cache_map_max_entries(desc) * desc->key_size);
+        unsigned char *values = malloc((size_t)cache_map_max_entries(desc) * desc->value_size);
+        long num = (keys && values) ? cache_map_dump(map_fd, desc, keys, values) : -1;
+        close(map_fd);
+
+        if (num >= 0) {
+            cache_ktime_rebase(desc, values, num);
+
+            cache_snapshot_section_t sec;
+            memset(&sec, 0, sizeof(sec));
+            strncpy(sec.name, desc->name, CACHE_SNAPSHOT_NAME_LEN - 1);
+            sec.key_size = desc->key_size;
+            sec.value_size = desc->value_size;
+            sec.count = num;
+
+            crc = crc32(crc, (const Bytef *)&sec, sizeof(sec));
+            crc = crc32(crc, keys, num * desc->key_size);
+            crc = crc32(crc, values, num * desc->value_size);
+            ok = (1 == fwrite(&sec, sizeof(sec), 1, fp)) &&
+                (fwrite(keys, desc->key_size, num, fp) == (size_t)num) &&
+                (fwrite(values, desc->value_size, num, fp) == (size_t)num);
+            hdr.section_num++;
+
+            printf("[INFO] %s: 保存 %ld 条\n", desc->name, num);
+        } else ok = false;
+
+        free(keys);
+        free(values);
+    }
+
+    hdr.crc32 = crc;
+    ok = ok && !fseek(fp, 0, SEEK_SET) && (1 == fwrite(&hdr, sizeof(hdr), 1, fp));
+    ok = ok && !fflush(fp) && !fsync(fileno(fp));
+    ok = (0 == fclose(fp)) && ok;
+    if (!ok || rename(tmp, path)) {
+        fprintf(stderr, "[ERROR] 缓存快照 %s 保存失败\n", path);
+        unlink(tmp);
+        return -1;
+    }
+
+    printf("[INFO] 缓存快照已保存到 %s\n", path);
+
+    return 0;
+}
+
+static const cache_map_desc_t *cache_map_desc_find(const char *name) {
+    for (size_t i = 0; i < CACHE_MAP_NUM; i++) {
+        if (!strcmp(cache_maps[i].name, name)) return &cache_maps[i];
+    }
+
+    return NULL;
+}
+
+/* 以文本输出一个缓存的全部条目: 地址或域名、动作编号与加入时长 */
+int cache_dump(const char *name) {
+    const cache_map_desc_t *desc = cache_map_desc_find(name);
+    if (NULL == desc) {
+        fprintf(stderr, "[ERROR] 参数错误 [%s]，" CACHE_PROG_USAGE "\n", name);
+        return -1;
+    }
+
+    int map_fd = bpf_obj_get(desc->pin);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", desc->pin, strerror(errno));
+        return -1;
+    }
+
+    unsigned char *keys = malloc((size_t)cache_map_max_entries(desc) * desc->key_size);
+    unsigned char *values = malloc((size_t)cache_map_max_entries(desc) * desc->value_size);
+    long num = (keys && values) ? cache_map_dump(map_fd, desc, keys, values) : -1;
+    close(map_fd);
+
+    __u64 now = ktime_now();
+    for (long i = 0; i < num; i++) {
+        const unsigned char *key = keys + i * desc->key_size;
+        const unsigned char *value = values + i * desc->value_size;
+
+        char text[CACHE_DUMP_NAME_MAXLEN];
+        if (sizeof(__u32) == desc->key_size) {
+            inet_ntop(AF_INET, key, text, sizeof(text));
+        } else {
+            domain_lpm_key_t domain;
+            memcpy(&domain, key, sizeof(domain));
+            if (!domain_decode(&domain, text, sizeof(text))) continue;
+        }
+
+        __u32 action = 0;
+        memcpy(&action, value + desc->action_off, sizeof(action));
+        printf("%-40s action=%-3u", text, action);
+
+        if (CACHE_NO_KTIME != desc->ktime_off) {
+            __u64 t = 0;
+            memcpy(&t, value + desc->ktime_off, sizeof(t));
+            printf(" age=%llus", (unsigned long long)((now > t) ? (now - t) / CACHE_NSEC_PER_SEC : 0));
+        }
+        printf("\n");
+    }
+
+    if (num >= 0) printf("[INFO] %s: 共 %ld 条\n", desc->name, num);
+
+    free(keys);
+    free(values);
+    return (num >= 0) ? 0 : -1;
+}
+
+/* 读取整个快照文件并校验，成功返回内容，由调用者释放 */
+static unsigned char *cache_snapshot_read(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (NULL == fp) {
+        fprintf(stderr, "[ERROR] 无法打开缓存快照 %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    unsigned char *buf = NULL;
+    long len = (!fseek(fp, 0, SEEK_END)) ? ftell(fp) : -1;
+    if (len >= (long)sizeof(cache_snapshot_hdr_t) && !fseek(fp, 0, SEEK_SET)) {
+        buf = malloc(len);
+        if (NULL != buf && 1 != fread(buf, len, 1, fp)) {
+            free(buf);
+            buf = NULL;
+        }
+    }
+    fclose(fp);
+
+    if (NULL == buf) {
+        fprintf(stderr, "[ERROR] 缓存快照 %s 读取失败\n", path);
+        return NULL;
+    }
+
+    const cache_snapshot_hdr_t *hdr = (const cache_snapshot_hdr_t *)buf;
+    if (CACHE_SNAPSHOT_MAGIC != hdr->magic || CACHE_SNAPSHOT_VERSION != hdr->version ||
+        hdr->crc32 != crc32(0L, buf + sizeof(*hdr), len - sizeof(*hdr))) {
+        fprintf(stderr, "[ERROR] 缓存快照 %s 格式错误或已损坏\n", path);
+        free(buf);
+        return NULL;
+    }
+
+    *size = len;
+    return buf;
+}
+
+/* 按当前规则查询一个快照条目应得的动作，IP 先查黑名单，命中黑名单返回 ACTION_NONE */
+static __u32 cache_rule_action(const cache_map_desc_t *desc, const unsigned char *key, int rule_fd, int blk_fd) {
+    __u32 action = ACTION_NONE;
+
+    if (sizeof(__u32) == desc->key_size) {
+        ip_lpm_key_t lpm = {.prefixlen = 32};
+        memcpy(&lpm.ipv4, key, sizeof(lpm.ipv4));
+
+        __u32 blk = 0;
+        if (!bpf_map_lookup_elem(blk_fd, &lpm, &blk)) return ACTION_NONE;
+        if (bpf_map_lookup_elem(rule_fd, &lpm, &action)) return ACTION_NONE;
+        return action;
+    }
+
+    domain_lpm_key_t domain;
+    memcpy(&domain, key, sizeof(domain));
+    if (bpf_map_lookup_elem(rule_fd, &domain, &action)) return ACTION_NONE;
+    return action;
+}
+
+/* 打开校验缓存条目所需的规则 map，IP 缓存同时需要黑名单 */
+static bool cache_rule_open(const cache_map_desc_t *desc, int *rule_fd, int *blk_fd) {
+    bool is_ip = (sizeof(__u32) == desc->key_size);
+
+    *rule_fd = bpf_obj_get(is_ip ? DIRECTMAP_PIN : DOMAINMAP_PIN);
+    *blk_fd = is_ip ? bpf_obj_get(BLACKMAP_PIN) : -1;
+    if (*rule_fd >= 0 && (!is_ip || *blk_fd >= 0)) return true;
+
+    if (*rule_fd >= 0) close(*rule_fd);
+    if (*blk_fd >= 0) close(*blk_fd);
+    return false;
+}
+
+/* 条目是否与当前规则一致: 未进入黑名单、仍然命中且动作相同 */
+static bool cache_entry_valid(const cache_map_desc_t *desc, const unsigned char *key,
+    const unsigned char *value, int rule_fd, int blk_fd) {
+    __u32 action = 0;
+    memcpy(&action, value + desc->action_off, sizeof(action));
+    return ACTION_NONE != action && cache_rule_action(desc, key, rule_fd, blk_fd) == action;
+}
+
+/* 丢弃与当前规则不一致的条目，原地压缩，返回保留的条目数
+ * 数据面信任缓存结果，恢复旧条目会让规则更新前的结果继续生效；
+ * 由 DOMAIN-KEYWORD 得出的域名缓存在域名库中查不到，同样丢弃，由数据面重新学习 */
+static size_t cache_restore_filter(const cache_map_desc_t *desc, unsigned char *keys, unsigned char *values, size_t num) {
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    /* Arena 引擎没有可在用户态查询的域名库 map，不恢复域名缓存 */
+    if (sizeof(__u32) != desc->key_size) {
+        printf("[INFO] %s: Arena 引擎下无法按规则校验，跳过\n", desc->name);
+        return 0;
+    }
+#endif
+
+    int rule_fd = -1, blk_fd = -1;
+    if (!cache_rule_open(desc, &rule_fd, &blk_fd)) {
+        fprintf(stderr, "[ERROR] 无法获取规则 map，%s 不恢复: %s\n", desc->name, strerror(errno));
+        return 0;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < num; i++) {
+        const unsigned char *key = keys + i * desc->key_size;
+        const unsigned char *value = values + i * desc->value_size;
+        if (!cache_entry_valid(desc, key, value, rule_fd, blk_fd)) continue;
+
+        memmove(keys + kept * desc->key_size, key, desc->key_size);
+        memmove(values + kept * desc->value_size, value, desc->value_size);
+        kept++;
+    }
+
+    if (kept < num) printf("[INFO] %s: %zu 条与当前规则不一致，丢弃\n", desc->name, num - kept);
+
+    close(rule_fd);
+    if (blk_fd >= 0) close(blk_fd);
+    return kept;
+}
+
+/* 删除缓存中与当前规则不一致的条目，规则删除后调用，避免已删除的规则通过缓存继续生效 */
+int cache_revalidate(const char *name) {
+    const cache_map_desc_t *desc = cache_map_desc_find(name);
+    if (NULL == desc) {
+        fprintf(stderr, "[ERROR] 参数错误 [%s]，" CACHE_PROG_USAGE "\n", name);
+        return -1;
+    }
+
+    /* Arena 引擎无法在用户态查询域名库，清空整个域名缓存 */
+    bool flush = false;
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    flush = (sizeof(__u32) != desc->key_size);
+#endif
+
+    int map_fd = bpf_obj_get(desc->pin);
+    int rule_fd = -1, blk_fd = -1;
+    if (map_fd < 0 || (!flush && !cache_rule_open(desc, &rule_fd, &blk_fd))) {
+        fprintf(stderr, "[ERROR] 无法获取 %s 或规则 map: %s\n", desc->name, strerror(errno));
+        if (map_fd >= 0) close(map_fd);
+        return -1;
+    }
+
+    unsigned char *keys = malloc((size_t)cache_map_max_entries(desc) * desc->key_size);
+    unsigned char *values = malloc((size_t)cache_map_max_entries(desc) * desc->value_size);
+    long num = (keys && values) ? cache_map_dump(map_fd, desc, keys, values) : -1;
+
+    long removed = 0;
+    for (long i = 0; i < num; i++) {
+        const unsigned char *key = keys + i * desc->key_size;
+        if (!flush && cache_entry_valid(desc, key, values + i * desc->value_size, rule_fd, blk_fd)) continue;
+        if (!bpf_map_delete_elem(map_fd, key)) removed++;
+    }
+
+    if (removed) printf("[INFO] %s: 删除与当前规则不一致的条目 %ld 条\n", desc->name, removed);
+
+    free(keys);
+    free(values);
+    if (blk_fd >= 0) close(blk_fd);
+    if (rule_fd >= 0) close(rule_fd);
+    close(map_fd);
+    return (num >= 0) ? 0 : -1;
+}
+
+static int cache_restore(const char *path) {
+    size_t size = 0;
+    unsigned char *buf = cache_snapshot_read(path, &size);
+    if (NULL == buf) return -1;
+
+    int ret = 0;
+    const cache_snapshot_hdr_t *hdr = (const cache_snapshot_hdr_t *)buf;
+    size_t offset = sizeof(*hdr);
+    for (__u32 i = 0; i < hdr->section_num; i++) {
+        cache_snapshot_section_t sec;
+        if (size - offset < sizeof(sec)) goto bad;
+
+        memcpy(&sec, buf + offset, sizeof(sec));
+        offset += sizeof(sec);
+        sec.name[CACHE_SNAPSHOT_NAME_LEN - 1] = '\0';
+
+        __u64 rec_size = (__u64)sec.key_size + sec.value_size;
+        if (0 == rec_size || sec.count > (size - offset) / rec_size) goto bad;
+
+        unsigned char *keys = buf + offset;
+        unsigned char *values = keys + sec.count * sec.key_size;
+        offset += sec.count * rec_size;
+
+        /* 编译选项改变 (如 DOMAIN_KEY_PACKED) 后 key 大小不同，跳过该 map */
+        const cache_map_desc_t *desc = cache_map_desc_find(sec.name);
+        if (NULL == desc || desc->key_size != sec.key_size || desc->value_size != sec.value_size) {
+            printf("[INFO] %s: 结构与当前程序不一致，跳过\n", sec.name);
+            continue;
+        }
+
+        if (sec.count > cache_map_max_entries(desc)) sec.count = cache_map_max_entries(desc);
+
+        int map_fd = bpf_obj_get(desc->pin);
+        if (map_fd < 0) {
+            fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", desc->pin, strerror(errno));
+            ret = -1;
+            continue;
+        }
+
+        cache_ktime_rebase(desc, values, sec.count);
+        sec.count = cache_restore_filter(desc, keys, values, sec.count);
+        if (map_update_all(map_fd, keys, desc->key_size, values, desc->value_size, sec.count)) {
+            fprintf(stderr, "[ERROR] %s 恢复失败\n", desc->name);
+            ret = -1;
+        } else printf("[INFO] %s: 恢复 %llu 条\n", desc->name, (unsigned long long)sec.count);
+
+        close(map_fd);
+    }
+
+    free(buf);
+    return ret;
+
+bad:
+    fprintf(stderr, "[ERROR] 缓存快照 %s 内容不完整\n", path);
+    free(buf);
+    return -1;
+}
+
+int cache_args_parse(int argc, char **argv) {
+    if (argc < CACHE_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" CACHE_PROG_USAGE "\n");
+        return -1;
+    }
+
+    if (!strcmp(argv[2], CACHE_ARGS_DUMP)) {
+        if (argc > CACHE_ARGS_MIN_NUM) return cache_dump(argv[3]);
+
+        int ret = 0;
+        for (size_t i = 0; i < CACHE_MAP_NUM; i++) ret |= cache_dump(cache_maps[i].name);
+        return ret;
+    }
+
+    const char *path = (argc > CACHE_ARGS_MIN_NUM) ? argv[3] : CACHE_DEFAULT_FILE;
+    if (!strcmp(argv[2], CACHE_ARGS_SAVE)) return cache_save(path);
+    else if (!strcmp(argv[2], CACHE_ARGS_RESTORE)) return cache_restore(path);
+
+    fprintf(stderr, "[ERROR] 参数错误 [%s]，" CACHE_PROG_USAGE "\n", argv[2]);
+    return -1;
+}
+
+int cache_main(int argc, char **argv) {
+    return cache_args_parse(argc, argv);
+}
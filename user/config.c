@@ -0,0 +1,183 @@
+/*
+ * File     : config.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-05 11:20:43
+*/
+
+#include <stdio.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "direct_path_user.h"
+#include "direct_path_config.h"
+
+/* 配置项类型 */
+#define CONF_TYPE_STR                   0
+#define CONF_TYPE_U32                   1
+/* 文件中以毫秒配置，保存为纳秒 */
+#define CONF_TYPE_MS                    2
+
+#define CONF_NSEC_PER_MSEC              1000000ULL
+
+typedef struct {
+    const char *key;
+    __u32 type;
+    size_t offset;
+    /* 数值的取值范围，字符串为最大长度 */
+    __u64 min;
+    __u64 max;
+} conf_item_t;
+
+static const conf_item_t conf_items[] = {
+    { CONF_KEY_LAN_IF, CONF_TYPE_STR, offsetof(direct_path_conf_t, lan_if), 1, IF_NAMESIZE - 1 },
+    { CONF_KEY_WAN_IF, CONF_TYPE_STR, offsetof(direct_path_conf_t, wan_if), 1, IF_NAMESIZE - 1 },
+    { CONF_KEY_DIRECT_DNS_PORT, CONF_TYPE_U32, offsetof(direct_path_conf_t, direct_dns_port), 1, 65535 },
+    { CONF_KEY_PROXY_DNS_PORT, CONF_TYPE_U32, offsetof(direct_path_conf_t, proxy_dns_port), 1, 65535 },
+    { CONF_KEY_DIRECT_MARK, CONF_TYPE_U32, offsetof(direct_path_conf_t, direct_mark), 0, 0xFFFFFFFFU },
+    { CONF_KEY_HOTPKG_NUM, CONF_TYPE_U32, offsetof(direct_path_conf_t, hotpkg_num), 1, 0xFFFFFFFFU },
+    { CONF_KEY_HOTPKG_INV_MS, CONF_TYPE_MS, offsetof(direct_path_conf_t, hotpkg_inv_time), 0, 3600000 },
+    { CONF_KEY_DEBUG, CONF_TYPE_U32, offsetof(direct_path_conf_t, debug), 0, 1 },
+    { CONF_KEY_PROFILE, CONF_TYPE_U32, offsetof(direct_path_conf_t, profile), 0, 1 },
+    { CONF_KEY_HOTPATH_CACHE_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, hotpath_cache_size), 1, 1U << 24 },
+    { CONF_KEY_PRE_CACHE_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, pre_cache_size), 1, 1U << 24 },
+    { CONF_KEY_BLKLIST_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, blklist_size), 1, 1U << 24 },
+    { CONF_KEY_DIRECT_IP_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, direct_ip_size), 1, 1U << 24 },
+    { CONF_KEY_DOMAIN_CACHE_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, domain_cache_size), 1, 1U << 24 },
+    { CONF_KEY_DOMAIN_MAP_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, domain_map_size), 1, 1U << 26 },
+    { CONF_KEY_DOMAIN_BLOOM_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, domain_bloom_size), 1, 1U << 26 },
+    { CONF_KEY_RATELIMIT_SIZE, CONF_TYPE_U32, offsetof(direct_path_conf_t, ratelimit_size), 1, 1U << 24 },
+    { CONF_KEY_MEM_BUDGET_KB, CONF_TYPE_U32, offsetof(direct_path_conf_t, mem_budget_kb), 1024, 1U << 26 },
+};
+
+#define CONF_ITEM_NUM                   (sizeof(conf_items) / sizeof(conf_items[0]))
+
+/* 默认配置 */
+static const direct_path_conf_t conf_default = {
+    .lan_if = LAN_IF,
+    .wan_if = WAN_IF,
+    .direct_dns_port = DIRECT_DNS_SERVER_PORT,
+    .proxy_dns_port = PROXY_DNS_SERVER_PORT,
+    .direct_mark = DIRECT_MARK,
+    .hotpkg_num = HOTPKG_NUM,
+    .hotpkg_inv_time = HOTPKG_INV_TIME,
+    .debug = 0,
+    .profile = 0,
+    .hotpath_cache_size = CACHE_IP_MAP_SIZE,
+    .pre_cache_size = PRE_CACHE_IP_MAP_SIZE,
+    .blklist_size = BLKLIST_IP_MAP_SIZE,
+    .direct_ip_size = DIRECT_IP_MAP_SIZE,
+    .domain_cache_size = DOMAINPRE_MAP_SIZE,
+    .domain_map_size = DOMAIN_MAP_SIZE,
+    .domain_bloom_size = DOMAIN_BLOOM_MAP_SIZE,
+    .ratelimit_size = RATELIMIT_MAP_SIZE,
+    .mem_budget_kb = MAP_MEM_BUDGET_KB,
+};
+
+static direct_path_conf_t conf;
+static bool conf_loaded = false;
+
+/* 只含配置文件，不含 plan 生成的容量 */
+static direct_path_conf_t conf_base;
+static bool conf_base_loaded = false;
+
+/* 去掉首尾空白 */
+static char *conf_trim(char *str) {
+    while (isspace((unsigned char)*str)) str++;
+
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+
+    return str;
+}
+
+static bool conf_item_set(direct_path_conf_t *dst, const conf_item_t *item, const char *value) {
+    void *field = (char *)dst + item->offset;
+
+    if (CONF_TYPE_STR == item->type) {
+        size_t len = strlen(value);
+        if (len < item->min || len > item->max) return false;
+
+        memcpy(field, value, len + 1);
+        return true;
+    }
+
+    /* 支持 0x 前缀的十六进制，便于配置 mark */
+    char *end = NULL;
+    errno = 0;
+    unsigned long long num = strtoull(value, &end, 0);
+    if (errno || end == value || '\0' != *end || num < item->min || num > item->max) return false;
+
+    if (CONF_TYPE_MS == item->type) *(__u64 *)field = num * CONF_NSEC_PER_MSEC;
+    else *(__u32 *)field = num;
+
+    return true;
+}
+
+static bool conf_parse_line(direct_path_conf_t *dst, const char *path, char *line, __u32 line_no) {
+    char *comment = strchr(line, '#');
+    if (NULL != comment) *comment = '\0';
+
+    char *key = conf_trim(line);
+    if ('\0' == *key) return true;
+
+    char *sep = strchr(key, '=');
+    if (NULL == sep) {
+        fprintf(stderr, "[ERROR] %s 第 %u 行格式错误，应为 key = value\n", path, line_no);
+        return false;
+    }
+
+    *sep = '\0';
+    key = conf_trim(key);
+    char *value = conf_trim(sep + 1);
+
+    for (size_t i = 0; i < CONF_ITEM_NUM; i++) {
+        if (strcmp(conf_items[i].key, key)) continue;
+
+        if (conf_item_set(dst, &conf_items[i], value)) return true;
+
+        fprintf(stderr, "[ERROR] %s 第 %u 行 %s 的值 [%s] 无效\n", path, line_no, key, value);
+        return false;
+    }
+
+    fprintf(stderr, "[ERROR] %s 第 %u 行未知配置项 [%s]\n", path, line_no, key);
+    return false;
+}
+
+/* 文件不存在时保持当前值，错误的行跳过并提示 */
+static void conf_load(direct_path_conf_t *dst, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (NULL == fp) return ;
+
+    __u32 line_no = 0;
+    char line[FILE_LINE_MAXLEN] = {0};
+    while (fgets(line, sizeof(line), fp)) conf_parse_line(dst, path, line, ++line_no);
+
+    fclose(fp);
+}
+
+const direct_path_conf_t *conf_get(void) {
+    if (!conf_loaded) {
+        conf = conf_default;
+        conf_load(&conf, DIRECT_PATH_CONF_FILE);
+        conf_load(&conf, DIRECT_PATH_PLAN_FILE);
+        conf_loaded = true;
+    }
+
+    return &conf;
+}
+
+const direct_path_conf_t *conf_get_base(void) {
+    if (!conf_base_loaded) {
+        conf_base = conf_default;
+        conf_load(&conf_base, DIRECT_PATH_CONF_FILE);
+        conf_base_loaded = true;
+    }
+
+    return &conf_base;
+}
@@ -0,0 +1,920 @@
+/*
+ * File     : daemon.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-20 21:20:46
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+#include "direct_path_dir24.h"
+#include "direct_path_cache.h"
+#include "direct_path_stats.h"
+#include "direct_path_daemon.h"
+
+/* 排序去重后的 key 集合 */
+typedef struct {
+    unsigned char *keys;
+    size_t num;
+    __u32 key_size;
+} daemon_keys_t;
+
+/* 规则组写入的目标 map，启动时按 map 名称确定，与路径的写法无关 */
+typedef enum {
+    DAEMON_MAP_OTHER = 0,
+    DAEMON_MAP_DIRECT,
+    DAEMON_MAP_BLKLIST,
+    DAEMON_MAP_DOMAIN,
+} daemon_map_type_t;
+
+/* 一组规则文件，参数格式与 rule 命令一致 */
+typedef struct {
+    const char *map_path;
+    daemon_map_type_t map_type;
+    char import_type[IMPORT_TYPE_MAX_LEN];
+    __u32 default_action;
+    char **files;
+    __u32 file_num;
+    /* 每个文件所在目录的 inotify watch，同一目录的 watch 相同 */
+    int *wds;
+
+    /* 上次成功写入的规则与关键字，重新导入时据此删除不再出现的 key */
+    daemon_keys_t rules;
+    daemon_keys_t keywords;
+
+    bool dirty;
+    int last_ret;
+    __u64 apply_num;
+    time_t apply_time;
+} daemon_group_t;
+
+typedef struct {
+    daemon_group_t groups[DAEMON_GROUP_MAX];
+    __u32 group_num;
+
+    const char *sock_path;
+    const char *cache_file;
+    __u32 save_sec;
+
+    int ino_fd;
+    int settle_fd;
+    int save_fd;
+    int sock_fd;
+
+    time_t start_time;
+    time_t save_time;
+    int save_ret;
+} daemon_ctx_t;
+
+/* qsort 与 bsearch 不带上下文，比较长度由调用方在排序、查找前设置 */
+static __u32 daemon_cmp_size;
+
+static int daemon_key_cmp(const void *a, const void *b) {
+    return memcmp(a, b, daemon_cmp_size);
+}
+
+static void daemon_keys_free(daemon_keys_t *set) {
+    free(set->keys);
+    memset(set, 0, sizeof(*set));
+}
+
+/* 从规则数组中按 stride 取出 key，排序去重 */
+static bool daemon_keys_build(daemon_keys_t *set, const void *base, size_t num, size_t stride, __u32 key_size) {
+    memset(set, 0, sizeof(*set));
+    set->key_size = key_size;
+    if (0 == num) return true;
+
+    set->keys = malloc(num * key_size);
+    if (NULL == set->keys) return false;
+
+    for (size_t i = 0; i < num; i++)
+        memcpy(set->keys + i * key_size, (const unsigned char *)base + i * stride, key_size);
+
+    daemon_cmp_size = key_size;
+    qsort(set->keys, num, key_size, daemon_key_cmp);
+
+    set->num = 1;
+    for (size_t i = 1; i < num; i++) {
+        const unsigned char *key = set->keys + i * key_size;
+        if (memcmp(key, set->keys + (set->num - 1) * key_size, key_size))
+            memmove(set->keys + set->num++ * key_size, key, key_size);
+    }
+
+    return true;
+}
+
+static bool daemon_keys_contains(const daemon_keys_t *set, const void *key) {
+    if (0 == set->num) return false;
+
+    daemon_cmp_size = set->key_size;
+    return NULL != bsearch(key, set->keys, set->num, set->key_size, daemon_key_cmp);
+}
+
+static bool daemon_group_is_domain(const daemon_group_t *g) {
+    return !strcmp(g->import_type, IMPORT_TYPE_DOMAIN);
+}
+
+/* 两组是否写入同一个 map，已知类型的 map 按类型比较，其他 map 按路径比较 */
+static bool daemon_group_same_map(const daemon_group_t *a, const daemon_group_t *b) {
+    if (DAEMON_MAP_OTHER != a->map_type || DAEMON_MAP_OTHER != b->map_type) return a->map_type == b->map_type;
+    return !strcmp(a->map_path, b->map_path);
+}
+
+/* 合并两个 key 集合，用于删除失败时同时保留新旧 key，下次导入时仍可删除 */
+static bool daemon_keys_union(daemon_keys_t *set, const daemon_keys_t *old, const daemon_keys_t *fresh) {
+    /* 首次导入前 old 为空集合，key 长度以 fresh 为准 */
+    __u32 key_size = fresh->key_size;
+    size_t num = old->num + fresh->num;
+    unsigned char *keys = malloc(num ? num * key_size : 1);
+    if (NULL == keys) return false;
+
+    if (old->num) memcpy(keys, old->keys, old->num * key_size);
+    if (fresh->num) memcpy(keys + old->num * key_size, fresh->keys, fresh->num * key_size);
+
+    bool ret = daemon_keys_build(set, keys, num, key_size, key_size);
+    free(keys);
+    return ret;
+}
+
+/* 区间集合中是否有一个区间完整覆盖 [start, end] */
+static bool daemon_range_covers(const ip_range_set_t *ranges, __u32 start, __u32 end) {
+    size_t lo = 0, hi = ranges->num;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ranges->ranges[mid].end < start) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo < ranges->num && ranges->ranges[lo].start <= start && end <= ranges->ranges[lo].end;
+}
+
+/* 国内 IP 库的删除候选: map 中落在上次写入范围内的全部前缀
+ * 导入黑名单时会把国内 IP 前缀拆分为更长的前缀，这些前缀不在记录中，按范围才能找全 */
+static bool daemon_direct_candidates(const daemon_group_t *g, daemon_keys_t *cand) {
+    memset(cand, 0, sizeof(*cand));
+    cand->key_size = sizeof(ip_lpm_key_t);
+    if (0 == g->rules.num) return true;
+
+    int map_fd = bpf_obj_get(g->map_path);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", g->map_path, strerror(errno));
+        return false;
+    }
+
+    ip_rule_set_t old = {0};
+    ip_rule_set_t current = {0};
+    ip_range_set_t ranges = {0};
+    ip_lpm_key_t *keys = NULL;
+    size_t num = 0;
+
+    bool ret = true;
+    for (size_t i = 0; ret && i < g->rules.num; i++)
+        ret = ip_rule_set_add(&old, (const ip_lpm_key_t *)(g->rules.keys + i * g->rules.key_size), 0);
+    ret = ret && ip_range_set_build(&ranges, &old) && ip_rule_set_from_map(&current, map_fd);
+    if (ret && current.num) {
+        keys = malloc(current.num * sizeof(ip_lpm_key_t));
+        ret = (NULL != keys);
+    }
+
+    for (size_t i = 0; ret && i < current.num; i++) {
+        const ip_lpm_key_t *key = &current.rules[i].key;
+        __u32 start = ntohl(key->ipv4);
+        __u32 end = start | ((key->prefixlen >= 32) ? 0 : (0xFFFFFFFFU >> key->prefixlen));
+        if (daemon_range_covers(&ranges, start, end)) keys[num++] = *key;
+    }
+
+    ret = ret && daemon_keys_build(cand, keys, num, sizeof(ip_lpm_key_t), sizeof(ip_lpm_key_t));
+
+    free(keys);
+    ip_range_set_free(&ranges);
+    ip_rule_set_free(&current);
+    ip_rule_set_free(&old);
+    close(map_fd);
+    return ret;
+}
+
+/* 删除候选中本次不再出现的 key；同一 map 的其他组仍包含的 key 保留
+ * 删除数写入 removed，gone 不为 NULL 时记录删除的 IP 前缀，用于清理缓存 */
+static bool daemon_keys_remove(const daemon_ctx_t *ctx, const daemon_group_t *self, bool keyword,
+    const daemon_keys_t *cand, const daemon_keys_t *fresh, __u32 *removed, ip_rule_set_t *gone) {
+    *removed = 0;
+    if (0 == cand->num) return true;
+
+    const char *map_path = keyword ? KEYWORDMAP_PIN : self->map_path;
+    int map_fd = bpf_obj_get(map_path);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", map_path, strerror(errno));
+        return false;
+    }
+
+    for (size_t i = 0; i < cand->num; i++) {
+        const unsigned char *key = cand->keys + i * cand->key_size;
+        if (daemon_keys_contains(fresh, key)) continue;
+
+        bool shared = false;
+        for (__u32 j = 0; j < ctx->group_num && !shared; j++) {
+            const daemon_group_t *g = &ctx->groups[j];
+            if (g == self) continue;
+
+            /* 关键字表为全部域名组共用 */
+            if (keyword && daemon_group_is_domain(g)) shared = daemon_keys_contains(&g->keywords, key);
+            else if (!keyword && daemon_group_same_map(g, self)) shared = daemon_keys_contains(&g->rules, key);
+        }
+
+        if (shared || bpf_map_delete_elem(map_fd, key)) continue;
+
+        (*removed)++;
+        if (gone) ip_rule_set_add(gone, (const ip_lpm_key_t *)key, 0);
+    }
+
+    close(map_fd);
+    return true;
+}
+
+/* 删除上次写入、本次不再出现的规则与关键字，并重建依赖这些 map 的查询结构 */
+static int daemon_group_prune(daemon_ctx_t *ctx, daemon_group_t *g,
+    const daemon_keys_t *fresh_rules, const daemon_keys_t *fresh_keywords) {
+    bool is_direct = (DAEMON_MAP_DIRECT == g->map_type);
+
+    daemon_keys_t cand = {0};
+    bool ok = is_direct ? daemon_direct_candidates(g, &cand) : true;
+
+    bool rule_prune = true;
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    /* Arena 引擎提交时与已有规则合并，不支持删除单条域名规则 */
+    rule_prune = !daemon_group_is_domain(g);
+#endif
+
+    __u32 removed = 0;
+    ip_rule_set_t gone = {0};
+    if (ok && rule_prune) ok = daemon_keys_remove(ctx, g, false, is_direct ? &cand : &g->rules,
+        fresh_rules, &removed, is_direct ? &gone : NULL);
+    daemon_keys_free(&cand);
+
+    __u32 removed_keywords = 0;
+    if (ok) ok = daemon_keys_remove(ctx, g, true, &g->keywords, fresh_keywords, &removed_keywords, NULL);
+
+    if (removed || removed_keywords)
+        printf("[INFO] %s 删除不再出现的规则 %u 条，关键字 %u 条\n", g->map_path, removed, removed_keywords);
+
+    int ret = ok ? 0 : -1;
+    if (removed && is_direct) ret |= dir24_rebuild();
+    if (removed_keywords) ret |= keyword_rebuild();
+
+    /* 数据面信任缓存结果，已删除的规则需同时从缓存中清除 */
+    if (gone.num) {
+        ip_range_set_t ranges = {0};
+        if (ip_range_set_build(&ranges, &gone)) {
+            cache_purge_range(HOTPATHMAP_PIN, &ranges, "国内 IP 库已删除前缀内的");
+            cache_purge_range(PREMAP_PIN, &ranges, "国内 IP 库已删除前缀内的");
+        } else ret = -1;
+        ip_range_set_free(&ranges);
+    }
+    ip_rule_set_free(&gone);
+
+    if ((removed || removed_keywords) && daemon_group_is_domain(g)) ret |= cache_revalidate(DOMAINCACHE_MAPNAME);
+
+    /* 黑名单缩小后，之前被扣除的国内 IP 前缀需由国内 IP 组按新的黑名单重新写入 */
+    if (removed && DAEMON_MAP_BLKLIST == g->map_type) {
+        for (__u32 i = 0; i < ctx->group_num; i++) {
+            if (DAEMON_MAP_DIRECT == ctx->groups[i].map_type) ctx->groups[i].dirty = true;
+        }
+    }
+
+    return ret;
+}
+
+/* 重新解析一组规则文件，按 rule 命令的方式写入成功后，再删除不再出现的 key */
+static int daemon_group_apply(daemon_ctx_t *ctx, daemon_group_t *g) {
+    g->dirty = false;
+    g->apply_time = time(NULL);
+    g->apply_num++;
+
+    import_rules_t rules;
+    memset(&rules, 0, sizeof(rules));
+
+    daemon_keys_t fresh_rules = {0};
+    daemon_keys_t fresh_keywords = {0};
+    int ret = import_rules_collect(g->import_type, g->files, g->file_num, g->default_action, &rules);
+    if (!ret) ret = import_rules_apply(g->import_type, g->map_path, &rules);
+    if (ret) {
+        fprintf(stderr, "[ERROR] %s 规则导入失败: %d，不删除上次的规则\n", g->map_path, ret);
+        goto out;
+    }
+
+    /* 写入后记录: 国内 IP 库为扣除黑名单后的前缀，域名为去重剪枝后的规则 */
+    bool ok = daemon_group_is_domain(g) ?
+        daemon_keys_build(&fresh_rules, rules.domain.rules, rules.domain.num,
+            sizeof(domain_rule_t), sizeof(domain_lpm_key_t)) &&
+        daemon_keys_build(&fresh_keywords, rules.keyword.keys, rules.keyword.num,
+            sizeof(keyword_key_t), sizeof(keyword_key_t)) :
+        daemon_keys_build(&fresh_rules, rules.ip.rules, rules.ip.num,
+            sizeof(ip_rule_t), sizeof(ip_lpm_key_t));
+    if (!ok) {
+        ret = -1;
+        goto out;
+    }
+
+    daemon_keys_t keep_rules = {0};
+    daemon_keys_t keep_keywords = {0};
+    ret = daemon_group_prune(ctx, g, &fresh_rules, &fresh_keywords);
+    if (ret) {
+        /* 删除未完成，新旧 key 均可能仍在 map 中，全部保留到下次导入 */
+        fprintf(stderr, "[ERROR] %s 删除不再出现的规则失败\n", g->map_path);
+        if (!daemon_keys_union(&keep_rules, &g->rules, &fresh_rules) ||
+            !daemon_keys_union(&keep_keywords, &g->keywords, &fresh_keywords)) {
+            daemon_keys_free(&keep_rules);
+            daemon_keys_free(&keep_keywords);
+            goto out;
+        }
+        daemon_keys_free(&fresh_rules);
+        daemon_keys_free(&fresh_keywords);
+        fresh_rules = keep_rules;
+        fresh_keywords = keep_keywords;
+    }
+
+    daemon_keys_free(&g->rules);
+    daemon_keys_free(&g->keywords);
+    g->rules = fresh_rules;
+    g->keywords = fresh_keywords;
+    memset(&fresh_rules, 0, sizeof(fresh_rules));
+    memset(&fresh_keywords, 0, sizeof(fresh_keywords));
+
+out:
+    g->last_ret = ret;
+    daemon_keys_free(&fresh_rules);
+    daemon_keys_free(&fresh_keywords);
+    import_rules_free(&rules);
+    return ret;
+}
+
+/* 导入全部待更新的组，黑名单先于国内 IP 库写入，国内 IP 库按新的黑名单扣除 */
+static int daemon_apply_dirty(daemon_ctx_t *ctx) {
+    int ret = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (__u32 i = 0; i < ctx->group_num; i++) {
+            daemon_group_t *g = &ctx->groups[i];
+            bool blk = (DAEMON_MAP_BLKLIST == g->map_type);
+            if (g->dirty && blk == (0 == pass)) ret |= daemon_group_apply(ctx, g);
+        }
+    }
+
+    fflush(stdout);
+    return ret;
+}
+
+static void daemon_mark_all(daemon_ctx_t *ctx) {
+    for (__u32 i = 0; i < ctx->group_num; i++) ctx->groups[i].dirty = true;
+}
+
+/* 监听规则文件所在目录，下载工具通常先写临时文件再改名，因此同时监听写入完成与移入 */
+static bool daemon_watch_add(daemon_ctx_t *ctx, daemon_group_t *g) {
+    g->wds = calloc(g->file_num, sizeof(int));
+    if (NULL == g->wds) return false;
+
+    for (__u32 i = 0; i < g->file_num; i++) {
+        char dir[PATH_MAX];
+        const char *slash = strrchr(g->files[i], '/');
+        if (NULL == slash) snprintf(dir, sizeof(dir), ".");
+        else if (slash == g->files[i]) snprintf(dir, sizeof(dir), "/");
+        else snprintf(dir, sizeof(dir), "%.*s", (int)(slash - g->files[i]), g->files[i]);
+
+        g->wds[i] = inotify_add_watch(ctx->ino_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (g->wds[i] < 0) {
+            fprintf(stderr, "[ERROR] 无法监听目录 %s: %s\n", dir, strerror(errno));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* 标记包含变化文件的组，返回是否有组需要更新 */
+static bool daemon_inotify_handle(daemon_ctx_t *ctx) {
+    char buf[DAEMON_INOTIFY_BUF_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+
+    ssize_t len = read(ctx->ino_fd, buf, sizeof(buf));
+    for (char *p = buf; len > 0 && p < buf + len; ) {
+        const struct inotify_event *ev = (const struct inotify_event *)p;
+        p += sizeof(*ev) + ev->len;
+
+        /* 事件队列溢出，无法确定哪些文件变化 */
+        if (ev->mask & IN_Q_OVERFLOW) {
+            daemon_mark_all(ctx);
+            changed = true;
+            continue;
+        }
+
+        if (0 == ev->len) continue;
+        for (__u32 i = 0; i < ctx->group_num; i++) {
+            daemon_group_t *g = &ctx->groups[i];
+            for (__u32 j = 0; j < g->file_num; j++) {
+                const char *slash = strrchr(g->files[j], '/');
+                const char *base = slash ? slash + 1 : g->files[j];
+                if (ev->wd != g->wds[j] || strcmp(ev->name, base)) continue;
+
+                printf("[INFO] 规则文件 %s 已更新\n", g->files[j]);
+                g->dirty = changed = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+static void daemon_timer_set(int timer_fd, __u64 ms, bool periodic) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = ms / 1000;
+    its.it_value.tv_nsec = (ms % 1000) * 1000000;
+    if (periodic) its.it_interval = its.it_value;
+
+    timerfd_settime(timer_fd, 0, &its, NULL);
+}
+
+static void daemon_timer_read(int timer_fd) {
+    __u64 expirations = 0;
+    if (read(timer_fd, &expirations, sizeof(expirations)) < 0) return ;
+}
+
+static int daemon_cache_save(daemon_ctx_t *ctx) {
+    ctx->save_ret = cache_save(ctx->cache_file);
+    ctx->save_time = time(NULL);
+    fflush(stdout);
+    return ctx->save_ret;
+}
+
+static void daemon_time_format(time_t t, char *buf, size_t size) {
+    struct tm tm;
+    if (0 == t) snprintf(buf, size, "-");
+    else strftime(buf, size, "%F %T", localtime_r(&t, &tm));
+}
+
+static int daemon_status(daemon_ctx_t *ctx) {
+    char when[32];
+    printf("daemon: pid %d，已运行 %lld 秒，socket %s\n",
+        (int)getpid(), (long long)(time(NULL) - ctx->start_time), ctx->sock_path);
+
+    daemon_time_format(ctx->save_time, when, sizeof(when));
+    if (ctx->save_sec) printf("cache: %s，每 %u 秒保存，上次 %s %s\n", ctx->cache_file, ctx->save_sec,
+        when, ctx->save_time ? (ctx->save_ret ? "失败" : "成功") : "");
+    else printf("cache: 未开启定时保存\n");
+
+    for (__u32 i = 0; i < ctx->group_num; i++) {
+        const daemon_group_t *g = &ctx->groups[i];
+        daemon_time_format(g->apply_time, when, sizeof(when));
+        printf("group %u: %s %s@%u，规则 %zu 条，关键字 %zu 条，导入 %llu 次，上次 %s %s\n", i,
+            g->map_path, g->import_type, g->default_action, g->rules.num, g->keywords.num,
+            (unsigned long long)g->apply_num, when, g->apply_num ? (g->last_ret ? "失败" : "成功") : "未应用");
+
+        for (__u32 j = 0; j < g->file_num; j++) printf("  %s\n", g->files[j]);
+    }
+
+    return 0;
+}
+
+static int daemon_cmd_dispatch(daemon_ctx_t *ctx, int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "[ERROR] 参数错误，" CTL_PROG_USAGE "\n");
+        return -1;
+    }
+
+    if (!strcmp(argv[0], DAEMON_CMD_STATS)) return stats_main(argc, argv);
+    else if (!strcmp(argv[0], DAEMON_CMD_STATUS)) return daemon_status(ctx);
+    else if (!strcmp(argv[0], DAEMON_CMD_SAVE)) return daemon_cache_save(ctx);
+    else if (!strcmp(argv[0], DAEMON_CMD_RELOAD)) {
+        daemon_mark_all(ctx);
+        return daemon_apply_dirty(ctx);
+    } else if (!strcmp(argv[0], DAEMON_CMD_DUMP)) {
+        if (argc > 1) return cache_dump(argv[1]);
+
+        int ret = cache_dump(HOTPATH_MAPNAME);
+        ret |= cache_dump(PRE_MAPNAME);
+        ret |= cache_dump(DOMAINCACHE_MAPNAME);
+        return ret;
+    }
+
+    fprintf(stderr, "[ERROR] 参数错误 [%s]，" CTL_PROG_USAGE "\n", argv[0]);
+    return -1;
+}
+
+static bool daemon_send_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        buf += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+/* 发送暂存的命令输出与返回码，超时或客户端断开即放弃，最多阻塞一次发送超时 */
+static void daemon_client_reply(int client_fd, int out_fd, int ret) {
+    char buf[DAEMON_REPLY_BUF_SIZE];
+    ssize_t n = 0;
+
+    if (lseek(out_fd, 0, SEEK_SET) < 0) return ;
+    while ((n = read(out_fd, buf, sizeof(buf))) > 0) {
+        if (!daemon_send_all(client_fd, buf, n)) return ;
+    }
+
+    int len = snprintf(buf, sizeof(buf), "%c%d\n", DAEMON_RET_SEP, ret);
+    daemon_send_all(client_fd, buf, len);
+}
+
+/* 读取一行命令，执行期间将标准输出与标准错误重定向到临时文件，执行结束后再发送给客户端
+ * 命令执行期间不直接写 socket，客户端不读取时不会阻塞 daemon */
+static void daemon_client_handle(daemon_ctx_t *ctx) {
+    int client_fd = accept(ctx->sock_fd, NULL, NULL);
+    if (client_fd < 0) return ;
+
+    struct timeval tv = {.tv_sec = DAEMON_CMD_TIMEOUT_SEC};
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char line[DAEMON_CMD_MAXLEN];
+    size_t len = 0;
+    while (len < sizeof(line) - 1) {
+        ssize_t n = recv(client_fd, line + len, sizeof(line) - 1 - len, 0);
+        if (n <= 0) break;
+        len += n;
+        if (memchr(line + len - n, '\n', n)) break;
+    }
+    line[len] = '\0';
+
+    int argc = 0;
+    char *argv[DAEMON_CMD_ARGS_MAX];
+    char *save = NULL;
+    for (char *tok = strtok_r(line, " \t\r\n", &save); tok && argc < DAEMON_CMD_ARGS_MAX;
+        tok = strtok_r(NULL, " \t\r\n", &save)) argv[argc++] = tok;
+
+    fflush(stdout);
+    FILE *tmp = tmpfile();
+    int out_fd = dup(STDOUT_FILENO);
+    int err_fd = dup(STDERR_FILENO);
+    if (NULL != tmp && out_fd >= 0 && err_fd >= 0) {
+        dup2(fileno(tmp), STDOUT_FILENO);
+        dup2(fileno(tmp), STDERR_FILENO);
+
+        int ret = daemon_cmd_dispatch(ctx, argc, argv);
+
+        fflush(stdout);
+        dup2(out_fd, STDOUT_FILENO);
+        dup2(err_fd, STDERR_FILENO);
+
+        daemon_client_reply(client_fd, fileno(tmp), ret);
+    } else {
+        fprintf(stderr, "[ERROR] 无法暂存控制命令输出: %s\n", strerror(errno));
+    }
+
+    if (NULL != tmp) fclose(tmp);
+    if (out_fd >= 0) close(out_fd);
+    if (err_fd >= 0) close(err_fd);
+    close(client_fd);
+}
+
+/* 创建控制 socket，已有 daemon 在监听时失败，残留的 socket 文件删除后重建 */
+static int daemon_sock_open(const char *path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "[ERROR] socket 路径过长: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    if (!connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        fprintf(stderr, "[ERROR] 已有 daemon 在 %s 上运行\n", path);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    mode_t mask = umask(077);
+    int ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(mask);
+    if (ret || listen(fd, SOMAXCONN)) {
+        fprintf(stderr, "[ERROR] 无法监听 %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool daemon_epoll_add(int ep_fd, int fd) {
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+    return !epoll_ctl(ep_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/* 收到 SIGINT/SIGTERM 时返回，SIGHUP 重新导入全部规则 */
+static bool daemon_loop(daemon_ctx_t *ctx) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL)) return false;
+
+    int sig_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    int ep_fd = epoll_create1(EPOLL_CLOEXEC);
+    bool ret = false;
+    if (sig_fd < 0 || ep_fd < 0) goto out;
+
+    if (!daemon_epoll_add(ep_fd, sig_fd) || !daemon_epoll_add(ep_fd, ctx->ino_fd) ||
+        !daemon_epoll_add(ep_fd, ctx->settle_fd) || !daemon_epoll_add(ep_fd, ctx->sock_fd) ||
+        (ctx->save_fd >= 0 && !daemon_epoll_add(ep_fd, ctx->save_fd))) goto out;
+
+    while (true) {
+        struct epoll_event events[DAEMON_EPOLL_EVENTS];
+        int num = epoll_wait(ep_fd, events, DAEMON_EPOLL_EVENTS, -1);
+        if (num < 0) {
+            if (EINTR == errno) continue;
+            goto out;
+        }
+
+        for (int i = 0; i < num; i++) {
+            int fd = events[i].data.fd;
+            if (sig_fd == fd) {
+                struct signalfd_siginfo info;
+                if (read(sig_fd, &info, sizeof(info)) != sizeof(info)) continue;
+                if (SIGHUP != info.ssi_signo) {
+                    ret = true;
+                    goto out;
+                }
+
+                daemon_mark_all(ctx);
+                daemon_apply_dirty(ctx);
+            } else if (ctx->ino_fd == fd) {
+                /* 每次变化都重新计时，最后一个文件写完后统一导入 */
+                if (daemon_inotify_handle(ctx)) daemon_timer_set(ctx->settle_fd, DAEMON_SETTLE_MS, false);
+            } else if (ctx->settle_fd == fd) {
+                daemon_timer_read(fd);
+                daemon_apply_dirty(ctx);
+            } else if (ctx->save_fd == fd) {
+                daemon_timer_read(fd);
+                daemon_cache_save(ctx);
+            } else if (ctx->sock_fd == fd) {
+                daemon_client_handle(ctx);
+            }
+        }
+    }
+
+out:
+    if (!ret) fprintf(stderr, "[ERROR] 事件循环异常退出: %s\n", strerror(errno));
+    if (ep_fd >= 0) close(ep_fd);
+    if (sig_fd >= 0) close(sig_fd);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    return ret;
+}
+
+/* 读取目标 map 的名称确定规则组类型，与 import 区分国内 IP 库与黑名单的方式一致 */
+static bool daemon_group_classify(daemon_group_t *g) {
+    int map_fd = bpf_obj_get(g->map_path);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", g->map_path, strerror(errno));
+        return false;
+    }
+
+    char name[BPF_OBJ_NAME_LEN] = {0};
+    bool ret = map_name_get(map_fd, name, sizeof(name));
+    close(map_fd);
+    if (!ret) {
+        fprintf(stderr, "[ERROR] 无法读取 BPF Map %s 的信息: %s\n", g->map_path, strerror(errno));
+        return false;
+    }
+
+    if (!strcmp(name, DIRECT_MAPNAME)) g->map_type = DAEMON_MAP_DIRECT;
+    else if (!strcmp(name, BLKLIST_MAPNAME)) g->map_type = DAEMON_MAP_BLKLIST;
+    else if (!strcmp(name, DOMAIN_MAPNAME)) g->map_type = DAEMON_MAP_DOMAIN;
+    else g->map_type = DAEMON_MAP_OTHER;
+
+    return true;
+}
+
+static int daemon_group_add(const char *import_type, const char *map_path,
+    char **rule_files, __u32 rule_file_num, __u32 default_action, void *data) {
+    daemon_ctx_t *ctx = data;
+    if (ctx->group_num >= DAEMON_GROUP_MAX) {
+        fprintf(stderr, "[ERROR] 规则组数量超过上限 %d\n", DAEMON_GROUP_MAX);
+        return -1;
+    }
+
+    daemon_group_t *g = &ctx->groups[ctx->group_num++];
+    g->map_path = map_path;
+    snprintf(g->import_type, sizeof(g->import_type), "%s", import_type);
+    g->default_action = default_action;
+    g->files = rule_files;
+    g->file_num = rule_file_num;
+    g->dirty = true;
+
+    return (daemon_group_classify(g) && daemon_watch_add(ctx, g)) ? 0 : -1;
+}
+
+static void daemon_ctx_free(daemon_ctx_t *ctx) {
+    for (__u32 i = 0; i < ctx->group_num; i++) {
+        free(ctx->groups[i].wds);
+        daemon_keys_free(&ctx->groups[i].rules);
+        daemon_keys_free(&ctx->groups[i].keywords);
+    }
+
+    if (ctx->sock_fd >= 0) {
+        close(ctx->sock_fd);
+        unlink(ctx->sock_path);
+    }
+    if (ctx->save_fd >= 0) close(ctx->save_fd);
+    if (ctx->settle_fd >= 0) close(ctx->settle_fd);
+    if (ctx->ino_fd >= 0) close(ctx->ino_fd);
+}
+
+static bool daemon_arg_parse(daemon_ctx_t *ctx, const char *arg) {
+    const char *val = NULL;
+
+#define DAEMON_ARG_IS(name) (!strncmp(arg, name, strlen(name)) && (val = arg + strlen(name)))
+    if (DAEMON_ARG_IS(DAEMON_ARGS_SOCK)) {
+        if ('\0' == *val) return false;
+        ctx->sock_path = val;
+    } else if (DAEMON_ARG_IS(DAEMON_ARGS_CACHE)) {
+        if ('\0' == *val) return false;
+        ctx->cache_file = val;
+    } else if (DAEMON_ARG_IS(DAEMON_ARGS_SAVE)) {
+        char *end = NULL;
+        unsigned long sec = strtoul(val, &end, 10);
+        if (end == val || *end || sec > UINT32_MAX / 1000) return false;
+        ctx->save_sec = sec;
+    } else {
+        return false;
+    }
+#undef DAEMON_ARG_IS
+
+    return true;
+}
+
+int daemon_args_parse(int argc, char **argv) {
+    daemon_ctx_t ctx = {
+        .sock_path = DAEMON_DEFAULT_SOCK,
+        .cache_file = CACHE_DEFAULT_FILE,
+        .save_sec = DAEMON_DEFAULT_SAVE_SEC,
+        .ino_fd = -1, .settle_fd = -1, .save_fd = -1, .sock_fd = -1,
+        .start_time = time(NULL),
+    };
+
+    int i = 2;
+    for (; i < argc && strchr(argv[i], '=') && '/' != argv[i][0]; i++) {
+        if (!daemon_arg_parse(&ctx, argv[i])) {
+            fprintf(stderr, "[ERROR] 参数错误 [%s]，" DAEMON_PROG_USAGE "\n", argv[i]);
+            return -1;
+        }
+    }
+
+    int ret = -1;
+    ctx.ino_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    ctx.settle_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (ctx.save_sec) ctx.save_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (ctx.ino_fd < 0 || ctx.settle_fd < 0 || (ctx.save_sec && ctx.save_fd < 0)) {
+        fprintf(stderr, "[ERROR] 无法创建 inotify 或定时器: %s\n", strerror(errno));
+        goto out;
+    }
+
+    if (rule_groups_foreach(argc, argv, i, daemon_group_add, &ctx)) goto out;
+
+    ctx.sock_fd = daemon_sock_open(ctx.sock_path);
+    if (ctx.sock_fd < 0) goto out;
+
+    /* 客户端提前断开时写入返回 EPIPE，不终止 daemon */
+    signal(SIGPIPE, SIG_IGN);
+
+    /* 启动时导入全部规则，作为之后增量删除的基准 */
+    daemon_apply_dirty(&ctx);
+    if (ctx.save_fd >= 0) daemon_timer_set(ctx.save_fd, (__u64)ctx.save_sec * 1000, true);
+
+    printf("[INFO] daemon 已启动，规则组 %u 个，控制 socket %s\n", ctx.group_num, ctx.sock_path);
+    fflush(stdout);
+
+    ret = daemon_loop(&ctx) ? 0 : -1;
+
+    /* 退出前保存一次缓存，重启后可直接恢复 */
+    if (ctx.save_fd >= 0) daemon_cache_save(&ctx);
+    printf("[INFO] daemon 已退出\n");
+
+out:
+    daemon_ctx_free(&ctx);
+    return ret;
+}
+
+int daemon_main(int argc, char **argv) {
+    return daemon_args_parse(argc, argv);
+}
+
+/* 将命令发送给 daemon，输出其返回的内容 */
+int ctl_args_parse(int argc, char **argv) {
+    const char *sock_path = DAEMON_DEFAULT_SOCK;
+    int i = 2;
+    if (i < argc && !strncmp(argv[i], DAEMON_ARGS_SOCK, strlen(DAEMON_ARGS_SOCK)))
+        sock_path = argv[i++] + strlen(DAEMON_ARGS_SOCK);
+
+    if (argc < CTL_ARGS_MIN_NUM || i >= argc) {
+        fprintf(stderr, "[ERROR] 参数错误，" CTL_PROG_USAGE "\n");
+        return -1;
+    }
+
+    char line[DAEMON_CMD_MAXLEN] = {0};
+    size_t len = 0;
+    for (; i < argc; i++) {
+        int n = snprintf(line + len, sizeof(line) - len, "%s%s", len ? " " : "", argv[i]);
+        if (n < 0 || (size_t)n >= sizeof(line) - len - 1) {
+            fprintf(stderr, "[ERROR] 命令过长，" CTL_PROG_USAGE "\n");
+            return -1;
+        }
+        len += n;
+    }
+    line[len++] = '\n';
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "[ERROR] socket 路径过长: %s\n", sock_path);
+        return -1;
+    }
+    strcpy(addr.sun_path, sock_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        fprintf(stderr, "[ERROR] 无法连接 daemon %s: %s\n", sock_path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    /* 分隔符之前为命令输出，之后为命令的返回码 */
+    int ret = -1;
+    bool got_ret = false;
+    char ret_buf[DAEMON_RET_MAXLEN] = {0};
+    size_t ret_len = 0;
+    if (send(fd, line, len, 0) == (ssize_t)len) {
+        shutdown(fd, SHUT_WR);
+
+        char buf[CTL_RECV_BUF_SIZE];
+        ssize_t n = 0;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            const char *pos = buf;
+            size_t left = n;
+            if (!got_ret) {
+                const char *sep = memchr(buf, DAEMON_RET_SEP, n);
+                size_t out = sep ? (size_t)(sep - buf) : left;
+                fwrite(buf, 1, out, stdout);
+                if (NULL == sep) continue;
+
+                got_ret = true;
+                pos = sep + 1;
+                left -= out + 1;
+            }
+
+            if (left > sizeof(ret_buf) - 1 - ret_len) left = sizeof(ret_buf) - 1 - ret_len;
+            memcpy(ret_buf + ret_len, pos, left);
+            ret_len += left;
+        }
+
+        if (0 == n && got_ret) {
+            char *end = NULL;
+            long val = strtol(ret_buf, &end, 10);
+            if (end != ret_buf && ('\n' == *end || '\0' == *end)) ret = (int)val;
+            else got_ret = false;
+        }
+    }
+
+    fflush(stdout);
+    if (!got_ret) fprintf(stderr, "[ERROR] 与 daemon 通信失败，未收到命令执行结果\n");
+    close(fd);
+    return ret;
+}
+
+int ctl_main(int argc, char **argv) {
+    return ctl_args_parse(argc, argv);
+}
@@ -0,0 +1,242 @@
+/*
+ * File     : dir24.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-16 10:14:02
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+
+#include <bpf/bpf.h>
+
+#include "direct_path_user.h"
+#include "direct_path_dir24.h"
+
+/* 数组总字节数 */
+#define DIR24_WORDS_BYTES               ((size_t)DIRECT_IP_DIR24_MAP_SIZE * sizeof(__u64))
+
+static __always_inline __u32 dir24_nibble_get(const __u64 *words, __u32 idx24) {
+    __u32 shift = (idx24 & (DIR24_SLOTS_PER_WORD - 1)) * DIR24_NIBBLE_BITS;
+    return (words[idx24 / DIR24_SLOTS_PER_WORD] >> shift) & DIR24_NIBBLE_MASK;
+}
+
+static __always_inline void dir24_nibble_set(__u64 *words, __u32 idx24, __u32 nibble) {
+    __u32 shift = (idx24 & (DIR24_SLOTS_PER_WORD - 1)) * DIR24_NIBBLE_BITS;
+    __u64 *word = &words[idx24 / DIR24_SLOTS_PER_WORD];
+    *word = (*word & ~((__u64)DIR24_NIBBLE_MASK << shift)) | ((__u64)nibble << shift);
+}
+
+/* /24 及更短前缀按前缀长度升序写入，更长的前缀覆盖更短的前缀 */
+static int dir24_rule_cmp_short(const void *a, const void *b) {
+    const ip_rule_t *ra = a, *rb = b;
+
+    if (ra->key.prefixlen != rb->key.prefixlen) return (ra->key.prefixlen < rb->key.prefixlen) ? -1 : 1;
+    if (ra->seq != rb->seq) return (ra->seq < rb->seq) ? -1 : 1;
+    return 0;
+}
+
+/* 长于 /24 的前缀按所在 /24 分组，组内按前缀长度升序 */
+static int dir24_rule_cmp_long(const void *a, const void *b) {
+    const ip_rule_t *ra = a, *rb = b;
+    __u32 ka = ntohl(ra->key.ipv4) >> 8, kb = ntohl(rb->key.ipv4) >> 8;
+
+    if (ka != kb) return (ka < kb) ? -1 : 1;
+    return dir24_rule_cmp_short(a, b);
+}
+
+bool dir24_build(dir24_table_t *table, const ip_rule_set_t *rules) {
+    if (unlikely(NULL == table || NULL == rules)) return false;
+
+    memset(table, 0, sizeof(*table));
+    table->words = calloc(DIRECT_IP_DIR24_MAP_SIZE, sizeof(__u64));
+    if (NULL == table->words) return false;
+
+    ip_rule_t *sorted = malloc((rules->num ? rules->num : 1) * sizeof(ip_rule_t));
+    if (NULL == sorted) {
+        dir24_free(table);
+        return false;
+    }
+
+    /* 短前缀放前面，长前缀放后面 */
+    size_t short_num = 0, long_num = 0;
+    for (size_t i = 0; i < rules->num; i++) {
+        if (rules->rules[i].key.prefixlen <= 24) sorted[short_num++] = rules->rules[i];
+        else sorted[rules->num - 1 - long_num++] = rules->rules[i];
+    }
+
+    qsort(sorted, short_num, sizeof(ip_rule_t), dir24_rule_cmp_short);
+    qsort(sorted + short_num, long_num, sizeof(ip_rule_t), dir24_rule_cmp_long);
+
+    for (size_t i = 0; i < short_num; i++) {
+        __u32 prefixlen = sorted[i].key.prefixlen;
+        __u32 start = (prefixlen ? (ntohl(sorted[i].key.ipv4) & (~0U << (32 - prefixlen))) : 0) >> 8;
+        __u32 count = 1U << (24 - prefixlen);
+        __u32 nibble = sorted[i].action & DIR24_NIBBLE_ACTION_MASK;
+
+        for (__u32 j = 0; j < count; j++) dir24_nibble_set(table->words, start + j, nibble);
+    }
+
+    /* 溢出表条目数不超过长前缀数量 */
+    if (long_num) {
+        table->ovf = calloc(long_num, sizeof(dir24_overflow_entry_t));
+        if (NULL == table->ovf) {
+            free(sorted);
+            dir24_free(table);
+            return false;
+        }
+    }
+
+    for (size_t i = short_num; i < rules->num; i++) {
+        __u32 addr = ntohl(sorted[i].key.ipv4);
+        __u32 key24 = addr >> 8;
+
+        dir24_overflow_entry_t *ent = table->ovf_num ? &table->ovf[table->ovf_num - 1] : NULL;
+        if (NULL == ent || ent->key24 != key24) {
+            /* 新的 /24，以覆盖它的短前缀结果为底 */
+            ent = &table->ovf[table->ovf_num++];
+            ent->key24 = key24;
+            memset(ent->val.action, dir24_nibble_get(table->words, key24) & DIR24_NIBBLE_ACTION_MASK, 
+                sizeof(ent->val.action));
+            dir24_nibble_set(table->words, key24, DIR24_NIBBLE_OVERFLOW);
+        }
+
+        __u32 prefixlen = sorted[i].key.prefixlen;
+        __u32 first = addr & (DIR24_OVERFLOW_SLOTS - 1) & (~0U << (32 - prefixlen));
+        __u32 count = 1U << (32 - prefixlen);
+        memset(&ent->val.action[first], sorted[i].action & DIR24_NIBBLE_ACTION_MASK, count);
+    }
+
+    free(sorted);
+    return true;
+}
+
+void dir24_free(dir24_table_t *table) {
+    if (unlikely(NULL == table)) return ;
+
+    free(table->words);
+    free(table->ovf);
+    memset(table, 0, sizeof(*table));
+}
+
+static const dir24_overflow_entry_t *dir24_ovf_find(const dir24_table_t *table, __u32 key24) {
+    size_t lo = 0, hi = table->ovf_num;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (table->ovf[mid].key24 < key24) lo = mid + 1;
+        else hi = mid;
+    }
+
+    if (lo < table->ovf_num && table->ovf[lo].key24 == key24) return &table->ovf[lo];
+    return NULL;
+}
+
+__u32 dir24_lookup(const dir24_table_t *table, __u32 addr) {
+    __u32 nibble = dir24_nibble_get(table->words, addr >> 8);
+    if (!(nibble & DIR24_NIBBLE_OVERFLOW)) return nibble;
+
+    const dir24_overflow_entry_t *ent = dir24_ovf_find(table, addr >> 8);
+    if (unlikely(NULL == ent)) return ACTION_NONE;
+
+    return ent->val.action[addr & (DIR24_OVERFLOW_SLOTS - 1)];
+}
+
+size_t dir24_mem_size(const dir24_table_t *table) {
+    if (unlikely(NULL == table)) return 0;
+
+    return DIR24_WORDS_BYTES + table->ovf_num * (DIRECT_IP_OVERFLOW_MAP_KEY_SIZE + DIRECT_IP_OVERFLOW_MAP_VAL_SIZE);
+}
+
+int dir24_sync(const dir24_table_t *table, int array_fd, int ovf_fd) {
+    if (unlikely(NULL == table || NULL == table->words || array_fd < 0 || ovf_fd < 0)) return -1;
+
+    if (table->ovf_num > DIRECT_IP_OVERFLOW_MAP_SIZE) {
+        fprintf(stderr, "[ERROR] DIR-24-8 溢出表需要 %zu 条，超过上限 %u\n", 
+            table->ovf_num, DIRECT_IP_OVERFLOW_MAP_SIZE);
+        return -1;
+    }
+
+    __u64 *words = mmap(NULL, DIR24_WORDS_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, array_fd, 0);
+    if (MAP_FAILED == words) {
+        fprintf(stderr, "[ERROR] DIR-24-8 数组 mmap 失败: %s\n", strerror(errno));
+        return -1;
+    }
+
+    /* 先写溢出表，再写数组，保证数据面看到溢出标记时溢出表已就绪 */
+    int ret = 0;
+    for (size_t i = 0; i < table->ovf_num; i++) {
+        ret = bpf_map_update_elem(ovf_fd, &table->ovf[i].key24, &table->ovf[i].val, BPF_ANY);
+        if (ret) {
+            fprintf(stderr, "[ERROR] DIR-24-8 溢出表写入失败: %s\n", strerror(errno));
+            goto out;
+        }
+    }
+
+    __u32 changed = 0;
+    for (__u32 i = 0; i < DIRECT_IP_DIR24_MAP_SIZE; i++) {
+        if (words[i] == table->words[i]) continue;
+
+        __atomic_store_n(&words[i], table->words[i], __ATOMIC_RELEASE);
+        changed++;
+    }
+
+    /* 最后清理不再需要的溢出表条目 */
+    __u32 key = 0, next = 0, stale_num = 0;
+    __u32 stale[DIRECT_IP_OVERFLOW_MAP_SIZE];
+    void *prev = NULL;
+    while (0 == bpf_map_get_next_key(ovf_fd, prev, &next)) {
+        if (NULL == dir24_ovf_find(table, next) && stale_num < DIRECT_IP_OVERFLOW_MAP_SIZE) 
+            stale[stale_num++] = next;
+
+        key = next;
+        prev = &key;
+    }
+
+    for (__u32 i = 0; i < stale_num; i++) bpf_map_delete_elem(ovf_fd, &stale[i]);
+
+    printf("[INFO] DIR-24-8 已更新: 数组元素变化 %u 个，溢出 /24 %zu 个，清理 %u 个\n", 
+        changed, table->ovf_num, stale_num);
+
+out:
+    munmap(words, DIR24_WORDS_BYTES);
+    return ret;
+}
+
+int dir24_rebuild(void) {
+#if DIRECT_IP_ENGINE == DIRECT_IP_ENGINE_DIR24
+    int direct_fd = bpf_obj_get(DIRECTMAP_PIN);
+    int array_fd = bpf_obj_get(DIRECTDIR24_PIN);
+    int ovf_fd = bpf_obj_get(DIRECTOVERFLOW_PIN);
+
+    int ret = -1;
+    ip_rule_set_t rules = {0};
+    dir24_table_t table = {0};
+
+    if (direct_fd < 0 || array_fd < 0 || ovf_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 DIR-24-8 相关 BPF Map: %s\n", strerror(errno));
+        goto out;
+    }
+
+    if (!ip_rule_set_from_map(&rules, direct_fd)) goto out;
+    if (!dir24_build(&table, &rules)) goto out;
+
+    ret = dir24_sync(&table, array_fd, ovf_fd);
+
+out:
+    dir24_free(&table);
+    ip_rule_set_free(&rules);
+    if (direct_fd >= 0) close(direct_fd);
+    if (array_fd >= 0) close(array_fd);
+    if (ovf_fd >= 0) close(ovf_fd);
+
+    return ret;
+#else
+    return 0;
+#endif
+}
@@ -9,12 +9,37 @@
 #include "direct_path_user.h"
 #include "direct_path_load.h"
 #include "direct_path_rule.h"
+#include "direct_path_pool.h"
+#include "direct_path_action.h"
+#include "direct_path_ratelimit.h"
+#include "direct_path_stats.h"
+#include "direct_path_cache.h"
+#include "direct_path_plan.h"
+#include "direct_path_mem.h"
+#include "direct_path_replay.h"
+#include "direct_path_sim.h"
+#include "direct_path_trace.h"
+#include "direct_path_profile.h"
+#include "direct_path_daemon.h"
 
 int direct_path_args_parse(int argc, char **argv) {
     if (argc < DIRECT_PATH_USER_VALID_ARGS_NUM) return -1;
 
     if (!strcmp(argv[1], DIRECT_PATH_LOAD_ARGS)) return load_main(argc, argv);
     else if (!strcmp(argv[1], DIRECT_PATH_RULE_ARGS)) return rule_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_POOL_ARGS)) return pool_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_ACTION_ARGS)) return action_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_RATELIMIT_ARGS)) return ratelimit_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_STATS_ARGS)) return stats_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_CACHE_ARGS)) return cache_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_PLAN_ARGS)) return plan_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_MEM_ARGS)) return mem_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_REPLAY_ARGS)) return replay_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_SIM_ARGS)) return sim_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_TRACE_ARGS)) return trace_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_PROFILE_ARGS)) return profile_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_DAEMON_ARGS)) return daemon_main(argc, argv);
+    else if (!strcmp(argv[1], DIRECT_PATH_CTL_ARGS)) return ctl_main(argc, argv);
 
     return 0;
 }
@@ -0,0 +1,409 @@
+/*
+ * File     : domain_arena.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-24 20:19:06
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <bpf/bpf.h>
+
+#include "direct_path_user.h"
+#include "direct_path_domain_arena.h"
+
+/* 双数组每份的字节数 */
+#define DOMAIN_ARENA_NODE_BYTES         ((size_t)DOMAIN_ARENA_NODE_MAX * sizeof(domain_dat_node_t))
+/* arena 总字节数 */
+#define DOMAIN_ARENA_BYTES              ((size_t)DOMAIN_ARENA_PAGES * DOMAIN_ARENA_PAGE_SIZE)
+/* 规则区中每条规则的头部: 符号数 + 动作编号 */
+#define DOMAIN_ARENA_RULE_HDR           2
+/* 符号表大小，转移时 base + 符号 不会超过该范围 */
+#define DOMAIN_DAT_ALPHABET             64
+/* 单个节点尝试超过该次数，说明前面的空闲槽位已经很零碎，之后从本次结果处开始查找 */
+#define DOMAIN_DAT_SCAN_SKIP            16
+
+_Static_assert(DOMAIN_ARENA_NODE_OFF + 2 * DOMAIN_ARENA_NODE_BYTES <= DOMAIN_ARENA_BYTES,
+    "arena 页数不足以容纳规则区与两份双数组");
+
+/* 等待写入 arena 的规则 */
+static domain_arena_rule_t *pending = NULL;
+static size_t pending_num = 0;
+static size_t pending_cap = 0;
+
+/* 构建队列元素，rules[lo, hi) 共享 node 对应的前 depth 个符号 */
+typedef struct {
+    __u32 node;
+    __u32 depth;
+    size_t lo;
+    size_t hi;
+} dat_task_t;
+
+static int domain_arena_rule_cmp(const void *a, const void *b) {
+    const domain_arena_rule_t *ra = a, *rb = b;
+    __u32 n = (ra->num < rb->num) ? ra->num : rb->num;
+
+    int ret = memcmp(ra->syms, rb->syms, n);
+    if (ret) return ret;
+    if (ra->num != rb->num) return (ra->num < rb->num) ? -1 : 1;
+    return (ra->seq < rb->seq) ? -1 : (ra->seq > rb->seq);
+}
+
+/* 构建过程中的双数组，next_free[i] 指向不小于 i 的空闲槽位 (路径压缩) */
+typedef struct {
+    domain_dat_t *dat;
+    __u32 *next_free;
+    __u32 cap;
+    /* 查找空闲槽位的起点 */
+    __u32 scan_from;
+} dat_builder_t;
+
+/* 保证双数组至少有 size 个槽位，新槽位标记为未使用 */
+static bool dat_reserve(dat_builder_t *b, __u32 size) {
+    if (size <= b->cap) return true;
+
+    __u32 new_cap = b->cap ? b->cap : 1024;
+    while (new_cap < size) new_cap <<= 1;
+
+    domain_dat_node_t *nodes = realloc(b->dat->nodes, (size_t)new_cap * sizeof(domain_dat_node_t));
+    if (NULL == nodes) return false;
+    b->dat->nodes = nodes;
+
+    /* 多留一个哨兵，查找空闲槽位时不会越界 */
+    __u32 *next_free = realloc(b->next_free, ((size_t)new_cap + 1) * sizeof(__u32));
+    if (NULL == next_free) return false;
+    b->next_free = next_free;
+
+    for (__u32 i = b->cap; i < new_cap; i++) {
+        nodes[i].base = 0;
+        nodes[i].check = DOMAIN_ARENA_NO_PARENT;
+        next_free[i] = i;
+    }
+    next_free[new_cap] = new_cap;
+
+    b->cap = new_cap;
+    return true;
+}
+
+/* 不小于 i 的第一个空闲槽位，可能等于 cap */
+static __u32 dat_free_find(dat_builder_t *b, __u32 i) {
+    __u32 root = i;
+    while (b->next_free[root] != root) root = b->next_free[root];
+
+    while (b->next_free[i] != root) {
+        __u32 next = b->next_free[i];
+        b->next_free[i] = root;
+        i = next;
+    }
+
+    return root;
+}
+
+/* 占用槽位 t */
+static void dat_slot_use(dat_builder_t *b, __u32 t, __u32 parent) {
+    b->dat->nodes[t].check = parent | ((__u32)ACTION_NONE << DOMAIN_DAT_ACTION_SHIFT);
+    b->next_free[t] = t + 1;
+}
+
+bool domain_dat_build(domain_dat_t *dat, domain_arena_rule_t *rules, size_t *num) {
+    if (unlikely(NULL == dat || NULL == num || (NULL == rules && *num > 0))) return false;
+
+    memset(dat, 0, sizeof(*dat));
+
+    /* 排序后相同域名相邻，只保留导入顺序最后的一条 */
+    qsort(rules, *num, sizeof(domain_arena_rule_t), domain_arena_rule_cmp);
+    size_t n = 0;
+    for (size_t i = 0; i < *num; i++) {
+        if (n > 0 && rules[n - 1].num == rules[i].num &&
+            !memcmp(rules[n - 1].syms, rules[i].syms, rules[i].num)) n--;
+        rules[n++] = rules[i];
+    }
+    *num = n;
+
+    dat_builder_t b = {.dat = dat};
+    size_t task_cap = 1024, head = 0, tail = 0;
+    dat_task_t *tasks = malloc(task_cap * sizeof(dat_task_t));
+    if (NULL == tasks || !dat_reserve(&b, DOMAIN_DAT_ALPHABET)) goto err;
+
+    /* 槽位 0 为根 */
+    __u32 used = 1;
+    b.next_free[0] = 1;
+    tasks[tail++] = (dat_task_t){.node = 0, .depth = 0, .lo = 0, .hi = n};
+
+    while (head < tail) {
+        dat_task_t task = tasks[head++];
+
+        /* 排序后恰好在此结束的规则位于区间最前 */
+        size_t lo = task.lo;
+        if (lo < task.hi && rules[lo].num == task.depth) 
+            dat->nodes[task.node].check = (dat->nodes[task.node].check & DOMAIN_DAT_PARENT_MASK) |
+                ((__u32)rules[lo++].action << DOMAIN_DAT_ACTION_SHIFT);
+        if (lo >= task.hi) continue;
+
+        /* 收集子节点符号，区间内按符号有序 */
+        __u8 syms[DOMAIN_DAT_ALPHABET];
+        size_t starts[DOMAIN_DAT_ALPHABET + 1];
+        __u32 child_num = 0;
+        for (size_t i = lo; i < task.hi; i++) {
+            __u8 c = rules[i].syms[task.depth];
+            if (0 == child_num || syms[child_num - 1] != c) {
+                syms[child_num] = c;
+                starts[child_num++] = i;
+            }
+        }
+        starts[child_num] = task.hi;
+
+        /* 第一个子节点只尝试空闲槽位，找到能容纳全部子节点的最小 base */
+        __u32 base = 0, tries = 0;
+        for (__u32 f = (b.scan_from > syms[0]) ? b.scan_from : syms[0];; f++, tries++) {
+            f = dat_free_find(&b, f);
+            base = f - syms[0];
+            if (!dat_reserve(&b, base + DOMAIN_DAT_ALPHABET)) goto err;
+
+            __u32 i = 1;
+            while (i < child_num && DOMAIN_ARENA_NO_PARENT == (dat->nodes[base + syms[i]].check & DOMAIN_DAT_PARENT_MASK)) i++;
+            if (i == child_num) break;
+        }
+        if (tries > DOMAIN_DAT_SCAN_SKIP) b.scan_from = base + syms[0];
+
+        dat->nodes[task.node].base = base;
+        if (tail + child_num > task_cap) {
+            task_cap = (tail + child_num) * 2;
+            dat_task_t *new_tasks = realloc(tasks, task_cap * sizeof(dat_task_t));
+            if (NULL == new_tasks) goto err;
+            tasks = new_tasks;
+        }
+
+        for (__u32 i = 0; i < child_num; i++) {
+            __u32 t = base + syms[i];
+            dat_slot_use(&b, t, task.node);
+            if (t + 1 > used) used = t + 1;
+
+            tasks[tail++] = (dat_task_t){.node = t, .depth = task.depth + 1, .lo = starts[i], .hi = starts[i + 1]};
+        }
+    }
+
+    dat->num = used;
+    free(b.next_free);
+    free(tasks);
+    return true;
+
+err:
+    fprintf(stderr, "[ERROR] 双数组构建内存不足\n");
+    free(b.next_free);
+    free(tasks);
+    domain_dat_free(dat);
+    return false;
+}
+
+void domain_dat_free(domain_dat_t *dat) {
+    if (unlikely(NULL == dat)) return ;
+
+    free(dat->nodes);
+    memset(dat, 0, sizeof(*dat));
+}
+
+__u32 domain_dat_lookup(const domain_dat_t *dat, const __u8 *syms, __u32 num) {
+    if (unlikely(NULL == dat || NULL == syms || 0 == dat->num)) return ACTION_NONE;
+
+    __u32 state = 0;
+    __u32 action = ACTION_NONE;
+    for (__u32 i = 0; i < num; i++) {
+        __u32 t = dat->nodes[state].base + syms[i];
+        if (t >= dat->num || (dat->nodes[t].check & DOMAIN_DAT_PARENT_MASK) != state) break;
+
+        state = t;
+        __u32 hit = dat->nodes[t].check >> DOMAIN_DAT_ACTION_SHIFT;
+        if (ACTION_NONE != hit) action = hit;
+    }
+
+    return action;
+}
+
+bool domain_arena_add(const __u8 *syms, __u32 num, __u32 action) {
+    if (unlikely(NULL == syms || 0 == num || num > DOMAIN_KEY_MAX_SYMS)) return false;
+
+    if (pending_num >= pending_cap) {
+        size_t cap = pending_cap ? pending_cap * 2 : 4096;
+        domain_arena_rule_t *rules = realloc(pending, cap * sizeof(domain_arena_rule_t));
+        if (NULL == rules) return false;
+
+        pending = rules;
+        pending_cap = cap;
+    }
+
+    domain_arena_rule_t *rule = &pending[pending_num];
+    memset(rule, 0, sizeof(*rule));
+    rule->num = num;
+    rule->action = action;
+    rule->seq = pending_num++;
+    memcpy(rule->syms, syms, num);
+
+    return true;
+}
+
+/* 读取 arena 规则区中已有的规则，导入顺序在暂存规则之前 */
+static domain_arena_rule_t *domain_arena_rules_load(const unsigned char *arena, size_t *num) {
+    const domain_arena_hdr_t *hdr = (const domain_arena_hdr_t *)arena;
+    __u32 old_num = (DOMAIN_ARENA_MAGIC == hdr->magic) ? hdr->rule_num : 0;
+
+    domain_arena_rule_t *rules = calloc(old_num + pending_num + 1, sizeof(domain_arena_rule_t));
+    if (NULL == rules) return NULL;
+
+    const unsigned char *p = arena + DOMAIN_ARENA_RULE_OFF;
+    const unsigned char *end = p + ((DOMAIN_ARENA_MAGIC == hdr->magic) ? hdr->rule_bytes : 0);
+    size_t n = 0;
+    while (n < old_num && p + DOMAIN_ARENA_RULE_HDR <= end) {
+        domain_arena_rule_t *rule = &rules[n];
+        rule->num = p[0];
+        rule->action = p[1];
+        if (0 == rule->num || rule->num > DOMAIN_KEY_MAX_SYMS ||
+            p + DOMAIN_ARENA_RULE_HDR + rule->num > end) break;
+
+        memcpy(rule->syms, p + DOMAIN_ARENA_RULE_HDR, rule->num);
+        rule->seq = n++;
+        p += DOMAIN_ARENA_RULE_HDR + rule->num;
+    }
+
+    for (size_t i = 0; i < pending_num; i++) {
+        rules[n] = pending[i];
+        rules[n].seq = n;
+        n++;
+    }
+
+    *num = n;
+    return rules;
+}
+
+/* 规则区按排序后的顺序紧凑写回，返回写入的字节数，超过规则区大小返回 0 */
+static size_t domain_arena_rules_store(unsigned char *arena, const domain_arena_rule_t *rules, size_t num) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < num; i++) bytes += DOMAIN_ARENA_RULE_HDR + rules[i].num;
+    if (bytes > DOMAIN_ARENA_RULE_BYTES) return 0;
+
+    unsigned char *p = arena + DOMAIN_ARENA_RULE_OFF;
+    for (size_t i = 0; i < num; i++) {
+        p[0] = rules[i].num;
+        p[1] = rules[i].action;
+        memcpy(p + DOMAIN_ARENA_RULE_HDR, rules[i].syms, rules[i].num);
+        p += DOMAIN_ARENA_RULE_HDR + rules[i].num;
+    }
+
+    return bytes;
+}
+
+int domain_arena_commit(void) {
+    if (0 == pending_num) return 0;
+
+    int ret = -1;
+    size_t num = 0;
+    domain_dat_t dat = {0};
+    domain_arena_rule_t *rules = NULL;
+    unsigned char *arena = MAP_FAILED;
+
+    int arena_fd = bpf_obj_get(DOMAINARENA_PIN);
+    if (arena_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", DOMAINARENA_PIN, strerror(errno));
+        goto out;
+    }
+
+    /* arena 只能映射到创建时约定的地址，双数组内使用下标，不依赖该地址 */
+    arena = mmap((void *)DOMAIN_ARENA_ADDR, DOMAIN_ARENA_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, arena_fd, 0);
+    if (MAP_FAILED == arena || (void *)DOMAIN_ARENA_ADDR != (void *)arena) {
+        fprintf(stderr, "[ERROR] 域名 arena mmap 失败: %s\n", strerror(errno));
+        goto out;
+    }
+
+    rules = domain_arena_rules_load(arena, &num);
+    if (NULL == rules) goto out;
+    if (!domain_dat_build(&dat, rules, &num)) goto out;
+
+    if (dat.num > DOMAIN_ARENA_NODE_MAX) {
+        fprintf(stderr, "[ERROR] 双数组需要 %u 个节点，超过上限 %u\n", dat.num, DOMAIN_ARENA_NODE_MAX);
+        goto out;
+    }
+
+    size_t rule_bytes = domain_arena_rules_store(arena, rules, num);
+    if (0 == rule_bytes && num > 0) {
+        fprintf(stderr, "[ERROR] 域名规则超过 arena 规则区上限 %u 字节\n", DOMAIN_ARENA_RULE_BYTES);
+        goto out;
+    }
+
+    domain_arena_hdr_t *hdr = (domain_arena_hdr_t *)arena;
+    if (DOMAIN_ARENA_MAGIC != hdr->magic) {
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->magic = DOMAIN_ARENA_MAGIC;
+    }
+
+    hdr->rule_num = num;
+    hdr->rule_bytes = rule_bytes;
+
+    /* 写入非活动的一份后切换，数据面不会读到构建中的双数组 */
+    __u32 idle = !hdr->active;
+    memcpy(arena + DOMAIN_ARENA_NODE_OFF + idle * DOMAIN_ARENA_NODE_BYTES,
+        dat.nodes, (size_t)dat.num * sizeof(domain_dat_node_t));
+    hdr->node_num[idle] = dat.num;
+    __atomic_store_n(&hdr->active, idle, __ATOMIC_RELEASE);
+
+    printf("[INFO] 域名双数组已更新: 规则 %zu 条，节点 %u 个，占用 %zu KB\n",
+        num, dat.num, ((size_t)dat.num * sizeof(domain_dat_node_t) + rule_bytes) >> 10);
+    ret = 0;
+
+out:
+    if (MAP_FAILED != arena) munmap(arena, DOMAIN_ARENA_BYTES);
+    if (arena_fd >= 0) close(arena_fd);
+    domain_dat_free(&dat);
+    free(rules);
+
+    free(pending);
+    pending = NULL;
+    pending_num = pending_cap = 0;
+
+    return ret;
+}
+
+bool domain_arena_snapshot(domain_dat_t *dat) {
+    if (unlikely(NULL == dat)) return false;
+    memset(dat, 0, sizeof(*dat));
+
+    bool ok = false;
+    unsigned char *arena = MAP_FAILED;
+    int arena_fd = bpf_obj_get(DOMAINARENA_PIN);
+    if (arena_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", DOMAINARENA_PIN, strerror(errno));
+        goto out;
+    }
+
+    arena = mmap((void *)DOMAIN_ARENA_ADDR, DOMAIN_ARENA_BYTES, PROT_READ, MAP_SHARED, arena_fd, 0);
+    if (MAP_FAILED == arena || (void *)DOMAIN_ARENA_ADDR != (void *)arena) {
+        fprintf(stderr, "[ERROR] 域名 arena mmap 失败: %s\n", strerror(errno));
+        goto out;
+    }
+
+    /* 尚未导入过规则时为空双数组，查询全部未命中 */
+    const domain_arena_hdr_t *hdr = (const domain_arena_hdr_t *)arena;
+    __u32 active = __atomic_load_n(&hdr->active, __ATOMIC_ACQUIRE) & 1;
+    __u32 num = (DOMAIN_ARENA_MAGIC == hdr->magic) ? hdr->node_num[active] : 0;
+    if (num > DOMAIN_ARENA_NODE_MAX) num = 0;
+
+    if (num > 0) {
+        dat->nodes = malloc((size_t)num * sizeof(domain_dat_node_t));
+        if (NULL == dat->nodes) goto out;
+
+        memcpy(dat->nodes, arena + DOMAIN_ARENA_NODE_OFF + active * DOMAIN_ARENA_NODE_BYTES,
+            (size_t)num * sizeof(domain_dat_node_t));
+        dat->num = num;
+    }
+    ok = true;
+
+out:
+    if (MAP_FAILED != arena) munmap(arena, DOMAIN_ARENA_BYTES);
+    if (arena_fd >= 0) close(arena_fd);
+    return ok;
+}
@@ -0,0 +1,121 @@
+/*
+ * File     : domain_set.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-26 21:07:40
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "direct_path_user.h"
+#include "direct_path_domain_set.h"
+
+bool domain_rule_set_add(domain_rule_set_t *set, const domain_lpm_key_t *key, __u32 action) {
+    if (unlikely(NULL == set || NULL == key)) return false;
+
+    if (set->num == set->cap) {
+        size_t cap = set->cap ? set->cap * 2 : DOMAIN_RULE_SET_INIT_CAP;
+        domain_rule_t *rules = realloc(set->rules, cap * sizeof(domain_rule_t));
+        if (NULL == rules) return false;
+
+        set->rules = rules;
+        set->cap = cap;
+    }
+
+    domain_rule_t *rule = &set->rules[set->num];
+    rule->key = *key;
+    rule->action = action;
+    rule->seq = (__u32)set->num;
+    set->num++;
+
+    return true;
+}
+
+void domain_rule_set_free(domain_rule_set_t *set) {
+    if (unlikely(NULL == set)) return ;
+
+    free(set->rules);
+    memset(set, 0, sizeof(*set));
+}
+
+/* key 前缀以外的位为 0，且合法 key 中不会出现全 0 的字符或符号，
+ * 按字节序排序即为反转后缀树的先序遍历顺序: 后缀规则排在其所有子域名规则之前，且子域名规则连续 */
+static int domain_rule_cmp_key_seq(const void *a, const void *b) {
+    const domain_rule_t *ra = a, *rb = b;
+
+    int ret = memcmp(ra->key.domain, rb->key.domain, DOMAIN_MAX_LEN);
+    if (ret) return ret;
+    if (ra->key.prefixlen != rb->key.prefixlen) return (ra->key.prefixlen < rb->key.prefixlen) ? -1 : 1;
+    if (ra->seq != rb->seq) return (ra->seq < rb->seq) ? -1 : 1;
+    return 0;
+}
+
+/* a 是否为 b 的前缀，即 a 为 b 的后缀域名，LPM 查询 b 覆盖的域名时 a 同样命中 */
+static bool domain_key_is_prefix(const domain_lpm_key_t *a, const domain_lpm_key_t *b) {
+    if (a->prefixlen > b->prefixlen) return false;
+
+    __u32 bytes = a->prefixlen / 8;
+    __u32 bits = a->prefixlen % 8;
+    if (memcmp(a->domain, b->domain, bytes)) return false;
+    if (0 == bits) return true;
+
+    __u8 mask = (__u8)(0xFF << (8 - bits));
+    return (a->domain[bytes] & mask) == (b->domain[bytes] & mask);
+}
+
+void domain_rule_set_prune(domain_rule_set_t *set, size_t *dup, size_t *shadowed) {
+    if (unlikely(NULL == set)) return ;
+
+    size_t dup_num = 0, shadowed_num = 0;
+    qsort(set->rules, set->num, sizeof(domain_rule_t), domain_rule_cmp_key_seq);
+
+    /* 相同 key 相邻，只保留最后加入的一条 */
+    size_t n = 0;
+    for (size_t i = 0; i < set->num; i++) {
+        domain_rule_t *last = (n > 0) ? &set->rules[n - 1] : NULL;
+        if (last && last->key.prefixlen == set->rules[i].key.prefixlen &&
+            !memcmp(last->key.domain, set->rules[i].key.domain, DOMAIN_MAX_LEN)) {
+            dup_num++;
+            n--;
+        }
+
+        set->rules[n++] = set->rules[i];
+    }
+    set->num = n;
+
+    /* 按先序遍历维护当前规则的祖先栈，栈顶为最近的更短后缀规则
+     * 被剪除的规则仍入栈: 其动作与自己的祖先相同，对子域名规则的判断没有影响 */
+    size_t *stack = malloc((n ? n : 1) * sizeof(size_t));
+    bool *keep = malloc((n ? n : 1) * sizeof(bool));
+    if (NULL == stack || NULL == keep) {
+        free(stack);
+        free(keep);
+        goto out;
+    }
+
+    size_t top = 0;
+    for (size_t i = 0; i < n; i++) {
+        while (top > 0 && !domain_key_is_prefix(&set->rules[stack[top - 1]].key, &set->rules[i].key)) top--;
+
+        keep[i] = !(top > 0 && set->rules[stack[top - 1]].action == set->rules[i].action);
+        if (!keep[i]) shadowed_num++;
+
+        stack[top++] = i;
+    }
+
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (keep[i]) set->rules[m++] = set->rules[i];
+    }
+    set->num = m;
+
+    free(stack);
+    free(keep);
+
+out:
+    if (dup) *dup = dup_num;
+    if (shadowed) *shadowed = shadowed_num;
+}
@@ -0,0 +1,219 @@
+/*
+ * File     : ip_set.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-14 16:24:05
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <bpf/bpf.h>
+
+#include "direct_path_user.h"
+#include "direct_path_ip_set.h"
+
+/* 前缀对应的主机位掩码 */
+static __always_inline __u32 ip_host_mask(__u32 prefixlen) {
+    return (prefixlen >= 32) ? 0 : (~0U >> prefixlen);
+}
+
+bool ip_rule_set_add(ip_rule_set_t *set, const ip_lpm_key_t *key, __u32 action) {
+    if (unlikely(NULL == set || NULL == key)) return false;
+
+    if (set->num == set->cap) {
+        size_t cap = set->cap ? set->cap * 2 : IP_RULE_SET_INIT_CAP;
+        ip_rule_t *rules = realloc(set->rules, cap * sizeof(ip_rule_t));
+        if (NULL == rules) return false;
+
+        set->rules = rules;
+        set->cap = cap;
+    }
+
+    ip_rule_t *rule = &set->rules[set->num];
+    rule->key = *key;
+    rule->action = action;
+    rule->seq = (__u32)set->num;
+    set->num++;
+
+    return true;
+}
+
+void ip_rule_set_free(ip_rule_set_t *set) {
+    if (unlikely(NULL == set)) return ;
+
+    free(set->rules);
+    memset(set, 0, sizeof(*set));
+}
+
+bool ip_rule_set_from_map(ip_rule_set_t *set, int map_fd) {
+    if (unlikely(NULL == set || map_fd < 0)) return false;
+
+    ip_lpm_key_t key = {0};
+    ip_lpm_key_t next = {0};
+    void *prev = NULL;
+    while (0 == bpf_map_get_next_key(map_fd, prev, &next)) {
+        __u32 action = ACTION_NONE;
+        if (0 == bpf_map_lookup_elem(map_fd, &next, &action)) {
+            if (!ip_rule_set_add(set, &next, action)) return false;
+        }
+
+        key = next;
+        prev = &key;
+    }
+
+    return true;
+}
+
+static int ip_rule_cmp_key_seq(const void *a, const void *b) {
+    const ip_rule_t *ra = a, *rb = b;
+    __u32 aa = ntohl(ra->key.ipv4), ab = ntohl(rb->key.ipv4);
+
+    if (aa != ab) return (aa < ab) ? -1 : 1;
+    if (ra->key.prefixlen != rb->key.prefixlen) return (ra->key.prefixlen < rb->key.prefixlen) ? -1 : 1;
+    if (ra->seq != rb->seq) return (ra->seq < rb->seq) ? -1 : 1;
+    return 0;
+}
+
+static int ip_rule_cmp_prefixlen_seq(const void *a, const void *b) {
+    const ip_rule_t *ra = a, *rb = b;
+
+    if (ra->key.prefixlen != rb->key.prefixlen) return (ra->key.prefixlen < rb->key.prefixlen) ? -1 : 1;
+    if (ra->seq != rb->seq) return (ra->seq < rb->seq) ? -1 : 1;
+    return 0;
+}
+
+void ip_rule_set_dedup(ip_rule_set_t *set) {
+    if (unlikely(NULL == set || 0 == set->num)) return ;
+
+    qsort(set->rules, set->num, sizeof(ip_rule_t), ip_rule_cmp_key_seq);
+
+    /* key 相同的规则相邻且按 seq 升序，保留每段最后一条 */
+    size_t n = 0;
+    for (size_t i = 0; i < set->num; i++) {
+        if (i + 1 < set->num &&
+            set->rules[i].key.ipv4 == set->rules[i + 1].key.ipv4 &&
+            set->rules[i].key.prefixlen == set->rules[i + 1].key.prefixlen) continue;
+
+        set->rules[n++] = set->rules[i];
+    }
+
+    set->num = n;
+}
+
+static int ip_range_cmp(const void *a, const void *b) {
+    const ip_range_t *ra = a, *rb = b;
+
+    if (ra->start != rb->start) return (ra->start < rb->start) ? -1 : 1;
+    if (ra->end != rb->end) return (ra->end > rb->end) ? -1 : 1;
+    return 0;
+}
+
+bool ip_range_set_build(ip_range_set_t *ranges, const ip_rule_set_t *set) {
+    if (unlikely(NULL == ranges || NULL == set)) return false;
+
+    memset(ranges, 0, sizeof(*ranges));
+    if (0 == set->num) return true;
+
+    ranges->ranges = calloc(set->num, sizeof(ip_range_t));
+    if (NULL == ranges->ranges) return false;
+
+    for (size_t i = 0; i < set->num; i++) {
+        __u32 start = ntohl(set->rules[i].key.ipv4) & ~ip_host_mask(set->rules[i].key.prefixlen);
+        ranges->ranges[i].start = start;
+        ranges->ranges[i].end = start | ip_host_mask(set->rules[i].key.prefixlen);
+    }
+
+    qsort(ranges->ranges, set->num, sizeof(ip_range_t), ip_range_cmp);
+
+    /* 合并重叠与相邻区间 */
+    size_t n = 0;
+    for (size_t i = 0; i < set->num; i++) {
+        ip_range_t *cur = &ranges->ranges[i];
+        if (n > 0) {
+            ip_range_t *last = &ranges->ranges[n - 1];
+            if (last->end == 0xFFFFFFFFU || cur->start <= last->end + 1) {
+                if (cur->end > last->end) last->end = cur->end;
+                continue;
+            }
+        }
+
+        ranges->ranges[n++] = *cur;
+    }
+
+    ranges->num = n;
+    return true;
+}
+
+void ip_range_set_free(ip_range_set_t *ranges) {
+    if (unlikely(NULL == ranges)) return ;
+
+    free(ranges->ranges);
+    memset(ranges, 0, sizeof(*ranges));
+}
+
+/* 第一个 end >= addr 的区间下标 */
+static size_t ip_range_lower_bound(const ip_range_set_t *ranges, __u32 addr) {
+    size_t lo = 0, hi = ranges->num;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ranges->ranges[mid].end < addr) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+bool ip_range_set_contains(const ip_range_set_t *ranges, __u32 addr) {
+    if (unlikely(NULL == ranges || 0 == ranges->num)) return false;
+
+    size_t i = ip_range_lower_bound(ranges, addr);
+    return (i < ranges->num && ranges->ranges[i].start <= addr);
+}
+
+/* 从前缀中扣除黑名单区间，未被覆盖的部分以尽量短的前缀输出 */
+static bool ip_prefix_subtract(__u32 start, __u32 prefixlen, __u32 action, 
+    const ip_range_set_t *blk, ip_rule_set_t *out) {
+
+    __u32 end = start | ip_host_mask(prefixlen);
+
+    size_t i = ip_range_lower_bound(blk, start);
+    if (i == blk->num || blk->ranges[i].start > end) {
+        ip_lpm_key_t key = {.prefixlen = prefixlen, .ipv4 = htonl(start)};
+        return ip_rule_set_add(out, &key, action);
+    }
+
+    /* 整个前缀都在黑名单中 */
+    if (blk->ranges[i].start <= start && blk->ranges[i].end >= end) return true;
+
+    /* 部分重叠，对半拆分后递归，部分重叠意味着 prefixlen 必然小于 32 */
+    if (!ip_prefix_subtract(start, prefixlen + 1, action, blk, out)) return false;
+    return ip_prefix_subtract(start | (1U << (31 - prefixlen)), prefixlen + 1, action, blk, out);
+}
+
+bool ip_rule_set_subtract(const ip_rule_set_t *set, const ip_range_set_t *blk, ip_rule_set_t *out) {
+    if (unlikely(NULL == set || NULL == blk || NULL == out)) return false;
+    if (0 == set->num) return true;
+
+    /* 按原前缀由短到长输出，拆分出的相同 key 由更长 (更具体) 的原规则覆盖 */
+    ip_rule_t *sorted = malloc(set->num * sizeof(ip_rule_t));
+    if (NULL == sorted) return false;
+
+    memcpy(sorted, set->rules, set->num * sizeof(ip_rule_t));
+    qsort(sorted, set->num, sizeof(ip_rule_t), ip_rule_cmp_prefixlen_seq);
+
+    bool ret = true;
+    for (size_t i = 0; i < set->num && ret; i++) {
+        __u32 prefixlen = sorted[i].key.prefixlen;
+        __u32 start = ntohl(sorted[i].key.ipv4) & ~ip_host_mask(prefixlen);
+        ret = ip_prefix_subtract(start, prefixlen, sorted[i].action, blk, out);
+    }
+
+    free(sorted);
+    if (ret) ip_rule_set_dedup(out);
+
+    return ret;
+}
@@ -0,0 +1,282 @@
+/*
+ * File     : keyword.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-20 09:43:10
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <bpf/bpf.h>
+
+#include "direct_path_user.h"
+#include "direct_path_keyword.h"
+
+/* 构造过程中表示尚无转移 */
+#define KEYWORD_AC_NO_STATE             0xFFFFFFFFU
+/* 单份转移表字节数 */
+#define KEYWORD_AC_TABLE_BYTES          ((size_t)KEYWORD_AC_TABLE_SIZE * KEYWORD_AC_MAP_VAL_SIZE)
+/* 转移表 map 总字节数 (双缓冲) */
+#define KEYWORD_AC_MAP_BYTES            ((size_t)KEYWORD_AC_MAP_SIZE * KEYWORD_AC_MAP_VAL_SIZE)
+
+__u8 domain_char_to_sym(unsigned char c) {
+    if (c >= '0' && c <= '9') return DOMAIN_SYM_DIGIT + (c - '0');
+    if (c >= 'a' && c <= 'z') return DOMAIN_SYM_ALPHA + (c - 'a');
+    if (c >= 'A' && c <= 'Z') return DOMAIN_SYM_ALPHA + (c - 'A');
+    if ('-' == c) return DOMAIN_SYM_HYPHEN;
+    if ('_' == c) return DOMAIN_SYM_UNDERSCORE;
+    return DOMAIN_SYM_PAD;
+}
+
+bool keyword_encode(const char *keyword, keyword_rule_t *rule) {
+    if (unlikely(NULL == keyword || NULL == rule)) return false;
+
+    rule->num = 0;
+    for (const char *p = keyword; *p != '\0'; p++) {
+        if (rule->num >= DOMAIN_MAX_LEN) return false;
+
+        __u8 sym = ('.' == *p) ? DOMAIN_SYM_SEP : domain_char_to_sym((unsigned char)*p);
+        if (DOMAIN_SYM_PAD == sym) return false;
+
+        rule->syms[rule->num++] = sym;
+    }
+
+    return rule->num > 0;
+}
+
+bool keyword_set_add(keyword_set_t *set, const char *keyword, __u32 action) {
+    if (unlikely(NULL == set || NULL == keyword)) return false;
+
+    keyword_rule_t rule;
+    if (!keyword_encode(keyword, &rule)) return false;
+
+    if (set->num == set->cap) {
+        size_t cap = set->cap ? set->cap * 2 : 256;
+        keyword_key_t *keys = realloc(set->keys, cap * sizeof(keyword_key_t));
+        if (NULL == keys) return false;
+        set->keys = keys;
+
+        __u32 *actions = realloc(set->actions, cap * sizeof(__u32));
+        if (NULL == actions) return false;
+        set->actions = actions;
+
+        set->cap = cap;
+    }
+
+    keyword_key_t *key = &set->keys[set->num];
+    memset(key, 0, sizeof(*key));
+    for (size_t i = 0; i < sizeof(key->keyword) - 1 && keyword[i] != '\0'; i++) 
+        key->keyword[i] = tolower((unsigned char)keyword[i]);
+
+    set->actions[set->num++] = action;
+    return true;
+}
+
+void keyword_set_free(keyword_set_t *set) {
+    if (unlikely(NULL == set)) return ;
+
+    free(set->keys);
+    free(set->actions);
+    memset(set, 0, sizeof(*set));
+}
+
+bool keyword_ac_build(keyword_ac_t *ac, const keyword_rule_t *rules, size_t num) {
+    if (unlikely(NULL == ac || (NULL == rules && num > 0))) return false;
+
+    memset(ac, 0, sizeof(*ac));
+
+    __u32 *next = malloc(KEYWORD_AC_TABLE_BYTES);
+    __u32 *fail = calloc(KEYWORD_AC_MAX_STATES, sizeof(__u32));
+    __u32 *out = calloc(KEYWORD_AC_MAX_STATES, sizeof(__u32));
+    __u32 *queue = malloc(KEYWORD_AC_MAX_STATES * sizeof(__u32));
+    if (NULL == next || NULL == fail || NULL == out || NULL == queue) goto err;
+
+    memset(next, 0xFF, KEYWORD_AC_TABLE_BYTES);
+
+    /* 构造关键字前缀树，状态 0 为根 */
+    __u32 states = 1;
+    for (size_t i = 0; i < num; i++) {
+        __u32 cur = 0;
+        for (__u32 j = 0; j < rules[i].num; j++) {
+            __u32 *slot = &next[(cur << KEYWORD_AC_ALPHABET_SHIFT) | rules[i].syms[j]];
+            if (KEYWORD_AC_NO_STATE == *slot) {
+                if (states >= KEYWORD_AC_MAX_STATES) {
+                    fprintf(stderr, "[ERROR] 关键字自动机状态数超过上限 %u\n", KEYWORD_AC_MAX_STATES);
+                    goto err;
+                }
+                *slot = states++;
+            }
+
+            cur = *slot;
+        }
+
+        if (ACTION_NONE == out[cur]) out[cur] = rules[i].action;
+    }
+
+    /* 广度优先计算失败指针，并补全为 DFA */
+    __u32 head = 0, tail = 0;
+    for (__u32 a = 0; a < KEYWORD_AC_ALPHABET; a++) {
+        __u32 *slot = &next[a];
+        if (KEYWORD_AC_NO_STATE == *slot) {
+            *slot = 0;
+            continue;
+        }
+
+        fail[*slot] = 0;
+        queue[tail++] = *slot;
+    }
+
+    while (head < tail) {
+        __u32 r = queue[head++];
+        for (__u32 a = 0; a < KEYWORD_AC_ALPHABET; a++) {
+            __u32 *slot = &next[(r << KEYWORD_AC_ALPHABET_SHIFT) | a];
+            __u32 f = next[(fail[r] << KEYWORD_AC_ALPHABET_SHIFT) | a];
+            if (KEYWORD_AC_NO_STATE == *slot) {
+                *slot = f;
+                continue;
+            }
+
+            fail[*slot] = f;
+            /* 自身不是关键字结尾时，继承失败状态上更短关键字的动作 */
+            if (ACTION_NONE == out[*slot]) out[*slot] = out[f];
+            queue[tail++] = *slot;
+        }
+    }
+
+    /* 转移目标状态的动作一并编码，数据面每步只需一次查表 */
+    for (__u32 i = 0; i < (states << KEYWORD_AC_ALPHABET_SHIFT); i++) 
+        next[i] |= out[next[i]] << KEYWORD_AC_ACTION_SHIFT;
+
+    ac->table = next;
+    ac->states = states;
+
+    free(fail);
+    free(out);
+    free(queue);
+    return true;
+
+err:
+    free(next);
+    free(fail);
+    free(out);
+    free(queue);
+    return false;
+}
+
+void keyword_ac_free(keyword_ac_t *ac) {
+    if (unlikely(NULL == ac)) return ;
+
+    free(ac->table);
+    memset(ac, 0, sizeof(*ac));
+}
+
+static int keyword_cmp(const void *a, const void *b) {
+    return strcmp(((const keyword_key_t *)a)->keyword, ((const keyword_key_t *)b)->keyword);
+}
+
+/* 读取全部关键字规则，按关键字排序保证编译结果稳定 */
+static bool keyword_rules_from_map(int map_fd, keyword_rule_t **rules, size_t *num) {
+    keyword_key_t *keys = calloc(KEYWORD_MAP_SIZE, sizeof(keyword_key_t));
+    if (NULL == keys) return false;
+
+    size_t n = 0;
+    keyword_key_t key, next;
+    void *prev = NULL;
+    while (n < KEYWORD_MAP_SIZE && 0 == bpf_map_get_next_key(map_fd, prev, &next)) {
+        keys[n++] = next;
+        key = next;
+        prev = &key;
+    }
+
+    qsort(keys, n, sizeof(keyword_key_t), keyword_cmp);
+
+    *rules = calloc(n ? n : 1, sizeof(keyword_rule_t));
+    if (NULL == *rules) {
+        free(keys);
+        return false;
+    }
+
+    *num = 0;
+    for (size_t i = 0; i < n; i++) {
+        keyword_rule_t *rule = &(*rules)[*num];
+        if (bpf_map_lookup_elem(map_fd, &keys[i], &rule->action)) continue;
+        if (!keyword_encode(keys[i].keyword, rule)) continue;
+        (*num)++;
+    }
+
+    free(keys);
+    return true;
+}
+
+/* 读取 XDP 配置 */
+static bool keyword_config_get(int map_fd, xdp_config_t *cfg) {
+    __u32 key = 0;
+    return (0 == bpf_map_lookup_elem(map_fd, &key, cfg));
+}
+
+/* 写入 XDP 配置，状态数与活动转移表一次更新 */
+static bool keyword_config_set(int map_fd, const xdp_config_t *cfg) {
+    __u32 key = 0;
+    return (0 == bpf_map_update_elem(map_fd, &key, cfg, BPF_ANY));
+}
+
+int keyword_rebuild(void) {
+    int map_fd = bpf_obj_get(KEYWORDMAP_PIN);
+    int ac_fd = bpf_obj_get(KEYWORDAC_PIN);
+    int cfg_fd = bpf_obj_get(XDPCONFIG_PIN);
+
+    int ret = -1;
+    size_t num = 0;
+    keyword_ac_t ac = {0};
+    keyword_rule_t *rules = NULL;
+    xdp_config_t cfg = {0};
+
+    if (map_fd < 0 || ac_fd < 0 || cfg_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取关键字相关 BPF Map: %s\n", strerror(errno));
+        goto out;
+    }
+
+    if (!keyword_rules_from_map(map_fd, &rules, &num)) goto out;
+    if (!keyword_ac_build(&ac, rules, num)) goto out;
+    if (!keyword_config_get(cfg_fd, &cfg)) {
+        fprintf(stderr, "[ERROR] 读取 XDP 配置失败: %s\n", strerror(errno));
+        goto out;
+    }
+
+    __u32 *table = mmap(NULL, KEYWORD_AC_MAP_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, ac_fd, 0);
+    if (MAP_FAILED == table) {
+        fprintf(stderr, "[ERROR] 关键字自动机 mmap 失败: %s\n", strerror(errno));
+        goto out;
+    }
+
+    /* 写入非活动的一份后切换，数据面正在进行的遍历仍读取旧表，不会读到新旧混合的转移表 */
+    __u32 idle = !(cfg.keyword_active & 1);
+    memcpy(table + (size_t)idle * KEYWORD_AC_TABLE_SIZE, ac.table,
+        ((size_t)ac.states << KEYWORD_AC_ALPHABET_SHIFT) * sizeof(__u32));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    cfg.keyword_active = idle;
+    cfg.keyword_states = num ? ac.states : 0;
+    if (keyword_config_set(cfg_fd, &cfg)) ret = 0;
+    else fprintf(stderr, "[ERROR] 更新 XDP 配置失败: %s\n", strerror(errno));
+
+    munmap(table, KEYWORD_AC_MAP_BYTES);
+
+    if (!ret) printf("[INFO] 关键字自动机已更新: 关键字 %zu 个，状态 %u 个\n", num, ac.states);
+
+out:
+    keyword_ac_free(&ac);
+    free(rules);
+    if (map_fd >= 0) close(map_fd);
+    if (ac_fd >= 0) close(ac_fd);
+    if (cfg_fd >= 0) close(cfg_fd);
+
+    return ret;
+}
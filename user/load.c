@@ -22,11 +22,35 @@ int load_install(int argc, char **argv) {
         return -1; 
     }
 
+    if (!init_map_all()) {
+        umount_map_all();
+        fprintf(stderr, "[ERRO] init_map_all failed\n");
+        return -1; 
+    }
+
     if(!load_and_pin_bpf_all()) return false;
 
     return 0;
 }
 
+int load_upgrade(int argc, char **argv) {
+    if (!create_map_missing()) {
+        fprintf(stderr, "[ERRO] create_map_missing failed\n");
+        return -1; 
+    }
+
+    if (!upgrade_bpf_all()) {
+        fprintf(stderr, "[ERRO] upgrade_bpf_all failed\n");
+        return -1; 
+    }
+
+    return 0;
+}
+
+int load_status(int argc, char **argv) {
+    return show_attach_status() ? 0 : -1;
+}
+
 int load_uninstall(int argc, char **argv) {
     if (!umount_map_all()) return -1;
     return 0;
@@ -37,6 +61,8 @@ int load_args_parse(int argc, char **argv) {
 
     if (!strcmp(argv[2], LOAD_ARGS_INSTALL)) return load_install(argc, argv);
     else if (!strcmp(argv[2], LOAD_ARGS_UNINSTALL)) return load_uninstall(argc, argv);
+    else if (!strcmp(argv[2], LOAD_ARGS_UPGRADE)) return load_upgrade(argc, argv);
+    else if (!strcmp(argv[2], LOAD_ARGS_STATUS)) return load_status(argc, argv);
 
     return 0;
 }
@@ -0,0 +1,212 @@
+/*
+ * File     : mem.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-09 22:05:36
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_plan.h"
+#include "direct_path_mem.h"
+
+typedef struct {
+    struct bpf_map_info info;
+    /* 无法遍历的 map (Bloom、arena) 为 -1 */
+    long long entries;
+    __u64 memlock;
+} mem_map_t;
+
+typedef struct {
+    mem_map_t maps[MEM_MAP_MAX_NUM];
+    __u32 num;
+} mem_report_t;
+
+/* 从 /proc/self/fdinfo 读取内核统计的 map 内存占用 */
+static bool mem_fdinfo_memlock(int map_fd, __u64 *memlock) {
+    char path[FILE_LINE_MAXLEN];
+    snprintf(path, sizeof(path), "/proc/self/fdinfo/%d", map_fd);
+
+    FILE *fp = fopen(path, "r");
+    if (NULL == fp) return false;
+
+    bool found = false;
+    char line[FILE_LINE_MAXLEN];
+    while (!found && fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, MEM_FDINFO_MEMLOCK, strlen(MEM_FDINFO_MEMLOCK))) continue;
+        *memlock = strtoull(line + strlen(MEM_FDINFO_MEMLOCK), NULL, 10);
+        found = true;
+    }
+
+    fclose(fp);
+    return found;
+}
+
+/* 程序与 link 也固定在同一目录，OBJ_GET_INFO_BY_FD 对它们同样成功，须先确认 fd 是 map */
+static bool mem_fd_is_map(int fd) {
+    char path[FILE_LINE_MAXLEN];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+
+    char target[FILE_LINE_MAXLEN];
+    ssize_t len = readlink(path, target, sizeof(target) - 1);
+    if (len < 0) return false;
+
+    target[len] = '\0';
+    return !strcmp(target, MEM_FD_MAP_TARGET);
+}
+
+/* 遍历 key 统计条目数，数组类 map 的条目数即容量 */
+static long long mem_map_entries(int map_fd, const struct bpf_map_info *info) {
+    switch (info->type) {
+        case BPF_MAP_TYPE_ARRAY:
+        case BPF_MAP_TYPE_PERCPU_ARRAY:
+            return info->max_entries;
+        case BPF_MAP_TYPE_HASH:
+        case BPF_MAP_TYPE_LRU_HASH:
+        case BPF_MAP_TYPE_LPM_TRIE:
+            break;
+        default:
+            return -1;
+    }
+
+    unsigned char *keys = malloc((size_t)info->key_size * 2);
+    if (NULL == keys) return -1;
+
+    long long num = 0;
+    void *prev = NULL;
+    void *next = keys;
+    while (!bpf_map_get_next_key(map_fd, prev, next)) {
+        num++;
+        prev = next;
+        next = (next == keys) ? keys + info->key_size : keys;
+    }
+
+    free(keys);
+    return num;
+}
+
+static bool mem_map_collected(const mem_report_t *report, __u32 id) {
+    for (__u32 i = 0; i < report->num; i++) {
+        if (report->maps[i].info.id == id) return true;
+    }
+
+    return false;
+}
+
+/* 收集目录下固定的 map，同一 map 固定在多个目录时只统计一次 */
+static void mem_collect_dir(mem_report_t *report, const char *dir) {
+    DIR *dp = opendir(dir);
+    if (NULL == dp) {
+        fprintf(stderr, "[ERROR] 无法打开 %s: %s\n", dir, strerror(errno));
+        return ;
+    }
+
+    struct dirent *ent = NULL;
+    while (NULL != (ent = readdir(dp)) && report->num < MEM_MAP_MAX_NUM) {
+        if ('.' == ent->d_name[0]) continue;
+
+        char path[FILE_LINE_MAXLEN];
+        snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+
+        int fd = bpf_obj_get(path);
+        if (fd < 0) continue;
+
+        /* 跳过同样固定在该目录的程序与 link */
+        mem_map_t *map = &report->maps[report->num];
+        memset(map, 0, sizeof(*map));
+        __u32 info_len = sizeof(map->info);
+        if (mem_fd_is_map(fd) && !bpf_map_get_info_by_fd(fd, &map->info, &info_len) &&
+            !mem_map_collected(report, map->info.id)) {
+            map->entries = mem_map_entries(fd, &map->info);
+            if (!mem_fdinfo_memlock(fd, &map->memlock)) {
+                map->memlock = plan_map_cost(map->info.type, map->info.key_size, map->info.value_size,
+                    map->info.max_entries, map->info.map_flags, map->info.map_extra, map->entries > 0 ? map->entries : 0);
+            }
+
+            report->num++;
+        }
+
+        close(fd);
+    }
+
+    closedir(dp);
+}
+
+/* 增长后的预计占用: 以实测占用为基准，按估算模型的比例换算 */
+static __u64 mem_map_grow(const mem_map_t *map) {
+    const struct bpf_map_info *info = &map->info;
+    __u64 used = (map->entries > 0) ? map->entries : 0;
+
+    /* 按需分配类 map 容量只是上限，增长的是条目数；预分配类 map 增长的是容量 */
+    bool on_demand = (BPF_MAP_TYPE_LPM_TRIE == info->type) ||
+        (BPF_MAP_TYPE_HASH == info->type && (info->map_flags & BPF_F_NO_PREALLOC));
+
+    __u64 cur = plan_map_cost(info->type, info->key_size, info->value_size,
+        info->max_entries, info->map_flags, info->map_extra, used);
+    __u64 grown = on_demand ?
+        plan_map_cost(info->type, info->key_size, info->value_size,
+            info->max_entries, info->map_flags, info->map_extra, used * MEM_GROW_FACTOR) :
+        plan_map_cost(info->type, info->key_size, info->value_size,
+            info->max_entries * MEM_GROW_FACTOR, info->map_flags, info->map_extra, used);
+
+    if (0 == cur) return map->memlock;
+    return (__u64)((double)map->memlock * grown / cur);
+}
+
+static void mem_report_show(const mem_report_t *report) {
+    char grow_title[16];
+    snprintf(grow_title, sizeof(grow_title), "x%d KB", MEM_GROW_FACTOR);
+    printf("%-16s %12s %12s %8s %12s %10s %12s\n",
+        "map", "max_entries", "entries", "fill%", "KB", "B/entry", grow_title);
+
+    __u64 total = 0, total_grow = 0;
+    for (__u32 i = 0; i < report->num; i++) {
+        const mem_map_t *map = &report->maps[i];
+        __u64 grow = mem_map_grow(map);
+        total += map->memlock;
+        total_grow += grow;
+
+        if (map->entries < 0) {
+            printf("%-16s %12u %12s %8s %12llu %10s %12llu\n", map->info.name, map->info.max_entries,
+                "-", "-", (unsigned long long)map->memlock / 1024, "-", (unsigned long long)grow / 1024);
+            continue;
+        }
+
+        double fill = map->info.max_entries ? 100.0 * map->entries / map->info.max_entries : 0;
+        double per_entry = map->entries ? (double)map->memlock / map->entries : 0;
+        printf("%-16s %12u %12lld %8.1f %12llu %10.1f %12llu\n", map->info.name, map->info.max_entries,
+            map->entries, fill, (unsigned long long)map->memlock / 1024, per_entry, (unsigned long long)grow / 1024);
+    }
+
+    printf("[INFO] 共 %u 个 map，占用 %llu KB，各自增长 %d 倍后共 %llu KB\n", report->num,
+        (unsigned long long)total / 1024, MEM_GROW_FACTOR, (unsigned long long)total_grow / 1024);
+}
+
+int mem_args_parse(int argc, char **argv) {
+    (void)argv;
+    if (argc != MEM_ARGS_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" MEM_PROG_USAGE "\n");
+        return -1;
+    }
+
+    mem_report_t *report = calloc(1, sizeof(*report));
+    if (NULL == report) return -1;
+
+    mem_collect_dir(report, TC_BPF_DIR);
+    mem_collect_dir(report, XDP_BPF_DIR);
+    mem_report_show(report);
+
+    free(report);
+    return 0;
+}
+
+int mem_main(int argc, char **argv) {
+    return mem_args_parse(argc, argv);
+}
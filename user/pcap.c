@@ -0,0 +1,164 @@
+/*
+ * File     : pcap.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-15 19:52:40
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/udp.h>
+
+#include "direct_path_pcap.h"
+
+#define PCAP_NSEC_PER_SEC               1000000000ULL
+#define PCAP_NSEC_PER_USEC              1000ULL
+
+static __u32 pcap_u32(const pcap_reader_t *reader, __u32 val) {
+    return reader->swapped ? __builtin_bswap32(val) : val;
+}
+
+/* 返回 0 不是 pcap，1 本机字节序，2 字节序相反 */
+static int pcap_magic_check(__u32 magic) {
+    if (PCAP_MAGIC_USEC == magic || PCAP_MAGIC_NSEC == magic) return 1;
+    if (PCAP_MAGIC_USEC == __builtin_bswap32(magic) || PCAP_MAGIC_NSEC == __builtin_bswap32(magic)) return 2;
+    return 0;
+}
+
+bool pcap_probe(const char *file) {
+    FILE *fp = fopen(file, "rb");
+    if (NULL == fp) return false;
+
+    __u32 magic = 0;
+    bool ret = (1 == fread(&magic, sizeof(magic), 1, fp)) && pcap_magic_check(magic);
+
+    fclose(fp);
+    return ret;
+}
+
+bool pcap_open(pcap_reader_t *reader, const char *file) {
+    reader->rec_num = 0;
+    reader->fp = fopen(file, "rb");
+    if (NULL == reader->fp) {
+        fprintf(stderr, "[ERROR] 无法打开 %s: %s\n", file, strerror(errno));
+        return false;
+    }
+
+    pcap_file_hdr_t hdr;
+    if (1 != fread(&hdr, sizeof(hdr), 1, reader->fp)) {
+        fprintf(stderr, "[ERROR] %s 不是 pcap 文件\n", file);
+        return false;
+    }
+
+    int order = pcap_magic_check(hdr.magic);
+    if (0 == order) {
+        /* pcapng 需先用 editcap -F pcap 转换 */
+        fprintf(stderr, "[ERROR] %s 不是 pcap 文件 (magic 0x%08x)，pcapng 需先转换为 pcap\n", file, hdr.magic);
+        return false;
+    }
+
+    reader->swapped = (2 == order);
+    reader->nsec = (PCAP_MAGIC_NSEC == pcap_u32(reader, hdr.magic));
+    reader->linktype = pcap_u32(reader, hdr.linktype);
+    if (PCAP_LINKTYPE_ETHERNET != reader->linktype && PCAP_LINKTYPE_LINUX_SLL != reader->linktype) {
+        fprintf(stderr, "[ERROR] 不支持的链路层类型 %u，仅支持以太网与 Linux cooked\n", reader->linktype);
+        return false;
+    }
+
+    return true;
+}
+
+void pcap_close(pcap_reader_t *reader) {
+    if (reader->fp) fclose(reader->fp);
+    reader->fp = NULL;
+}
+
+int pcap_next(pcap_reader_t *reader, __u8 *pkt, __u32 size, __u32 *len, __u64 *ts) {
+    pcap_rec_hdr_t rec;
+    if (1 != fread(&rec, sizeof(rec), 1, reader->fp)) return 0;
+
+    reader->rec_num++;
+    __u32 caplen = pcap_u32(reader, rec.caplen);
+    if (caplen > PCAP_REC_MAXLEN) {
+        fprintf(stderr, "[ERROR] 第 %llu 个报文长度 %u 异常\n", (unsigned long long)reader->rec_num, caplen);
+        return -1;
+    }
+
+    /* 文件末尾被截断的报文按文件结束处理 */
+    __u8 *buf = reader->rec;
+    if (caplen && 1 != fread(buf, caplen, 1, reader->fp)) return 0;
+
+    __u64 frac = pcap_u32(reader, rec.ts_frac);
+    *ts = pcap_u32(reader, rec.ts_sec) * PCAP_NSEC_PER_SEC + (reader->nsec ? frac : frac * PCAP_NSEC_PER_USEC);
+
+    const __u8 *data = buf;
+    __u32 data_len = caplen;
+    __u32 hdr_len = 0;
+    *len = 0;
+
+    if (PCAP_LINKTYPE_LINUX_SLL == reader->linktype) {
+        if (caplen < PCAP_SLL_HDR_LEN || size < sizeof(struct ethhdr)) return 1;
+
+        struct ethhdr *eth = (struct ethhdr *)pkt;
+        memset(eth, 0, sizeof(*eth));
+        memcpy(&eth->h_proto, buf + PCAP_SLL_PROTO_OFF, sizeof(eth->h_proto));
+        data += PCAP_SLL_HDR_LEN;
+        data_len -= PCAP_SLL_HDR_LEN;
+        hdr_len = sizeof(*eth);
+    }
+
+    /* 超长报文 (GRO 合并后抓取) 由调用方跳过 */
+    if (hdr_len + data_len > size) return 1;
+
+    memcpy(pkt + hdr_len, data, data_len);
+    *len = hdr_len + data_len;
+    return 1;
+}
+
+void pcap_pkt_parse(const __u8 *pkt, __u32 len, pcap_pkt_info_t *info) {
+    memset(info, 0, sizeof(*info));
+    if (len < sizeof(struct ethhdr) + sizeof(struct iphdr)) return ;
+
+    const struct ethhdr *eth = (const struct ethhdr *)pkt;
+    if (htons(ETH_P_IP) != eth->h_proto) return ;
+
+    const struct iphdr *ip = (const struct iphdr *)(pkt + sizeof(*eth));
+    __u32 ip_len = ip->ihl * 4;
+    if (ip_len < sizeof(*ip) || sizeof(*eth) + ip_len > len) return ;
+
+    info->ip = ip;
+    if (IPPROTO_UDP != ip->protocol && IPPROTO_TCP != ip->protocol) return ;
+    if (sizeof(*eth) + ip_len + sizeof(struct udphdr) > len) return ;
+
+    info->ports = (const __u16 *)((const __u8 *)ip + ip_len);
+    info->l4_len = len - sizeof(*eth) - ip_len;
+}
+
+void pcap_dns_qname(const pcap_pkt_info_t *info, char *name) {
+    name[0] = '\0';
+    if (NULL == info->ports || IPPROTO_UDP != info->ip->protocol) return ;
+    if (info->l4_len < sizeof(struct udphdr) + PCAP_DNS_HDR_LEN) return ;
+
+    const __u8 *pos = (const __u8 *)info->ports + sizeof(struct udphdr) + PCAP_DNS_HDR_LEN;
+    const __u8 *end = (const __u8 *)info->ports + info->l4_len;
+    __u32 name_len = 0;
+
+    while (pos < end && *pos) {
+        __u8 label_len = *pos++;
+        /* 查询中不应出现压缩指针 */
+        if (label_len > 63 || pos + label_len > end || name_len + label_len + 2 > PCAP_DNS_NAME_MAXLEN) {
+            name[0] = '\0';
+            return ;
+        }
+
+        if (name_len) name[name_len++] = '.';
+        memcpy(name + name_len, pos, label_len);
+        name_len += label_len;
+        pos += label_len;
+    }
+
+    name[name_len] = '\0';
+}
@@ -0,0 +1,401 @@
+/*
+ * File     : plan.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-07 20:31:48
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+#include "direct_path_config.h"
+#include "direct_path_plan.h"
+
+/* 规划涉及的 map 数量上限 */
+#define PLAN_ROW_MAX                    32
+
+typedef struct {
+    const char *name;
+    __u32 map_type;
+    __u32 key_size;
+    __u32 value_size;
+    __u32 map_flags;
+    __u64 map_extra;
+    __u32 entries;
+    /* 按需分配类 map 的预计条目数 */
+    __u64 used;
+    __u64 bytes;
+} plan_row_t;
+
+typedef struct {
+    plan_row_t rows[PLAN_ROW_MAX];
+    __u32 num;
+    __u64 total;
+} plan_t;
+
+/* 以默认容量为基准缩放的缓存类 map */
+typedef struct {
+    const char *name;
+    __u32 map_type;
+    __u32 key_size;
+    __u32 value_size;
+    __u32 default_entries;
+} plan_cache_desc_t;
+
+static const plan_cache_desc_t plan_caches[] = {
+    { HOTPATH_MAPNAME, BPF_MAP_TYPE_LRU_HASH,
+        CACHE_IP_MAP_KEY_SIZE, CACHE_IP_MAP_VAL_SIZE, CACHE_IP_MAP_SIZE },
+    { PRE_MAPNAME, BPF_MAP_TYPE_LRU_HASH,
+        PRE_CACHE_IP_MAP_KEY_SIZE, PRE_CACHE_IP_MAP_VAL_SIZE, PRE_CACHE_IP_MAP_SIZE },
+    { DOMAINCACHE_MAPNAME, BPF_MAP_TYPE_LRU_HASH,
+        DOMAINPRE_MAP_KEY_SIZE, DOMAINPRE_MAP_VAL_SIZE, DOMAINPRE_MAP_SIZE },
+    { RATELIMIT_MAPNAME, BPF_MAP_TYPE_LRU_HASH,
+        RATELIMIT_MAP_KEY_SIZE, RATELIMIT_MAP_VAL_SIZE, RATELIMIT_MAP_SIZE },
+};
+
+#define PLAN_CACHE_NUM                  (sizeof(plan_caches) / sizeof(plan_caches[0]))
+
+static __u64 plan_round_up(__u64 size, __u64 align) {
+    return (size + align - 1) / align * align;
+}
+
+static __u64 plan_roundup_pow2(__u64 num) {
+    __u64 ret = 1;
+    while (ret < num) ret <<= 1;
+    return ret;
+}
+
+/* kmalloc 实际分配的大小，小对象按 slab 规格取整，大对象按 2 的幂取整 */
+static __u64 plan_kmalloc_size(__u64 size) {
+    if (size <= 8) return 8;
+    if (size > 64 && size <= 96) return 96;
+    if (size > 128 && size <= 192) return 192;
+    return plan_roundup_pow2(size);
+}
+
+__u64 plan_map_cost(__u32 map_type, __u32 key_size, __u32 value_size,
+    __u32 max_entries, __u32 map_flags, __u64 map_extra, __u64 used) {
+    __u64 value = plan_round_up(value_size, 8);
+
+    switch (map_type) {
+        case BPF_MAP_TYPE_HASH:
+        case BPF_MAP_TYPE_LRU_HASH: {
+            __u64 elem = PLAN_HTAB_ELEM_SIZE + plan_round_up(key_size, 8) + value;
+            __u64 buckets = plan_roundup_pow2(max_entries) * PLAN_HTAB_BUCKET_SIZE;
+
+            /* LRU 总是预分配 */
+            if (BPF_MAP_TYPE_HASH == map_type && (map_flags & BPF_F_NO_PREALLOC))
+                return buckets + used * plan_kmalloc_size(elem);
+            return buckets + (__u64)max_entries * elem;
+        }
+        case BPF_MAP_TYPE_LPM_TRIE: {
+            /* key 去掉 prefixlen 后为节点数据，中间节点不带 value */
+            __u64 data = key_size - sizeof(__u32);
+            __u64 leaf = plan_kmalloc_size(PLAN_LPM_NODE_SIZE + data + value_size);
+            __u64 inner = plan_kmalloc_size(PLAN_LPM_NODE_SIZE + data);
+            return used * leaf + (used ? used - 1 : 0) * inner;
+        }
+        case BPF_MAP_TYPE_BLOOM_FILTER: {
+            __u64 nr_hashes = map_extra & 0xF;
+            if (0 == nr_hashes) nr_hashes = PLAN_BLOOM_DEFAULT_HASHES;
+
+            /* 与内核一致: 位数 = 容量 * 哈希函数个数 / ln2，取 2 的幂 */
+            __u64 bits = (__u64)max_entries * nr_hashes / 5 * 7;
+            if (bits < 64) bits = 64;
+            return plan_roundup_pow2(bits) / 8;
+        }
+        case BPF_MAP_TYPE_ARRAY: {
+            __u64 bytes = value * max_entries;
+            return (map_flags & BPF_F_MMAPABLE) ? plan_round_up(bytes, PLAN_PAGE_SIZE) : bytes;
+        }
+        case BPF_MAP_TYPE_PERCPU_ARRAY: {
+            int cpus = libbpf_num_possible_cpus();
+            if (cpus <= 0) cpus = 1;
+            return (value * cpus + sizeof(void *)) * max_entries;
+        }
+        case BPF_MAP_TYPE_RINGBUF:
+            /* 数据页加一页控制页 */
+            return (__u64)max_entries + PLAN_PAGE_SIZE;
+        case BPF_MAP_TYPE_ARENA:
+            /* 按需分配页，按上限计算 */
+            return (__u64)max_entries * PLAN_PAGE_SIZE;
+        default: break;
+    }
+
+    return 0;
+}
+
+static void plan_row_add(plan_t *plan, const char *name, __u32 map_type, __u32 key_size, __u32 value_size,
+    __u32 entries, __u32 map_flags, __u64 map_extra, __u64 used) {
+    if (plan->num >= PLAN_ROW_MAX) return ;
+
+    plan_row_t *row = &plan->rows[plan->num++];
+    row->name = name;
+    row->map_type = map_type;
+    row->key_size = key_size;
+    row->value_size = value_size;
+    row->map_flags = map_flags;
+    row->map_extra = map_extra;
+    row->entries = entries;
+    row->used = used;
+    row->bytes = plan_map_cost(map_type, key_size, value_size, entries, map_flags, map_extra, used);
+
+    plan->total += row->bytes;
+}
+
+/* 规则类 map 的容量: 规则数加余量，不低于配置文件或默认的容量
+ * 规则类 map 均为按需分配，容量不影响实际占用，缩小容量只会让之后的导入失败 */
+static __u32 plan_rule_entries(size_t num, __u32 floor) {
+    __u64 entries = num + (num >> PLAN_RULE_HEADROOM_SHIFT);
+    if (entries < PLAN_RULE_MIN_ENTRIES) entries = PLAN_RULE_MIN_ENTRIES;
+    if (entries < floor) entries = floor;
+    if (entries > PLAN_CACHE_MAX_ENTRIES) entries = PLAN_CACHE_MAX_ENTRIES;
+    return entries;
+}
+
+/* 规则类与容量固定的 map，与 create_map_list 一一对应 */
+static void plan_rows_fixed(plan_t *plan, const plan_counts_t *counts) {
+    const direct_path_conf_t *base = conf_get_base();
+    __u32 blklist = plan_rule_entries(counts->blklist, base->blklist_size);
+    __u32 direct_ip = plan_rule_entries(counts->direct_ip, base->direct_ip_size);
+    __u32 domain = plan_rule_entries(counts->domain, base->domain_map_size);
+    /* Bloom 过滤器按自身的默认容量取下限，不能沿用域名库的容量 */
+    __u32 bloom = plan_rule_entries(counts->domain, base->domain_bloom_size);
+
+    plan_row_add(plan, BLKLIST_MAPNAME, BPF_MAP_TYPE_LPM_TRIE, BLKLIST_IP_MAP_KEY_SIZE,
+        BLKLIST_IP_MAP_VAL_SIZE, blklist, BPF_F_NO_PREALLOC, 0, counts->blklist);
+    plan_row_add(plan, DIRECT_MAPNAME, BPF_MAP_TYPE_LPM_TRIE, DIRECT_IP_MAP_KEY_SIZE,
+        DIRECT_IP_MAP_VAL_SIZE, direct_ip, BPF_F_NO_PREALLOC, 0, counts->direct_ip);
+    plan_row_add(plan, BLKLISTBLOOM_MAPNAME, BPF_MAP_TYPE_BLOOM_FILTER, 0,
+        BLKLIST_BLOOM_MAP_VAL_SIZE, blklist, 0, BLOOM_NR_HASHES, 0);
+    plan_row_add(plan, TCCONFIG_MAPNAME, BPF_MAP_TYPE_ARRAY, TC_CONFIG_MAP_KEY_SIZE,
+        TC_CONFIG_MAP_VAL_SIZE, TC_CONFIG_MAP_SIZE, 0, 0, 0);
+    plan_row_add(plan, TCSTATS_MAPNAME, BPF_MAP_TYPE_PERCPU_ARRAY, TC_STATS_MAP_KEY_SIZE,
+        TC_STATS_MAP_VAL_SIZE, TC_STATS_MAP_SIZE, 0, 0, 0);
+
+#if DIRECT_IP_ENGINE == DIRECT_IP_ENGINE_DIR24
+    plan_row_add(plan, DIRECTDIR24_MAPNAME, BPF_MAP_TYPE_ARRAY, DIRECT_IP_DIR24_MAP_KEY_SIZE,
+        DIRECT_IP_DIR24_MAP_VAL_SIZE, DIRECT_IP_DIR24_MAP_SIZE, BPF_F_MMAPABLE, 0, 0);
+    plan_row_add(plan, DIRECTOVERFLOW_MAPNAME, BPF_MAP_TYPE_HASH, DIRECT_IP_OVERFLOW_MAP_KEY_SIZE,
+        DIRECT_IP_OVERFLOW_MAP_VAL_SIZE, DIRECT_IP_OVERFLOW_MAP_SIZE, BPF_F_NO_PREALLOC, 0, DIRECT_IP_OVERFLOW_MAP_SIZE);
+#endif
+
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    /* arena 引擎下 domain_map 不写入数据 */
+    plan_row_add(plan, DOMAIN_MAPNAME, BPF_MAP_TYPE_LPM_TRIE, DOMAIN_MAP_KEY_SIZE,
+        DOMAIN_MAP_VAL_SIZE, domain, BPF_F_NO_PREALLOC, 0, 0);
+    plan_row_add(plan, DOMAINARENA_MAPNAME, BPF_MAP_TYPE_ARENA, 0, 0, DOMAIN_ARENA_PAGES, BPF_F_MMAPABLE, 0, 0);
+#else
+    plan_row_add(plan, DOMAIN_MAPNAME, BPF_MAP_TYPE_LPM_TRIE, DOMAIN_MAP_KEY_SIZE,
+        DOMAIN_MAP_VAL_SIZE, domain, BPF_F_NO_PREALLOC, 0, counts->domain);
+    plan_row_add(plan, DOMAINBLOOM_MAPNAME, BPF_MAP_TYPE_BLOOM_FILTER, 0,
+        DOMAIN_BLOOM_MAP_VAL_SIZE, bloom, 0, BLOOM_NR_HASHES, 0);
+#endif
+
+    plan_row_add(plan, KEYWORD_MAPNAME, BPF_MAP_TYPE_HASH, KEYWORD_MAP_KEY_SIZE,
+        KEYWORD_MAP_VAL_SIZE, KEYWORD_MAP_SIZE, BPF_F_NO_PREALLOC, 0, counts->keyword);
+    plan_row_add(plan, KEYWORDAC_MAPNAME, BPF_MAP_TYPE_ARRAY, KEYWORD_AC_MAP_KEY_SIZE,
+        KEYWORD_AC_MAP_VAL_SIZE, KEYWORD_AC_MAP_SIZE, BPF_F_MMAPABLE, 0, 0);
+    plan_row_add(plan, DNSPOOL_MAPNAME, BPF_MAP_TYPE_ARRAY, DNS_POOL_MAP_KEY_SIZE,
+        DNS_POOL_MAP_VAL_SIZE, DNS_POOL_MAP_SIZE, 0, 0, 0);
+    plan_row_add(plan, DNSPOOLSTATS_MAPNAME, BPF_MAP_TYPE_PERCPU_ARRAY, DNS_POOL_STATS_MAP_KEY_SIZE,
+        DNS_POOL_STATS_MAP_VAL_SIZE, DNS_POOL_STATS_MAP_SIZE, 0, 0, 0);
+    plan_row_add(plan, ACTION_MAPNAME, BPF_MAP_TYPE_ARRAY, ACTION_MAP_KEY_SIZE,
+        ACTION_MAP_VAL_SIZE, ACTION_MAP_SIZE, 0, 0, 0);
+    plan_row_add(plan, XDPCONFIG_MAPNAME, BPF_MAP_TYPE_ARRAY, XDP_CONFIG_MAP_KEY_SIZE,
+        XDP_CONFIG_MAP_VAL_SIZE, XDP_CONFIG_MAP_SIZE, 0, 0, 0);
+    plan_row_add(plan, XDPSTATS_MAPNAME, BPF_MAP_TYPE_PERCPU_ARRAY, XDP_STATS_MAP_KEY_SIZE,
+        XDP_STATS_MAP_VAL_SIZE, XDP_STATS_MAP_SIZE, 0, 0, 0);
+    plan_row_add(plan, TRACERINGBUF_MAPNAME, BPF_MAP_TYPE_RINGBUF, 0, 0, TRACE_RINGBUF_SIZE, 0, 0, 0);
+    plan_row_add(plan, TRACECONFIG_MAPNAME, BPF_MAP_TYPE_ARRAY, TRACE_CONFIG_MAP_KEY_SIZE,
+        TRACE_CONFIG_MAP_VAL_SIZE, TRACE_CONFIG_MAP_SIZE, 0, 0, 0);
+    plan_row_add(plan, PROFILEHIST_MAPNAME, BPF_MAP_TYPE_PERCPU_ARRAY, PROFILE_HIST_MAP_KEY_SIZE,
+        PROFILE_HIST_MAP_VAL_SIZE, PROFILE_HIST_MAP_SIZE, 0, 0, 0);
+}
+
+/* 缓存类 map 在默认容量基础上左移 (shift > 0) 或右移后的容量 */
+static __u32 plan_cache_entries(const plan_cache_desc_t *desc, int shift) {
+    __u64 entries = (shift >= 0) ? ((__u64)desc->default_entries << shift) : (desc->default_entries >> -shift);
+    if (entries < PLAN_CACHE_MIN_ENTRIES) entries = PLAN_CACHE_MIN_ENTRIES;
+    if (entries > PLAN_CACHE_MAX_ENTRIES) entries = PLAN_CACHE_MAX_ENTRIES;
+    return entries;
+}
+
+static __u64 plan_caches_cost(int shift) {
+    __u64 total = 0;
+    for (size_t i = 0; i < PLAN_CACHE_NUM; i++) {
+        const plan_cache_desc_t *desc = &plan_caches[i];
+        total += plan_map_cost(desc->map_type, desc->key_size, desc->value_size,
+            plan_cache_entries(desc, shift), 0, 0, 0);
+    }
+
+    return total;
+}
+
+/* 先满足规则类与固定容量的 map，剩余预算按默认容量的比例分给缓存类 map
+ * 缓存类 map 是预分配的，容量即占用；按 2 的幂缩放，与哈希桶数一致 */
+static bool plan_compute(plan_t *plan, const plan_counts_t *counts, __u64 budget) {
+    plan_rows_fixed(plan, counts);
+
+    int shift = PLAN_CACHE_MAX_SHIFT;
+    while (shift > -PLAN_CACHE_MAX_SHIFT && plan->total + plan_caches_cost(shift) > budget) shift--;
+
+    if (plan->total + plan_caches_cost(shift) > budget) {
+        fprintf(stderr, "[ERROR] 内存预算 %llu KB 不足，至少需要 %llu KB\n",
+            (unsigned long long)budget / 1024, (unsigned long long)(plan->total + plan_caches_cost(shift)) / 1024);
+        return false;
+    }
+
+    for (size_t i = 0; i < PLAN_CACHE_NUM; i++) {
+        const plan_cache_desc_t *desc = &plan_caches[i];
+        plan_row_add(plan, desc->name, desc->map_type, desc->key_size, desc->value_size,
+            plan_cache_entries(desc, shift), 0, 0, 0);
+    }
+
+    return true;
+}
+
+static const plan_row_t *plan_row_find(const plan_t *plan, const char *name) {
+    for (__u32 i = 0; i < plan->num; i++) {
+        if (!strcmp(plan->rows[i].name, name)) return &plan->rows[i];
+    }
+
+    return NULL;
+}
+
+static void plan_show(const plan_t *plan, __u64 budget) {
+    printf("%-20s %12s %12s %12s\n", "map", "max_entries", "entries", "KB");
+    for (__u32 i = 0; i < plan->num; i++) {
+        const plan_row_t *row = &plan->rows[i];
+        printf("%-20s %12u %12llu %12llu\n", row->name, row->entries,
+            (unsigned long long)row->used, (unsigned long long)(row->bytes + 1023) / 1024);
+    }
+
+    printf("[INFO] 内存预算 %llu KB，预计占用 %llu KB\n",
+        (unsigned long long)budget / 1024, (unsigned long long)(plan->total + 1023) / 1024);
+}
+
+/* 写入规划文件，先写临时文件再替换 */
+static bool plan_write(const plan_t *plan, const plan_counts_t *counts, const char *path) {
+    static const struct {
+        const char *conf_key;
+        const char *map_name;
+    } plan_keys[] = {
+        { CONF_KEY_HOTPATH_CACHE_SIZE, HOTPATH_MAPNAME },
+        { CONF_KEY_PRE_CACHE_SIZE, PRE_MAPNAME },
+        { CONF_KEY_BLKLIST_SIZE, BLKLIST_MAPNAME },
+        { CONF_KEY_DIRECT_IP_SIZE, DIRECT_MAPNAME },
+        { CONF_KEY_DOMAIN_CACHE_SIZE, DOMAINCACHE_MAPNAME },
+        { CONF_KEY_DOMAIN_MAP_SIZE, DOMAIN_MAPNAME },
+        { CONF_KEY_DOMAIN_BLOOM_SIZE, DOMAINBLOOM_MAPNAME },
+        { CONF_KEY_RATELIMIT_SIZE, RATELIMIT_MAPNAME },
+    };
+
+    char tmp[FILE_LINE_MAXLEN];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp, "w");
+    if (NULL == fp) {
+        fprintf(stderr, "[ERROR] 无法写入 %s\n", tmp);
+        return false;
+    }
+
+    fprintf(fp, "# 由 direct_path plan 生成，删除本文件即恢复配置文件中的容量\n");
+    fprintf(fp, "# 规则: IP %zu 条，黑名单 %zu 条，域名 %zu 条，关键字 %zu 条\n",
+        counts->direct_ip, counts->blklist, counts->domain, counts->keyword);
+
+    for (size_t i = 0; i < sizeof(plan_keys) / sizeof(plan_keys[0]); i++) {
+        /* 没有规则组的规则类 map 沿用配置文件中的容量 */
+        const char *name = plan_keys[i].map_name;
+        if ((!strcmp(name, BLKLIST_MAPNAME) && !counts->has_blklist) ||
+            (!strcmp(name, DIRECT_MAPNAME) && !counts->has_direct_ip) ||
+            ((!strcmp(name, DOMAIN_MAPNAME) || !strcmp(name, DOMAINBLOOM_MAPNAME)) && !counts->has_domain)) continue;
+
+        const plan_row_t *row = plan_row_find(plan, name);
+        if (NULL != row) fprintf(fp, "%s = %u\n", plan_keys[i].conf_key, row->entries);
+    }
+
+    bool ok = !ferror(fp);
+    if (fclose(fp)) ok = false;
+    if (!ok || rename(tmp, path)) {
+        fprintf(stderr, "[ERROR] 无法写入 %s\n", path);
+        remove(tmp);
+        return false;
+    }
+
+    printf("[INFO] 规划已写入 %s，load install 时生效\n", path);
+    return true;
+}
+
+__u32 plan_rule_map_entries(const plan_counts_t *counts, const char *map_name) {
+    if (NULL == counts || NULL == map_name) return 0;
+
+    plan_t plan;
+    memset(&plan, 0, sizeof(plan));
+    plan_rows_fixed(&plan, counts);
+
+    const plan_row_t *row = plan_row_find(&plan, map_name);
+    return row ? row->entries : 0;
+}
+
+/* 统计一组规则去重后的条数，按目标 map 归类 */
+static int plan_count_group(const char *import_type, const char *map_path,
+    char **rule_files, __u32 rule_file_num, __u32 default_action, void *ctx) {
+    plan_counts_t *counts = ctx;
+
+    import_rules_t rules;
+    memset(&rules, 0, sizeof(rules));
+
+    int ret = import_rules_collect(import_type, rule_files, rule_file_num, default_action, &rules);
+    if (ret) goto out;
+
+    if (!strcmp(import_type, IMPORT_TYPE_IP)) {
+        ip_rule_set_dedup(&rules.ip);
+        if (!strcmp(map_path, BLACKMAP_PIN)) {
+            counts->blklist += rules.ip.num;
+            counts->has_blklist = true;
+        } else {
+            counts->direct_ip += rules.ip.num;
+            counts->has_direct_ip = true;
+        }
+    } else {
+        counts->has_domain = true;
+        size_t dup = 0, shadowed = 0;
+        domain_rule_set_prune(&rules.domain, &dup, &shadowed);
+        counts->domain += rules.domain.num;
+        counts->keyword += rules.keyword.num;
+    }
+
+out:
+    import_rules_free(&rules);
+    return ret;
+}
+
+int plan_args_parse(int argc, char **argv) {
+    if (argc < PLAN_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" PLAN_PROG_USAGE "\n");
+        return -1;
+    }
+
+    plan_counts_t counts;
+    memset(&counts, 0, sizeof(counts));
+    if (rule_groups_foreach(argc, argv, 2, plan_count_group, &counts)) return -1;
+
+    plan_t plan;
+    memset(&plan, 0, sizeof(plan));
+
+    __u64 budget = (__u64)conf_get()->mem_budget_kb * 1024;
+    if (!plan_compute(&plan, &counts, budget)) return -1;
+
+    plan_show(&plan, budget);
+    return plan_write(&plan, &counts, DIRECT_PATH_PLAN_FILE) ? 0 : -1;
+}
+
+int plan_main(int argc, char **argv) {
+    return plan_args_parse(argc, argv);
+}
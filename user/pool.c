@@ -0,0 +1,137 @@
+/*
+ * File     : pool.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-09 20:15:02
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_pool.h"
+#include "direct_path_stats.h"
+
+static const char *pool_name(__u32 pool_id, char *buf, size_t size) {
+    if (DNS_POOL_DIRECT == pool_id) return POOL_NAME_DIRECT;
+    if (DNS_POOL_PROXY == pool_id) return POOL_NAME_PROXY;
+
+    snprintf(buf, size, "%u", pool_id);
+    return buf;
+}
+
+/* 解析池名称，支持 direct / proxy 或池编号 */
+static bool pool_id_parse(const char *name, __u32 *pool_id) {
+    if (unlikely(NULL == name || NULL == pool_id)) return false;
+
+    if (!strcmp(name, POOL_NAME_DIRECT)) *pool_id = DNS_POOL_DIRECT;
+    else if (!strcmp(name, POOL_NAME_PROXY)) *pool_id = DNS_POOL_PROXY;
+    else {
+        char *end = NULL;
+        unsigned long id = strtoul(name, &end, 10);
+        if (end == name || *end != '\0' || id >= DNS_POOL_NUM) return false;
+        *pool_id = (__u32)id;
+    }
+
+    return true;
+}
+
+int pool_show(int argc, char **argv) {
+    int pool_fd = bpf_obj_get(DNSPOOL_XDP_PIN);
+    if (pool_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", DNSPOOL_XDP_PIN, strerror(errno));
+        return -1;
+    }
+
+    int stats_fd = bpf_obj_get(DNSPOOLSTATS_PIN);
+    if (stats_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", DNSPOOLSTATS_PIN, strerror(errno));
+        close(pool_fd);
+        return -1;
+    }
+
+    char name[POOL_NAME_MAX_LEN] = {0};
+    printf("%-8s | %-6s | %-8s | %-20s\n", "POOL", "MEMBER", "PORT", "QUERIES");
+    for (__u32 pool_id = 0; pool_id < DNS_POOL_NUM; pool_id++) {
+        dns_pool_t pool = {0};
+        if (bpf_map_lookup_elem(pool_fd, &pool_id, &pool)) continue;
+
+        for (__u32 i = 0; i < pool.num && i < DNS_POOL_MAX_MEMBERS; i++) {
+            __u64 count = 0;
+            map_percpu_u64_sum(stats_fd, pool_id * DNS_POOL_MAX_MEMBERS + i, &count);
+            printf("%-8s | %-6u | %-8u | %-20llu\n", pool_name(pool_id, name, sizeof(name)), 
+                i, pool.port[i], (unsigned long long)count);
+        }
+    }
+
+    close(stats_fd);
+    close(pool_fd);
+
+    return 0;
+}
+
+int pool_set(int argc, char **argv) {
+    if (argc < POOL_SET_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" POOL_PROG_USAGE "\n");
+        return -1;
+    }
+
+    __u32 pool_id = 0;
+    if (!pool_id_parse(argv[3], &pool_id)) {
+        fprintf(stderr, "[ERROR] 参数错误 pool [%s]，" POOL_PROG_USAGE "\n", argv[3]);
+        return -1;
+    }
+
+    dns_pool_t pool = {0};
+    for (int i = 4; i < argc; i++) {
+        if (pool.num >= DNS_POOL_MAX_MEMBERS) {
+            fprintf(stderr, "[ERROR] 解析器池最多 %d 个成员\n", DNS_POOL_MAX_MEMBERS);
+            return -1;
+        }
+
+        int port = atoi(argv[i]);
+        if (port <= 0 || port > 65535) {
+            fprintf(stderr, "[ERROR] 参数错误 port [%s]\n", argv[i]);
+            return -1;
+        }
+
+        pool.port[pool.num++] = (unsigned short)port;
+    }
+
+    int pool_fd = bpf_obj_get(DNSPOOL_XDP_PIN);
+    if (pool_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", DNSPOOL_XDP_PIN, strerror(errno));
+        return -1;
+    }
+
+    char name[POOL_NAME_MAX_LEN] = {0};
+    int ret = bpf_map_update_elem(pool_fd, &pool_id, &pool, BPF_ANY);
+    if (ret) fprintf(stderr, "[ERROR] 解析器池 %s 更新失败: %s\n", 
+        pool_name(pool_id, name, sizeof(name)), strerror(errno));
+    else printf("[INFO] 解析器池 %s 已更新，共 %u 个成员\n", 
+        pool_name(pool_id, name, sizeof(name)), pool.num);
+
+    close(pool_fd);
+
+    return ret;
+}
+
+int pool_args_parse(int argc, char **argv) {
+    if (argc < POOL_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" POOL_PROG_USAGE "\n");
+        return -1;
+    }
+
+    if (!strcmp(argv[2], POOL_ARGS_SHOW)) return pool_show(argc, argv);
+    else if (!strcmp(argv[2], POOL_ARGS_SET)) return pool_set(argc, argv);
+
+    return 0;
+}
+
+int pool_main(int argc, char **argv) {
+    return pool_args_parse(argc, argv);
+}
@@ -9,6 +9,7 @@
 #include <bpf/libbpf.h>
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
 #include <unistd.h>
 #include<stdlib.h>
 
@@ -21,32 +22,34 @@
 
 #include "direct_path_user.h"
 #include "direct_path_prepare.h"
+#include "direct_path_config.h"
 
-/* 卸载 TC clsact qdisc */
+/* 断开并删除固定的 bpf_link，删除固定点后 link 引用归零也会自动断开 */
+bool link_clean(const char *pin) {
+    if (unlikely(NULL == pin)) return false;
+
+    int link_fd = bpf_obj_get(pin);
+    if (link_fd < 0) return true;
+
+    bpf_link_detach(link_fd);
+    close(link_fd);
+    unlink(pin);
+
+    return true;
+}
+
+/* 卸载 TC clsact qdisc，同时指定 ingress 与 egress 时才会删除 qdisc 及其全部 filter */
 bool tc_clean(const char *ifname) {
     if (unlikely(NULL == ifname)) return false;
 
     int ifindex = if_nametoindex(ifname);
     if (unlikely(0 == ifindex)) return false;
 
-    char cmd[SYSTEM_CMD_MAX_LEN] = {0};
-    snprintf(cmd, sizeof(cmd), "tc qdisc del dev %s clsact 2>/dev/null", ifname);
-    system(cmd);  // 忽略返回值，无论是否存在都继续
-
-    /* 待解决，如下代码无法释放TC */
-    // DECLARE_LIBBPF_OPTS(bpf_tc_hook, ingress_tc_hook, .ifindex = ifindex, .attach_point = BPF_TC_INGRESS);
-    // DECLARE_LIBBPF_OPTS(bpf_tc_hook, egress_tc_hook, .ifindex = ifindex, .attach_point = BPF_TC_EGRESS);
-    // 
-    // /* 销毁hook会同时清理关联的filter */
-    // bpf_tc_hook_destroy(&ingress_tc_hook); 
-    // bpf_tc_hook_destroy(&egress_tc_hook); 
-
-    // int tc_prog_fd = bpf_obj_get(TC_PROG_BASE);
+    DECLARE_LIBBPF_OPTS(bpf_tc_hook, tc_hook, .ifindex = ifindex, 
+        .attach_point = BPF_TC_INGRESS | BPF_TC_EGRESS);
 
-    // DECLARE_LIBBPF_OPTS(bpf_tc_opts, tc_opts, .prog_fd = tc_prog_fd, .handle = 1, .priority = 1);
-
-    // bpf_tc_detach(&ingress_tc_hook, &tc_opts);
-    // bpf_tc_detach(&egress_tc_hook, &tc_opts);
+    /* 忽略返回值，无论是否存在都继续 */
+    bpf_tc_hook_destroy(&tc_hook);
 
     return true;
 }
@@ -91,10 +94,14 @@ bool mount_bpf_fs(const char *dir) {
     return true;
 }
 
+/* 升级时保留已固定的 map，只创建新版本新增的 map */
+static bool map_keep_existing = false;
+
 bool create_map(const char *map_name, 
     const char *map_path, enum bpf_map_type map_type, 
     int key_size, int value_size, int max_entries, 
     struct bpf_map_create_opts *opts) {
+    if (map_keep_existing && 0 == access(map_path, F_OK)) return true;
 
     int map_fd = bpf_map_create(map_type, map_name, key_size, value_size, max_entries, opts);
     if (map_fd < 0) {
@@ -115,11 +122,40 @@ bool create_map(const char *map_name,
     return true;
 }
 
+/* 将已固定的 map 再固定到另一路径，供 TC 与 XDP 程序共享同一个 map */
+bool pin_map_shared(const char *map_path, const char *shared_path) {
+    if (unlikely(NULL == map_path || NULL == shared_path)) return false;
+    if (map_keep_existing && 0 == access(shared_path, F_OK)) return true;
+
+    int map_fd = bpf_obj_get(map_path);
+    if (map_fd < 0) {
+        fprintf(stderr, "Failed to get BPF map %s: %s\n", map_path, strerror(errno));
+        return false;
+    }
+
+    if (bpf_obj_pin(map_fd, shared_path) < 0) {
+        fprintf(stderr, "Failed to pin BPF map to path: %s\n", strerror(errno));
+        close(map_fd);
+        return false;
+    }
+
+    printf("[INFO] map %s 已共享至 %s\n", map_path, shared_path);
+    close(map_fd);
+
+    return true;
+}
+
 bool umount_map_all() {
-    if (!tc_clean(LAN_IF)) return false;
-    if (!tc_clean(WAN_IF)) return false;
+    /* link 方式挂载的程序不受 qdisc 删除与 bpf_xdp_detach 影响，先断开 link */
+    link_clean(TC_LINK_INGRESS_PIN);
+    link_clean(TC_LINK_EGRESS_PIN);
+    link_clean(XDP_LINK_PIN);
+
+    const direct_path_conf_t *conf = conf_get();
+    if (!tc_clean(conf->lan_if)) return false;
+    if (!tc_clean(conf->wan_if)) return false;
 
-    if (!xdp_clean(if_nametoindex(LAN_IF))) return false;
+    if (!xdp_clean(if_nametoindex(conf->lan_if))) return false;
 
     printf("[INFO] 程序已卸载\n");
 
@@ -139,12 +175,10 @@ bool mount_map_all() {
     return true;
 }
 
-bool create_map_all() {
-    umount_map_all();
-
-    bool ret = mount_map_all();
-    if (!ret) return ret;
-
+static bool create_map_list() {
+    /* 规则与缓存类 map 的容量可在配置文件中调整，其余 map 的容量由数据结构决定 */
+    const direct_path_conf_t *conf = conf_get();
+    bool ret = true;
     struct bpf_map_create_opts opts = {
         .sz = sizeof(opts),
         .map_flags = BPF_F_NO_PREALLOC,  // 必须设置此标志
@@ -156,28 +190,226 @@ bool create_map_all() {
     };
 
     ret = create_map(HOTPATH_MAPNAME, HOTPATHMAP_PIN, BPF_MAP_TYPE_LRU_HASH, 
-        CACHE_IP_MAP_KEY_SIZE, CACHE_IP_MAP_VAL_SIZE, CACHE_IP_MAP_SIZE, 0);
+        CACHE_IP_MAP_KEY_SIZE, CACHE_IP_MAP_VAL_SIZE, conf->hotpath_cache_size, 0);
     if (!ret) return ret;
 
     ret = create_map(PRE_MAPNAME, PREMAP_PIN, BPF_MAP_TYPE_LRU_HASH, 
-        PRE_CACHE_IP_MAP_KEY_SIZE, PRE_CACHE_IP_MAP_VAL_SIZE, PRE_CACHE_IP_MAP_SIZE, 0);
+        PRE_CACHE_IP_MAP_KEY_SIZE, PRE_CACHE_IP_MAP_VAL_SIZE, conf->pre_cache_size, 0);
     if (!ret) return ret;
 
     ret = create_map(BLKLIST_MAPNAME, BLACKMAP_PIN, BPF_MAP_TYPE_LPM_TRIE, 
-        BLKLIST_IP_MAP_KEY_SIZE, BLKLIST_IP_MAP_VAL_SIZE, BLKLIST_IP_MAP_SIZE, &opts);
+        BLKLIST_IP_MAP_KEY_SIZE, BLKLIST_IP_MAP_VAL_SIZE, conf->blklist_size, &opts);
     if (!ret) return ret;
 
     ret = create_map(DIRECT_MAPNAME, DIRECTMAP_PIN, BPF_MAP_TYPE_LPM_TRIE, 
-        DIRECT_IP_MAP_KEY_SIZE, DIRECT_IP_MAP_VAL_SIZE, DIRECT_IP_MAP_SIZE, &opts);
+        DIRECT_IP_MAP_KEY_SIZE, DIRECT_IP_MAP_VAL_SIZE, conf->direct_ip_size, &opts);
+    if (!ret) return ret;
+
+    /* Bloom 过滤器没有 key，低 4 位 map_extra 为哈希函数个数 */
+    struct bpf_map_create_opts bloom_opts = {
+        .sz = sizeof(bloom_opts),
+        .map_extra = BLOOM_NR_HASHES,
+    };
+
+    ret = create_map(BLKLISTBLOOM_MAPNAME, BLKLISTBLOOM_PIN, BPF_MAP_TYPE_BLOOM_FILTER, 
+        0, BLKLIST_BLOOM_MAP_VAL_SIZE, conf->blklist_size, &bloom_opts);
+    if (!ret) return ret;
+
+    ret = create_map(TCCONFIG_MAPNAME, TCCONFIG_PIN, BPF_MAP_TYPE_ARRAY, 
+        TC_CONFIG_MAP_KEY_SIZE, TC_CONFIG_MAP_VAL_SIZE, TC_CONFIG_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = create_map(TCSTATS_MAPNAME, TCSTATS_PIN, BPF_MAP_TYPE_PERCPU_ARRAY, 
+        TC_STATS_MAP_KEY_SIZE, TC_STATS_MAP_VAL_SIZE, TC_STATS_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+#if DIRECT_IP_ENGINE == DIRECT_IP_ENGINE_DIR24
+    /* DIR-24-8 数组需要 mmap，由用户态整体比较后写入 */
+    struct bpf_map_create_opts mmap_opts = {
+        .sz = sizeof(mmap_opts),
+        .map_flags = BPF_F_MMAPABLE,
+    };
+
+    ret = create_map(DIRECTDIR24_MAPNAME, DIRECTDIR24_PIN, BPF_MAP_TYPE_ARRAY, 
+        DIRECT_IP_DIR24_MAP_KEY_SIZE, DIRECT_IP_DIR24_MAP_VAL_SIZE, DIRECT_IP_DIR24_MAP_SIZE, &mmap_opts);
+    if (!ret) return ret;
+
+    ret = create_map(DIRECTOVERFLOW_MAPNAME, DIRECTOVERFLOW_PIN, BPF_MAP_TYPE_HASH, 
+        DIRECT_IP_OVERFLOW_MAP_KEY_SIZE, DIRECT_IP_OVERFLOW_MAP_VAL_SIZE, DIRECT_IP_OVERFLOW_MAP_SIZE, &opts);
     if (!ret) return ret;
+#endif
 
     ret = create_map(DOMAINCACHE_MAPNAME, DOMAINCACHE_PIN, BPF_MAP_TYPE_LRU_HASH, 
-        DOMAINPRE_MAP_KEY_SIZE, DOMAINPRE_MAP_VAL_SIZE, DOMAINPRE_MAP_SIZE, 0);
+        DOMAINPRE_MAP_KEY_SIZE, DOMAINPRE_MAP_VAL_SIZE, conf->domain_cache_size, 0);
     if (!ret) return ret;
 
     ret = create_map(DOMAIN_MAPNAME, DOMAINMAP_PIN, BPF_MAP_TYPE_LPM_TRIE, 
-        DOMAIN_MAP_KEY_SIZE, DOMAIN_MAP_VAL_SIZE, DOMAIN_MAP_SIZE, &opts);
+        DOMAIN_MAP_KEY_SIZE, DOMAIN_MAP_VAL_SIZE, conf->domain_map_size, &opts);
+    if (!ret) return ret;
+
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    /* arena 没有 key/value，max_entries 为页数，map_extra 为用户态映射地址
+     * domain_map 仍作为 "rule" 的导入目标，不写入数据，不占用内存 */
+    struct bpf_map_create_opts arena_opts = {
+        .sz = sizeof(arena_opts),
+        .map_flags = BPF_F_MMAPABLE,
+        .map_extra = DOMAIN_ARENA_ADDR,
+    };
+
+    ret = create_map(DOMAINARENA_MAPNAME, DOMAINARENA_PIN, BPF_MAP_TYPE_ARENA, 
+        0, 0, DOMAIN_ARENA_PAGES, &arena_opts);
+    if (!ret) return ret;
+#else
+    ret = create_map(DOMAINBLOOM_MAPNAME, DOMAINBLOOM_PIN, BPF_MAP_TYPE_BLOOM_FILTER, 
+        0, DOMAIN_BLOOM_MAP_VAL_SIZE, conf->domain_bloom_size, &bloom_opts);
+    if (!ret) return ret;
+#endif
+
+    ret = create_map(KEYWORD_MAPNAME, KEYWORDMAP_PIN, BPF_MAP_TYPE_HASH, 
+        KEYWORD_MAP_KEY_SIZE, KEYWORD_MAP_VAL_SIZE, KEYWORD_MAP_SIZE, &opts);
+    if (!ret) return ret;
+
+    /* 关键字自动机转移表由用户态整体写入 */
+    struct bpf_map_create_opts keyword_ac_opts = {
+        .sz = sizeof(keyword_ac_opts),
+        .map_flags = BPF_F_MMAPABLE,
+    };
+
+    ret = create_map(KEYWORDAC_MAPNAME, KEYWORDAC_PIN, BPF_MAP_TYPE_ARRAY, 
+        KEYWORD_AC_MAP_KEY_SIZE, KEYWORD_AC_MAP_VAL_SIZE, KEYWORD_AC_MAP_SIZE, &keyword_ac_opts);
+    if (!ret) return ret;
+
+    ret = create_map(DNSPOOL_MAPNAME, DNSPOOL_XDP_PIN, BPF_MAP_TYPE_ARRAY, 
+        DNS_POOL_MAP_KEY_SIZE, DNS_POOL_MAP_VAL_SIZE, DNS_POOL_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = pin_map_shared(DNSPOOL_XDP_PIN, DNSPOOL_TC_PIN);
+    if (!ret) return ret;
+
+    ret = create_map(DNSPOOLSTATS_MAPNAME, DNSPOOLSTATS_PIN, BPF_MAP_TYPE_PERCPU_ARRAY, 
+        DNS_POOL_STATS_MAP_KEY_SIZE, DNS_POOL_STATS_MAP_VAL_SIZE, DNS_POOL_STATS_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = create_map(ACTION_MAPNAME, ACTION_XDP_PIN, BPF_MAP_TYPE_ARRAY, 
+        ACTION_MAP_KEY_SIZE, ACTION_MAP_VAL_SIZE, ACTION_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = pin_map_shared(ACTION_XDP_PIN, ACTION_TC_PIN);
+    if (!ret) return ret;
+
+    ret = create_map(RATELIMIT_MAPNAME, RATELIMIT_PIN, BPF_MAP_TYPE_LRU_HASH, 
+        RATELIMIT_MAP_KEY_SIZE, RATELIMIT_MAP_VAL_SIZE, conf->ratelimit_size, 0);
+    if (!ret) return ret;
+
+    ret = create_map(XDPCONFIG_MAPNAME, XDPCONFIG_PIN, BPF_MAP_TYPE_ARRAY, 
+        XDP_CONFIG_MAP_KEY_SIZE, XDP_CONFIG_MAP_VAL_SIZE, XDP_CONFIG_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = create_map(XDPSTATS_MAPNAME, XDPSTATS_PIN, BPF_MAP_TYPE_PERCPU_ARRAY, 
+        XDP_STATS_MAP_KEY_SIZE, XDP_STATS_MAP_VAL_SIZE, XDP_STATS_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    /* ring buffer 没有 key/value，max_entries 为缓冲区字节数，XDP 与 TC 共用一个事件流 */
+    ret = create_map(TRACERINGBUF_MAPNAME, TRACERINGBUF_XDP_PIN, BPF_MAP_TYPE_RINGBUF, 
+        0, 0, TRACE_RINGBUF_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = pin_map_shared(TRACERINGBUF_XDP_PIN, TRACERINGBUF_TC_PIN);
+    if (!ret) return ret;
+
+    ret = create_map(TRACECONFIG_MAPNAME, TRACECONFIG_XDP_PIN, BPF_MAP_TYPE_ARRAY, 
+        TRACE_CONFIG_MAP_KEY_SIZE, TRACE_CONFIG_MAP_VAL_SIZE, TRACE_CONFIG_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = pin_map_shared(TRACECONFIG_XDP_PIN, TRACECONFIG_TC_PIN);
+    if (!ret) return ret;
+
+    ret = create_map(PROFILEHIST_MAPNAME, PROFILEHIST_XDP_PIN, BPF_MAP_TYPE_PERCPU_ARRAY, 
+        PROFILE_HIST_MAP_KEY_SIZE, PROFILE_HIST_MAP_VAL_SIZE, PROFILE_HIST_MAP_SIZE, 0);
+    if (!ret) return ret;
+
+    ret = pin_map_shared(PROFILEHIST_XDP_PIN, PROFILEHIST_TC_PIN);
+    if (!ret) return ret;
+
+    return ret;
+}
+
+bool create_map_all() {
+    umount_map_all();
+
+    bool ret = mount_map_all();
     if (!ret) return ret;
 
+    return create_map_list();
+}
+
+bool create_map_missing() {
+    if (0 != access(HOTPATHMAP_PIN, F_OK) || 0 != access(DOMAINCACHE_PIN, F_OK)) {
+        fprintf(stderr, "[ERROR] 未找到已安装的 map，请先执行 load install\n");
+        return false;
+    }
+
+    map_keep_existing = true;
+    bool ret = create_map_list();
+    map_keep_existing = false;
+
     return ret;
 }
+
+/* 解析器池默认各只有一个成员，与原有单解析器端口保持一致 */
+bool dns_pool_init_default() {
+    int map_fd = bpf_obj_get(DNSPOOL_XDP_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "Failed to get BPF map %s: %s\n", DNSPOOL_XDP_PIN, strerror(errno));
+        return false;
+    }
+
+    dns_pool_t pools[DNS_POOL_NUM] = {0};
+    pools[DNS_POOL_PROXY].num = 1;
+    pools[DNS_POOL_PROXY].port[0] = conf_get()->proxy_dns_port;
+    pools[DNS_POOL_DIRECT].num = 1;
+    pools[DNS_POOL_DIRECT].port[0] = conf_get()->direct_dns_port;
+
+    for (__u32 i = 0; i < DNS_POOL_NUM; i++) {
+        if (bpf_map_update_elem(map_fd, &i, &pools[i], BPF_ANY)) {
+            fprintf(stderr, "Failed to init DNS pool %u: %s\n", i, strerror(errno));
+            close(map_fd);
+            return false;
+        }
+    }
+
+    close(map_fd);
+    return true;
+}
+
+/* 动作表默认仅有 未命中 -> 代理 与 国内直连 -> 国内解析器 + 直连标记，其余动作未配置时走代理 */
+bool action_init_default() {
+    int map_fd = bpf_obj_get(ACTION_XDP_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "Failed to get BPF map %s: %s\n", ACTION_XDP_PIN, strerror(errno));
+        return false;
+    }
+
+    action_t actions[ACTION_MAX_NUM] = {0};
+    for (__u32 i = 0; i < ACTION_MAX_NUM; i++) actions[i].dns_pool = DNS_POOL_PROXY;
+    actions[ACTION_DIRECT].dns_pool = DNS_POOL_DIRECT;
+    actions[ACTION_DIRECT].mark = htonl(conf_get()->direct_mark);
+
+    for (__u32 i = 0; i < ACTION_MAX_NUM; i++) {
+        if (bpf_map_update_elem(map_fd, &i, &actions[i], BPF_ANY)) {
+            fprintf(stderr, "Failed to init action %u: %s\n", i, strerror(errno));
+            close(map_fd);
+            return false;
+        }
+    }
+
+    close(map_fd);
+    return true;
+}
+
+bool init_map_all() {
+    if (!dns_pool_init_default()) return false;
+    if (!action_init_default()) return false;
+
+    return true;
+}
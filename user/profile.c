@@ -0,0 +1,239 @@
+/*
+ * File     : profile.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-18 10:41:07
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_config.h"
+#include "direct_path_stats.h"
+#include "direct_path_profile.h"
+
+/* 阶段名称，下标与 PROFILE_STAGE_* 一致 */
+static const char *profile_stage_names[PROFILE_STAGE_NUM] = {
+    [PROFILE_STAGE_XDP_MATCH]   = "xdp match",
+    [PROFILE_STAGE_XDP_PARSE]   = "xdp parse",
+    [PROFILE_STAGE_XDP_CACHE]   = "xdp cache",
+    [PROFILE_STAGE_XDP_RULE]    = "xdp rule",
+    [PROFILE_STAGE_XDP_KEYWORD] = "xdp keyword",
+    [PROFILE_STAGE_TC_LOOKUP]   = "tc lookup",
+    [PROFILE_STAGE_TC_CACHE]    = "tc cache",
+    [PROFILE_STAGE_TC_PRE]      = "tc pre",
+    [PROFILE_STAGE_TC_RULE]     = "tc rule",
+};
+
+/* 输出的分位数 */
+static const double profile_quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+#define PROFILE_QUANTILE_NUM            (sizeof(profile_quantiles) / sizeof(profile_quantiles[0]))
+
+typedef struct {
+    __u64 slots[PROFILE_HIST_MAP_SIZE];
+    /* 内核运行统计，需开启 bpf_stats_enabled */
+    __u64 xdp_run_time;
+    __u64 xdp_run_cnt;
+    __u64 tc_run_time;
+    __u64 tc_run_cnt;
+} profile_snapshot_t;
+
+static bool profile_hist_read(__u64 *slots) {
+    int map_fd = bpf_obj_get(PROFILEHIST_XDP_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", PROFILEHIST_XDP_PIN, strerror(errno));
+        return false;
+    }
+
+    bool ret = true;
+    for (__u32 i = 0; i < PROFILE_HIST_MAP_SIZE && ret; i++) ret = map_percpu_u64_sum(map_fd, i, &slots[i]);
+
+    close(map_fd);
+    return ret;
+}
+
+/* 读取程序的累计运行时间与次数，程序未加载时为 0 */
+static void profile_prog_read(const char *pin, __u64 *run_time, __u64 *run_cnt) {
+    *run_time = *run_cnt = 0;
+
+    int prog_fd = bpf_obj_get(pin);
+    if (prog_fd < 0) return ;
+
+    struct bpf_prog_info info;
+    __u32 info_len = sizeof(info);
+    memset(&info, 0, sizeof(info));
+    if (!bpf_prog_get_info_by_fd(prog_fd, &info, &info_len)) {
+        *run_time = info.run_time_ns;
+        *run_cnt = info.run_cnt;
+    }
+
+    close(prog_fd);
+}
+
+static bool profile_snapshot(profile_snapshot_t *snap) {
+    profile_prog_read(XDP_PROG_PIN, &snap->xdp_run_time, &snap->xdp_run_cnt);
+    profile_prog_read(TC_PROG_PIN, &snap->tc_run_time, &snap->tc_run_cnt);
+    return profile_hist_read(snap->slots);
+}
+
+/* 在分位数所在的桶内按线性分布估算 */
+static double profile_quantile(const __u64 *slots, __u64 total, double q) {
+    double rank = q * total;
+    __u64 cum = 0;
+
+    for (__u32 i = 0; i < PROFILE_HIST_SLOTS; i++) {
+        if (0 == slots[i]) continue;
+        if (cum + slots[i] >= rank) {
+            double lo = i ? (double)(1ULL << i) : 0;
+            double hi = (double)(1ULL << (i + 1));
+            return lo + (hi - lo) * (rank - cum) / slots[i];
+        }
+        cum += slots[i];
+    }
+
+    return 0;
+}
+
+static void profile_show_prog(const char *title, __u64 run_time, __u64 run_cnt) {
+    if (0 == run_cnt) {
+        printf("%-6s 内核运行统计: 无 (未开启 kernel.bpf_stats_enabled 或程序未运行)\n", title);
+        return ;
+    }
+
+    printf("%-6s 内核运行统计: %llu 次，平均 %.1f ns\n", title, (unsigned long long)run_cnt, (double)run_time / run_cnt);
+}
+
+static void profile_show(const profile_snapshot_t *snap) {
+    printf("%-12s | %-12s", "stage", "count");
+    for (__u32 q = 0; q < PROFILE_QUANTILE_NUM; q++) {
+        char name[16];
+        snprintf(name, sizeof(name), "p%g", profile_quantiles[q] * 100);
+        printf(" | %-8s", name);
+    }
+    printf(" | %-8s\n", "max");
+
+    __u64 all = 0;
+    for (__u32 stage = 0; stage < PROFILE_STAGE_NUM; stage++) {
+        const __u64 *slots = snap->slots + stage * PROFILE_HIST_SLOTS;
+        __u64 total = 0;
+        __u32 top = 0;
+        for (__u32 i = 0; i < PROFILE_HIST_SLOTS; i++) {
+            total += slots[i];
+            if (slots[i]) top = i;
+        }
+
+        all += total;
+        printf("%-12s | %-12llu", profile_stage_names[stage], (unsigned long long)total);
+        for (__u32 q = 0; q < PROFILE_QUANTILE_NUM; q++) {
+            if (total) printf(" | %-8.0f", profile_quantile(slots, total, profile_quantiles[q]));
+            else printf(" | %-8s", "-");
+        }
+
+        /* 只知道落在哪个桶，输出桶的上界 */
+        if (total) printf(" | <%-7llu\n", 1ULL << (top + 1));
+        else printf(" | %-8s\n", "-");
+    }
+
+    if (0 == all) printf("[INFO] 未记录到耗时，需在配置文件中设置 %s = 1 后重新加载\n", CONF_KEY_PROFILE);
+
+    profile_show_prog("XDP", snap->xdp_run_time, snap->xdp_run_cnt);
+    profile_show_prog("TC", snap->tc_run_time, snap->tc_run_cnt);
+}
+
+/* 加载以来 (或上次 reset 以来) 的累计分布 */
+int profile_total(int argc, char **argv) {
+    profile_snapshot_t *snap = calloc(1, sizeof(*snap));
+    if (NULL == snap) return -1;
+
+    int ret = -1;
+    if (profile_snapshot(snap)) {
+        profile_show(snap);
+        ret = 0;
+    }
+
+    free(snap);
+    return ret;
+}
+
+/* 统计一段时间内的增量，期间开启内核运行统计 */
+int profile_window(int argc, char **argv) {
+    char *end = NULL;
+    unsigned long sec = strtoul(argv[2], &end, 10);
+    if (0 == sec || *end || sec > PROFILE_WINDOW_MAX_SEC) {
+        fprintf(stderr, "[ERROR] 参数错误 [%s]，" PROFILE_PROG_USAGE "\n", argv[2]);
+        return -1;
+    }
+
+    profile_snapshot_t *snap = calloc(2, sizeof(*snap));
+    if (NULL == snap) return -1;
+
+    /* 返回的 fd 关闭前内核持续统计程序运行时间 */
+    int stats_fd = bpf_enable_stats(BPF_STATS_RUN_TIME);
+    if (stats_fd < 0) fprintf(stderr, "[INFO] 无法开启内核运行统计: %s\n", strerror(errno));
+
+    int ret = -1;
+    if (!profile_snapshot(&snap[0])) goto out;
+    printf("[INFO] 统计 %lu 秒 ...\n", sec);
+    fflush(stdout);
+    sleep(sec);
+    if (!profile_snapshot(&snap[1])) goto out;
+
+    for (__u32 i = 0; i < PROFILE_HIST_MAP_SIZE; i++) snap[1].slots[i] -= snap[0].slots[i];
+    snap[1].xdp_run_time -= snap[0].xdp_run_time;
+    snap[1].xdp_run_cnt -= snap[0].xdp_run_cnt;
+    snap[1].tc_run_time -= snap[0].tc_run_time;
+    snap[1].tc_run_cnt -= snap[0].tc_run_cnt;
+
+    profile_show(&snap[1]);
+    ret = 0;
+
+out:
+    if (stats_fd >= 0) close(stats_fd);
+    free(snap);
+    return ret;
+}
+
+int profile_reset(int argc, char **argv) {
+    int map_fd = bpf_obj_get(PROFILEHIST_XDP_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", PROFILEHIST_XDP_PIN, strerror(errno));
+        return -1;
+    }
+
+    int cpus = libbpf_num_possible_cpus();
+    __u64 *zero = (cpus > 0) ? calloc(cpus, sizeof(__u64)) : NULL;
+    int ret = zero ? 0 : -1;
+
+    for (__u32 i = 0; i < PROFILE_HIST_MAP_SIZE && 0 == ret; i++) {
+        if (bpf_map_update_elem(map_fd, &i, zero, BPF_ANY)) {
+            fprintf(stderr, "[ERROR] 耗时分布清空失败: %s\n", strerror(errno));
+            ret = -1;
+        }
+    }
+
+    free(zero);
+    close(map_fd);
+    if (0 == ret) printf("[INFO] 耗时分布已清空\n");
+    return ret;
+}
+
+int profile_args_parse(int argc, char **argv) {
+    if (argc < PROFILE_ARGS_MIN_NUM || argc > PROFILE_ARGS_MAX_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" PROFILE_PROG_USAGE "\n");
+        return -1;
+    }
+
+    if (PROFILE_ARGS_MIN_NUM == argc) return profile_total(argc, argv);
+    else if (!strcmp(argv[2], PROFILE_ARGS_RESET)) return profile_reset(argc, argv);
+
+    return profile_window(argc, argv);
+}
+
+int profile_main(int argc, char **argv) {
+    return profile_args_parse(argc, argv);
+}
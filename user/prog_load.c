@@ -6,11 +6,14 @@
  * Creation : 2026-03-02 15:27:32
 */
 
+#include <errno.h>
+#include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 
 #include <bpf/libbpf.h>
+#include <bpf/btf.h>
 #include <net/if.h>
 #include <linux/if_link.h>
 #include <linux/pkt_cls.h>
@@ -18,10 +21,94 @@
 
 #include "direct_path_user.h"
 #include "direct_path_prog_load.h"
+#include "direct_path_config.h"
 
-bool load_and_pin_bpf_prog(const char *prog_file, const char *bpf_dir, const char *pin_dir, 
+/* 按 BTF 中 .rodata 段的变量信息修改初值，对象中没有该变量时返回 true */
+static bool rodata_set(struct bpf_object *obj, const char *name, const void *value, __u32 size) {
+    struct bpf_map *map = bpf_object__find_map_by_name(obj, ".rodata");
+    struct btf *btf = bpf_object__btf(obj);
+    if (NULL == map || NULL == btf) return true;
+
+    int sec_id = btf__find_by_name_kind(btf, ".rodata", BTF_KIND_DATASEC);
+    if (sec_id < 0) return true;
+
+    size_t data_size = 0;
+    char *data = bpf_map__initial_value(map, &data_size);
+    if (NULL == data) return false;
+
+    const struct btf_type *sec = btf__type_by_id(btf, sec_id);
+    const struct btf_var_secinfo *vars = btf_var_secinfos(sec);
+    for (__u32 i = 0; i < btf_vlen(sec); i++) {
+        const struct btf_type *var = btf__type_by_id(btf, vars[i].type);
+        if (strcmp(btf__name_by_offset(btf, var->name_off), name)) continue;
+
+        if (vars[i].size != size || vars[i].offset + size > data_size) {
+            fprintf(stderr, "[ERROR] .rodata 变量 %s 大小不一致\n", name);
+            return false;
+        }
+
+        memcpy(data + vars[i].offset, value, size);
+        return true;
+    }
+
+    return true;
+}
+
+/* 将配置文件中的数据面参数写入 .rodata */
+static bool rodata_apply(struct bpf_object *obj) {
+    const direct_path_conf_t *conf = conf_get();
+    __u16 direct_port = conf->direct_dns_port;
+    __u16 proxy_port = conf->proxy_dns_port;
+
+    return rodata_set(obj, RODATA_DIRECT_DNS_PORT, &direct_port, sizeof(direct_port)) &&
+        rodata_set(obj, RODATA_PROXY_DNS_PORT, &proxy_port, sizeof(proxy_port)) &&
+        rodata_set(obj, RODATA_DIRECT_MARK, &conf->direct_mark, sizeof(conf->direct_mark)) &&
+        rodata_set(obj, RODATA_HOTPKG_NUM, &conf->hotpkg_num, sizeof(conf->hotpkg_num)) &&
+        rodata_set(obj, RODATA_HOTPKG_INV_TIME, &conf->hotpkg_inv_time, sizeof(conf->hotpkg_inv_time)) &&
+        rodata_set(obj, RODATA_DEBUG, &conf->debug, sizeof(conf->debug)) &&
+        rodata_set(obj, RODATA_PROFILE, &conf->profile, sizeof(conf->profile));
+}
+
+/* 数据面会写入的 map: LRU 缓存、per-CPU 统计与事件流 */
+static bool snapshot_map_writable(__u32 type) {
+    return BPF_MAP_TYPE_LRU_HASH == type || BPF_MAP_TYPE_PERCPU_ARRAY == type || BPF_MAP_TYPE_RINGBUF == type;
+}
+
+/* 按固定 map 的属性创建副本，LRU 缓存复制现有条目，per-CPU 统计与事件流保持为空 */
+static int snapshot_map_clone(int pinned_fd) {
+    struct bpf_map_info info;
+    __u32 info_len = sizeof(info);
+    memset(&info, 0, sizeof(info));
+    if (bpf_map_get_info_by_fd(pinned_fd, &info, &info_len)) return -1;
+
+    LIBBPF_OPTS(bpf_map_create_opts, opts, .map_flags = info.map_flags, .map_extra = info.map_extra);
+    int fd = bpf_map_create(info.type, info.name, info.key_size, info.value_size, info.max_entries, &opts);
+    if (fd < 0 || BPF_MAP_TYPE_PERCPU_ARRAY == info.type || BPF_MAP_TYPE_RINGBUF == info.type) return fd;
+
+    unsigned char *buf = malloc((size_t)info.key_size * 2 + info.value_size);
+    if (NULL == buf) {
+        close(fd);
+        return -1;
+    }
+
+    void *prev = NULL;
+    void *next = buf;
+    void *value = buf + info.key_size * 2;
+    while (!bpf_map_get_next_key(pinned_fd, prev, next)) {
+        /* 遍历期间条目可能被淘汰，查找失败时跳过 */
+        if (!bpf_map_lookup_elem(pinned_fd, next, value)) bpf_map_update_elem(fd, next, value, BPF_ANY);
+        prev = next;
+        next = (next == buf) ? buf + info.key_size : buf;
+    }
+
+    free(buf);
+    return fd;
+}
+
+/* 打开并加载 BPF 对象，已固定的同名 map 直接复用
+ * snapshot 为 true 时数据面会写入的 map 改用副本，运行时不影响线上缓存与统计 */
+static bool load_bpf_prog(const char *prog_file, const char *bpf_dir, bool snapshot,
     struct bpf_object **obj, int *prog_fd) {
-    
     *obj = bpf_object__open_file(prog_file, NULL);
     if (libbpf_get_error(*obj)) return false;
 
@@ -38,6 +125,16 @@ bool load_and_pin_bpf_prog(const char *prog_file, const char *bpf_dir, const cha
         int pinned_fd = bpf_obj_get(map_pin_path);
         if (pinned_fd < 0) continue;
 
+        if (snapshot && snapshot_map_writable(bpf_map__type(map))) {
+            int clone_fd = snapshot_map_clone(pinned_fd);
+            close(pinned_fd);
+            if (clone_fd < 0) {
+                fprintf(stderr, "[ERROR] 无法创建 Map %s 的副本\n", map_name);
+                return false;
+            }
+            pinned_fd = clone_fd;
+        }
+
         /* 告诉 libbpf 这个 map 不要创建新的，直接用这个 FD */
         if (bpf_map__reuse_fd(map, pinned_fd)) {
             fprintf(stderr, "[ERROR] 无法复用 Map %s\n", map_name);
@@ -48,27 +145,40 @@ bool load_and_pin_bpf_prog(const char *prog_file, const char *bpf_dir, const cha
         close(pinned_fd); 
     }
     
+    /* 数据面参数写入 .rodata，加载后冻结，校验器按常量处理 */
+    if (!rodata_apply(*obj)) return false;
+
     if (bpf_object__load(*obj)) return false;
 
-    /* 核心修改：动态获取内核程序名 */
     struct bpf_program *prog = bpf_object__next_program(*obj, NULL);
     if (!prog) return false;
 
-    const char *actual_name = bpf_program__name(prog); // 获取 "tc_direct_path"
     *prog_fd = bpf_program__fd(prog);
 
+    return true;
+}
+
+/* 按内核程序名固定程序，已存在的同名固定路径会被替换 */
+static bool pin_bpf_prog(const char *pin_dir, struct bpf_object *obj, int prog_fd) {
+    /* 核心修改：动态获取内核程序名 */
+    struct bpf_program *prog = bpf_object__next_program(obj, NULL);
+    if (!prog) return false;
+
+    const char *actual_name = bpf_program__name(prog); // 获取 "tc_direct_path"
+
     /* 构造路径：/sys/fs/bpf/tc_progs/tc_direct_path/tc_direct_path */
     char final_dir[256];
     snprintf(final_dir, sizeof(final_dir), "%s/%s", pin_dir, actual_name);
 
-    /* 1. 创建子目录 (类似 bpftool 的行为) */
-    char mkdir_cmd[300];
-    snprintf(mkdir_cmd, sizeof(mkdir_cmd), "mkdir -p %s", pin_dir);
-    system(mkdir_cmd);
+    /* 1. 创建子目录 (类似 bpftool 的行为)，父目录为已挂载的 bpffs */
+    if (mkdir(pin_dir, 0755) && EEXIST != errno) {
+        fprintf(stderr, "[ERROR] 创建目录 %s 失败: %s\n", pin_dir, strerror(errno));
+        return false;
+    }
 
     /* 2. Pin 到这个正确的路径 */
     unlink(final_dir); 
-    if (bpf_obj_pin(*prog_fd, final_dir)) {
+    if (bpf_obj_pin(prog_fd, final_dir)) {
         fprintf(stderr, "Pin 失败到路径: %s\n", final_dir);
         return false;
     }
@@ -77,6 +187,17 @@ bool load_and_pin_bpf_prog(const char *prog_file, const char *bpf_dir, const cha
     return true;
 }
 
+bool load_and_pin_bpf_prog(const char *prog_file, const char *bpf_dir, const char *pin_dir, 
+    struct bpf_object **obj, int *prog_fd) {
+    if (!load_bpf_prog(prog_file, bpf_dir, false, obj, prog_fd)) return false;
+
+    return pin_bpf_prog(pin_dir, *obj, *prog_fd);
+}
+
+bool load_bpf_prog_snapshot(const char *prog_file, const char *bpf_dir, struct bpf_object **obj, int *prog_fd) {
+    return load_bpf_prog(prog_file, bpf_dir, true, obj, prog_fd);
+}
+
 bool tc_prog_hook_create(struct bpf_object *tc_obj, int ifindex) {
     if (unlikely(0 == ifindex)) return false;
     DECLARE_LIBBPF_OPTS(bpf_tc_hook, tc_hook, .ifindex = ifindex, .attach_point = BPF_TC_INGRESS);
@@ -109,17 +230,51 @@ bool attach_tc_prog_by_if(struct bpf_object *tc_obj, int tc_prog_fd,
     return true;
 }
 
-/* 附加TC程序到接口 */
+/* 创建 bpf_link 并固定，进程退出后 link 由固定点持有，失败返回负的错误码 */
+static int link_create_pin(int prog_fd, int ifindex, enum bpf_attach_type type, __u32 flags, const char *pin) {
+    LIBBPF_OPTS(bpf_link_create_opts, opts, .flags = flags);
+
+    int link_fd = bpf_link_create(prog_fd, ifindex, type, &opts);
+    if (link_fd < 0) return link_fd;
+
+    unlink(pin);
+    int err = bpf_obj_pin(link_fd, pin) ? -errno : 0;
+    /* 固定失败时关闭 fd 即断开 link */
+    close(link_fd);
+
+    return err;
+}
+
+/* tcx link (内核 >= 6.6) 挂载 ingress 与 egress */
+static int attach_tc_prog_tcx(int tc_prog_fd, int ifindex) {
+    int err = link_create_pin(tc_prog_fd, ifindex, BPF_TCX_INGRESS, 0, TC_LINK_INGRESS_PIN);
+    if (err) return err;
+
+    err = link_create_pin(tc_prog_fd, ifindex, BPF_TCX_EGRESS, 0, TC_LINK_EGRESS_PIN);
+    if (err) unlink(TC_LINK_INGRESS_PIN);
+
+    return err;
+}
+
+/* 附加TC程序到接口，优先使用 tcx link，内核不支持时回退到 clsact + cls_bpf */
 bool attach_tc_prog(int tc_prog_fd, struct bpf_object *tc_obj) {
     if (unlikely(NULL == tc_obj)) return false;
 
-    bool ret = tc_prog_hook_create(tc_obj, if_nametoindex(LAN_IF));
+    int err = attach_tc_prog_tcx(tc_prog_fd, if_nametoindex(conf_get()->lan_if));
+    if (!err) {
+        printf("[INFO] TC 程序以 tcx link 方式挂载\n");
+        return true;
+    }
+
+    printf("[INFO] 内核不支持 tcx link (%s)，使用 clsact cls_bpf 挂载\n", strerror(-err));
+
+    bool ret = tc_prog_hook_create(tc_obj, if_nametoindex(conf_get()->lan_if));
     if (!ret) return ret;
 
-    ret = attach_tc_prog_by_if(tc_obj, tc_prog_fd, if_nametoindex(LAN_IF), BPF_TC_INGRESS);
+    ret = attach_tc_prog_by_if(tc_obj, tc_prog_fd, if_nametoindex(conf_get()->lan_if), BPF_TC_INGRESS);
     if (!ret) return ret;
 
-    ret = attach_tc_prog_by_if(tc_obj, tc_prog_fd, if_nametoindex(LAN_IF), BPF_TC_EGRESS);
+    ret = attach_tc_prog_by_if(tc_obj, tc_prog_fd, if_nametoindex(conf_get()->lan_if), BPF_TC_EGRESS);
     if (!ret) return ret;
 
     // ret = tc_prog_hook_create(tc_obj, if_nametoindex(WAN_IF));
@@ -134,19 +289,53 @@ bool attach_tc_prog(int tc_prog_fd, struct bpf_object *tc_obj) {
     return ret;
 }
 
-/* 附加XDP程序到接口 */
+/* XDP 挂载模式，按顺序尝试，优先原生驱动模式 */
+static const struct {
+    __u32 flags;
+    const char *name;
+} xdp_modes[] = {
+    { XDP_FLAGS_DRV_MODE, XDP_MODE_NAME_NATIVE },
+    { XDP_FLAGS_SKB_MODE, XDP_MODE_NAME_GENERIC },
+};
+
+#define XDP_MODE_NUM                (sizeof(xdp_modes) / sizeof(xdp_modes[0]))
+
+static void xdp_mode_report(const char *name, bool link) {
+    printf("[INFO] XDP 程序以 %s 模式%s挂载\n", name, link ? "通过 bpf_link " : "");
+    if (!strcmp(name, XDP_MODE_NAME_GENERIC))
+        printf("[INFO] 网卡驱动不支持原生 XDP，generic 模式在协议栈中执行，性能低于 native 模式\n");
+}
+
+/* 附加XDP程序到接口，优先 XDP link (内核 >= 5.9)，每种方式都先尝试原生驱动模式 */
 bool attach_xdp_prog(int xdp_prog_fd, struct bpf_object *xdp_obj) {
     if (unlikely(NULL == xdp_obj)) return false;
 
-    __u32 flags = XDP_FLAGS_UPDATE_IF_NOEXIST;  // 标志位
-    
-    if (bpf_xdp_attach(if_nametoindex(LAN_IF), xdp_prog_fd, flags, NULL)) {
-        fprintf(stderr, "附加XDP程序失败\n");
-        bpf_object__close(xdp_obj);
-        return false;
+    int ifindex = if_nametoindex(conf_get()->lan_if);
+    int err = 0;
+    for (size_t i = 0; i < XDP_MODE_NUM; i++) {
+        err = link_create_pin(xdp_prog_fd, ifindex, BPF_XDP, xdp_modes[i].flags, XDP_LINK_PIN);
+        if (!err) {
+            xdp_mode_report(xdp_modes[i].name, true);
+            return true;
+        }
+
+        printf("[INFO] XDP link %s 模式挂载失败: %s\n", xdp_modes[i].name, strerror(-err));
     }
 
-    return true;
+    for (size_t i = 0; i < XDP_MODE_NUM; i++) {
+        __u32 flags = XDP_FLAGS_UPDATE_IF_NOEXIST | xdp_modes[i].flags;  // 标志位
+        err = bpf_xdp_attach(ifindex, xdp_prog_fd, flags, NULL);
+        if (!err) {
+            xdp_mode_report(xdp_modes[i].name, false);
+            return true;
+        }
+
+        printf("[INFO] XDP %s 模式挂载失败: %s\n", xdp_modes[i].name, strerror(-err));
+    }
+
+    fprintf(stderr, "附加XDP程序失败\n");
+    bpf_object__close(xdp_obj);
+    return false;
 }
 
 bool load_and_pin_bpf_all() {
@@ -170,3 +359,234 @@ bool load_and_pin_bpf_all() {
 
     return ret;
 }
+
+/* 原位替换 TC 程序，handle 与 priority 与安装时一致，替换期间 filter 始终存在 */
+static bool replace_tc_prog_by_if(int tc_prog_fd, int ifindex, enum bpf_tc_attach_point attach_point) {
+    if (unlikely(0 == ifindex)) return false;
+
+    DECLARE_LIBBPF_OPTS(bpf_tc_hook, tc_hook, .ifindex = ifindex, .attach_point = attach_point);
+    DECLARE_LIBBPF_OPTS(bpf_tc_opts, tc_opts, .prog_fd = tc_prog_fd, .handle = 1, .priority = 1, 
+        .flags = BPF_TC_F_REPLACE);
+
+    int err = bpf_tc_attach(&tc_hook, &tc_opts);
+    if (err) {
+        fprintf(stderr, "[ERROR] 替换TC程序失败: %s\n", strerror(-err));
+        return false;
+    }
+
+    return true;
+}
+
+/* 原位替换 XDP 程序，按当前挂载模式并指定旧程序，避免替换掉其他程序 */
+static bool replace_xdp_prog(int xdp_prog_fd, int ifindex) {
+    if (unlikely(0 == ifindex)) return false;
+
+    LIBBPF_OPTS(bpf_xdp_query_opts, query);
+    if (bpf_xdp_query(ifindex, 0, &query) || 0 == query.prog_id) {
+        fprintf(stderr, "[ERROR] %s 上没有已挂载的 XDP 程序，请先执行 load install\n", conf_get()->lan_if);
+        return false;
+    }
+
+    __u32 flags = XDP_FLAGS_REPLACE;
+    if (XDP_ATTACHED_SKB == query.attach_mode) flags |= XDP_FLAGS_SKB_MODE;
+    else if (XDP_ATTACHED_DRV == query.attach_mode) flags |= XDP_FLAGS_DRV_MODE;
+    else if (XDP_ATTACHED_HW == query.attach_mode) flags |= XDP_FLAGS_HW_MODE;
+
+    int old_fd = bpf_prog_get_fd_by_id(query.prog_id);
+    if (old_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取当前 XDP 程序: %s\n", strerror(errno));
+        return false;
+    }
+
+    LIBBPF_OPTS(bpf_xdp_attach_opts, attach, .old_prog_fd = old_fd);
+    int err = bpf_xdp_attach(ifindex, xdp_prog_fd, flags, &attach);
+    close(old_fd);
+    if (err) {
+        fprintf(stderr, "[ERROR] 替换XDP程序失败: %s\n", strerror(-err));
+        return false;
+    }
+
+    return true;
+}
+
+/* 更新固定的 bpf_link 指向新程序，原子替换 */
+static bool link_update_pinned(const char *pin, int prog_fd) {
+    int link_fd = bpf_obj_get(pin);
+    if (link_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 link %s: %s\n", pin, strerror(errno));
+        return false;
+    }
+
+    int err = bpf_link_update(link_fd, prog_fd, NULL);
+    close(link_fd);
+    if (err) {
+        fprintf(stderr, "[ERROR] 更新 link %s 失败: %s\n", pin, strerror(-err));
+        return false;
+    }
+
+    return true;
+}
+
+static bool link_pinned(const char *pin) {
+    return 0 == access(pin, F_OK);
+}
+
+/* 读取固定 link 当前指向的程序 id */
+static __u32 link_prog_id(const char *pin) {
+    int link_fd = bpf_obj_get(pin);
+    if (link_fd < 0) return 0;
+
+    struct bpf_link_info info;
+    __u32 len = sizeof(info);
+    memset(&info, 0, sizeof(info));
+    __u32 prog_id = bpf_link_get_info_by_fd(link_fd, &info, &len) ? 0 : info.prog_id;
+    close(link_fd);
+
+    return prog_id;
+}
+
+/* 在线升级替换的一个挂载点 */
+typedef struct {
+    const char *name;
+    /* link 方式挂载时固定的 link，否则为 NULL */
+    const char *link_pin;
+    bool is_xdp;
+    enum bpf_tc_attach_point tc_point;
+    /* 替换前正在运行的程序，用于回滚 */
+    int old_fd;
+} upgrade_point_t;
+
+/* 查询挂载点当前运行的程序 id，没有挂载时返回 0 */
+static __u32 upgrade_point_prog_id(const upgrade_point_t *point, int ifindex) {
+    if (point->link_pin) return link_prog_id(point->link_pin);
+
+    if (point->is_xdp) {
+        LIBBPF_OPTS(bpf_xdp_query_opts, query);
+        return bpf_xdp_query(ifindex, 0, &query) ? 0 : query.prog_id;
+    }
+
+    DECLARE_LIBBPF_OPTS(bpf_tc_hook, tc_hook, .ifindex = ifindex, .attach_point = point->tc_point);
+    DECLARE_LIBBPF_OPTS(bpf_tc_opts, tc_opts, .handle = 1, .priority = 1);
+    return bpf_tc_query(&tc_hook, &tc_opts) ? 0 : tc_opts.prog_id;
+}
+
+/* 记录挂载点当前运行的程序，任何一个挂载点缺失都不开始替换 */
+static bool upgrade_point_save(upgrade_point_t *point, int ifindex) {
+    __u32 prog_id = upgrade_point_prog_id(point, ifindex);
+    if (0 == prog_id) {
+        fprintf(stderr, "[ERROR] %s 上没有已挂载的程序，请先执行 load install\n", point->name);
+        return false;
+    }
+
+    point->old_fd = bpf_prog_get_fd_by_id(prog_id);
+    if (point->old_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 %s 当前的程序: %s\n", point->name, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+static bool upgrade_point_swap(const upgrade_point_t *point, int prog_fd, int ifindex) {
+    if (point->link_pin) return link_update_pinned(point->link_pin, prog_fd);
+    if (point->is_xdp) return replace_xdp_prog(prog_fd, ifindex);
+    return replace_tc_prog_by_if(prog_fd, ifindex, point->tc_point);
+}
+
+/* 新程序复用已固定的 map，两个对象都通过校验、全部挂载点都已记录后才开始替换
+ * TC 与 XDP 共用 map 布局与配置约定，任何一步替换失败都将已替换的挂载点恢复为旧程序 */
+bool upgrade_bpf_all() {
+    int tc_prog_fd, xdp_prog_fd;
+    struct bpf_object *tc_obj = NULL, *xdp_obj = NULL;
+    bool ret = false;
+
+    bool tc_link = link_pinned(TC_LINK_INGRESS_PIN);
+    upgrade_point_t points[] = {
+        { "TC ingress", tc_link ? TC_LINK_INGRESS_PIN : NULL, false, BPF_TC_INGRESS, -1 },
+        { "TC egress", tc_link ? TC_LINK_EGRESS_PIN : NULL, false, BPF_TC_EGRESS, -1 },
+        { "XDP", link_pinned(XDP_LINK_PIN) ? XDP_LINK_PIN : NULL, true, BPF_TC_INGRESS, -1 },
+    };
+    const size_t point_num = sizeof(points) / sizeof(points[0]);
+    size_t swapped = 0;
+    int lan = if_nametoindex(conf_get()->lan_if);
+
+    if (!load_bpf_prog(TC_BPF_OBJ, TC_BPF_DIR, false, &tc_obj, &tc_prog_fd)) {
+        fprintf(stderr, "[ERROR] %s 加载失败，map 结构变化时需要重新 load install\n", TC_BPF_OBJ);
+        goto out;
+    }
+
+    if (!load_bpf_prog(XDP_BPF_OBJ, XDP_BPF_DIR, false, &xdp_obj, &xdp_prog_fd)) {
+        fprintf(stderr, "[ERROR] %s 加载失败，map 结构变化时需要重新 load install\n", XDP_BPF_OBJ);
+        goto out;
+    }
+
+    /* 按安装时的挂载方式替换: link 方式更新 link，否则替换 filter 与 XDP 程序 */
+    for (size_t i = 0; i < point_num; i++) {
+        if (!upgrade_point_save(&points[i], lan)) goto out;
+    }
+
+    for (; swapped < point_num; swapped++) {
+        upgrade_point_t *point = &points[swapped];
+        if (!upgrade_point_swap(point, point->is_xdp ? xdp_prog_fd : tc_prog_fd, lan)) goto out;
+    }
+    printf("[INFO] TC 程序 %s、XDP 程序 %s 已替换\n", TC_BPF_OBJ, XDP_BPF_OBJ);
+
+    ret = pin_bpf_prog(TC_PROG_BASE, tc_obj, tc_prog_fd) && pin_bpf_prog(XDP_PROG_BASE, xdp_obj, xdp_prog_fd);
+
+out:
+    /* 替换未全部完成，逆序恢复已替换的挂载点，避免 TC 与 XDP 运行不同版本 */
+    if (swapped < point_num) {
+        while (swapped > 0) {
+            const upgrade_point_t *point = &points[--swapped];
+            if (upgrade_point_swap(point, point->old_fd, lan)) 
+                printf("[INFO] %s 已回滚到旧程序\n", point->name);
+            else 
+                fprintf(stderr, "[ERROR] %s 回滚失败，TC 与 XDP 可能运行不同版本，请重新 load install\n", point->name);
+        }
+    }
+
+    for (size_t i = 0; i < point_num; i++) {
+        if (points[i].old_fd >= 0) close(points[i].old_fd);
+    }
+
+    /* 已挂载的程序由 TC filter 与网卡持有引用，关闭对象不影响运行 */
+    bpf_object__close(tc_obj);
+    bpf_object__close(xdp_obj);
+
+    return ret;
+}
+
+/* 输出 TC 与 XDP 程序的挂载方式与模式 */
+bool show_attach_status() {
+    int lan = if_nametoindex(conf_get()->lan_if);
+    if (0 == lan) {
+        fprintf(stderr, "[ERROR] 网卡 %s 不存在\n", conf_get()->lan_if);
+        return false;
+    }
+
+    if (link_pinned(TC_LINK_INGRESS_PIN)) {
+        printf("TC : tcx link, ingress prog id %u, egress prog id %u\n", 
+            link_prog_id(TC_LINK_INGRESS_PIN), link_prog_id(TC_LINK_EGRESS_PIN));
+    } else {
+        DECLARE_LIBBPF_OPTS(bpf_tc_hook, tc_hook, .ifindex = lan, .attach_point = BPF_TC_INGRESS);
+        DECLARE_LIBBPF_OPTS(bpf_tc_opts, tc_opts, .handle = 1, .priority = 1);
+        if (!bpf_tc_query(&tc_hook, &tc_opts)) printf("TC : clsact cls_bpf, prog id %u\n", tc_opts.prog_id);
+        else printf("TC : 未挂载\n");
+    }
+
+    LIBBPF_OPTS(bpf_xdp_query_opts, query);
+    if (bpf_xdp_query(lan, 0, &query) || 0 == query.prog_id) {
+        printf("XDP: 未挂载\n");
+        return true;
+    }
+
+    const char *mode = "unknown";
+    if (XDP_ATTACHED_DRV == query.attach_mode) mode = XDP_MODE_NAME_NATIVE;
+    else if (XDP_ATTACHED_SKB == query.attach_mode) mode = XDP_MODE_NAME_GENERIC;
+    else if (XDP_ATTACHED_HW == query.attach_mode) mode = XDP_MODE_NAME_OFFLOAD;
+    else if (XDP_ATTACHED_MULTI == query.attach_mode) mode = "multi";
+
+    printf("XDP: %s%s, prog id %u\n", mode, link_pinned(XDP_LINK_PIN) ? " (bpf_link)" : "", query.prog_id);
+
+    return true;
+}
@@ -0,0 +1,119 @@
+/*
+ * File     : ratelimit.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-12 22:08:26
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_ratelimit.h"
+
+static bool xdp_config_read(xdp_config_t *cfg) {
+    int map_fd = bpf_obj_get(XDPCONFIG_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", XDPCONFIG_PIN, strerror(errno));
+        return false;
+    }
+
+    __u32 key = 0;
+    bool ret = !bpf_map_lookup_elem(map_fd, &key, cfg);
+    close(map_fd);
+
+    return ret;
+}
+
+static bool xdp_config_write(const xdp_config_t *cfg) {
+    int map_fd = bpf_obj_get(XDPCONFIG_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", XDPCONFIG_PIN, strerror(errno));
+        return false;
+    }
+
+    __u32 key = 0;
+    bool ret = !bpf_map_update_elem(map_fd, &key, cfg, BPF_ANY);
+    if (!ret) fprintf(stderr, "[ERROR] XDP 配置更新失败: %s\n", strerror(errno));
+    close(map_fd);
+
+    return ret;
+}
+
+int ratelimit_show(int argc, char **argv) {
+    xdp_config_t cfg = {0};
+    if (!xdp_config_read(&cfg)) return -1;
+
+    if (0 == cfg.rl_rate) {
+        printf("ratelimit: off\n");
+        return 0;
+    }
+
+    printf("ratelimit: %u/s, burst %u, %s\n", cfg.rl_rate, cfg.rl_burst,
+        (RATELIMIT_ACTION_TRUNCATE == cfg.rl_action) ? RATELIMIT_NAME_TRUNCATE : RATELIMIT_NAME_DROP);
+
+    return 0;
+}
+
+int ratelimit_set(int argc, char **argv) {
+    if (argc < RATELIMIT_SET_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" RATELIMIT_PROG_USAGE "\n");
+        return -1;
+    }
+
+    xdp_config_t cfg = {0};
+    if (!xdp_config_read(&cfg)) return -1;
+
+    int rate = atoi(argv[3]);
+    int burst = atoi(argv[4]);
+    if (rate <= 0 || burst <= 0) {
+        fprintf(stderr, "[ERROR] 参数错误 rate [%s] burst [%s]\n", argv[3], argv[4]);
+        return -1;
+    }
+
+    cfg.rl_rate = rate;
+    cfg.rl_burst = burst;
+    cfg.rl_action = RATELIMIT_ACTION_DROP;
+    if (argc > RATELIMIT_SET_ARGS_MIN_NUM) {
+        if (!strcmp(argv[5], RATELIMIT_NAME_TRUNCATE)) cfg.rl_action = RATELIMIT_ACTION_TRUNCATE;
+        else if (strcmp(argv[5], RATELIMIT_NAME_DROP)) {
+            fprintf(stderr, "[ERROR] 参数错误 [%s]，" RATELIMIT_PROG_USAGE "\n", argv[5]);
+            return -1;
+        }
+    }
+
+    if (!xdp_config_write(&cfg)) return -1;
+
+    return ratelimit_show(argc, argv);
+}
+
+int ratelimit_off(int argc, char **argv) {
+    xdp_config_t cfg = {0};
+    if (!xdp_config_read(&cfg)) return -1;
+
+    cfg.rl_rate = 0;
+    if (!xdp_config_write(&cfg)) return -1;
+
+    return ratelimit_show(argc, argv);
+}
+
+int ratelimit_args_parse(int argc, char **argv) {
+    if (argc < RATELIMIT_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" RATELIMIT_PROG_USAGE "\n");
+        return -1;
+    }
+
+    if (!strcmp(argv[2], RATELIMIT_ARGS_SHOW)) return ratelimit_show(argc, argv);
+    else if (!strcmp(argv[2], RATELIMIT_ARGS_SET)) return ratelimit_set(argc, argv);
+    else if (!strcmp(argv[2], RATELIMIT_ARGS_OFF)) return ratelimit_off(argc, argv);
+
+    return 0;
+}
+
+int ratelimit_main(int argc, char **argv) {
+    return ratelimit_args_parse(argc, argv);
+}
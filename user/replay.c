@@ -0,0 +1,249 @@
+/*
+ * File     : replay.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-13 21:02:53
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/pkt_cls.h>
+
+#include "direct_path_user.h"
+#include "direct_path_prog_load.h"
+#include "direct_path_pcap.h"
+#include "direct_path_replay.h"
+
+typedef struct {
+    __u64 slots[REPLAY_HIST_SLOTS];
+    __u64 num;
+    __u64 total;
+    __u32 max;
+} replay_hist_t;
+
+typedef struct {
+    bool quiet;
+
+    int xdp_fd;
+    int tc_fd;
+
+    __u64 pkt_num;
+    __u64 ipv4_num;
+    __u64 skip_num;
+    __u64 rewrite_num;
+    __u64 mark_num;
+    __u64 xdp_drop_num;
+    __u64 tc_drop_num;
+
+    replay_hist_t xdp_hist;
+    replay_hist_t tc_hist;
+
+    pcap_reader_t pcap;
+} replay_ctx_t;
+
+static void replay_hist_add(replay_hist_t *hist, __u32 ns) {
+    __u32 slot = 0;
+    while (slot + 1 < REPLAY_HIST_SLOTS && (ns >> (slot + 1))) slot++;
+
+    hist->slots[slot]++;
+    hist->num++;
+    hist->total += ns;
+    if (ns > hist->max) hist->max = ns;
+}
+
+static void replay_hist_show(const char *title, const replay_hist_t *hist) {
+    if (0 == hist->num) return ;
+
+    printf("[INFO] %s 单包耗时分布 (ns)，共 %llu 次，平均 %.1f，最大 %u\n", title,
+        (unsigned long long)hist->num, (double)hist->total / hist->num, hist->max);
+
+    __u64 peak = 0;
+    for (__u32 i = 0; i < REPLAY_HIST_SLOTS; i++) if (hist->slots[i] > peak) peak = hist->slots[i];
+
+    for (__u32 i = 0; i < REPLAY_HIST_SLOTS; i++) {
+        if (0 == hist->slots[i]) continue;
+
+        char bar[REPLAY_HIST_BAR_WIDTH + 1] = {0};
+        __u32 width = hist->slots[i] * REPLAY_HIST_BAR_WIDTH / peak;
+        memset(bar, '*', width ? width : 1);
+        printf("%10llu -> %-10llu : %-10llu |%-*s|\n", i ? 1ULL << i : 0ULL, (1ULL << (i + 1)) - 1,
+            (unsigned long long)hist->slots[i], REPLAY_HIST_BAR_WIDTH, bar);
+    }
+}
+
+static const char *replay_xdp_action_name(__u32 ret) {
+    static const char *names[] = { "ABORTED", "DROP", "PASS", "TX", "REDIRECT" };
+    return ret < sizeof(names) / sizeof(names[0]) ? names[ret] : "UNKNOWN";
+}
+
+static const char *replay_tc_action_name(__u32 ret) {
+    switch ((int)ret) {
+        case TC_ACT_OK: return "OK";
+        case TC_ACT_SHOT: return "SHOT";
+        case TC_ACT_REDIRECT: return "REDIRECT";
+        default: return "OTHER";
+    }
+}
+
+/* 按数据面的顺序运行: 先经 XDP，放行的报文 (可能已改写端口) 再经 TC */
+static bool replay_packet(replay_ctx_t *ctx, const __u8 *pkt, __u32 len) {
+    __u8 xdp_out[REPLAY_PKT_MAXLEN];
+    __u8 tc_out[REPLAY_PKT_MAXLEN];
+
+    LIBBPF_OPTS(bpf_test_run_opts, xdp_opts,
+        .data_in = pkt,
+        .data_size_in = len,
+        .data_out = xdp_out,
+        .data_size_out = sizeof(xdp_out),
+        .repeat = 1,
+    );
+
+    if (bpf_prog_test_run_opts(ctx->xdp_fd, &xdp_opts)) {
+        fprintf(stderr, "[ERROR] 第 %llu 个报文 XDP test run 失败: %s\n",
+            (unsigned long long)ctx->pkt_num, strerror(errno));
+        return false;
+    }
+    replay_hist_add(&ctx->xdp_hist, xdp_opts.duration);
+
+    struct __sk_buff skb;
+    memset(&skb, 0, sizeof(skb));
+    bool tc_run = (XDP_PASS == xdp_opts.retval);
+
+    LIBBPF_OPTS(bpf_test_run_opts, tc_opts,
+        .data_in = xdp_out,
+        .data_size_in = xdp_opts.data_size_out,
+        .data_out = tc_out,
+        .data_size_out = sizeof(tc_out),
+        .ctx_in = &skb,
+        .ctx_size_in = sizeof(skb),
+        .ctx_out = &skb,
+        .ctx_size_out = sizeof(skb),
+        .repeat = 1,
+    );
+
+    if (tc_run) {
+        if (bpf_prog_test_run_opts(ctx->tc_fd, &tc_opts)) {
+            fprintf(stderr, "[ERROR] 第 %llu 个报文 TC test run 失败: %s\n",
+                (unsigned long long)ctx->pkt_num, strerror(errno));
+            return false;
+        }
+        replay_hist_add(&ctx->tc_hist, tc_opts.duration);
+        if (TC_ACT_SHOT == tc_opts.retval) ctx->tc_drop_num++;
+    } else {
+        ctx->xdp_drop_num++;
+    }
+
+    pcap_pkt_info_t in, out;
+    pcap_pkt_parse(pkt, len, &in);
+    pcap_pkt_parse(xdp_out, xdp_opts.data_size_out, &out);
+    if (NULL == in.ip) return true;
+
+    ctx->ipv4_num++;
+    bool rewrite = (NULL != in.ports && NULL != out.ports && in.ports[1] != out.ports[1]);
+    if (rewrite) ctx->rewrite_num++;
+    if (tc_run && skb.mark) ctx->mark_num++;
+
+    if (ctx->quiet) return true;
+
+    char saddr[INET_ADDRSTRLEN], daddr[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &in.ip->saddr, saddr, sizeof(saddr));
+    inet_ntop(AF_INET, &in.ip->daddr, daddr, sizeof(daddr));
+
+    printf("%-8llu %-5s %s:%u -> %s:%u xdp=%s", (unsigned long long)ctx->pkt_num,
+        IPPROTO_UDP == in.ip->protocol ? "udp" : (IPPROTO_TCP == in.ip->protocol ? "tcp" : "ip"),
+        saddr, in.ports ? ntohs(in.ports[0]) : 0, daddr, in.ports ? ntohs(in.ports[1]) : 0,
+        replay_xdp_action_name(xdp_opts.retval));
+
+    if (rewrite) printf(" dport=%u->%u", ntohs(in.ports[1]), ntohs(out.ports[1]));
+    if (tc_run) printf(" tc=%s mark=0x%x", replay_tc_action_name(tc_opts.retval), skb.mark);
+
+    char qname[PCAP_DNS_NAME_MAXLEN];
+    pcap_dns_qname(&in, qname);
+    if (qname[0]) printf(" qname=%s", qname);
+
+    printf(" [%u/%u ns]\n", xdp_opts.duration, tc_run ? tc_opts.duration : 0);
+    return true;
+}
+
+static bool replay_run(replay_ctx_t *ctx) {
+    __u8 pkt[REPLAY_PKT_MAXLEN];
+    __u32 len = 0;
+    __u64 ts = 0;
+    int ret = 0;
+
+    while (1 == (ret = pcap_next(&ctx->pcap, pkt, sizeof(pkt), &len, &ts))) {
+        ctx->pkt_num++;
+        /* test run 要求至少包含以太网头 */
+        if (len < ETH_HLEN) {
+            ctx->skip_num++;
+            continue;
+        }
+
+        if (!replay_packet(ctx, pkt, len)) return false;
+    }
+
+    return 0 == ret;
+}
+
+static void replay_summary(const replay_ctx_t *ctx) {
+    printf("[INFO] 共 %llu 个报文，IPv4 %llu，跳过 %llu (过短或过长)\n", (unsigned long long)ctx->pkt_num,
+        (unsigned long long)ctx->ipv4_num, (unsigned long long)ctx->skip_num);
+    printf("[INFO] 端口改写 %llu，打标 %llu，XDP 未放行 %llu，TC 丢弃 %llu\n", (unsigned long long)ctx->rewrite_num,
+        (unsigned long long)ctx->mark_num, (unsigned long long)ctx->xdp_drop_num, (unsigned long long)ctx->tc_drop_num);
+
+    replay_hist_show("XDP", &ctx->xdp_hist);
+    replay_hist_show("TC", &ctx->tc_hist);
+}
+
+int replay_args_parse(int argc, char **argv) {
+    if (argc < REPLAY_ARGS_MIN_NUM || argc > REPLAY_ARGS_MAX_NUM ||
+        (REPLAY_ARGS_MAX_NUM == argc && strcmp(argv[3], REPLAY_ARGS_QUIET))) {
+        fprintf(stderr, "[ERROR] 参数错误，" REPLAY_PROG_USAGE "\n");
+        return -1;
+    }
+
+    replay_ctx_t *ctx = calloc(1, sizeof(*ctx));
+    if (NULL == ctx) return -1;
+    ctx->quiet = (REPLAY_ARGS_MAX_NUM == argc);
+
+    int ret = -1;
+    struct bpf_object *xdp_obj = NULL, *tc_obj = NULL;
+
+    if (!pcap_open(&ctx->pcap, argv[2])) goto out;
+
+    /* 规则与动作读取线上 map，缓存从线上复制，回放产生的写入只落在副本中 */
+    if (!load_bpf_prog_snapshot(XDP_BPF_OBJ, XDP_BPF_DIR, &xdp_obj, &ctx->xdp_fd)) {
+        fprintf(stderr, "[ERROR] %s 加载失败\n", XDP_BPF_OBJ);
+        goto out;
+    }
+
+    if (!load_bpf_prog_snapshot(TC_BPF_OBJ, TC_BPF_DIR, &tc_obj, &ctx->tc_fd)) {
+        fprintf(stderr, "[ERROR] %s 加载失败\n", TC_BPF_OBJ);
+        goto out;
+    }
+
+    if (!replay_run(ctx)) {
+        fprintf(stderr, "[ERROR] 回放在第 %llu 个报文中止\n", (unsigned long long)ctx->pkt_num);
+    } else {
+        ret = 0;
+    }
+
+    replay_summary(ctx);
+
+out:
+    if (tc_obj && !libbpf_get_error(tc_obj)) bpf_object__close(tc_obj);
+    if (xdp_obj && !libbpf_get_error(xdp_obj)) bpf_object__close(xdp_obj);
+    pcap_close(&ctx->pcap);
+    free(ctx);
+    return ret;
+}
+
+int replay_main(int argc, char **argv) {
+    return replay_args_parse(argc, argv);
+}
@@ -12,8 +12,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <unistd.h>
 
 #include "direct_path_user.h"
+#include "direct_path_ip_set.h"
+#include "direct_path_dir24.h"
+#include "direct_path_keyword.h"
+#include "direct_path_domain_arena.h"
+#include "direct_path_domain_set.h"
+#include "direct_path_rule.h"
+#include "direct_path_bundle.h"
+#include "direct_path_rule_reader.h"
 
 static __always_inline void del_head_space_char(char *line, char **res) {
     if (unlikely(NULL == line || NULL == res)) return ;
@@ -26,6 +35,106 @@ static __always_inline void del_head_space_char(char *line, char **res) {
     return ;
 }
 
+/**
+ * 解析规则行尾可选的动作字段，例如 "DOMAIN-SUFFIX,netflix.com,action=2"
+ * @param line            规则行
+ * @param default_action  规则未指定动作时使用的动作
+ * @param action          输出：动作编号
+ * @return                成功返回 true, 动作编号非法返回 false
+ */
+bool rule_line_action(const char *line, __u32 default_action, __u32 *action) {
+    if (unlikely(NULL == line || NULL == action)) return false;
+
+    *action = default_action;
+
+    const char *tag = strstr(line, RULE_ACTION_TAG);
+    if (NULL == tag) return true;
+
+    char *end = NULL;
+    const char *num = tag + strlen(RULE_ACTION_TAG);
+    unsigned long id = strtoul(num, &end, 10);
+    if (end == num || id >= ACTION_MAX_NUM) {
+        fprintf(stderr, "[ERROR] [%s] 动作编号非法\n", line);
+        return false;
+    }
+
+    *action = (__u32)id;
+    return true;
+}
+
+#if DOMAIN_KEY_PACKED
+/* 按高位在前写入第 i 个符号，位序与 LPM 前缀比较一致 */
+static void domain_key_sym_set(domain_lpm_key_t *key, __u32 i, __u8 sym) {
+    for (__u32 b = 0; b < DOMAIN_SYM_BITS; b++) {
+        __u32 pos = i * DOMAIN_SYM_BITS + b;
+        if ((sym >> (DOMAIN_SYM_BITS - 1 - b)) & 1) key->domain[pos / 8] |= (0x80 >> (pos % 8));
+    }
+}
+#endif
+
+/* 读取 key 中第 i 个符号 */
+static __u8 domain_key_sym_get(const domain_lpm_key_t *key, __u32 i) {
+#if DOMAIN_KEY_PACKED
+    __u8 sym = 0;
+    for (__u32 b = 0; b < DOMAIN_SYM_BITS; b++) {
+        __u32 pos = i * DOMAIN_SYM_BITS + b;
+        sym = (sym << 1) | ((key->domain[pos / 8] >> (7 - pos % 8)) & 1);
+    }
+
+    return sym;
+#else
+    return key->domain[i];
+#endif
+}
+
+__u32 domain_key_syms_get(const domain_lpm_key_t *key, __u8 *syms) {
+    __u32 num = key->prefixlen / DOMAIN_SYM_BITS;
+    if (num > DOMAIN_KEY_MAX_SYMS) num = DOMAIN_KEY_MAX_SYMS;
+
+    for (__u32 i = 0; i < num; i++) syms[i] = domain_key_sym_get(key, i);
+    return num;
+}
+
+#if DOMAIN_KEY_PACKED
+/**
+ * 打包编码并反转数据，每个符号 6 bit，标签长度字节替换为分隔符。
+ * 例如 "baidu.com" -> |baidu|com -> 反转 -> moc|udiab|
+ */
+bool domain_encode_and_reverse(const char *domain, domain_lpm_key_t *key) {
+    __u32 num = 0;
+    char buf[FILE_LINE_MAXLEN] = {0};
+    __u8 syms[DOMAIN_KEY_MAX_SYMS] = {0};
+
+    strncpy(buf, domain, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+
+    char *saveptr = NULL;
+    char *token = strtok_r(buf, DOMAIN_NAME_SEPARATOR, &saveptr);
+    while (token != NULL) {
+        size_t len = strlen(token);
+        if (len == 0 || num + len + 1 > DOMAIN_KEY_MAX_SYMS) return false;
+
+        syms[num++] = DOMAIN_SYM_SEP;
+        for (size_t i = 0; i < len; i++) {
+            __u8 sym = domain_char_to_sym((unsigned char)token[i]);
+            if (DOMAIN_SYM_PAD == sym) return false;
+            syms[num++] = sym;
+        }
+
+        token = strtok_r(NULL, DOMAIN_NAME_SEPARATOR, &saveptr);
+    }
+
+    if (0 == num) return false;
+
+    key->prefixlen = num * DOMAIN_SYM_BITS;
+
+    /* 符号反转后打包填充 */
+    memset(key->domain, 0, DOMAIN_MAX_LEN);
+    for (__u32 i = 0; i < num; i++) domain_key_sym_set(key, i, syms[num - 1 - i]);
+
+    return true;
+}
+#else
 /**
  * DNS 编码并反转数据。
  * 例如 "baidu.com" -> \x05baidu\x03com -> 反转 -> \x6d\x6f\x63\x03\x75\x64\x69\x61\x62\x05
@@ -62,9 +171,110 @@ bool domain_encode_and_reverse(const char *domain, domain_lpm_key_t *key) {
     }
     return true;
 }
+#endif
+
+#if DOMAIN_KEY_PACKED
+static char domain_sym_to_char(__u8 sym) {
+    if (DOMAIN_SYM_SEP == sym) return '.';
+    if (sym >= DOMAIN_SYM_DIGIT && sym < DOMAIN_SYM_DIGIT + 10) return '0' + (sym - DOMAIN_SYM_DIGIT);
+    if (sym >= DOMAIN_SYM_ALPHA && sym < DOMAIN_SYM_ALPHA + 26) return 'a' + (sym - DOMAIN_SYM_ALPHA);
+    if (DOMAIN_SYM_HYPHEN == sym) return '-';
+    if (DOMAIN_SYM_UNDERSCORE == sym) return '_';
+    return '?';
+}
+#endif
+
+/* 将反转后的 LPM key 还原为域名，key 可能来自数据面，按最坏情况校验 */
+bool domain_decode(const domain_lpm_key_t *key, char *name, size_t size) {
+    __u8 syms[DOMAIN_KEY_MAX_SYMS];
+    __u32 num = key->prefixlen / DOMAIN_SYM_BITS;
+    if (0 == size) return false;
+    if (num > DOMAIN_KEY_MAX_SYMS) num = DOMAIN_KEY_MAX_SYMS;
+
+    /* 反转回报文中的顺序 */
+    for (__u32 i = 0; i < num; i++) syms[i] = domain_key_sym_get(key, num - 1 - i);
+
+    size_t len = 0;
+#if DOMAIN_KEY_PACKED
+    /* 首个符号为分隔符 */
+    for (__u32 i = 1; i < num && len + 1 < size; i++) name[len++] = domain_sym_to_char(syms[i]);
+#else
+    /* 按 [长度][内容] 逐个标签还原 */
+    __u32 pos = 0;
+    while (pos < num && syms[pos]) {
+        __u32 label_len = syms[pos++];
+        if (pos + label_len > num || len + label_len + 2 > size) break;
+
+        if (len) name[len++] = '.';
+        memcpy(name + len, syms + pos, label_len);
+        len += label_len;
+        pos += label_len;
+    }
+#endif
 
-bool import_map_domain_by_line(char *line, int map_fd) {
-    if (unlikely(NULL == line || map_fd <= 0)) return false;
+    name[len] = '\0';
+    return len > 0;
+}
+
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_LPM
+/* 写入域名 Bloom 过滤器，元素为反转后规则整体的哈希 */
+static bool domain_bloom_push(int bloom_fd, const domain_lpm_key_t *key) {
+    if (bloom_fd < 0) return true;
+
+    domain_bloom_val_t val = {.len = key->prefixlen / DOMAIN_SYM_BITS, .hash = DOMAIN_BLOOM_FNV_OFFSET};
+    for (__u32 i = 0; i < val.len && i < DOMAIN_KEY_MAX_SYMS; i++) 
+        val.hash = (val.hash ^ domain_key_sym_get(key, i)) * DOMAIN_BLOOM_FNV_PRIME;
+
+    return 0 == bpf_map_update_elem(bloom_fd, NULL, &val, BPF_ANY);
+}
+#endif
+
+/* 写入域名库，先写 Bloom 再批量写 LPM，保证数据面不会因 Bloom 漏判跳过已存在的规则
+ * arena 引擎下规则先暂存，整组导入完成后统一构建双数组 */
+int domain_rule_set_write(int map_fd, int bloom_fd, const domain_rule_set_t *rules) {
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    for (size_t i = 0; i < rules->num; i++) {
+        const domain_lpm_key_t *key = &rules->rules[i].key;
+        __u8 syms[DOMAIN_KEY_MAX_SYMS];
+        __u32 num = domain_key_syms_get(key, syms);
+
+        if (!domain_arena_add(syms, num, rules->rules[i].action)) return -1;
+    }
+
+    return 0;
+#else
+    if (0 == rules->num) return 0;
+
+    for (size_t i = 0; i < rules->num; i++) {
+        if (!domain_bloom_push(bloom_fd, &rules->rules[i].key)) {
+            fprintf(stderr, "[ERROR] [%s] Bloom 写入失败: %s\n", __func__, strerror(errno));
+            return -1;
+        }
+    }
+
+    domain_lpm_key_t *keys = malloc(rules->num * sizeof(domain_lpm_key_t));
+    __u32 *values = malloc(rules->num * sizeof(__u32));
+    if (NULL == keys || NULL == values) {
+        free(keys);
+        free(values);
+        return -1;
+    }
+
+    for (size_t i = 0; i < rules->num; i++) {
+        keys[i] = rules->rules[i].key;
+        values[i] = rules->rules[i].action;
+    }
+
+    int ret = map_update_all(map_fd, keys, sizeof(domain_lpm_key_t), values, sizeof(__u32), rules->num);
+
+    free(keys);
+    free(values);
+    return ret;
+#endif
+}
+
+bool import_map_domain_by_line(char *line, import_rules_t *rules, __u32 default_action) {
+    if (unlikely(NULL == line || NULL == rules)) return false;
 
     /* 去掉前面空白字符 */
     char *start = NULL;
@@ -76,6 +286,11 @@ bool import_map_domain_by_line(char *line, int map_fd) {
         !strstr(start, RULE_DOMAIN_KEYWORD) && 
         !strstr(start, RULE_DOMAIN_SUFFIX)) return false;
 
+    /* 动作字段需要在 strtok 截断规则行之前解析 */
+    uint32_t value = ACTION_DIRECT;
+    if (!rule_line_action(start, default_action, &value)) return false;
+    bool is_keyword = (NULL != strstr(start, RULE_DOMAIN_KEYWORD));
+
     domain_lpm_key_t key;
     key.prefixlen = 24;
     memset(key.domain, 0, sizeof(key.domain));
@@ -84,44 +299,43 @@ bool import_map_domain_by_line(char *line, int map_fd) {
     char *ptr = strchr(start, ',');
     char *target = NULL;
     if (ptr) {
-        target = strtok(ptr + 1, " \t\n\r\"");
+        target = strtok(ptr + 1, ", \t\n\r\"");
     } else {
         ptr = strchr(start, '-');
-        if (ptr) target = strtok(ptr + 1, " \t\n\r\"");
+        if (ptr) target = strtok(ptr + 1, ", \t\n\r\"");
     }
 
     if (!target) return false;
 
+    /* 关键字规则整组写入关键字表后统一编译为自动机 */
+    if (is_keyword) return keyword_set_add(&rules->keyword, target, value);
+
     if (!domain_encode_and_reverse(target, &key)) return false;
 
-    uint32_t value = 1;
-    int ret = bpf_map_update_elem(map_fd, &key, &value, BPF_ANY);
-    if (ret) {
-        fprintf(stderr, "[ERROR] [%s:%d] [%s] import failed: %d\n", __func__, __LINE__, line, ret);
+    /* 后缀规则整组收集，去重剪除后统一写入 */
+    if (!domain_rule_set_add(&rules->domain, &key, value)) {
+        fprintf(stderr, "[ERROR] [%s:%d] [%s] import failed: 内存不足\n", __func__, __LINE__, line);
         return false;
     }
 
     return true;
 }
 
-int import_map_domain(FILE *fp, int map_fd, __u32 *rule_num) {
-    if (unlikely(NULL == fp || map_fd <= 0 || NULL == rule_num)) return -1;
+int import_map_domain(rule_reader_t *reader, import_rules_t *rules, __u32 *rule_num, __u32 default_action) {
+    if (unlikely(NULL == reader || NULL == rules || NULL == rule_num)) return -1;
 
-    /* 特殊处理 .cn */
-    /* 编码为 \x02cn，长度 3 字节，前缀 24 位 */
-    domain_lpm_key_t key;
-
-    key.prefixlen = 24;
-    memset(key.domain, 0, sizeof(key.domain));
-    uint32_t value = 1;
-    key.domain[0] = 'n'; key.domain[1] = 'c'; key.domain[2] = 2;
-
-    bpf_map_update_elem(map_fd, &key, &value, BPF_ANY);
+    /* 特殊处理 .cn，仅国内直连规则组需要 */
+    /* 按当前 key 编码方式生成 cn 顶级域 */
+    if (ACTION_DIRECT == default_action) {
+        domain_lpm_key_t key;
+        memset(&key, 0, sizeof(key));
+        if (domain_encode_and_reverse("cn", &key)) domain_rule_set_add(&rules->domain, &key, ACTION_DIRECT);
+    }
 
     /* 逐行解析规则 */
     char line[FILE_LINE_MAXLEN] = {0};
-    while (fgets(line, sizeof(line), fp)) {
-        if (import_map_domain_by_line(line, map_fd)) (*rule_num)++;
+    while (rule_reader_gets(reader, line, sizeof(line))) {
+        if (import_map_domain_by_line(line, rules, default_action)) (*rule_num)++;
     }
 
     return 0;
@@ -197,10 +411,13 @@ bool parse_cidr_to_lpm_key(char *cidr_raw, ip_lpm_key_t *key) {
     return true;
 }
 
-bool import_map_ip_by_line(char *line, int map_fd) {
-    if (unlikely(NULL == line || map_fd <= 0)) return false;
+bool import_map_ip_by_line(char *line, ip_rule_set_t *rules, __u32 default_action) {
+    if (unlikely(NULL == line || NULL == rules)) return false;
     if (line[0] == RULE_FILE_COMMIT_SEPARATOR) return false;
 
+    uint32_t value = ACTION_DIRECT;
+    if (!rule_line_action(line, default_action, &value)) return false;
+
     char *start_line = strstr(line, RULE_IP);
     if (NULL == start_line) start_line = line;
     else {
@@ -211,110 +428,516 @@ bool import_map_ip_by_line(char *line, int map_fd) {
     ip_lpm_key_t key;
     if (!parse_cidr_to_lpm_key(start_line, &key)) return false;
 
-    uint32_t value = 1;
-    int ret = bpf_map_update_elem(map_fd, &key, &value, BPF_ANY);
-    if (ret) {
-        fprintf(stderr, "[ERROR] [%s] import failed: %d\n", line, ret);
+    if (!ip_rule_set_add(rules, &key, value)) {
+        fprintf(stderr, "[ERROR] [%s] import failed: out of memory\n", line);
         return false;
     }
 
     return true;
 }
 
-int import_map_ip(FILE *fp, int map_fd, __u32 *rule_num) {
-    if (unlikely(NULL == fp || map_fd <= 0 || NULL == rule_num)) return -1;
+int import_map_ip(rule_reader_t *reader, ip_rule_set_t *rules, __u32 *rule_num, __u32 default_action) {
+    if (unlikely(NULL == reader || NULL == rules || NULL == rule_num)) return -1;
 
-    /* 逐行解析规则 */
-    __u32 count = 0;
+    /* 逐行解析规则，先收集，整组规则文件解析完成后统一写入 */
     char line[FILE_LINE_MAXLEN] = {0};
-    while (fgets(line, sizeof(line), fp)) {
-        if (import_map_ip_by_line(line, map_fd)) (*rule_num)++;
+    while (rule_reader_gets(reader, line, sizeof(line))) {
+        if (import_map_ip_by_line(line, rules, default_action)) (*rule_num)++;
     }
 
     return 0;
 }
 
-int import(const char *import_type, const char *map_path, const char *rule_file) {
-    if (unlikely(NULL == import_type || NULL == map_path || NULL == rule_file)) return -1;
+bool map_name_get(int map_fd, char *name, size_t size) {
+    if (unlikely(map_fd < 0 || NULL == name || 0 == size)) return false;
 
-    /* 获取 Map 的文件描述符 (FD) */
+    struct bpf_map_info info;
+    __u32 info_len = sizeof(info);
+    memset(&info, 0, sizeof(info));
+    if (bpf_obj_get_info_by_fd(map_fd, &info, &info_len)) return false;
+
+    strncpy(name, info.name, size - 1);
+    name[size - 1] = '\0';
+
+    return true;
+}
+
+int map_update_all(int map_fd, const void *keys, __u32 key_size, 
+    const void *values, __u32 value_size, size_t num) {
+    if (unlikely(map_fd < 0 || (num > 0 && (NULL == keys || NULL == values)))) return -1;
+
+    struct bpf_map_batch_opts opts = {
+        .sz = sizeof(opts),
+        .elem_flags = BPF_ANY,
+    };
+
+    size_t done = 0;
+    while (done < num) {
+        __u32 count = (num - done > RULE_BATCH_SIZE) ? RULE_BATCH_SIZE : (__u32)(num - done);
+        int ret = bpf_map_update_batch(map_fd, (const char *)keys + done * key_size, 
+            (const char *)values + done * value_size, &count, &opts);
+        /* 失败时 count 为已写入的元素数 */
+        done += count;
+        if (!ret) continue;
+
+        if (EINVAL == errno || EOPNOTSUPP == errno || ENOTSUPP == errno) break;
+
+        fprintf(stderr, "[ERROR] [%s] 批量写入失败: %s\n", __func__, strerror(errno));
+        return -1;
+    }
+
+    for (; done < num; done++) {
+        if (bpf_map_update_elem(map_fd, (const char *)keys + done * key_size, 
+            (const char *)values + done * value_size, BPF_ANY)) {
+            fprintf(stderr, "[ERROR] [%s] 写入失败: %s\n", __func__, strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* 写入 LPM，key 与 value 整理为连续数组后批量写入 */
+static int ip_rule_set_write(int map_fd, const ip_rule_set_t *rules) {
+    if (0 == rules->num) return 0;
+
+    ip_lpm_key_t *keys = malloc(rules->num * sizeof(ip_lpm_key_t));
+    __u32 *values = malloc(rules->num * sizeof(__u32));
+    if (NULL == keys || NULL == values) {
+        free(keys);
+        free(values);
+        return -1;
+    }
+
+    for (size_t i = 0; i < rules->num; i++) {
+        keys[i] = rules->rules[i].key;
+        values[i] = rules->rules[i].action;
+    }
+
+    int ret = map_update_all(map_fd, keys, sizeof(ip_lpm_key_t), values, sizeof(__u32), rules->num);
+
+    free(keys);
+    free(values);
+    return ret;
+}
+
+/* 读取 map 并构造区间集合 */
+static bool ip_range_set_from_map_path(ip_range_set_t *ranges, const char *map_path) {
     int map_fd = bpf_obj_get(map_path);
     if (map_fd < 0) {
         fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", map_path, strerror(errno));
+        return false;
+    }
+
+    ip_rule_set_t rules = {0};
+    bool ret = ip_rule_set_from_map(&rules, map_fd) && ip_range_set_build(ranges, &rules);
+
+    ip_rule_set_free(&rules);
+    close(map_fd);
+
+    return ret;
+}
+
+/* 国内 IP 库写入前扣除黑名单，数据面只需一次 LPM 查询 */
+static int import_ip_apply_direct(int map_fd, ip_rule_set_t *rules) {
+    ip_range_set_t blk = {0};
+    if (!ip_range_set_from_map_path(&blk, BLACKMAP_PIN)) return -1;
+
+    ip_rule_set_t effective = {0};
+    if (!ip_rule_set_subtract(rules, &blk, &effective)) {
+        ip_range_set_free(&blk);
+        return -1;
+    }
+
+    int ret = ip_rule_set_write(map_fd, &effective);
+    printf("[INFO] 国内 IP 规则 %zu 条，扣除黑名单后写入 %zu 条前缀\n", rules->num, effective.num);
+    if (!ret) ret = dir24_rebuild();
+
+    /* 写入成功后以实际写入的前缀替换规则，调用方据此记录 map 中的 key */
+    if (!ret) {
+        ip_rule_set_free(rules);
+        *rules = effective;
+        memset(&effective, 0, sizeof(effective));
+    }
+
+    ip_rule_set_free(&effective);
+    ip_range_set_free(&blk);
+
+    return ret;
+}
+
+void cache_purge_range(const char *map_path, const ip_range_set_t *ranges, const char *what) {
+    int map_fd = bpf_obj_get(map_path);
+    if (map_fd < 0) return ;
+
+    __u32 num = 0;
+    __u32 cap = 0;
+    __u32 *stale = NULL;
+    __u32 key = 0, next = 0;
+    void *prev = NULL;
+
+    /* 遍历过程中删除会打乱迭代顺序，先收集再删除 */
+    while (0 == bpf_map_get_next_key(map_fd, prev, &next)) {
+        if (ip_range_set_contains(ranges, ntohl(next))) {
+            if (num == cap) {
+                cap = cap ? cap * 2 : IP_RULE_SET_INIT_CAP;
+                __u32 *tmp = realloc(stale, cap * sizeof(__u32));
+                if (NULL == tmp) break;
+                stale = tmp;
+            }
+            stale[num++] = next;
+        }
+
+        key = next;
+        prev = &key;
+    }
+
+    for (__u32 i = 0; i < num; i++) bpf_map_delete_elem(map_fd, &stale[i]);
+    if (num) printf("[INFO] %s 清理%s地址 %u 个\n", map_path, what, num);
+
+    free(stale);
+    close(map_fd);
+}
+
+/* 写入黑名单 Bloom 过滤器，并记录出现过的前缀长度，须在写入黑名单 LPM 之前完成 */
+static int blklist_bloom_write(const ip_rule_set_t *rules) {
+    int bloom_fd = bpf_obj_get(BLKLISTBLOOM_PIN);
+    int config_fd = bpf_obj_get(TCCONFIG_PIN);
+    if (bloom_fd < 0 || config_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取黑名单 Bloom 相关 BPF Map: %s\n", strerror(errno));
+        if (bloom_fd >= 0) close(bloom_fd);
+        if (config_fd >= 0) close(config_fd);
         return -1;
     }
 
-    FILE *fp = fopen(rule_file, "r");
-    if (!fp) {
-        perror("[ERROR] 无法打开规则文件");
+    __u32 zero = 0;
+    tc_config_t cfg = {0};
+    bpf_map_lookup_elem(config_fd, &zero, &cfg);
+
+    int ret = 0;
+    for (size_t i = 0; i < rules->num; i++) {
+        ret = bpf_map_update_elem(bloom_fd, NULL, &rules->rules[i].key, BPF_ANY);
+        if (ret) {
+            fprintf(stderr, "[ERROR] [%s] Bloom 写入失败: %s\n", __func__, strerror(errno));
+            goto out;
+        }
+
+        cfg.blk_prefix_mask |= 1ULL << rules->rules[i].key.prefixlen;
+    }
+
+    ret = bpf_map_update_elem(config_fd, &zero, &cfg, BPF_ANY);
+
+out:
+    close(bloom_fd);
+    close(config_fd);
+
+    return ret;
+}
+
+/* 黑名单更新后，从国内 IP 库中扣除新的黑名单，并清理缓存 */
+static int import_ip_apply_blklist(int map_fd, ip_rule_set_t *rules) {
+    int ret = blklist_bloom_write(rules);
+    if (ret) return ret;
+
+    ret = ip_rule_set_write(map_fd, rules);
+    if (ret) return ret;
+
+    ip_range_set_t blk = {0};
+    if (!ip_range_set_from_map_path(&blk, BLACKMAP_PIN)) return -1;
+
+    int direct_fd = bpf_obj_get(DIRECTMAP_PIN);
+    if (direct_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", DIRECTMAP_PIN, strerror(errno));
+        ip_range_set_free(&blk);
         return -1;
     }
 
+    ip_rule_set_t current = {0};
+    ip_rule_set_t effective = {0};
+    if (!ip_rule_set_from_map(&current, direct_fd) || 
+        !ip_rule_set_subtract(&current, &blk, &effective)) {
+        ret = -1;
+        goto out;
+    }
+
+    /* 两个集合均已按 key 排序，删除不再生效的前缀 */
+    ip_rule_set_dedup(&current);
+    size_t j = 0;
+    __u32 removed = 0;
+    for (size_t i = 0; i < current.num; i++) {
+        const ip_lpm_key_t *k = &current.rules[i].key;
+        while (j < effective.num && 
+            (ntohl(effective.rules[j].key.ipv4) < ntohl(k->ipv4) ||
+            (effective.rules[j].key.ipv4 == k->ipv4 && effective.rules[j].key.prefixlen < k->prefixlen))) j++;
+
+        if (j < effective.num && 
+            effective.rules[j].key.ipv4 == k->ipv4 && 
+            effective.rules[j].key.prefixlen == k->prefixlen) continue;
+
+        bpf_map_delete_elem(direct_fd, k);
+        removed++;
+    }
+
+    ret = ip_rule_set_write(direct_fd, &effective);
+    printf("[INFO] 国内 IP 库扣除黑名单: 移除 %u 条前缀，当前 %zu 条\n", removed, effective.num);
+    if (!ret) ret = dir24_rebuild();
+
+    cache_purge_range(HOTPATHMAP_PIN, &blk, "黑名单");
+    cache_purge_range(PREMAP_PIN, &blk, "黑名单");
+
+out:
+    ip_rule_set_free(&effective);
+    ip_rule_set_free(&current);
+    ip_range_set_free(&blk);
+    close(direct_fd);
+
+    return ret;
+}
+
+int import_ip_apply(int map_fd, ip_rule_set_t *rules) {
+    if (unlikely(map_fd < 0 || NULL == rules)) return -1;
+
+    char name[BPF_OBJ_NAME_LEN] = {0};
+    if (!map_name_get(map_fd, name, sizeof(name))) return -1;
+
+    if (!strcmp(name, DIRECT_MAPNAME)) return import_ip_apply_direct(map_fd, rules);
+    if (!strcmp(name, BLKLIST_MAPNAME)) return import_ip_apply_blklist(map_fd, rules);
+
+    return ip_rule_set_write(map_fd, rules);
+}
+
+int import(const char *import_type, const char *rule_file, __u32 default_action, import_rules_t *rules) {
+    if (unlikely(NULL == import_type || NULL == rule_file || NULL == rules)) return -1;
+
+    /* 文本、gzip 与 zstd 规则文件均按行流式解析，不在内存中展开整个文件 */
+    rule_reader_t reader;
+    if (!rule_reader_open(&reader, rule_file)) return -1;
+
     int ret = 0;
     __u32 rule_num = 0;
     if (!strcmp(import_type, IMPORT_TYPE_DOMAIN)) 
-        ret = import_map_domain(fp, map_fd, &rule_num);
+        ret = import_map_domain(&reader, rules, &rule_num, default_action);
     else if (!strcmp(import_type, IMPORT_TYPE_IP)) 
-        ret = import_map_ip(fp, map_fd, &rule_num);
+        ret = import_map_ip(&reader, &rules->ip, &rule_num, default_action);
 
-    if (fp != NULL) fclose(fp);
+    if (reader.error) ret = -1;
+    rule_reader_close(&reader);
 
     printf("%s 注入完成！共处理 %d 条规则\n", rule_file, rule_num);
 
     return ret;
 }
 
-int import_args_parse(int argc, char **argv) {
-    if (argc < IMPORT_ARGS_MIN_VALID_NUM) 
-        return import(IMPORT_TYPE_DOMAIN, IMPORT_DEFULE_MAP, IMPORT_DEFAULT_RULE_FILE);
+/* 整组域名规则去重，剪除被更短后缀以相同动作覆盖的规则后写入 */
+static int import_domain_apply(int map_fd, int bloom_fd, domain_rule_set_t *rules) {
+    size_t total = rules->num, dup = 0, shadowed = 0;
+    domain_rule_set_prune(rules, &dup, &shadowed);
+
+    if (domain_rule_set_write(map_fd, bloom_fd, rules)) {
+        fprintf(stderr, "[ERROR] [%s] 域名规则写入失败\n", __func__);
+        return -1;
+    }
+
+    printf("[INFO] 域名规则 %zu 条: 重复 %zu 条，被更短后缀覆盖 %zu 条，写入 %zu 条\n", 
+        total, dup, shadowed, rules->num);
+
+    return 0;
+}
+
+/* 写入关键字表后重新编译自动机 */
+static int import_keyword_apply(const keyword_set_t *keywords) {
+    int keyword_fd = bpf_obj_get(KEYWORDMAP_PIN);
+    if (keyword_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", KEYWORDMAP_PIN, strerror(errno));
+        return -1;
+    }
+
+    int ret = map_update_all(keyword_fd, keywords->keys, sizeof(keyword_key_t), 
+        keywords->actions, sizeof(__u32), keywords->num);
+    close(keyword_fd);
+    if (ret) return ret;
+
+    return keyword_rebuild();
+}
+
+void import_rules_free(import_rules_t *rules) {
+    if (unlikely(NULL == rules)) return ;
+
+    ip_rule_set_free(&rules->ip);
+    domain_rule_set_free(&rules->domain);
+    keyword_set_free(&rules->keyword);
+}
+
+int import_rules_collect(const char *import_type, char **rule_files, 
+    __u32 rule_file_num, __u32 default_action, import_rules_t *rules) {
+    if (unlikely(NULL == import_type || NULL == rule_files || NULL == rules)) return -1;
 
-    for (int i = 2; i < argc; i++) {
+    for (__u32 i = 0; i < rule_file_num; i++) {
+        if (NULL == rule_files[i]) {
+            perror("[ERROR] 参数错误 rule file NULL，" EXPORT_PROG_USAGE);
+            return -1;
+        }
+
+        int ret = import(import_type, rule_files[i], default_action, rules);
+        if (ret) return ret;
+    }
+
+    return 0;
+}
+
+int import_rules_apply(const char *import_type, const char *map_path, import_rules_t *rules) {
+    if (unlikely(NULL == import_type || NULL == map_path || NULL == rules)) return -1;
+
+    /* 获取 Map 的文件描述符 (FD) */
+    int map_fd = bpf_obj_get(map_path);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", map_path, strerror(errno));
+        return -1;
+    }
+
+    /* 导入域名库时同步写入 Bloom 过滤器与关键字表 */
+    int bloom_fd = -1;
+    char name[BPF_OBJ_NAME_LEN] = {0};
+    bool is_domain_map = map_name_get(map_fd, name, sizeof(name)) && !strcmp(name, DOMAIN_MAPNAME);
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_LPM
+    if (is_domain_map) {
+        bloom_fd = bpf_obj_get(DOMAINBLOOM_PIN);
+        if (bloom_fd < 0) {
+            fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", DOMAINBLOOM_PIN, strerror(errno));
+            close(map_fd);
+            return -1;
+        }
+    }
+#endif
+
+    int ret = 0;
+    if (!strcmp(import_type, IMPORT_TYPE_IP)) ret = import_ip_apply(map_fd, &rules->ip);
+    if (!ret && !strcmp(import_type, IMPORT_TYPE_DOMAIN)) ret = import_domain_apply(map_fd, bloom_fd, &rules->domain);
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    if (!ret && is_domain_map) ret = domain_arena_commit();
+#endif
+    if (!ret && is_domain_map) ret = import_keyword_apply(&rules->keyword);
+
+    if (bloom_fd >= 0) close(bloom_fd);
+    close(map_fd);
+
+    return ret;
+}
+
+/* 导入一组规则文件，整组收集后统一写入 */
+int import_group(const char *import_type, const char *map_path, 
+    char **rule_files, __u32 rule_file_num, __u32 default_action) {
+    if (unlikely(NULL == import_type || NULL == map_path || NULL == rule_files)) return -1;
+
+    import_rules_t rules;
+    memset(&rules, 0, sizeof(rules));
+
+    int ret = import_rules_collect(import_type, rule_files, rule_file_num, default_action, &rules);
+    if (!ret) ret = import_rules_apply(import_type, map_path, &rules);
+
+    import_rules_free(&rules);
+
+    return ret;
+}
+
+/**
+ * 解析导入类型及可选的默认动作，例如 "domain"、"ip@2"
+ * @param arg             命令行参数
+ * @param import_type     输出：导入类型
+ * @param size            import_type 缓冲区大小
+ * @param default_action  输出：该组规则文件的默认动作
+ * @return                成功返回 true, 失败返回 false
+ */
+bool import_type_parse(const char *arg, char *import_type, size_t size, __u32 *default_action) {
+    if (unlikely(NULL == arg || NULL == import_type || NULL == default_action)) return false;
+
+    strncpy(import_type, arg, size - 1);
+    import_type[size - 1] = '\0';
+    *default_action = ACTION_DIRECT;
+
+    char *sep = strchr(import_type, IMPORT_TYPE_ACTION_SEPARATOR);
+    if (sep) {
+        *sep = '\0';
+
+        char *end = NULL;
+        unsigned long id = strtoul(sep + 1, &end, 10);
+        if (end == sep + 1 || *end != '\0' || id >= ACTION_MAX_NUM) return false;
+        *default_action = (__u32)id;
+    }
+
+    if (strcmp(import_type, IMPORT_TYPE_DOMAIN) &&
+        strcmp(import_type, IMPORT_TYPE_IP)) return false;
+
+    return true;
+}
+
+int rule_groups_foreach(int argc, char **argv, int start, rule_group_fn fn, void *ctx) {
+    if (unlikely(NULL == argv || NULL == fn)) return -1;
+
+    for (int i = start; i < argc; i++) {
         const char *map_path = argv[i++];
         if (NULL == map_path) {
             perror("[ERROR] 参数错误 map_path，" EXPORT_PROG_USAGE);
             return -1;
         }
 
-        const char *import_type = argv[i++];
-        if (NULL == import_type) {
+        const char *import_type_arg = (i < argc) ? argv[i++] : NULL;
+        if (NULL == import_type_arg) {
             perror("[ERROR] 参数错误 import_type NULL，" EXPORT_PROG_USAGE);
             return -1;
         }
 
-        if (strcmp(import_type, IMPORT_TYPE_DOMAIN) &&
-            strcmp(import_type, IMPORT_TYPE_IP)) {
+        __u32 default_action = ACTION_DIRECT;
+        char import_type[IMPORT_TYPE_MAX_LEN] = {0};
+        if (!import_type_parse(import_type_arg, import_type, sizeof(import_type), &default_action)) {
             fprintf(stderr, 
                 "[ERROR] 参数错误 import_type argv[%d] = [%s]，"
-                EXPORT_PROG_USAGE, i, import_type);
+                EXPORT_PROG_USAGE, i, import_type_arg);
             return -1;
         }
 
-        __u32 rule_file_num = atoi(argv[i++]);
+        __u32 rule_file_num = (i < argc) ? atoi(argv[i++]) : 0;
         if (!rule_file_num) {
             perror("[ERROR] 参数错误 rule file num，" EXPORT_PROG_USAGE);
             return -1;
         }
 
-        for (int j = i; j < i + rule_file_num; j++) {
-            const char *rule_file = argv[j];
-            if (NULL == rule_file) {
-                perror("[ERROR] 参数错误 rule file NULL，" EXPORT_PROG_USAGE);
-                return -1;
-            }
-
-            int ret = import(import_type, map_path, rule_file);
-            if (ret) {
-                fprintf(stderr, "[ERROR] import error: %d, import done\n", ret);
-                return ret;
-            }
+        if (i + rule_file_num > argc) {
+            fprintf(stderr, "[ERROR] 参数错误 rule file num，" EXPORT_PROG_USAGE "\n");
+            return -1;
         }
 
+        int ret = fn(import_type, map_path, &argv[i], rule_file_num, default_action, ctx);
+        if (ret) return ret;
+
         i += rule_file_num - 1;
     }
 
     return 0;
 }
 
+static int import_group_fn(const char *import_type, const char *map_path, 
+    char **rule_files, __u32 rule_file_num, __u32 default_action, void *ctx) {
+    (void)ctx;
+
+    int ret = import_group(import_type, map_path, rule_files, rule_file_num, default_action);
+    if (ret) fprintf(stderr, "[ERROR] import error: %d, import done\n", ret);
+
+    return ret;
+}
+
+int import_args_parse(int argc, char **argv) {
+    if (argc < IMPORT_ARGS_MIN_VALID_NUM) {
+        char *default_rule_file = IMPORT_DEFAULT_RULE_FILE;
+        return import_group(IMPORT_TYPE_DOMAIN, IMPORT_DEFULE_MAP, &default_rule_file, 1, ACTION_DIRECT);
+    }
+
+    return rule_groups_foreach(argc, argv, 2, import_group_fn, NULL);
+}
+
 int rule_main(int argc, char **argv) {
+    if (argc > 2 && !strcmp(argv[2], RULE_ARGS_COMPILE)) return bundle_compile_args_parse(argc, argv);
+    if (argc > 2 && !strcmp(argv[2], RULE_ARGS_LOAD_BUNDLE)) return bundle_load_args_parse(argc, argv);
+
     return import_args_parse(argc, argv);
 }
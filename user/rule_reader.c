@@ -0,0 +1,173 @@
+/*
+ * File     : rule_reader.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-30 10:20:05
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule_reader.h"
+
+/* 读取文件起始的魔数识别格式 */
+static bool rule_reader_detect(const char *path, __u32 *format) {
+    FILE *fp = fopen(path, "rb");
+    if (NULL == fp) return false;
+
+    unsigned char magic[4] = {0};
+    size_t n = fread(magic, 1, sizeof(magic), fp);
+    fclose(fp);
+
+    *format = RULE_FORMAT_TEXT;
+    if (n >= 2 && 0x1f == magic[0] && 0x8b == magic[1]) *format = RULE_FORMAT_GZIP;
+    if (n == 4 && RULE_READER_ZSTD_MAGIC == ((__u32)magic[0] | (__u32)magic[1] << 8 |
+        (__u32)magic[2] << 16 | (__u32)magic[3] << 24)) *format = RULE_FORMAT_ZSTD;
+
+    return true;
+}
+
+#ifdef HAVE_ZSTD
+static bool rule_reader_zstd_open(rule_reader_t *reader, const char *path) {
+    reader->fp = fopen(path, "rb");
+    reader->zds = ZSTD_createDStream();
+    reader->in_cap = ZSTD_DStreamInSize();
+    reader->out_cap = ZSTD_DStreamOutSize();
+    reader->in_buf = malloc(reader->in_cap);
+    reader->out_buf = malloc(reader->out_cap);
+    if (NULL == reader->fp || NULL == reader->zds || NULL == reader->in_buf || NULL == reader->out_buf) return false;
+
+    ZSTD_initDStream(reader->zds);
+    reader->in.src = reader->in_buf;
+
+    return true;
+}
+
+/* 解压出下一块数据，输入读完且解码器中没有剩余输出时返回 false */
+static bool rule_reader_zstd_fill(rule_reader_t *reader) {
+    while (true) {
+        /* 输入读完后仍以空输入继续调用，取出上次输出缓冲区写满时留在解码器中的数据 */
+        if (reader->in.pos == reader->in.size && !reader->in_eof) {
+            reader->in.size = fread(reader->in_buf, 1, reader->in_cap, reader->fp);
+            reader->in.pos = 0;
+            if (reader->in.size < reader->in_cap) reader->in_eof = true;
+        }
+
+        size_t in_pos = reader->in.pos;
+        ZSTD_outBuffer out = { reader->out_buf, reader->out_cap, 0 };
+        size_t ret = ZSTD_decompressStream(reader->zds, &out, &reader->in);
+        if (ZSTD_isError(ret)) {
+            fprintf(stderr, "[ERROR] zstd 解压失败: %s\n", ZSTD_getErrorName(ret));
+            reader->error = true;
+            return false;
+        }
+
+        reader->out_pos = 0;
+        reader->out_len = out.pos;
+        if (out.pos > 0) return true;
+        if (reader->in_eof && reader->in.pos == reader->in.size && reader->in.pos == in_pos) {
+            /* 没有任何进展且返回非 0，表示最后一帧未结束，文件被截断 */
+            if (0 != ret) {
+                fprintf(stderr, "[ERROR] zstd 规则文件不完整\n");
+                reader->error = true;
+            }
+
+            return false;
+        }
+    }
+}
+
+static char *rule_reader_zstd_gets(rule_reader_t *reader, char *buf, int len) {
+    int n = 0;
+    while (n < len - 1) {
+        if (reader->out_pos == reader->out_len && !rule_reader_zstd_fill(reader)) break;
+
+        size_t avail = reader->out_len - reader->out_pos;
+        if (avail > (size_t)(len - 1 - n)) avail = len - 1 - n;
+
+        const unsigned char *src = reader->out_buf + reader->out_pos;
+        const unsigned char *nl = memchr(src, '\n', avail);
+        if (NULL != nl) avail = nl - src + 1;
+
+        memcpy(buf + n, src, avail);
+        reader->out_pos += avail;
+        n += avail;
+        if (NULL != nl) break;
+    }
+
+    if (0 == n) return NULL;
+
+    buf[n] = '\0';
+    return buf;
+}
+#endif
+
+bool rule_reader_open(rule_reader_t *reader, const char *path) {
+    if (unlikely(NULL == reader || NULL == path)) return false;
+
+    memset(reader, 0, sizeof(*reader));
+    if (!rule_reader_detect(path, &reader->format)) {
+        fprintf(stderr, "[ERROR] 无法打开规则文件 %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if (RULE_FORMAT_ZSTD == reader->format) {
+#ifdef HAVE_ZSTD
+        if (rule_reader_zstd_open(reader, path)) return true;
+
+        fprintf(stderr, "[ERROR] 无法打开 zstd 规则文件 %s\n", path);
+        rule_reader_close(reader);
+#else
+        fprintf(stderr, "[ERROR] %s 为 zstd 格式，编译时未开启 RULE_ZSTD\n", path);
+#endif
+        return false;
+    }
+
+    reader->gz = gzopen(path, "rb");
+    if (NULL == reader->gz) {
+        fprintf(stderr, "[ERROR] 无法打开规则文件 %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    gzbuffer(reader->gz, RULE_READER_BUF_SIZE);
+
+    return true;
+}
+
+char *rule_reader_gets(rule_reader_t *reader, char *buf, int len) {
+    if (unlikely(NULL == reader || NULL == buf || len <= 1)) return NULL;
+
+#ifdef HAVE_ZSTD
+    if (RULE_FORMAT_ZSTD == reader->format) return rule_reader_zstd_gets(reader, buf, len);
+#endif
+
+    char *line = gzgets(reader->gz, buf, len);
+    if (NULL == line) {
+        int err = Z_OK;
+        const char *msg = gzerror(reader->gz, &err);
+        if (Z_OK != err && Z_STREAM_END != err) {
+            fprintf(stderr, "[ERROR] gzip 解压失败: %s\n", msg);
+            reader->error = true;
+        }
+    }
+
+    return line;
+}
+
+void rule_reader_close(rule_reader_t *reader) {
+    if (unlikely(NULL == reader)) return ;
+
+    if (NULL != reader->gz) gzclose(reader->gz);
+#ifdef HAVE_ZSTD
+    if (NULL != reader->fp) fclose(reader->fp);
+    if (NULL != reader->zds) ZSTD_freeDStream(reader->zds);
+    free(reader->in_buf);
+    free(reader->out_buf);
+#endif
+
+    memset(reader, 0, sizeof(*reader));
+}
@@ -0,0 +1,628 @@
+/*
+ * File     : sim.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-15 21:26:14
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/if_ether.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+#include "direct_path_config.h"
+#include "direct_path_pcap.h"
+#include "direct_path_sim.h"
+#include "direct_path_domain_arena.h"
+
+#define SIM_NIL                         0xFFFFFFFFU
+#define SIM_DNS_PORT                    53
+#define SIM_NSEC_PER_SEC                1000000000ULL
+#define SIM_NSEC_PER_MSEC               1000000ULL
+
+/* 一个不同的外部地址或域名，action 为规则库的查询结果 */
+typedef struct {
+    __u32 type;
+    __u32 action;
+    __u32 ip;
+    domain_lpm_key_t *domain;
+} sim_key_t;
+
+typedef struct {
+    __u64 ts;
+    __u32 id;
+} sim_event_t;
+
+typedef struct {
+    sim_key_t *keys;
+    size_t key_num;
+    size_t key_cap;
+
+    /* 开放寻址索引，保存 id + 1，0 为空 */
+    __u32 *index;
+    size_t index_cap;
+
+    sim_event_t *events;
+    size_t event_num;
+    size_t event_cap;
+
+    __u64 ip_events;
+    __u64 domain_events;
+    __u64 invalid;
+
+    int ip_fd;
+    int domain_fd;
+    /* arena 引擎下域名规则在双数组中，domain_map 为空 */
+    domain_dat_t domain_dat;
+} sim_trace_t;
+
+/* 以 key id 为下标的严格 LRU */
+typedef struct {
+    __u32 cap;
+    __u32 num;
+    __u32 head;
+    __u32 tail;
+    __u32 *prev;
+    __u32 *next;
+    __u8 *present;
+    __u64 evict;
+} sim_lru_t;
+
+/* 一个参数的扫描取值 */
+typedef struct {
+    const char *key;
+    __u32 values[SIM_SWEEP_MAX_NUM];
+    __u32 num;
+} sim_sweep_t;
+
+enum {
+    SIM_SWEEP_HOTPATH = 0,
+    SIM_SWEEP_PRE,
+    SIM_SWEEP_HOTPKG_NUM,
+    SIM_SWEEP_HOTPKG_INV,
+    SIM_SWEEP_DOMAIN,
+    SIM_SWEEP_NUM,
+};
+
+typedef struct {
+    __u64 pkts;
+    __u64 hot_hit;
+    __u64 pre_hit;
+    __u64 lookup;
+    __u64 promote;
+    __u64 hot_evict;
+    __u64 pre_evict;
+} sim_ip_result_t;
+
+typedef struct {
+    __u64 queries;
+    __u64 hit;
+    __u64 lookup;
+    __u64 evict;
+} sim_domain_result_t;
+
+static bool sim_is_private(__u32 ip) {
+    __u32 addr = ntohl(ip);
+    return (addr & 0xFF000000) == 0x7F000000 || (addr & 0xFF000000) == 0x0A000000 ||
+        (addr & 0xFFF00000) == 0xAC100000 || (addr & 0xFFFF0000) == 0xC0A80000;
+}
+
+static __u64 sim_key_hash(__u32 type, __u32 ip, const domain_lpm_key_t *domain) {
+    const __u8 *data = (const __u8 *)&ip;
+    size_t len = sizeof(ip);
+    if (SIM_EVENT_DOMAIN == type) {
+        data = (const __u8 *)domain;
+        len = sizeof(*domain);
+    }
+
+    __u64 hash = 0xcbf29ce484222325ULL ^ type;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static bool sim_key_equal(const sim_key_t *key, __u32 type, __u32 ip, const domain_lpm_key_t *domain) {
+    if (key->type != type) return false;
+    if (SIM_EVENT_IP == type) return key->ip == ip;
+    return 0 == memcmp(key->domain, domain, sizeof(*domain));
+}
+
+static bool sim_index_grow(sim_trace_t *trace) {
+    size_t cap = trace->index_cap ? trace->index_cap * 2 : SIM_INIT_CAP;
+    __u32 *index = calloc(cap, sizeof(*index));
+    if (NULL == index) return false;
+
+    for (size_t id = 0; id < trace->key_num; id++) {
+        const sim_key_t *key = &trace->keys[id];
+        size_t pos = sim_key_hash(key->type, key->ip, key->domain) & (cap - 1);
+        while (index[pos]) pos = (pos + 1) & (cap - 1);
+        index[pos] = id + 1;
+    }
+
+    free(trace->index);
+    trace->index = index;
+    trace->index_cap = cap;
+    return true;
+}
+
+/* 查询规则库得出动作，与数据面未命中缓存时的结果一致 (不含 DOMAIN-KEYWORD) */
+static __u32 sim_rule_lookup(const sim_trace_t *trace, __u32 type, __u32 ip, const domain_lpm_key_t *domain) {
+    __u32 action = ACTION_NONE;
+
+    if (SIM_EVENT_IP == type) {
+        ip_lpm_key_t key = {.prefixlen = 32, .ipv4 = ip};
+        if (bpf_map_lookup_elem(trace->ip_fd, &key, &action)) return ACTION_NONE;
+    } else {
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+        __u8 syms[DOMAIN_KEY_MAX_SYMS];
+        __u32 num = domain_key_syms_get(domain, syms);
+        action = domain_dat_lookup(&trace->domain_dat, syms, num);
+#else
+        if (bpf_map_lookup_elem(trace->domain_fd, domain, &action)) return ACTION_NONE;
+#endif
+    }
+
+    return action;
+}
+
+/* 返回 key id，首次出现时查询规则库，失败返回 SIM_NIL */
+static __u32 sim_key_intern(sim_trace_t *trace, __u32 type, __u32 ip, const domain_lpm_key_t *domain) {
+    if ((trace->key_num + 1) * 2 > trace->index_cap && !sim_index_grow(trace)) return SIM_NIL;
+
+    size_t pos = sim_key_hash(type, ip, domain) & (trace->index_cap - 1);
+    while (trace->index[pos]) {
+        __u32 id = trace->index[pos] - 1;
+        if (sim_key_equal(&trace->keys[id], type, ip, domain)) return id;
+        pos = (pos + 1) & (trace->index_cap - 1);
+    }
+
+    if (trace->key_num == trace->key_cap) {
+        size_t cap = trace->key_cap ? trace->key_cap * 2 : SIM_INIT_CAP;
+        sim_key_t *keys = realloc(trace->keys, cap * sizeof(*keys));
+        if (NULL == keys) return SIM_NIL;
+        trace->keys = keys;
+        trace->key_cap = cap;
+    }
+
+    sim_key_t *key = &trace->keys[trace->key_num];
+    memset(key, 0, sizeof(*key));
+    key->type = type;
+    key->ip = ip;
+    if (SIM_EVENT_DOMAIN == type) {
+        key->domain = malloc(sizeof(*domain));
+        if (NULL == key->domain) return SIM_NIL;
+        memcpy(key->domain, domain, sizeof(*domain));
+    }
+    key->action = sim_rule_lookup(trace, type, ip, domain);
+
+    trace->index[pos] = trace->key_num + 1;
+    return trace->key_num++;
+}
+
+static bool sim_event_add(sim_trace_t *trace, __u64 ts, __u32 type, __u32 ip, const domain_lpm_key_t *domain) {
+    __u32 id = sim_key_intern(trace, type, ip, domain);
+    if (SIM_NIL == id) return false;
+
+    if (trace->event_num == trace->event_cap) {
+        size_t cap = trace->event_cap ? trace->event_cap * 2 : SIM_INIT_CAP;
+        sim_event_t *events = realloc(trace->events, cap * sizeof(*events));
+        if (NULL == events) return false;
+        trace->events = events;
+        trace->event_cap = cap;
+    }
+
+    trace->events[trace->event_num].ts = ts;
+    trace->events[trace->event_num].id = id;
+    trace->event_num++;
+
+    if (SIM_EVENT_IP == type) trace->ip_events++;
+    else trace->domain_events++;
+
+    return true;
+}
+
+static bool sim_domain_event_add(sim_trace_t *trace, __u64 ts, const char *name) {
+    domain_lpm_key_t key;
+    memset(&key, 0, sizeof(key));
+    if (!domain_encode_and_reverse(name, &key)) {
+        trace->invalid++;
+        return true;
+    }
+
+    return sim_event_add(trace, ts, SIM_EVENT_DOMAIN, 0, &key);
+}
+
+/* 与数据面相同的筛选: 私网客户端发出的 UDP DNS 查询经 XDP，外部地址发往私网的报文经 TC 查询源地址 */
+static bool sim_load_pcap(sim_trace_t *trace, const char *file) {
+    pcap_reader_t *reader = calloc(1, sizeof(*reader));
+    __u8 *pkt = malloc(PCAP_REC_MAXLEN + ETH_HLEN);
+    bool ret = false;
+    if (NULL == reader || NULL == pkt) goto out;
+    if (!pcap_open(reader, file)) goto out;
+
+    __u32 len = 0;
+    __u64 ts = 0;
+    int next = 0;
+    while (1 == (next = pcap_next(reader, pkt, PCAP_REC_MAXLEN + ETH_HLEN, &len, &ts))) {
+        pcap_pkt_info_t info;
+        pcap_pkt_parse(pkt, len, &info);
+        if (NULL == info.ip) continue;
+
+        if (NULL != info.ports && IPPROTO_UDP == info.ip->protocol &&
+            htons(SIM_DNS_PORT) == info.ports[1] && sim_is_private(info.ip->saddr)) {
+            char name[PCAP_DNS_NAME_MAXLEN];
+            pcap_dns_qname(&info, name);
+            if ('\0' == name[0]) trace->invalid++;
+            else if (!sim_domain_event_add(trace, ts, name)) goto out;
+            continue;
+        }
+
+        if (!sim_is_private(info.ip->daddr) || sim_is_private(info.ip->saddr)) continue;
+        if (!sim_event_add(trace, ts, SIM_EVENT_IP, info.ip->saddr, NULL)) goto out;
+    }
+
+    ret = (0 == next);
+
+out:
+    if (reader) pcap_close(reader);
+    free(reader);
+    free(pkt);
+    return ret;
+}
+
+static bool sim_load_log(sim_trace_t *trace, const char *file) {
+    FILE *fp = fopen(file, "r");
+    if (NULL == fp) {
+        fprintf(stderr, "[ERROR] 无法打开 %s: %s\n", file, strerror(errno));
+        return false;
+    }
+
+    bool ret = true;
+    char line[FILE_LINE_MAXLEN];
+    while (ret && fgets(line, sizeof(line), fp)) {
+        char *comment = strchr(line, SIM_LOG_COMMENT);
+        if (NULL != comment) *comment = '\0';
+
+        char *saveptr = NULL;
+        char *ts_str = strtok_r(line, " \t\r\n", &saveptr);
+        char *target = strtok_r(NULL, " \t\r\n", &saveptr);
+        if (NULL == ts_str) continue;
+
+        char *end = NULL;
+        double sec = strtod(ts_str, &end);
+        if (NULL == target || '\0' != *end || sec < 0) {
+            trace->invalid++;
+            continue;
+        }
+
+        __u64 ts = (__u64)(sec * SIM_NSEC_PER_SEC);
+        __u32 ip = 0;
+        if (1 == inet_pton(AF_INET, target, &ip)) {
+            if (sim_is_private(ip)) continue;
+            ret = sim_event_add(trace, ts, SIM_EVENT_IP, ip, NULL);
+        } else {
+            ret = sim_domain_event_add(trace, ts, target);
+        }
+    }
+
+    fclose(fp);
+    return ret;
+}
+
+static bool sim_lru_init(sim_lru_t *lru, size_t num) {
+    memset(lru, 0, sizeof(*lru));
+    lru->prev = calloc(num ? num : 1, sizeof(*lru->prev));
+    lru->next = calloc(num ? num : 1, sizeof(*lru->next));
+    lru->present = calloc(num ? num : 1, sizeof(*lru->present));
+    return lru->prev && lru->next && lru->present;
+}
+
+static void sim_lru_free(sim_lru_t *lru) {
+    free(lru->prev);
+    free(lru->next);
+    free(lru->present);
+}
+
+static void sim_lru_reset(sim_lru_t *lru, size_t num, __u32 cap) {
+    memset(lru->present, 0, num);
+    lru->cap = cap;
+    lru->num = 0;
+    lru->evict = 0;
+    lru->head = lru->tail = SIM_NIL;
+}
+
+static void sim_lru_unlink(sim_lru_t *lru, __u32 id) {
+    if (SIM_NIL != lru->prev[id]) lru->next[lru->prev[id]] = lru->next[id];
+    else lru->head = lru->next[id];
+
+    if (SIM_NIL != lru->next[id]) lru->prev[lru->next[id]] = lru->prev[id];
+    else lru->tail = lru->prev[id];
+}
+
+static void sim_lru_push(sim_lru_t *lru, __u32 id) {
+    lru->prev[id] = SIM_NIL;
+    lru->next[id] = lru->head;
+    if (SIM_NIL != lru->head) lru->prev[lru->head] = id;
+    lru->head = id;
+    if (SIM_NIL == lru->tail) lru->tail = id;
+}
+
+/* 查询命中时移到表头 */
+static bool sim_lru_lookup(sim_lru_t *lru, __u32 id) {
+    if (!lru->present[id]) return false;
+
+    sim_lru_unlink(lru, id);
+    sim_lru_push(lru, id);
+    return true;
+}
+
+/* 插入新条目，满时淘汰最久未访问的条目 */
+static void sim_lru_insert(sim_lru_t *lru, __u32 id) {
+    if (sim_lru_lookup(lru, id)) return ;
+
+    if (lru->num >= lru->cap) {
+        __u32 victim = lru->tail;
+        sim_lru_unlink(lru, victim);
+        lru->present[victim] = 0;
+        lru->num--;
+        lru->evict++;
+    }
+
+    sim_lru_push(lru, id);
+    lru->present[id] = 1;
+    lru->num++;
+}
+
+/* 按 tc_direct_path.c 中 do_lookup_map 的分级逻辑模拟 */
+static void sim_ip_run(const sim_trace_t *trace, sim_lru_t *hot, sim_lru_t *pre, __u64 *first_seen, __u32 *count,
+    const __u32 *conf, sim_ip_result_t *result) {
+    __u64 inv_time = conf[SIM_SWEEP_HOTPKG_INV] * SIM_NSEC_PER_MSEC;
+    sim_lru_reset(hot, trace->key_num, conf[SIM_SWEEP_HOTPATH]);
+    sim_lru_reset(pre, trace->key_num, conf[SIM_SWEEP_PRE]);
+    memset(result, 0, sizeof(*result));
+
+    for (size_t i = 0; i < trace->event_num; i++) {
+        const sim_event_t *event = &trace->events[i];
+        const sim_key_t *key = &trace->keys[event->id];
+        if (SIM_EVENT_IP != key->type) continue;
+
+        result->pkts++;
+        if (sim_lru_lookup(hot, event->id)) {
+            result->hot_hit++;
+            continue;
+        }
+
+        if (sim_lru_lookup(pre, event->id)) {
+            result->pre_hit++;
+            if (++count[event->id] >= conf[SIM_SWEEP_HOTPKG_NUM] && event->ts - first_seen[event->id] > inv_time) {
+                if (!hot->present[event->id]) result->promote++;
+                sim_lru_insert(hot, event->id);
+            }
+            continue;
+        }
+
+        result->lookup++;
+        if (ACTION_NONE == key->action) continue;
+
+        sim_lru_insert(pre, event->id);
+        first_seen[event->id] = event->ts;
+        count[event->id] = 1;
+    }
+
+    result->hot_evict = hot->evict;
+    result->pre_evict = pre->evict;
+}
+
+/* 按 xdp_direct_path.c 中 do_lookup_map 的逻辑模拟，只有命中规则的域名写入缓存 */
+static void sim_domain_run(const sim_trace_t *trace, sim_lru_t *cache, __u32 size, sim_domain_result_t *result) {
+    sim_lru_reset(cache, trace->key_num, size);
+    memset(result, 0, sizeof(*result));
+
+    for (size_t i = 0; i < trace->event_num; i++) {
+        const sim_event_t *event = &trace->events[i];
+        const sim_key_t *key = &trace->keys[event->id];
+        if (SIM_EVENT_DOMAIN != key->type) continue;
+
+        result->queries++;
+        if (sim_lru_lookup(cache, event->id)) {
+            result->hit++;
+            continue;
+        }
+
+        result->lookup++;
+        if (ACTION_NONE != key->action) sim_lru_insert(cache, event->id);
+    }
+
+    result->evict = cache->evict;
+}
+
+static double sim_ratio(__u64 num, __u64 total) {
+    return total ? 100.0 * num / total : 0;
+}
+
+static void sim_trace_show(const sim_trace_t *trace) {
+    __u64 ip_keys = 0, ip_matched = 0, domain_keys = 0, domain_matched = 0;
+    for (size_t id = 0; id < trace->key_num; id++) {
+        const sim_key_t *key = &trace->keys[id];
+        bool matched = (ACTION_NONE != key->action);
+        if (SIM_EVENT_IP == key->type) {
+            ip_keys++;
+            ip_matched += matched;
+        } else {
+            domain_keys++;
+            domain_matched += matched;
+        }
+    }
+
+    printf("[INFO] IP 报文 %llu 个，外部地址 %llu 个 (命中规则 %llu 个)；DNS 查询 %llu 个，域名 %llu 个 (命中规则 %llu 个)；无法解析 %llu 个\n",
+        (unsigned long long)trace->ip_events, (unsigned long long)ip_keys, (unsigned long long)ip_matched,
+        (unsigned long long)trace->domain_events, (unsigned long long)domain_keys, (unsigned long long)domain_matched,
+        (unsigned long long)trace->invalid);
+}
+
+static bool sim_run_all(const sim_trace_t *trace, const sim_sweep_t *sweeps) {
+    sim_lru_t hot, pre;
+    bool ret = sim_lru_init(&hot, trace->key_num);
+    ret = sim_lru_init(&pre, trace->key_num) && ret;
+    __u64 *first_seen = calloc(trace->key_num ? trace->key_num : 1, sizeof(*first_seen));
+    __u32 *count = calloc(trace->key_num ? trace->key_num : 1, sizeof(*count));
+    ret = ret && first_seen && count;
+    if (!ret) goto out;
+
+    if (trace->ip_events) {
+        printf("%10s %10s %8s %8s %8s %8s %8s %10s %10s %10s %10s\n", "hotpath", "pre_cache", "hotpkg", "inv_ms",
+            "hot%", "pre%", "avoid%", "lpm", "promote", "hot_evict", "pre_evict");
+
+        const sim_sweep_t *s = sweeps;
+        __u32 conf[SIM_SWEEP_NUM];
+        for (__u32 a = 0; a < s[SIM_SWEEP_HOTPATH].num; a++)
+        for (__u32 b = 0; b < s[SIM_SWEEP_PRE].num; b++)
+        for (__u32 c = 0; c < s[SIM_SWEEP_HOTPKG_NUM].num; c++)
+        for (__u32 d = 0; d < s[SIM_SWEEP_HOTPKG_INV].num; d++) {
+            conf[SIM_SWEEP_HOTPATH] = s[SIM_SWEEP_HOTPATH].values[a];
+            conf[SIM_SWEEP_PRE] = s[SIM_SWEEP_PRE].values[b];
+            conf[SIM_SWEEP_HOTPKG_NUM] = s[SIM_SWEEP_HOTPKG_NUM].values[c];
+            conf[SIM_SWEEP_HOTPKG_INV] = s[SIM_SWEEP_HOTPKG_INV].values[d];
+
+            sim_ip_result_t r;
+            sim_ip_run(trace, &hot, &pre, first_seen, count, conf, &r);
+            printf("%10u %10u %8u %8u %8.2f %8.2f %8.2f %10llu %10llu %10llu %10llu\n",
+                conf[SIM_SWEEP_HOTPATH], conf[SIM_SWEEP_PRE], conf[SIM_SWEEP_HOTPKG_NUM], conf[SIM_SWEEP_HOTPKG_INV],
+                sim_ratio(r.hot_hit, r.pkts), sim_ratio(r.pre_hit, r.pkts), sim_ratio(r.hot_hit + r.pre_hit, r.pkts),
+                (unsigned long long)r.lookup, (unsigned long long)r.promote,
+                (unsigned long long)r.hot_evict, (unsigned long long)r.pre_evict);
+        }
+    }
+
+    if (trace->domain_events) {
+        printf("%12s %8s %10s %8s %10s\n", "domain_cache", "hit%", "lpm", "avoid%", "evict");
+
+        /* IP 模拟已结束，复用 hot 作为域名缓存 */
+        for (__u32 i = 0; i < sweeps[SIM_SWEEP_DOMAIN].num; i++) {
+            sim_domain_result_t r;
+            sim_domain_run(trace, &hot, sweeps[SIM_SWEEP_DOMAIN].values[i], &r);
+            printf("%12u %8.2f %10llu %8.2f %10llu\n", sweeps[SIM_SWEEP_DOMAIN].values[i],
+                sim_ratio(r.hit, r.queries), (unsigned long long)r.lookup,
+                sim_ratio(r.queries - r.lookup, r.queries), (unsigned long long)r.evict);
+        }
+    }
+
+out:
+    sim_lru_free(&hot);
+    sim_lru_free(&pre);
+    free(first_seen);
+    free(count);
+    return ret;
+}
+
+static void sim_trace_free(sim_trace_t *trace) {
+    for (size_t id = 0; id < trace->key_num; id++) free(trace->keys[id].domain);
+    free(trace->keys);
+    free(trace->index);
+    free(trace->events);
+    if (trace->ip_fd >= 0) close(trace->ip_fd);
+    if (trace->domain_fd >= 0) close(trace->domain_fd);
+    domain_dat_free(&trace->domain_dat);
+}
+
+/* 未指定的参数取配置文件中的当前值 */
+static void sim_sweep_default(sim_sweep_t *sweeps) {
+    const direct_path_conf_t *conf = conf_get();
+
+    sweeps[SIM_SWEEP_HOTPATH] = (sim_sweep_t){CONF_KEY_HOTPATH_CACHE_SIZE, {conf->hotpath_cache_size}, 1};
+    sweeps[SIM_SWEEP_PRE] = (sim_sweep_t){CONF_KEY_PRE_CACHE_SIZE, {conf->pre_cache_size}, 1};
+    sweeps[SIM_SWEEP_HOTPKG_NUM] = (sim_sweep_t){CONF_KEY_HOTPKG_NUM, {conf->hotpkg_num}, 1};
+    sweeps[SIM_SWEEP_HOTPKG_INV] = (sim_sweep_t){CONF_KEY_HOTPKG_INV_MS,
+        {(__u32)(conf->hotpkg_inv_time / SIM_NSEC_PER_MSEC)}, 1};
+    sweeps[SIM_SWEEP_DOMAIN] = (sim_sweep_t){CONF_KEY_DOMAIN_CACHE_SIZE, {conf->domain_cache_size}, 1};
+}
+
+/* key=value1,value2,... 容量需大于 0 */
+static bool sim_sweep_parse(sim_sweep_t *sweeps, char *arg) {
+    char *sep = strchr(arg, '=');
+    if (NULL == sep) return false;
+    *sep = '\0';
+
+    sim_sweep_t *sweep = NULL;
+    for (__u32 i = 0; i < SIM_SWEEP_NUM; i++) {
+        if (!strcmp(sweeps[i].key, arg)) sweep = &sweeps[i];
+    }
+    if (NULL == sweep) return false;
+
+    sweep->num = 0;
+    char *saveptr = NULL;
+    char *token = strtok_r(sep + 1, SIM_SWEEP_SEPARATOR, &saveptr);
+    while (NULL != token) {
+        char *end = NULL;
+        errno = 0;
+        unsigned long val = strtoul(token, &end, 0);
+        if (errno || '\0' != *end || val > 0xFFFFFFFFUL || sweep->num >= SIM_SWEEP_MAX_NUM) return false;
+        if (0 == val && sweep != &sweeps[SIM_SWEEP_HOTPKG_INV]) return false;
+
+        sweep->values[sweep->num++] = val;
+        token = strtok_r(NULL, SIM_SWEEP_SEPARATOR, &saveptr);
+    }
+
+    return sweep->num > 0;
+}
+
+int sim_args_parse(int argc, char **argv) {
+    if (argc < SIM_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" SIM_PROG_USAGE "\n");
+        return -1;
+    }
+
+    sim_sweep_t sweeps[SIM_SWEEP_NUM];
+    sim_sweep_default(sweeps);
+    for (int i = SIM_ARGS_MIN_NUM; i < argc; i++) {
+        char arg[FILE_LINE_MAXLEN];
+        snprintf(arg, sizeof(arg), "%s", argv[i]);
+        if (!sim_sweep_parse(sweeps, arg)) {
+            fprintf(stderr, "[ERROR] 无效参数 [%s]，可用: %s %s %s %s %s\n", argv[i],
+                CONF_KEY_HOTPATH_CACHE_SIZE, CONF_KEY_PRE_CACHE_SIZE, CONF_KEY_HOTPKG_NUM,
+                CONF_KEY_HOTPKG_INV_MS, CONF_KEY_DOMAIN_CACHE_SIZE);
+            return -1;
+        }
+    }
+
+    sim_trace_t trace;
+    memset(&trace, 0, sizeof(trace));
+    trace.ip_fd = bpf_obj_get(DIRECTMAP_PIN);
+#if DOMAIN_ENGINE == DOMAIN_ENGINE_ARENA
+    trace.domain_fd = -1;
+    if (trace.ip_fd < 0 || !domain_arena_snapshot(&trace.domain_dat)) {
+        fprintf(stderr, "[ERROR] 无法获取规则库 %s、%s，需要先 load install 并导入规则\n", DIRECTMAP_PIN, DOMAINARENA_PIN);
+#else
+    trace.domain_fd = bpf_obj_get(DOMAINMAP_PIN);
+    if (trace.ip_fd < 0 || trace.domain_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取规则库 %s、%s，需要先 load install 并导入规则\n", DIRECTMAP_PIN, DOMAINMAP_PIN);
+#endif
+        sim_trace_free(&trace);
+        return -1;
+    }
+
+    bool loaded = pcap_probe(argv[2]) ? sim_load_pcap(&trace, argv[2]) : sim_load_log(&trace, argv[2]);
+    if (!loaded) {
+        fprintf(stderr, "[ERROR] 读取 %s 失败\n", argv[2]);
+        sim_trace_free(&trace);
+        return -1;
+    }
+
+    sim_trace_show(&trace);
+    int ret = sim_run_all(&trace, sweeps) ? 0 : -1;
+
+    sim_trace_free(&trace);
+    return ret;
+}
+
+int sim_main(int argc, char **argv) {
+    return sim_args_parse(argc, argv);
+}
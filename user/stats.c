@@ -0,0 +1,96 @@
+/*
+ * File     : stats.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-03-12 22:33:40
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_stats.h"
+
+/* 统计项名称，下标与 XDP_STAT_* 一致 */
+static const char *xdp_stat_names[XDP_STAT_NUM] = {
+    [XDP_STAT_RL_CHECKED]   = "ratelimit checked",
+    [XDP_STAT_RL_DROP]      = "ratelimit dropped",
+    [XDP_STAT_RL_TRUNCATE]  = "ratelimit truncated",
+    [XDP_STAT_DOMAIN_BLOOM_SKIP] = "domain bloom skipped",
+    [XDP_STAT_DOMAIN_BLOOM_PASS] = "domain bloom passed",
+    [XDP_STAT_KEYWORD_WALK] = "keyword walks",
+    [XDP_STAT_KEYWORD_STEP] = "keyword steps",
+    [XDP_STAT_KEYWORD_HIT]  = "keyword hits",
+    [XDP_STAT_TRACE_DROP]   = "trace dropped",
+};
+
+/* 统计项名称，下标与 TC_STAT_* 一致 */
+static const char *tc_stat_names[TC_STAT_NUM] = {
+    [TC_STAT_BLK_BLOOM_SKIP] = "blklist bloom skipped",
+    [TC_STAT_BLK_BLOOM_PASS] = "blklist bloom passed",
+    [TC_STAT_TRACE_DROP]     = "trace dropped",
+};
+
+bool map_percpu_u64_sum(int map_fd, __u32 key, __u64 *sum) {
+    if (unlikely(map_fd < 0 || NULL == sum)) return false;
+
+    int cpus = libbpf_num_possible_cpus();
+    if (cpus <= 0) return false;
+
+    __u64 *values = calloc(cpus, sizeof(__u64));
+    if (NULL == values) return false;
+
+    if (bpf_map_lookup_elem(map_fd, &key, values)) {
+        free(values);
+        return false;
+    }
+
+    *sum = 0;
+    for (int i = 0; i < cpus; i++) *sum += values[i];
+
+    free(values);
+    return true;
+}
+
+static int stats_show_map(const char *title, const char *map_path, const char **names, __u32 num) {
+    int map_fd = bpf_obj_get(map_path);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", map_path, strerror(errno));
+        return -1;
+    }
+
+    printf("%s\n", title);
+    for (__u32 i = 0; i < num; i++) {
+        __u64 sum = 0;
+        if (!map_percpu_u64_sum(map_fd, i, &sum)) continue;
+        printf("  %-24s %llu\n", names[i], (unsigned long long)sum);
+    }
+
+    close(map_fd);
+    return 0;
+}
+
+/* 关键字自动机每次匹配的平均转移步数，即每个报文的查表次数 */
+static void stats_show_keyword_cost() {
+    int map_fd = bpf_obj_get(XDPSTATS_PIN);
+    if (map_fd < 0) return ;
+
+    __u64 walks = 0, steps = 0;
+    if (map_percpu_u64_sum(map_fd, XDP_STAT_KEYWORD_WALK, &walks) && 
+        map_percpu_u64_sum(map_fd, XDP_STAT_KEYWORD_STEP, &steps) && walks) 
+        printf("  %-24s %.2f\n", "keyword steps/walk", (double)steps / walks);
+
+    close(map_fd);
+}
+
+int stats_main(int argc, char **argv) {
+    int ret = stats_show_map("XDP:", XDPSTATS_PIN, xdp_stat_names, XDP_STAT_NUM);
+    if (ret) return ret;
+    stats_show_keyword_cost();
+
+    return stats_show_map("TC:", TCSTATS_PIN, tc_stat_names, TC_STAT_NUM);
+}
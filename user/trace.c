@@ -0,0 +1,255 @@
+/*
+ * File     : trace.c
+ * Author   : sun.wang
+ * Mail     : sunowsir@163.com
+ * Github   : github.com/sunowsir
+ * Creation : 2026-04-16 20:30:12
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+
+#include "direct_path_user.h"
+#include "direct_path_rule.h"
+#include "direct_path_trace.h"
+
+#define TRACE_NSEC_PER_SEC              1000000000ULL
+
+typedef struct {
+    trace_config_t cfg;
+    /* 输出 sim 日志格式 */
+    bool sim;
+    /* 输出的事件数上限，0 表示不限 */
+    __u64 count;
+
+    __u64 num;
+    /* bpf_ktime_get_ns 与墙上时间的差值 */
+    __u64 realtime_off;
+} trace_ctx_t;
+
+static const char *trace_tier_names[] = {
+    [TRACE_TIER_NONE]    = "none",
+    [TRACE_TIER_CACHE]   = "cache",
+    [TRACE_TIER_PRE]     = "pre",
+    [TRACE_TIER_RULE]    = "rule",
+    [TRACE_TIER_KEYWORD] = "keyword",
+    [TRACE_TIER_BLOOM]   = "bloom",
+    [TRACE_TIER_MISS]    = "miss",
+    [TRACE_TIER_BLKLIST] = "blklist",
+};
+
+static const char *trace_tier_name(__u8 tier) {
+    return tier < sizeof(trace_tier_names) / sizeof(trace_tier_names[0]) ? trace_tier_names[tier] : "unknown";
+}
+
+static __u64 trace_clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * TRACE_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static bool trace_config_write(const trace_config_t *cfg) {
+    int map_fd = bpf_obj_get(TRACECONFIG_XDP_PIN);
+    if (map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s\n", TRACECONFIG_XDP_PIN, strerror(errno));
+        return false;
+    }
+
+    __u32 key = 0;
+    trace_config_t old = {0};
+    if (cfg->sample && !bpf_map_lookup_elem(map_fd, &key, &old) && old.sample)
+        fprintf(stderr, "[INFO] 已有 trace 在运行或上次未正常退出，覆盖其配置\n");
+
+    bool ret = !bpf_map_update_elem(map_fd, &key, cfg, BPF_ANY);
+    if (!ret) fprintf(stderr, "[ERROR] 事件流配置更新失败: %s\n", strerror(errno));
+    close(map_fd);
+
+    return ret;
+}
+
+static int trace_event_handle(void *data, void *raw, size_t size) {
+    trace_ctx_t *ctx = data;
+    const trace_event_t *event = raw;
+    if (size < sizeof(*event)) return 0;
+    if (ctx->count && ctx->num >= ctx->count) return 0;
+
+    char client[INET_ADDRSTRLEN];
+    char target[TRACE_NAME_MAXLEN];
+    inet_ntop(AF_INET, &event->client, client, sizeof(client));
+
+    if (TRACE_SRC_XDP == event->source) {
+        if (size < sizeof(trace_domain_event_t)) return 0;
+        if (!domain_decode(&((const trace_domain_event_t *)raw)->key, target, sizeof(target))) return 0;
+    } else {
+        inet_ntop(AF_INET, &event->remote, target, sizeof(target));
+    }
+
+    ctx->num++;
+    __u64 ts = event->ts + ctx->realtime_off;
+
+    if (ctx->sim) {
+        printf("%llu.%06llu %s\n", ts / TRACE_NSEC_PER_SEC, ts % TRACE_NSEC_PER_SEC / 1000, target);
+        return 0;
+    }
+
+    char wall[16];
+    time_t sec = ts / TRACE_NSEC_PER_SEC;
+    struct tm tm;
+    strftime(wall, sizeof(wall), "%H:%M:%S", localtime_r(&sec, &tm));
+
+    printf("%s.%06llu %-3s %-7s action=%-3u %-15s %s\n", wall, ts % TRACE_NSEC_PER_SEC / 1000,
+        TRACE_SRC_XDP == event->source ? TRACE_NAME_XDP : TRACE_NAME_TC,
+        trace_tier_name(event->tier), event->action, client, target);
+    return 0;
+}
+
+/* 同时等待 ring buffer 与退出信号，收到 SIGINT/SIGTERM 或达到事件数上限时返回 */
+static bool trace_loop(trace_ctx_t *ctx, struct ring_buffer *rb) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL)) return false;
+
+    int sig_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    int ep_fd = epoll_create1(EPOLL_CLOEXEC);
+    bool ret = false;
+    if (sig_fd < 0 || ep_fd < 0) goto out;
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = sig_fd};
+    if (epoll_ctl(ep_fd, EPOLL_CTL_ADD, sig_fd, &ev)) goto out;
+
+    int rb_fd = ring_buffer__epoll_fd(rb);
+    ev.data.fd = rb_fd;
+    if (epoll_ctl(ep_fd, EPOLL_CTL_ADD, rb_fd, &ev)) goto out;
+
+    while (!ctx->count || ctx->num < ctx->count) {
+        struct epoll_event events[TRACE_EPOLL_EVENTS];
+        int num = epoll_wait(ep_fd, events, TRACE_EPOLL_EVENTS, -1);
+        if (num < 0) {
+            if (EINTR == errno) continue;
+            goto out;
+        }
+
+        for (int i = 0; i < num; i++) {
+            if (sig_fd == events[i].data.fd) {
+                ret = true;
+                goto out;
+            }
+
+            if (ring_buffer__consume(rb) < 0) goto out;
+        }
+
+        /* 管道下游退出时及时结束 */
+        if (fflush(stdout)) goto out;
+    }
+
+    ret = true;
+
+out:
+    if (!ret) fprintf(stderr, "[ERROR] 事件读取失败: %s\n", strerror(errno));
+    if (ep_fd >= 0) close(ep_fd);
+    if (sig_fd >= 0) close(sig_fd);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    return ret;
+}
+
+static bool trace_arg_parse(trace_ctx_t *ctx, const char *arg) {
+    const char *val = NULL;
+
+#define TRACE_ARG_IS(name) (!strncmp(arg, name, strlen(name)) && (val = arg + strlen(name)))
+    if (TRACE_ARG_IS(TRACE_ARGS_SAMPLE)) {
+        char *end = NULL;
+        unsigned long sample = strtoul(val, &end, 10);
+        if (0 == sample || *end || sample > UINT32_MAX) return false;
+        ctx->cfg.sample = sample;
+    } else if (TRACE_ARG_IS(TRACE_ARGS_CLIENT)) {
+        if (1 != inet_pton(AF_INET, val, &ctx->cfg.client)) return false;
+    } else if (TRACE_ARG_IS(TRACE_ARGS_SRC)) {
+        ctx->cfg.flags &= ~(TRACE_F_XDP | TRACE_F_TC);
+        if (!strcmp(val, TRACE_NAME_XDP)) ctx->cfg.flags |= TRACE_F_XDP;
+        else if (!strcmp(val, TRACE_NAME_TC)) ctx->cfg.flags |= TRACE_F_TC;
+        else if (!strcmp(val, TRACE_NAME_ALL)) ctx->cfg.flags |= TRACE_F_XDP | TRACE_F_TC;
+        else return false;
+    } else if (TRACE_ARG_IS(TRACE_ARGS_VERDICT)) {
+        ctx->cfg.flags &= ~(TRACE_F_HIT | TRACE_F_MISS);
+        if (!strcmp(val, TRACE_NAME_HIT)) ctx->cfg.flags |= TRACE_F_HIT;
+        else if (!strcmp(val, TRACE_NAME_MISS)) ctx->cfg.flags |= TRACE_F_MISS;
+        else if (strcmp(val, TRACE_NAME_ALL)) return false;
+    } else if (TRACE_ARG_IS(TRACE_ARGS_COUNT)) {
+        char *end = NULL;
+        ctx->count = strtoull(val, &end, 10);
+        if (0 == ctx->count || *end) return false;
+    } else if (TRACE_ARG_IS(TRACE_ARGS_FORMAT)) {
+        if (!strcmp(val, TRACE_NAME_SIM)) ctx->sim = true;
+        else if (!strcmp(val, TRACE_NAME_TEXT)) ctx->sim = false;
+        else return false;
+    } else {
+        return false;
+    }
+#undef TRACE_ARG_IS
+
+    return true;
+}
+
+int trace_args_parse(int argc, char **argv) {
+    trace_ctx_t ctx = {
+        .cfg = {.sample = TRACE_DEFAULT_SAMPLE, .client = 0, .flags = TRACE_F_XDP | TRACE_F_TC},
+    };
+
+    if (argc < TRACE_ARGS_MIN_NUM) {
+        fprintf(stderr, "[ERROR] 参数错误，" TRACE_PROG_USAGE "\n");
+        return -1;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        if (!trace_arg_parse(&ctx, argv[i])) {
+            fprintf(stderr, "[ERROR] 参数错误 [%s]，" TRACE_PROG_USAGE "\n", argv[i]);
+            return -1;
+        }
+    }
+
+    int rb_map_fd = bpf_obj_get(TRACERINGBUF_XDP_PIN);
+    if (rb_map_fd < 0) {
+        fprintf(stderr, "[ERROR] 无法获取 BPF Map %s: %s，请先执行 load install\n", TRACERINGBUF_XDP_PIN, strerror(errno));
+        return -1;
+    }
+
+    struct ring_buffer *rb = ring_buffer__new(rb_map_fd, trace_event_handle, &ctx, NULL);
+    if (NULL == rb) {
+        fprintf(stderr, "[ERROR] 无法打开事件流: %s\n", strerror(errno));
+        close(rb_map_fd);
+        return -1;
+    }
+
+    /* 先打开消费端再开启采样，避免开头的事件因缓冲区满被丢弃 */
+    ctx.realtime_off = trace_clock_ns(CLOCK_REALTIME) - trace_clock_ns(CLOCK_MONOTONIC);
+    int ret = -1;
+    if (trace_config_write(&ctx.cfg)) {
+        if (!ctx.sim) fprintf(stderr, "[INFO] 开始记录事件，Ctrl-C 结束\n");
+        ret = trace_loop(&ctx, rb) ? 0 : -1;
+
+        /* 退出后关闭采样，数据面恢复为每包一次数组查询 */
+        trace_config_t off = ctx.cfg;
+        off.sample = 0;
+        trace_config_write(&off);
+    }
+
+    fprintf(stderr, "[INFO] 共输出 %llu 个事件\n", (unsigned long long)ctx.num);
+
+    ring_buffer__free(rb);
+    close(rb_map_fd);
+    return ret;
+}
+
+int trace_main(int argc, char **argv) {
+    return trace_args_parse(argc, argv);
+}